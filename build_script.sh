@@ -53,10 +53,17 @@ CFLAGS="$CFLAGS -ffast-math -ftree-vectorize -funroll-loops"
 echo "Compiling with flags: $CFLAGS"
 clang $CFLAGS -c -o vsort.o vsort.c
 clang $CFLAGS -c -o vsort_logger.o vsort_logger.c
+clang $CFLAGS -c -o vsort_pool.o vsort_pool.c
+clang $CFLAGS -c -o vsort_merge.o vsort_merge.c
+clang $CFLAGS -c -o vsort_external.o vsort_external.c
+clang $CFLAGS -c -o vsort_stream.o vsort_stream.c
+clang $CFLAGS -c -o vsort_scratch.o vsort_scratch.c
+clang $CFLAGS -c -o vsort_async.o vsort_async.c
+clang $CFLAGS -c -o vsort_stats.o vsort_stats.c
 
 # Create the static library
 echo "Creating static library..."
-ar rcs libvsort.a vsort.o vsort_logger.o
+ar rcs libvsort.a vsort.o vsort_logger.o vsort_pool.o vsort_merge.o vsort_external.o vsort_stream.o vsort_scratch.o vsort_async.o vsort_stats.o
 
 echo "Building tests..."
 # Build test_basic with the same flags
@@ -0,0 +1,761 @@
+/**
+ * benchmark_suite.c - Reproducible benchmark matrix for vsort
+ *
+ * Sorts every combination of element kind, input distribution, array size
+ * and thread count with vsort and with the C library qsort as a baseline.
+ * Every configuration gets warmup runs and then several timed repetitions,
+ * and reports min/median/mean/max time and throughput as a text table, CSV
+ * or JSON. Inputs come from a seeded generator, so the same seed and
+ * options sort the same data on every host, and results from two vsort
+ * releases can be diffed to catch regressions.
+ *
+ * Arrays shorter than BENCH_MIN_BATCH elements are sorted in batches of
+ * copies per sample so the timer resolution does not dominate; times are
+ * always reported per array.
+ *
+ * Usage: benchmark_suite [--kinds LIST] [--dists LIST] [--sizes LIST]
+ *                        [--threads LIST] [--warmup N] [--reps N]
+ *                        [--seed N] [--format text|csv|json] [--output FILE]
+ */
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vsort.h"
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_MAX_LIST 32
+#define BENCH_MIN_BATCH ((size_t)1 << 16) // Elements sorted per sample at least
+#define BENCH_ZIPF_RANKS ((size_t)1 << 16)
+
+// -----------------------------------------------------------------------------
+// Element kinds
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    int64_t key;
+    int64_t payload;
+} bench_record_t;
+
+typedef struct
+{
+    const char *name;
+    size_t size;
+    vsort_data_kind_t kind;
+    int (*compare)(const void *, const void *);
+    void (*put)(void *data, size_t index, uint64_t value, uint64_t range);
+} bench_kind_t;
+
+static int compare_int32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_float32(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_record(const void *a, const void *b)
+{
+    int64_t x = ((const bench_record_t *)a)->key;
+    int64_t y = ((const bench_record_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+static int compare_char8(const void *a, const void *b)
+{
+    return (int)*(const unsigned char *)a - (int)*(const unsigned char *)b;
+}
+
+// Generated values lie in [0, range); signed kinds are centred on zero and
+// bytes are scaled down to 0-255, so every kind keeps the shape of the
+// distribution.
+static void put_int32(void *data, size_t index, uint64_t value, uint64_t range)
+{
+    ((int32_t *)data)[index] = (int32_t)((int64_t)value - (int64_t)(range / 2));
+}
+
+static void put_float32(void *data, size_t index, uint64_t value, uint64_t range)
+{
+    ((float *)data)[index] = (float)((int64_t)value - (int64_t)(range / 2)) * 0.5f;
+}
+
+static void put_record(void *data, size_t index, uint64_t value, uint64_t range)
+{
+    (void)range;
+    bench_record_t *record = (bench_record_t *)data + index;
+    record->key = (int64_t)value;
+    record->payload = (int64_t)index;
+}
+
+static void put_char8(void *data, size_t index, uint64_t value, uint64_t range)
+{
+    ((unsigned char *)data)[index] = (unsigned char)(range > 256 ? value * 256 / range : value);
+}
+
+static const bench_kind_t g_kinds[] = {
+    {"int32", sizeof(int32_t), VSORT_KIND_INT32, compare_int32, put_int32},
+    {"float32", sizeof(float), VSORT_KIND_FLOAT32, compare_float32, put_float32},
+    {"generic", sizeof(bench_record_t), VSORT_KIND_GENERIC, compare_record, put_record},
+    {"char", 1, VSORT_KIND_CHAR8, compare_char8, put_char8},
+};
+
+// -----------------------------------------------------------------------------
+// Input distributions
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    void *data;
+    size_t count;
+    const bench_kind_t *kind;
+    uint64_t state; /**< splitmix64 state */
+} bench_input_t;
+
+typedef void (*bench_generator_t)(bench_input_t *input);
+
+static uint64_t bench_random(bench_input_t *input)
+{
+    uint64_t z = (input->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void bench_put(bench_input_t *input, size_t index, uint64_t value, uint64_t range)
+{
+    input->kind->put(input->data, index, value, range);
+}
+
+static void bench_swap(bench_input_t *input, size_t a, size_t b)
+{
+    unsigned char tmp[sizeof(bench_record_t)];
+    unsigned char *data = (unsigned char *)input->data;
+    size_t size = input->kind->size;
+    memcpy(tmp, data + a * size, size);
+    memcpy(data + a * size, data + b * size, size);
+    memcpy(data + b * size, tmp, size);
+}
+
+static void gen_random(bench_input_t *input)
+{
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, bench_random(input) >> 33, (uint64_t)1 << 31);
+}
+
+static void gen_sorted(bench_input_t *input)
+{
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, i, input->count);
+}
+
+static void gen_reversed(bench_input_t *input)
+{
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, input->count - 1 - i, input->count);
+}
+
+// Sorted, then 1% of the positions swapped with random partners.
+static void gen_nearly_sorted(bench_input_t *input)
+{
+    gen_sorted(input);
+    size_t swaps = input->count / 100 + 1;
+    for (size_t s = 0; s < swaps && input->count > 1; s++)
+        bench_swap(input, bench_random(input) % input->count, bench_random(input) % input->count);
+}
+
+// About sqrt(n) distinct values.
+static void gen_few_unique(bench_input_t *input)
+{
+    uint64_t distinct = (uint64_t)sqrt((double)input->count) + 2;
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, bench_random(input) % distinct, distinct);
+}
+
+static void gen_duplicates_heavy(bench_input_t *input)
+{
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, bench_random(input) % 4, 4);
+}
+
+static void gen_all_equal(bench_input_t *input)
+{
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, 0, 1);
+}
+
+// Zipf (s = 1) over BENCH_ZIPF_RANKS ranks: rank r has weight 1 / (r + 1).
+static void gen_zipf(bench_input_t *input)
+{
+    static double cdf[BENCH_ZIPF_RANKS];
+    static bool ready = false;
+    if (!ready)
+    {
+        double total = 0.0;
+        for (size_t r = 0; r < BENCH_ZIPF_RANKS; r++)
+            cdf[r] = (total += 1.0 / (double)(r + 1));
+        for (size_t r = 0; r < BENCH_ZIPF_RANKS; r++)
+            cdf[r] /= total;
+        ready = true;
+    }
+
+    for (size_t i = 0; i < input->count; i++)
+    {
+        double u = (double)(bench_random(input) >> 11) * (1.0 / 9007199254740992.0);
+        size_t lo = 0;
+        size_t hi = BENCH_ZIPF_RANKS - 1;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (cdf[mid] < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        bench_put(input, i, lo, BENCH_ZIPF_RANKS);
+    }
+}
+
+// Ascending to the middle, then descending.
+static void gen_organ_pipe(bench_input_t *input)
+{
+    size_t half = input->count / 2;
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, i < half ? i : input->count - 1 - i, half + 1);
+}
+
+// Ascending runs of about sqrt(n) elements.
+static void gen_sawtooth(bench_input_t *input)
+{
+    size_t period = (size_t)sqrt((double)input->count) + 16;
+    for (size_t i = 0; i < input->count; i++)
+        bench_put(input, i, i % period, period);
+}
+
+// Musser's median-of-3 killer: degrades quicksorts that take the median of
+// the first, middle and last element to quadratic time.
+static void gen_median3_killer(bench_input_t *input)
+{
+    size_t n = input->count;
+    size_t k = n / 2;
+    uint64_t range = n + 2;
+    for (size_t i = 1; i <= k; i++)
+    {
+        if (i % 2 == 1)
+        {
+            bench_put(input, i - 1, i, range);
+            if (i < k)
+                bench_put(input, i, k + i, range);
+        }
+        bench_put(input, k + i - 1, 2 * i, range);
+    }
+    if (n % 2 == 1)
+        bench_put(input, n - 1, n + 1, range);
+}
+
+typedef struct
+{
+    const char *name;
+    bench_generator_t generate;
+} bench_distribution_t;
+
+static const bench_distribution_t g_distributions[] = {
+    {"random", gen_random},
+    {"sorted", gen_sorted},
+    {"reversed", gen_reversed},
+    {"nearly_sorted", gen_nearly_sorted},
+    {"few_unique", gen_few_unique},
+    {"duplicates_heavy", gen_duplicates_heavy},
+    {"all_equal", gen_all_equal},
+    {"zipf", gen_zipf},
+    {"organ_pipe", gen_organ_pipe},
+    {"sawtooth", gen_sawtooth},
+    {"median3_killer", gen_median3_killer},
+};
+
+#define BENCH_KIND_COUNT (sizeof(g_kinds) / sizeof(g_kinds[0]))
+#define BENCH_DIST_COUNT (sizeof(g_distributions) / sizeof(g_distributions[0]))
+
+// -----------------------------------------------------------------------------
+// Timing
+// -----------------------------------------------------------------------------
+
+static uint64_t bench_now_ns(void)
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    uint64_t ticks = (uint64_t)now.QuadPart;
+    uint64_t hz = (uint64_t)frequency.QuadPart;
+    return ticks / hz * 1000000000u + ticks % hz * 1000000000u / hz;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static const char *engine_name(vsort_engine_t engine)
+{
+    static const char *names[VSORT_ENGINE_COUNT] = {
+        "none", "introsort", "mergesort", "run_merge", "radix_lsd",
+        "radix_msd", "parallel_merge", "fork_join", "numa", "counting"};
+    return engine < VSORT_ENGINE_COUNT ? names[engine] : "unknown";
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark driver
+// -----------------------------------------------------------------------------
+
+typedef enum
+{
+    BENCH_ALGO_VSORT,
+    BENCH_ALGO_QSORT
+} bench_algorithm_t;
+
+typedef enum
+{
+    BENCH_FORMAT_TEXT,
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON
+} bench_format_t;
+
+typedef struct
+{
+    const bench_kind_t *kinds[BENCH_KIND_COUNT];
+    size_t kind_count;
+    const bench_distribution_t *dists[BENCH_DIST_COUNT];
+    size_t dist_count;
+    size_t sizes[BENCH_MAX_LIST];
+    size_t size_count;
+    int threads[BENCH_MAX_LIST];
+    size_t thread_count;
+    int warmup;
+    int reps;
+    uint64_t seed;
+    bench_format_t format;
+    FILE *out;
+} bench_config_t;
+
+typedef struct
+{
+    const char *kind;
+    const char *dist;
+    size_t size;
+    int threads;
+    const char *algorithm;
+    const char *engine;
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+    double max_ns;
+    bool sorted;
+} bench_result_t;
+
+static bool bench_is_sorted(const bench_kind_t *kind, const void *data, size_t count)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 1; i < count; i++)
+    {
+        if (kind->compare(bytes + (i - 1) * kind->size, bytes + i * kind->size) > 0)
+            return false;
+    }
+    return true;
+}
+
+// Sorts every copy of the batch once; returns nanoseconds per array.
+static double bench_run(const bench_kind_t *kind, bench_algorithm_t algorithm, unsigned char *work,
+                        const unsigned char *source, size_t count, size_t copies, bool *sorted,
+                        vsort_stats_t *stats)
+{
+    size_t bytes = count * kind->size;
+    for (size_t c = 0; c < copies; c++)
+        memcpy(work + c * bytes, source, bytes);
+
+    vsort_options_t options = {
+        .data = NULL,
+        .length = count,
+        .element_size = kind->size,
+        .kind = kind->kind,
+        .comparator = kind->compare,
+        .flags = vsort_default_flags()};
+
+    uint64_t start = bench_now_ns();
+    for (size_t c = 0; c < copies; c++)
+    {
+        if (algorithm == BENCH_ALGO_QSORT)
+            qsort(work + c * bytes, count, kind->size, kind->compare);
+        else
+        {
+            options.data = work + c * bytes;
+            if (stats)
+                vsort_sort_with_stats(&options, stats);
+            else
+                vsort_sort(&options);
+        }
+    }
+    double elapsed = (double)(bench_now_ns() - start) / (double)copies;
+
+    for (size_t c = 0; c < copies && *sorted; c++)
+        *sorted = bench_is_sorted(kind, work + c * bytes, count);
+    return elapsed;
+}
+
+static void bench_emit(const bench_config_t *config, const bench_result_t *r, bool *first)
+{
+    double melems = r->median_ns > 0.0 ? (double)r->size * 1e3 / r->median_ns : 0.0;
+    switch (config->format)
+    {
+    case BENCH_FORMAT_CSV:
+        fprintf(config->out, "%s,%s,%zu,%d,%s,%s,%.0f,%.0f,%.0f,%.0f,%.3f,%s\n", r->kind, r->dist, r->size,
+                r->threads, r->algorithm, r->engine, r->min_ns, r->median_ns, r->mean_ns, r->max_ns, melems,
+                r->sorted ? "true" : "false");
+        break;
+    case BENCH_FORMAT_JSON:
+        fprintf(config->out,
+                "%s\n    {\"kind\": \"%s\", \"distribution\": \"%s\", \"size\": %zu, \"threads\": %d, "
+                "\"algorithm\": \"%s\", \"engine\": \"%s\", \"min_ns\": %.0f, \"median_ns\": %.0f, "
+                "\"mean_ns\": %.0f, \"max_ns\": %.0f, \"melem_per_s\": %.3f, \"sorted\": %s}",
+                *first ? "" : ",", r->kind, r->dist, r->size, r->threads, r->algorithm, r->engine, r->min_ns,
+                r->median_ns, r->mean_ns, r->max_ns, melems, r->sorted ? "true" : "false");
+        break;
+    default:
+        fprintf(config->out, "%-8s %-16s %12zu %7d %-6s %-14s %14.0f %14.0f %10.2f %s\n", r->kind, r->dist, r->size,
+                r->threads, r->algorithm, r->engine, r->min_ns, r->median_ns, melems, r->sorted ? "ok" : "UNSORTED");
+        break;
+    }
+    *first = false;
+    fflush(config->out);
+}
+
+static void bench_header(const bench_config_t *config)
+{
+    vsort_tuning_t tuning;
+    vsort_get_tuning(&tuning);
+
+    switch (config->format)
+    {
+    case BENCH_FORMAT_CSV:
+        fprintf(config->out, "kind,distribution,size,threads,algorithm,engine,min_ns,median_ns,mean_ns,max_ns,"
+                             "melem_per_s,sorted\n");
+        break;
+    case BENCH_FORMAT_JSON:
+        fprintf(config->out, "{\n  \"vsort_version\": \"%s\",\n  \"cores\": %d,\n  \"seed\": %llu,\n"
+                             "  \"warmup\": %d,\n  \"repetitions\": %d,\n",
+                vsort_version(), get_num_processors(), (unsigned long long)config->seed, config->warmup, config->reps);
+        fprintf(config->out, "  \"tuning\": {\"insertion_threshold\": %zu, \"parallel_threshold\": %zu, "
+                             "\"radix_threshold\": %zu, \"radix_bits\": %zu},\n  \"results\": [",
+                tuning.insertion_threshold, tuning.parallel_threshold, tuning.radix_threshold, tuning.radix_bits);
+        break;
+    default:
+        fprintf(config->out, "vsort %s, %d core(s), seed %llu, %d warmup + %d timed run(s)\n\n", vsort_version(),
+                get_num_processors(), (unsigned long long)config->seed, config->warmup, config->reps);
+        fprintf(config->out, "%-8s %-16s %12s %7s %-6s %-14s %14s %14s %10s %s\n", "kind", "distribution", "size",
+                "threads", "algo", "engine", "min (ns)", "median (ns)", "Melem/s", "check");
+        break;
+    }
+}
+
+static void bench_footer(const bench_config_t *config)
+{
+    if (config->format == BENCH_FORMAT_JSON)
+        fprintf(config->out, "\n  ]\n}\n");
+}
+
+// Warmup, then config->reps timed samples of one configuration.
+static bool bench_measure(const bench_config_t *config, const bench_kind_t *kind, const char *dist,
+                          bench_algorithm_t algorithm, int threads, unsigned char *work,
+                          const unsigned char *source, size_t count, size_t copies, double *samples, bool *first)
+{
+    bench_result_t result = {
+        .kind = kind->name,
+        .dist = dist,
+        .size = count,
+        .threads = algorithm == BENCH_ALGO_QSORT ? 1 : threads,
+        .algorithm = algorithm == BENCH_ALGO_QSORT ? "qsort" : "vsort",
+        .engine = algorithm == BENCH_ALGO_QSORT ? "qsort" : "-",
+        .sorted = true};
+
+    // The engine is taken from the last warmup run, so timed runs carry no
+    // telemetry overhead.
+    vsort_stats_t stats = {.engine = VSORT_ENGINE_NONE};
+    for (int w = 0; w < config->warmup; w++)
+        bench_run(kind, algorithm, work, source, count, copies, &result.sorted,
+                  algorithm == BENCH_ALGO_VSORT ? &stats : NULL);
+    if (algorithm == BENCH_ALGO_VSORT && config->warmup > 0)
+        result.engine = engine_name(stats.engine);
+
+    double total = 0.0;
+    for (int r = 0; r < config->reps; r++)
+    {
+        samples[r] = bench_run(kind, algorithm, work, source, count, copies, &result.sorted, NULL);
+        total += samples[r];
+    }
+    qsort(samples, (size_t)config->reps, sizeof(double), compare_double);
+
+    int mid = config->reps / 2;
+    result.min_ns = samples[0];
+    result.max_ns = samples[config->reps - 1];
+    result.mean_ns = total / config->reps;
+    result.median_ns = config->reps % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2.0;
+    bench_emit(config, &result, first);
+    return result.sorted;
+}
+
+static bool bench_matrix(const bench_config_t *config)
+{
+    bool all_sorted = true;
+    bool first = true;
+    double *samples = (double *)malloc((size_t)config->reps * sizeof(double));
+    if (!samples)
+        return false;
+
+    bench_header(config);
+    for (size_t k = 0; k < config->kind_count; k++)
+    {
+        const bench_kind_t *kind = config->kinds[k];
+        for (size_t s = 0; s < config->size_count; s++)
+        {
+            size_t count = config->sizes[s];
+            size_t copies = count < BENCH_MIN_BATCH ? BENCH_MIN_BATCH / count : 1;
+            unsigned char *source = (unsigned char *)malloc(count * kind->size);
+            unsigned char *work = (unsigned char *)malloc(count * copies * kind->size);
+            if (!source || !work)
+            {
+                fprintf(stderr, "Skipping %s arrays of %zu elements: out of memory\n", kind->name, count);
+                free(source);
+                free(work);
+                continue;
+            }
+
+            for (size_t d = 0; d < config->dist_count; d++)
+            {
+                // Same seed for every kind and size of a distribution.
+                bench_input_t input = {.data = source, .count = count, .kind = kind, .state = config->seed + d};
+                config->dists[d]->generate(&input);
+
+                for (size_t t = 0; t < config->thread_count; t++)
+                {
+                    vsort_set_thread_count(config->threads[t]);
+                    all_sorted &= bench_measure(config, kind, config->dists[d]->name, BENCH_ALGO_VSORT,
+                                                config->threads[t], work, source, count, copies, samples, &first);
+                }
+                all_sorted &= bench_measure(config, kind, config->dists[d]->name, BENCH_ALGO_QSORT, 1, work,
+                                            source, count, copies, samples, &first);
+            }
+            free(source);
+            free(work);
+        }
+    }
+    bench_footer(config);
+
+    vsort_set_thread_count(0);
+    free(samples);
+    return all_sorted;
+}
+
+// -----------------------------------------------------------------------------
+// Command line
+// -----------------------------------------------------------------------------
+
+static void print_usage(void)
+{
+    printf("Usage: benchmark_suite [options]\n");
+    printf("Options:\n");
+    printf("  --kinds LIST     int32,float32,generic,char (default: all)\n");
+    printf("  --dists LIST     random,sorted,reversed,nearly_sorted,few_unique,duplicates_heavy,\n");
+    printf("                   all_equal,zipf,organ_pipe,sawtooth,median3_killer (default: all)\n");
+    printf("  --sizes LIST     Array sizes, e.g. 10,1e3,1e6,1e9 (default: 10,1000,100000,1000000)\n");
+    printf("  --threads LIST   Thread counts for vsort (default: 1 and every core)\n");
+    printf("  --warmup N       Untimed runs per configuration (default: 1)\n");
+    printf("  --reps N         Timed runs per configuration (default: 5)\n");
+    printf("  --seed N         Input generator seed (default: 42)\n");
+    printf("  --format FORMAT  text, csv or json (default: text)\n");
+    printf("  --output FILE    Write results to FILE instead of stdout\n");
+    printf("  --help           Display this help message\n");
+}
+
+// Splits a comma-separated list in place; returns the number of items.
+static size_t split_list(char *list, char **items, size_t max)
+{
+    size_t count = 0;
+    for (char *item = strtok(list, ","); item && count < max; item = strtok(NULL, ","))
+        items[count++] = item;
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_config_t config = {.warmup = 1, .reps = 5, .seed = 42, .format = BENCH_FORMAT_TEXT, .out = stdout};
+    const char *output = NULL;
+
+    for (size_t k = 0; k < BENCH_KIND_COUNT; k++)
+        config.kinds[config.kind_count++] = &g_kinds[k];
+    for (size_t d = 0; d < BENCH_DIST_COUNT; d++)
+        config.dists[config.dist_count++] = &g_distributions[d];
+    static const size_t default_sizes[] = {10, 1000, 100000, 1000000};
+    for (size_t s = 0; s < sizeof(default_sizes) / sizeof(default_sizes[0]); s++)
+        config.sizes[config.size_count++] = default_sizes[s];
+    config.threads[config.thread_count++] = 1;
+    if (get_num_processors() > 1)
+        config.threads[config.thread_count++] = get_num_processors();
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0)
+        {
+            print_usage();
+            return 0;
+        }
+        if (!value)
+        {
+            fprintf(stderr, "Error: Missing value for '%s'\n", arg);
+            return 1;
+        }
+        i++;
+
+        char *items[BENCH_MAX_LIST];
+        if (strcmp(arg, "--kinds") == 0)
+        {
+            config.kind_count = 0;
+            size_t n = split_list(value, items, BENCH_MAX_LIST);
+            for (size_t j = 0; j < n; j++)
+            {
+                size_t k = 0;
+                while (k < BENCH_KIND_COUNT && strcmp(items[j], g_kinds[k].name) != 0)
+                    k++;
+                if (k == BENCH_KIND_COUNT || config.kind_count == BENCH_KIND_COUNT)
+                {
+                    fprintf(stderr, "Error: Unknown or repeated kind '%s'\n", items[j]);
+                    return 1;
+                }
+                config.kinds[config.kind_count++] = &g_kinds[k];
+            }
+        }
+        else if (strcmp(arg, "--dists") == 0)
+        {
+            config.dist_count = 0;
+            size_t n = split_list(value, items, BENCH_MAX_LIST);
+            for (size_t j = 0; j < n; j++)
+            {
+                size_t d = 0;
+                while (d < BENCH_DIST_COUNT && strcmp(items[j], g_distributions[d].name) != 0)
+                    d++;
+                if (d == BENCH_DIST_COUNT || config.dist_count == BENCH_DIST_COUNT)
+                {
+                    fprintf(stderr, "Error: Unknown or repeated distribution '%s'\n", items[j]);
+                    return 1;
+                }
+                config.dists[config.dist_count++] = &g_distributions[d];
+            }
+        }
+        else if (strcmp(arg, "--sizes") == 0)
+        {
+            config.size_count = split_list(value, items, BENCH_MAX_LIST);
+            for (size_t j = 0; j < config.size_count; j++)
+            {
+                double size = strtod(items[j], NULL);
+                if (size < 1.0)
+                {
+                    fprintf(stderr, "Error: Invalid size '%s'\n", items[j]);
+                    return 1;
+                }
+                config.sizes[j] = (size_t)size;
+            }
+        }
+        else if (strcmp(arg, "--threads") == 0)
+        {
+            config.thread_count = split_list(value, items, BENCH_MAX_LIST);
+            for (size_t j = 0; j < config.thread_count; j++)
+            {
+                config.threads[j] = atoi(items[j]);
+                if (config.threads[j] < 1)
+                {
+                    fprintf(stderr, "Error: Invalid thread count '%s'\n", items[j]);
+                    return 1;
+                }
+            }
+        }
+        else if (strcmp(arg, "--warmup") == 0)
+            config.warmup = atoi(value) > 0 ? atoi(value) : 0;
+        else if (strcmp(arg, "--reps") == 0)
+            config.reps = atoi(value) > 0 ? atoi(value) : 1;
+        else if (strcmp(arg, "--seed") == 0)
+            config.seed = strtoull(value, NULL, 10);
+        else if (strcmp(arg, "--format") == 0)
+        {
+            if (strcmp(value, "text") == 0)
+                config.format = BENCH_FORMAT_TEXT;
+            else if (strcmp(value, "csv") == 0)
+                config.format = BENCH_FORMAT_CSV;
+            else if (strcmp(value, "json") == 0)
+                config.format = BENCH_FORMAT_JSON;
+            else
+            {
+                fprintf(stderr, "Error: Unknown format '%s'\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(arg, "--output") == 0)
+            output = value;
+        else
+        {
+            fprintf(stderr, "Error: Unknown option '%s'\n", arg);
+            return 1;
+        }
+    }
+
+    if (config.kind_count == 0 || config.dist_count == 0 || config.size_count == 0 || config.thread_count == 0)
+    {
+        fprintf(stderr, "Error: Empty kind, distribution, size or thread list\n");
+        return 1;
+    }
+
+    if (output)
+    {
+        config.out = fopen(output, "w");
+        if (!config.out)
+        {
+            fprintf(stderr, "Error: Cannot open '%s' for writing\n", output);
+            return 1;
+        }
+    }
+
+    bool sorted = bench_matrix(&config);
+    if (output)
+        fclose(config.out);
+    if (!sorted)
+        fprintf(stderr, "Error: Some runs did not produce sorted output\n");
+    return sorted ? 0 : 1;
+}
@@ -5,6 +5,9 @@
  * sizes and patterns.
  */
 
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -187,6 +190,1515 @@ static int test_sort_duplicate_values()
     return 1;
 }
 
+static int test_radix_key_ranges()
+{
+    printf("Testing radix sort key ranges... ");
+
+    int n = (1 << 22) + 9;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = (size_t)n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_RADIX};
+
+    // Narrow timestamp-like range (constant high digits) then full 32-bit range
+    for (int round = 0; round < 2; round++)
+    {
+        for (int i = 0; i < n; i++)
+            arr[i] = round == 0 ? 1700000000 + rand() % 4096 : (int)(((unsigned)rand() << 16) ^ (unsigned)rand());
+        arr[n / 2] = round == 0 ? 1700000000 : -2147483647 - 1;
+
+        if (vsort_sort(&options) != VSORT_OK || !is_sorted(arr, n))
+        {
+            printf("FAILED: Radix round %d produced unsorted output\n", round);
+            free(arr);
+            return 0;
+        }
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+// IEEE-754 total order key, used to check the float radix path bit-exactly
+static unsigned int float_order_key(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+static int test_float_radix_total_order()
+{
+    printf("Testing float radix total order... ");
+
+    unsigned int specials[] = {0x00000000u, 0x80000000u, 0x7F800000u, 0xFF800000u, 0x7FC00000u, 0xFFC00000u, 0x00000001u};
+    int special_count = sizeof(specials) / sizeof(specials[0]);
+    unsigned int flag_sets[] = {VSORT_FLAG_ALLOW_RADIX, VSORT_FLAG_ALLOW_RADIX | VSORT_FLAG_LOW_MEMORY};
+
+    int n = (1 << 22) + 3;
+    float *arr = (float *)malloc(n * sizeof(float));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (int f = 0; f < 2; f++)
+    {
+        for (int i = 0; i < n; i++)
+            arr[i] = ((float)rand() / (float)RAND_MAX - 0.5f) * 1.0e6f;
+        for (int i = 0; i < special_count * 64; i++)
+            memcpy(&arr[rand() % n], &specials[i % special_count], sizeof(float));
+
+        vsort_options_t options = {
+            .data = arr,
+            .length = (size_t)n,
+            .element_size = sizeof(float),
+            .kind = VSORT_KIND_FLOAT32,
+            .comparator = NULL,
+            .flags = flag_sets[f]};
+
+        if (vsort_sort(&options) != VSORT_OK)
+        {
+            printf("FAILED: vsort_sort returned an error\n");
+            free(arr);
+            return 0;
+        }
+
+        for (int i = 1; i < n; i++)
+        {
+            if (float_order_key(arr[i]) < float_order_key(arr[i - 1]))
+            {
+                printf("FAILED: Total order violated at index %d (flags %u)\n", i, flag_sets[f]);
+                free(arr);
+                return 0;
+            }
+        }
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_low_memory_radix()
+{
+    printf("Testing in-place radix sort... ");
+
+    int n = (1 << 22) + 5;
+    int *arr = create_random_array(n, 1 << 30);
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (int i = 0; i < n; i += 3)
+        arr[i] = -arr[i];
+    arr[0] = -2147483647 - 1;
+    arr[1] = 2147483647;
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = (size_t)n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_RADIX | VSORT_FLAG_LOW_MEMORY};
+
+    if (vsort_sort(&options) != VSORT_OK || !is_sorted(arr, n))
+    {
+        printf("FAILED: In-place radix produced unsorted output\n");
+        free(arr);
+        return 0;
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static uint64_t random_word64(int narrow)
+{
+    uint64_t word = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+    return narrow ? word % 2001 : word;
+}
+
+static int test_sort_64bit_kinds()
+{
+    printf("Testing int64/uint64/double sort... ");
+
+    // Sizes cover the insertion-sort leaves, the vector partition and both
+    // radix engines; narrow values leave most radix passes constant.
+    size_t sizes[] = {37, 1000, ((size_t)1 << 21) + 3};
+    unsigned int flag_sets[] = {VSORT_FLAG_FORCE_SIMD, VSORT_FLAG_ALLOW_RADIX, VSORT_FLAG_ALLOW_RADIX | VSORT_FLAG_LOW_MEMORY};
+    size_t max_n = sizes[2];
+    uint64_t *words = (uint64_t *)malloc(max_n * sizeof(uint64_t));
+    if (!words)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (int f = 0; f < 3; f++)
+        {
+            for (int kind = 0; kind < 3; kind++)
+            {
+                size_t n = sizes[s];
+                int narrow = (s + f + kind) % 2;
+                uint64_t checksum = 0;
+                for (size_t i = 0; i < n; i++)
+                {
+                    uint64_t word = random_word64(narrow);
+                    if (kind == 0 && narrow)
+                        word -= 1000;
+                    if (kind == 2)
+                    {
+                        double value = ((double)(int64_t)(word >> 1) - (double)(INT64_MAX / 2)) * (narrow ? 1e-18 : 1e60);
+                        memcpy(&word, &value, sizeof(word));
+                    }
+                    words[i] = word;
+                    checksum += word;
+                }
+
+                static const vsort_data_kind_t kinds[] = {VSORT_KIND_INT64, VSORT_KIND_UINT64, VSORT_KIND_FLOAT64};
+                vsort_options_t options = {
+                    .data = words,
+                    .length = n,
+                    .element_size = sizeof(uint64_t),
+                    .kind = kinds[kind],
+                    .comparator = NULL,
+                    .flags = flag_sets[f]};
+
+                int ok = vsort_sort(&options) == VSORT_OK;
+                uint64_t after = 0;
+                for (size_t i = 0; i < n; i++)
+                    after += words[i];
+                ok = ok && after == checksum;
+                for (size_t i = 1; ok && i < n; i++)
+                {
+                    if (kind == 0)
+                        ok = (int64_t)words[i - 1] <= (int64_t)words[i];
+                    else if (kind == 1)
+                        ok = words[i - 1] <= words[i];
+                    else
+                    {
+                        double a;
+                        double b;
+                        memcpy(&a, &words[i - 1], sizeof(a));
+                        memcpy(&b, &words[i], sizeof(b));
+                        ok = a <= b;
+                    }
+                }
+
+                if (!ok)
+                {
+                    printf("FAILED: Kind %d, size %zu, flags %u not sorted correctly\n", kind, n, flag_sets[f]);
+                    free(words);
+                    return 0;
+                }
+            }
+        }
+    }
+
+    free(words);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_simd_partition()
+{
+    printf("Testing vectorized partition on small ranges... ");
+
+    // Sizes straddle the vector widths so the buffered ends, the unread tail
+    // and the scalar fallback all get exercised.
+    for (int n = 2; n <= 600; n += 7)
+    {
+        int *arr = create_random_array(n, 16);
+        float *farr = (float *)malloc((size_t)n * sizeof(float));
+        if (!arr || !farr)
+        {
+            printf("FAILED: Memory allocation error\n");
+            free(arr);
+            free(farr);
+            return 0;
+        }
+
+        for (int i = 0; i < n; i++)
+            farr[i] = (float)(arr[i] - 8) * 0.5f;
+
+        vsort_options_t options = {
+            .data = arr,
+            .length = (size_t)n,
+            .element_size = sizeof(int),
+            .kind = VSORT_KIND_INT32,
+            .comparator = NULL,
+            .flags = VSORT_FLAG_FORCE_SIMD};
+        vsort_result_t int_result = vsort_sort(&options);
+
+        options.data = farr;
+        options.element_size = sizeof(float);
+        options.kind = VSORT_KIND_FLOAT32;
+        vsort_result_t float_result = vsort_sort(&options);
+
+        int ok = int_result == VSORT_OK && float_result == VSORT_OK && is_sorted(arr, n);
+        for (int i = 1; ok && i < n; i++)
+            ok = farr[i - 1] <= farr[i];
+
+        free(arr);
+        free(farr);
+        if (!ok)
+        {
+            printf("FAILED: Array of size %d not sorted correctly\n", n);
+            return 0;
+        }
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_small_float_leaves()
+{
+    printf("Testing small float arrays with special values... ");
+
+    const float specials[] = {INFINITY, -INFINITY, 0.0f, -0.0f, 1e-40f, -1e-40f, 2.5f, -2.5f};
+    for (int n = 1; n <= 64; n++)
+    {
+        float arr[64];
+        int negative_zeros = 0;
+        for (int i = 0; i < n; i++)
+        {
+            arr[i] = (rand() % 3 == 0) ? specials[rand() % 8] : (float)(rand() % 200 - 100);
+            negative_zeros += (arr[i] == 0.0f && signbit(arr[i]));
+        }
+
+        vsort_float(arr, n);
+
+        int after = 0;
+        for (int i = 0; i < n; i++)
+        {
+            after += (arr[i] == 0.0f && signbit(arr[i]));
+            if (i > 0 && arr[i - 1] > arr[i])
+            {
+                printf("FAILED: Array of size %d not sorted correctly\n", n);
+                return 0;
+            }
+        }
+        if (after != negative_zeros)
+        {
+            printf("FAILED: Signed zeros lost for size %d\n", n);
+            return 0;
+        }
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_presorted_runs()
+{
+    printf("Testing presorted and run-structured inputs... ");
+
+    const char *names[] = {"sorted with swaps", "concatenated runs", "descending runs", "locally shuffled"};
+    int n = 1000003;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (int pattern = 0; pattern < 4; pattern++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            switch (pattern)
+            {
+            case 0:
+                arr[i] = i;
+                break;
+            case 1:
+                arr[i] = i % 100000;
+                break;
+            case 2:
+                arr[i] = 100000 - i % 100000;
+                break;
+            default:
+                arr[i] = i / 64 * 64 + rand() % 64;
+                break;
+            }
+        }
+        if (pattern == 0)
+        {
+            for (int k = 0; k < 20; k++)
+            {
+                int a = rand() % n;
+                int b = rand() % n;
+                int tmp = arr[a];
+                arr[a] = arr[b];
+                arr[b] = tmp;
+            }
+        }
+
+        long long before = 0;
+        for (int i = 0; i < n; i++)
+            before += arr[i];
+
+        vsort(arr, n);
+
+        long long after = 0;
+        for (int i = 0; i < n; i++)
+            after += arr[i];
+        if (!is_sorted(arr, n) || after != before)
+        {
+            printf("FAILED: %s input not sorted correctly\n", names[pattern]);
+            free(arr);
+            return 0;
+        }
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_adversarial_patterns()
+{
+    printf("Testing low-cardinality and patterned inputs... ");
+
+    const char *names[] = {"all equal", "two values", "organ pipe", "sawtooth", "low cardinality"};
+    int n = 200003;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (int pattern = 0; pattern < 5; pattern++)
+    {
+        long long before = 0;
+        for (int i = 0; i < n; i++)
+        {
+            switch (pattern)
+            {
+            case 0:
+                arr[i] = 42;
+                break;
+            case 1:
+                arr[i] = rand() & 1;
+                break;
+            case 2:
+                arr[i] = i < n / 2 ? i : n - i;
+                break;
+            case 3:
+                arr[i] = i % 257;
+                break;
+            default:
+                arr[i] = rand() % 16;
+                break;
+            }
+            before += arr[i];
+        }
+
+        vsort_options_t options = {
+            .data = arr,
+            .length = (size_t)n,
+            .element_size = sizeof(int),
+            .kind = VSORT_KIND_INT32,
+            .comparator = NULL,
+            .flags = 0};
+
+        vsort_result_t result = vsort_sort(&options);
+        long long after = 0;
+        for (int i = 0; i < n; i++)
+            after += arr[i];
+        if (result != VSORT_OK || !is_sorted(arr, n) || after != before)
+        {
+            printf("FAILED: %s input not sorted correctly\n", names[pattern]);
+            free(arr);
+            return 0;
+        }
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+typedef struct
+{
+    int key;
+    int sequence;
+    char payload[16];
+} generic_record_t;
+
+static int compare_record_key(const void *a, const void *b)
+{
+    const generic_record_t *x = (const generic_record_t *)a;
+    const generic_record_t *y = (const generic_record_t *)b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static int compare_int_value(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int test_generic_engine()
+{
+    printf("Testing generic comparator engine... ");
+
+    int n = 50021;
+    generic_record_t *records = (generic_record_t *)malloc(n * sizeof(generic_record_t));
+    int *values = create_random_array(n, 1000000);
+    if (!records || !values)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(records);
+        free(values);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        records[i].key = rand() % 500;
+        records[i].sequence = i;
+        memset(records[i].payload, i & 0x7F, sizeof(records[i].payload));
+    }
+
+    vsort_options_t options = {
+        .data = records,
+        .length = (size_t)n,
+        .element_size = sizeof(generic_record_t),
+        .kind = VSORT_KIND_GENERIC,
+        .comparator = compare_record_key,
+        .flags = VSORT_FLAG_FORCE_STABLE};
+
+    if (vsort_sort(&options) != VSORT_OK)
+    {
+        printf("FAILED: Generic sort returned an error\n");
+        free(records);
+        free(values);
+        return 0;
+    }
+
+    for (int i = 1; i < n; i++)
+    {
+        const generic_record_t *prev = &records[i - 1];
+        const generic_record_t *cur = &records[i];
+        if (prev->key > cur->key || (prev->key == cur->key && prev->sequence > cur->sequence) ||
+            cur->payload[15] != (char)(cur->sequence & 0x7F))
+        {
+            printf("FAILED: Records not stably sorted at %d\n", i);
+            free(records);
+            free(values);
+            return 0;
+        }
+    }
+
+    vsort_with_comparator(values, n, sizeof(int), compare_int_value);
+    if (!is_sorted(values, n))
+    {
+        printf("FAILED: Comparator sort of ints not sorted correctly\n");
+        free(records);
+        free(values);
+        return 0;
+    }
+
+    free(records);
+    free(values);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_argsort()
+{
+    printf("Testing argsort... ");
+
+    int n = 30011;
+    int *values = create_random_array(n, 700);
+    float *floats = (float *)malloc(n * sizeof(float));
+    generic_record_t *records = (generic_record_t *)malloc(n * sizeof(generic_record_t));
+    size_t *order = (size_t *)malloc(n * sizeof(size_t));
+    uint32_t *narrow = (uint32_t *)malloc(n * sizeof(uint32_t));
+    if (!values || !floats || !records || !order || !narrow)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(values);
+        free(floats);
+        free(records);
+        free(order);
+        free(narrow);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        values[i] -= 350;
+        floats[i] = (float)(rand() % 1001 - 500) * 0.25f;
+        records[i].key = rand() % 300;
+        records[i].sequence = i;
+    }
+
+    int ok = 1;
+    vsort_options_t options = {
+        .data = values,
+        .length = (size_t)n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = 0};
+    ok &= vsort_argsort(&options, order, VSORT_INDEX_SIZE) == VSORT_OK;
+    for (int i = 1; ok && i < n; i++)
+        ok = values[order[i - 1]] < values[order[i]] || (values[order[i - 1]] == values[order[i]] && order[i - 1] < order[i]);
+
+    options.data = floats;
+    options.element_size = sizeof(float);
+    options.kind = VSORT_KIND_FLOAT32;
+    ok &= vsort_argsort(&options, narrow, VSORT_INDEX_UINT32) == VSORT_OK;
+    for (int i = 1; ok && i < n; i++)
+        ok = floats[narrow[i - 1]] < floats[narrow[i]] || (floats[narrow[i - 1]] == floats[narrow[i]] && narrow[i - 1] < narrow[i]);
+
+    options.data = records;
+    options.element_size = sizeof(generic_record_t);
+    options.kind = VSORT_KIND_GENERIC;
+    options.comparator = compare_record_key;
+    ok &= vsort_argsort(&options, order, VSORT_INDEX_SIZE) == VSORT_OK;
+    for (int i = 1; ok && i < n; i++)
+        ok = records[order[i - 1]].key < records[order[i]].key ||
+             (records[order[i - 1]].key == records[order[i]].key && order[i - 1] < order[i]);
+    for (int i = 0; ok && i < n; i++)
+        ok = records[i].sequence == i;
+
+    free(values);
+    free(floats);
+    free(records);
+    free(order);
+    free(narrow);
+
+    if (!ok)
+    {
+        printf("FAILED: Permutation does not stably sort the input\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+typedef struct
+{
+    double weight;
+    int sequence;
+    float score;
+    long long id;
+} keyed_record_t;
+
+static int test_sort_by_key()
+{
+    printf("Testing key-extraction sort... ");
+
+    size_t n = 40013;
+    keyed_record_t *records = (keyed_record_t *)malloc(n * sizeof(keyed_record_t));
+    if (!records)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        records[i].weight = (double)(rand() % 2001 - 1000) / 8.0;
+        records[i].sequence = (int)i;
+        records[i].score = (float)(rand() % 301 - 150) * 0.5f;
+        records[i].id = ((long long)(rand() % 64) - 32) * ((long long)1 << 40);
+    }
+
+    vsort_key_options_t options = {
+        .data = records,
+        .length = n,
+        .element_size = sizeof(keyed_record_t),
+        .key_offset = offsetof(keyed_record_t, score),
+        .key_type = VSORT_KEY_FLOAT32,
+        .order = VSORT_ORDER_DESCENDING,
+        .flags = 0};
+
+    if (vsort_sort_by_key(&options) != VSORT_OK)
+    {
+        printf("FAILED: Float key sort returned an error\n");
+        free(records);
+        return 0;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        if (records[i - 1].score < records[i].score ||
+            (records[i - 1].score == records[i].score && records[i - 1].sequence > records[i].sequence))
+        {
+            printf("FAILED: Descending float keys not stably sorted at %zu\n", i);
+            free(records);
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+        records[i].sequence = (int)i;
+    options.key_offset = offsetof(keyed_record_t, id);
+    options.key_type = VSORT_KEY_INT64;
+    options.order = VSORT_ORDER_ASCENDING;
+    options.flags = VSORT_FLAG_LOW_MEMORY;
+    if (vsort_sort_by_key(&options) != VSORT_OK)
+    {
+        printf("FAILED: Int64 key sort returned an error\n");
+        free(records);
+        return 0;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        if (records[i - 1].id > records[i].id ||
+            (records[i - 1].id == records[i].id && records[i - 1].sequence > records[i].sequence))
+        {
+            printf("FAILED: Int64 keys not stably sorted at %zu\n", i);
+            free(records);
+            return 0;
+        }
+    }
+
+    options.key_offset = offsetof(keyed_record_t, weight);
+    options.key_type = VSORT_KEY_FLOAT64;
+    options.flags = 0;
+    if (vsort_sort_by_key(&options) != VSORT_OK)
+    {
+        printf("FAILED: Double key sort returned an error\n");
+        free(records);
+        return 0;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        if (records[i - 1].weight > records[i].weight)
+        {
+            printf("FAILED: Double keys not sorted at %zu\n", i);
+            free(records);
+            return 0;
+        }
+    }
+
+    options.key_offset = sizeof(keyed_record_t) - 2;
+    if (vsort_sort_by_key(&options) != VSORT_ERR_INVALID_ARGUMENT)
+    {
+        printf("FAILED: Out-of-record key accepted\n");
+        free(records);
+        return 0;
+    }
+
+    free(records);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_sort_kv()
+{
+    printf("Testing key-value sort... ");
+
+    // Values start out as positions, so they must keep tied keys in order
+    // and still name the key they travelled with.
+    int n = 50007;
+    int *keys = (int *)malloc(n * sizeof(int));
+    int *original = (int *)malloc(n * sizeof(int));
+    unsigned int *values32 = (unsigned int *)malloc(n * sizeof(unsigned int));
+    double *dkeys = (double *)malloc(n * sizeof(double));
+    double *doriginal = (double *)malloc(n * sizeof(double));
+    uint64_t *values64 = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!keys || !original || !values32 || !dkeys || !doriginal || !values64)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(keys);
+        free(original);
+        free(values32);
+        free(dkeys);
+        free(doriginal);
+        free(values64);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        keys[i] = original[i] = rand() % 1000 - 500;
+        dkeys[i] = doriginal[i] = (double)(rand() % 2000 - 1000) * 0.25;
+        values32[i] = (unsigned int)i;
+        values64[i] = (uint64_t)i << 32;
+    }
+
+    vsort_kv_options_t options = {
+        .keys = keys,
+        .values = values32,
+        .length = (size_t)n,
+        .key_type = VSORT_KEY_INT32,
+        .value_size = sizeof(unsigned int),
+        .order = VSORT_ORDER_ASCENDING,
+        .flags = 0};
+    int ok = vsort_sort_kv(&options) == VSORT_OK;
+    for (int i = 0; ok && i < n; i++)
+        ok = keys[i] == original[values32[i]] &&
+             (i == 0 || keys[i - 1] < keys[i] || (keys[i - 1] == keys[i] && values32[i - 1] < values32[i]));
+
+    options.keys = dkeys;
+    options.values = values64;
+    options.key_type = VSORT_KEY_FLOAT64;
+    options.value_size = sizeof(uint64_t);
+    options.order = VSORT_ORDER_DESCENDING;
+    ok = ok && vsort_sort_kv(&options) == VSORT_OK;
+    for (int i = 0; ok && i < n; i++)
+        ok = dkeys[i] == doriginal[values64[i] >> 32] &&
+             (i == 0 || dkeys[i - 1] > dkeys[i] || (dkeys[i - 1] == dkeys[i] && values64[i - 1] < values64[i]));
+
+    options.value_size = 3;
+    ok = ok && vsort_sort_kv(&options) == VSORT_ERR_INVALID_ARGUMENT;
+
+    free(keys);
+    free(original);
+    free(values32);
+    free(dkeys);
+    free(doriginal);
+    free(values64);
+    if (!ok)
+    {
+        printf("FAILED: Keys and values not sorted together\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_selection()
+{
+    printf("Testing nth_element and partial_sort... ");
+
+    // Each pattern is checked against a fully sorted copy: nth_element must
+    // put the right value at nth with the sides split around it, and
+    // partial_sort must reproduce the sorted prefix.
+    int sizes[] = {1, 2, 37, 1000, 100003};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int n = sizes[s];
+        int *arr = (int *)malloc(n * sizeof(int));
+        int *sorted = (int *)malloc(n * sizeof(int));
+        double *darr = (double *)malloc(n * sizeof(double));
+        if (!arr || !sorted || !darr)
+        {
+            printf("FAILED: Memory allocation error\n");
+            free(arr);
+            free(sorted);
+            free(darr);
+            return 0;
+        }
+
+        for (int pattern = 0; pattern < 4; pattern++)
+        {
+            for (int i = 0; i < n; i++)
+                sorted[i] = pattern == 0 ? rand() % 100000 - 50000 : (pattern == 1 ? i : (pattern == 2 ? n - i : rand() % 3));
+            vsort(sorted, n);
+
+            size_t ranks[] = {0, (size_t)n / 2, (size_t)n * 99 / 100, (size_t)n - 1};
+            for (int r = 0; r < 4; r++)
+            {
+                size_t nth = ranks[r];
+                // Copies of the reference hold the same multiset: ascending,
+                // descending, or shuffled for the random patterns.
+                for (int i = 0; i < n; i++)
+                    arr[i] = pattern == 2 ? sorted[n - 1 - i] : sorted[i];
+                for (int i = n - 1; (pattern == 0 || pattern == 3) && i > 0; i--)
+                {
+                    int j = rand() % (i + 1);
+                    int tmp = arr[i];
+                    arr[i] = arr[j];
+                    arr[j] = tmp;
+                }
+                for (int i = 0; i < n; i++)
+                    darr[i] = (double)arr[i] * 0.5;
+
+                vsort_options_t options = {
+                    .data = arr,
+                    .length = (size_t)n,
+                    .element_size = sizeof(int),
+                    .kind = VSORT_KIND_INT32,
+                    .comparator = NULL,
+                    .flags = 0};
+                int ok = vsort_nth_element(&options, nth) == VSORT_OK && arr[nth] == sorted[nth];
+                for (int i = 0; ok && i < n; i++)
+                    ok = (size_t)i < nth ? arr[i] <= arr[nth] : arr[i] >= arr[nth];
+
+                options.data = darr;
+                options.element_size = sizeof(double);
+                options.kind = VSORT_KIND_FLOAT64;
+                ok = ok && vsort_partial_sort(&options, nth + 1) == VSORT_OK;
+                for (size_t i = 0; ok && i <= nth; i++)
+                    ok = darr[i] == (double)sorted[i] * 0.5;
+
+                options.data = arr;
+                options.element_size = sizeof(int);
+                options.kind = VSORT_KIND_GENERIC;
+                options.comparator = compare_int_value;
+                ok = ok && vsort_partial_sort(&options, nth + 1) == VSORT_OK;
+                for (size_t i = 0; ok && i <= nth; i++)
+                    ok = arr[i] == sorted[i];
+
+                if (!ok)
+                {
+                    printf("FAILED: Size %d, pattern %d, rank %zu\n", n, pattern, nth);
+                    free(arr);
+                    free(sorted);
+                    free(darr);
+                    return 0;
+                }
+            }
+        }
+
+        free(arr);
+        free(sorted);
+        free(darr);
+    }
+
+    int value = 1;
+    vsort_options_t options = {
+        .data = &value,
+        .length = 1,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = 0};
+    if (vsort_nth_element(&options, 1) != VSORT_ERR_INVALID_ARGUMENT || vsort_partial_sort(&options, 2) != VSORT_ERR_INVALID_ARGUMENT)
+    {
+        printf("FAILED: Out-of-range rank accepted\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_merge_runs()
+{
+    printf("Testing K-way merge of sorted runs... ");
+
+    // Runs of uneven length, one of them empty, merged against a full sort.
+    size_t lengths[] = {500, 0, 1, 3000, 77, 1200, 64};
+    size_t run_count = sizeof(lengths) / sizeof(lengths[0]);
+    size_t total = 0;
+    for (size_t r = 0; r < run_count; r++)
+        total += lengths[r];
+
+    int *input = (int *)malloc(total * sizeof(int));
+    int *merged = (int *)malloc(total * sizeof(int));
+    double *input64 = (double *)malloc(total * sizeof(double));
+    double *merged64 = (double *)malloc(total * sizeof(double));
+    if (!input || !merged || !input64 || !merged64)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(input);
+        free(merged);
+        free(input64);
+        free(merged64);
+        return 0;
+    }
+
+    vsort_sorted_run_t runs[7];
+    vsort_sorted_run_t runs64[7];
+    vsort_options_t sort_options = {.element_size = 0, .comparator = NULL, .flags = 0};
+    int ok = 1;
+    size_t offset = 0;
+    for (size_t r = 0; r < run_count; r++)
+    {
+        for (size_t i = offset; i < offset + lengths[r]; i++)
+        {
+            input[i] = rand() % 4001 - 2000;
+            input64[i] = (double)(rand() % 4001 - 2000) / 8.0;
+        }
+        sort_options.data = input + offset;
+        sort_options.length = lengths[r];
+        sort_options.kind = VSORT_KIND_INT32;
+        ok = ok && vsort_sort(&sort_options) == VSORT_OK;
+        sort_options.data = input64 + offset;
+        sort_options.kind = VSORT_KIND_FLOAT64;
+        ok = ok && vsort_sort(&sort_options) == VSORT_OK;
+        runs[r].data = input + offset;
+        runs[r].length = lengths[r];
+        runs64[r].data = input64 + offset;
+        runs64[r].length = lengths[r];
+        offset += lengths[r];
+    }
+
+    vsort_merge_options_t options = {
+        .runs = runs,
+        .run_count = run_count,
+        .output = merged,
+        .kind = VSORT_KIND_INT32,
+        .flags = 0};
+    ok = ok && vsort_merge_runs(&options) == VSORT_OK;
+
+    options.runs = runs64;
+    options.output = merged64;
+    options.kind = VSORT_KIND_FLOAT64;
+    ok = ok && vsort_merge_runs(&options) == VSORT_OK;
+
+    // The concatenation sorted from scratch is the reference.
+    sort_options.data = input;
+    sort_options.length = total;
+    sort_options.kind = VSORT_KIND_INT32;
+    ok = ok && vsort_sort(&sort_options) == VSORT_OK && memcmp(input, merged, total * sizeof(int)) == 0;
+    sort_options.data = input64;
+    sort_options.kind = VSORT_KIND_FLOAT64;
+    ok = ok && vsort_sort(&sort_options) == VSORT_OK && memcmp(input64, merged64, total * sizeof(double)) == 0;
+
+    // A single run is copied; no runs or only empty ones need no output.
+    options.runs = runs + 3;
+    options.run_count = 1;
+    options.output = merged;
+    options.kind = VSORT_KIND_INT32;
+    ok = ok && vsort_merge_runs(&options) == VSORT_OK && memcmp(merged, runs[3].data, lengths[3] * sizeof(int)) == 0;
+    options.runs = runs + 1;
+    options.output = NULL;
+    ok = ok && vsort_merge_runs(&options) == VSORT_OK;
+    options.run_count = 0;
+    ok = ok && vsort_merge_runs(&options) == VSORT_OK;
+
+    options.runs = runs;
+    options.run_count = run_count;
+    ok = ok && vsort_merge_runs(&options) == VSORT_ERR_INVALID_ARGUMENT;
+    options.output = merged;
+    options.kind = VSORT_KIND_GENERIC;
+    ok = ok && vsort_merge_runs(&options) == VSORT_ERR_UNSUPPORTED_TYPE;
+    ok = ok && vsort_merge_runs(NULL) == VSORT_ERR_INVALID_ARGUMENT;
+
+    free(input);
+    free(merged);
+    free(input64);
+    free(merged64);
+    if (!ok)
+    {
+        printf("FAILED: Merged output does not match the sorted concatenation\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_stream()
+{
+    printf("Testing streaming sort... ");
+
+    // Batch sizes mix staged pushes with runs of their own; enough of them
+    // to cascade a couple of merge levels.
+    size_t batches[] = {1, 0, 700, 5000, 65535, 2, 70000, 300, 131072};
+    size_t batch_count = sizeof(batches) / sizeof(batches[0]);
+    size_t rounds = 12;
+    size_t total = 0;
+    for (size_t b = 0; b < batch_count; b++)
+        total += batches[b] * rounds;
+
+    int *pushed = (int *)malloc(total * sizeof(int));
+    int *sorted = (int *)malloc(total * sizeof(int));
+    vsort_stream_t *stream = NULL;
+    if (!pushed || !sorted || vsort_stream_create(&stream, VSORT_KIND_INT32, 0) != VSORT_OK)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(pushed);
+        free(sorted);
+        return 0;
+    }
+
+    for (size_t i = 0; i < total; i++)
+        pushed[i] = rand() % 100000 - 50000;
+
+    int ok = 1;
+    // The second window reuses the stream after finalize.
+    for (int window = 0; ok && window < 2; window++)
+    {
+        size_t offset = 0;
+        for (size_t r = 0; ok && r < rounds; r++)
+        {
+            for (size_t b = 0; ok && b < batch_count; b++)
+            {
+                ok = vsort_stream_push(stream, pushed + offset, batches[b]) == VSORT_OK;
+                offset += batches[b];
+            }
+        }
+        ok = ok && vsort_stream_length(stream) == total;
+        ok = ok && vsort_stream_finalize(stream, sorted) == VSORT_OK && vsort_stream_length(stream) == 0;
+        for (size_t i = 1; ok && i < total; i++)
+            ok = sorted[i - 1] <= sorted[i];
+    }
+
+    vsort_options_t options = {
+        .data = pushed,
+        .length = total,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = 0};
+    ok = ok && vsort_sort(&options) == VSORT_OK && memcmp(pushed, sorted, total * sizeof(int)) == 0;
+
+    // An empty window needs no output; bad arguments are rejected.
+    ok = ok && vsort_stream_finalize(stream, NULL) == VSORT_OK;
+    ok = ok && vsort_stream_push(stream, NULL, 4) == VSORT_ERR_INVALID_ARGUMENT;
+    ok = ok && vsort_stream_push(stream, pushed, 4) == VSORT_OK;
+    ok = ok && vsort_stream_finalize(stream, NULL) == VSORT_ERR_INVALID_ARGUMENT;
+    vsort_stream_destroy(stream);
+
+    ok = ok && vsort_stream_create(&stream, VSORT_KIND_GENERIC, 0) == VSORT_ERR_UNSUPPORTED_TYPE && stream == NULL;
+    ok = ok && vsort_stream_create(NULL, VSORT_KIND_INT32, 0) == VSORT_ERR_INVALID_ARGUMENT;
+
+    free(pushed);
+    free(sorted);
+    if (!ok)
+    {
+        printf("FAILED: Finalized output does not match the sorted input\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_context()
+{
+    printf("Testing sort context scratch arena... ");
+
+    size_t n = 200000;
+    int *arr = (int *)malloc(n * sizeof(int));
+    size_t *order = (size_t *)malloc(n * sizeof(size_t));
+    vsort_context_t *context = NULL;
+    if (!arr || !order || vsort_context_create(&context, 0) != VSORT_OK)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        free(order);
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_FORCE_STABLE};
+
+    // The first call grows the arena to its peak; the same workload then
+    // fits without changing it.
+    int ok = 1;
+    size_t capacity = 0;
+    unsigned int flag_sets[] = {VSORT_FLAG_FORCE_STABLE, VSORT_FLAG_ALLOW_RADIX};
+    for (int round = 0; ok && round < 3; round++)
+    {
+        for (int f = 0; ok && f < 2; f++)
+        {
+            for (size_t i = 0; i < n; i++)
+                arr[i] = rand() % 100000 - 50000;
+            options.flags = flag_sets[f];
+            ok = vsort_sort_with_context(context, &options) == VSORT_OK && is_sorted(arr, (int)n);
+        }
+        ok = ok && vsort_context_capacity(context) >= vsort_context_peak(context) && vsort_context_peak(context) > 0;
+        ok = ok && (round == 0 || vsort_context_capacity(context) == capacity);
+        capacity = vsort_context_capacity(context);
+    }
+
+    // A bound context serves the other entry points as well.
+    ok = ok && vsort_context_bind(context) == NULL;
+    options.flags = 0;
+    ok = ok && vsort_argsort(&options, order, VSORT_INDEX_SIZE) == VSORT_OK;
+    for (size_t i = 1; ok && i < n; i++)
+        ok = arr[order[i - 1]] <= arr[order[i]];
+    ok = ok && vsort_context_bind(NULL) == context;
+    ok = ok && vsort_context_reserve(context, capacity * 2) == VSORT_OK && vsort_context_capacity(context) >= capacity * 2;
+    vsort_context_destroy(context);
+
+    // Caller memory never grows; overflow is served from the heap.
+    static unsigned char memory[1 << 16];
+    ok = ok && vsort_context_create_with_memory(&context, memory, sizeof(memory)) == VSORT_OK;
+    for (size_t i = 0; ok && i < n; i++)
+        arr[i] = rand();
+    options.flags = VSORT_FLAG_FORCE_STABLE;
+    ok = ok && vsort_sort_with_context(context, &options) == VSORT_OK && is_sorted(arr, (int)n);
+    options.length = 8000;
+    ok = ok && vsort_sort_with_context(context, &options) == VSORT_OK && is_sorted(arr, 8000);
+    ok = ok && vsort_context_capacity(context) <= sizeof(memory);
+    ok = ok && vsort_context_reserve(context, sizeof(memory) * 2) == VSORT_ERR_INVALID_ARGUMENT;
+    vsort_context_destroy(context);
+
+    free(arr);
+    free(order);
+    if (!ok)
+    {
+        printf("FAILED: Sort under a context misbehaved\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_scratch_cache()
+{
+    printf("Testing scratch cache limit, trim and idle time... ");
+
+    size_t n = 100000;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_FORCE_STABLE};
+
+    // Worker threads may still hold blocks from earlier tests; only this
+    // thread's share must follow the calls below.
+    vsort_scratch_cache_trim();
+    size_t base = vsort_scratch_cache_bytes();
+
+    int ok = 1;
+    for (int round = 0; ok && round < 2; round++)
+    {
+        for (size_t i = 0; i < n; i++)
+            arr[i] = rand() % 100000 - 50000;
+        ok = vsort_sort(&options) == VSORT_OK && is_sorted(arr, (int)n);
+        ok = ok && vsort_scratch_cache_bytes() >= base + n * sizeof(int);
+    }
+    vsort_scratch_cache_trim();
+    ok = ok && vsort_scratch_cache_bytes() == base;
+
+    // A zero limit frees every block on release.
+    vsort_set_scratch_cache_limit(0);
+    for (size_t i = 0; ok && i < n; i++)
+        arr[i] = rand();
+    ok = ok && vsort_sort(&options) == VSORT_OK && is_sorted(arr, (int)n);
+    ok = ok && vsort_scratch_cache_bytes() == base;
+    vsort_set_scratch_cache_limit((size_t)64 << 20);
+
+    // Blocks left idle are freed by a later, smaller request.
+    vsort_set_scratch_cache_idle_ms(5);
+    for (size_t i = 0; ok && i < n; i++)
+        arr[i] = rand();
+    ok = ok && vsort_sort(&options) == VSORT_OK && is_sorted(arr, (int)n);
+    clock_t start = clock();
+    while (clock() - start < CLOCKS_PER_SEC / 50)
+        ;
+    options.length = 2000;
+    ok = ok && vsort_sort(&options) == VSORT_OK && is_sorted(arr, 2000);
+    ok = ok && vsort_scratch_cache_bytes() < base + n * sizeof(int);
+    vsort_set_scratch_cache_idle_ms(0);
+    vsort_scratch_cache_trim();
+
+    free(arr);
+    if (!ok)
+    {
+        printf("FAILED: Cached bytes do not follow the configuration\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_sort_batch()
+{
+    printf("Testing batched sort of many small arrays... ");
+
+    size_t arrays = 5000;
+    size_t *offsets = (size_t *)malloc((arrays + 1) * sizeof(size_t));
+    offsets[0] = 0;
+    for (size_t i = 0; offsets && i < arrays; i++)
+        offsets[i + 1] = offsets[i] + (size_t)(rand() % 300);
+    size_t n = offsets ? offsets[arrays] : 0;
+    int *arr = (int *)malloc(n * sizeof(int));
+    double *wide = (double *)malloc(n * sizeof(double));
+    generic_record_t *records = (generic_record_t *)malloc(arrays * sizeof(generic_record_t));
+    vsort_batch_array_t *descriptors = (vsort_batch_array_t *)malloc(arrays * sizeof(vsort_batch_array_t));
+    if (!offsets || !arr || !wide || !records || !descriptors)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(offsets);
+        free(arr);
+        free(wide);
+        free(records);
+        free(descriptors);
+        return 0;
+    }
+
+    // CSR layout, int32.
+    long long expected = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        arr[i] = rand() % 1000 - 500;
+        expected += arr[i];
+    }
+    vsort_batch_options_t options = {
+        .data = arr,
+        .offsets = offsets,
+        .arrays = NULL,
+        .count = arrays,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = 0};
+    int ok = vsort_sort_batch(&options) == VSORT_OK;
+    for (size_t i = 0; ok && i < arrays; i++)
+        ok = is_sorted(arr + offsets[i], (int)(offsets[i + 1] - offsets[i]));
+    for (size_t i = 0; i < n; i++)
+        expected -= arr[i];
+    ok = ok && expected == 0;
+
+    // Descriptor layout, float64, arrays out of buffer order.
+    for (size_t i = 0; i < n; i++)
+        wide[i] = (double)(rand() % 20000 - 10000) / 3.0;
+    for (size_t i = 0; i < arrays; i++)
+    {
+        size_t a = arrays - 1 - i;
+        descriptors[i].data = wide + offsets[a];
+        descriptors[i].length = offsets[a + 1] - offsets[a];
+    }
+    options.data = NULL;
+    options.offsets = NULL;
+    options.arrays = descriptors;
+    options.kind = VSORT_KIND_FLOAT64;
+    options.flags = VSORT_FLAG_ALLOW_RADIX;
+    ok = ok && vsort_sort_batch(&options) == VSORT_OK;
+    for (size_t i = 0; ok && i < arrays; i++)
+    {
+        const double *a = (const double *)descriptors[i].data;
+        for (size_t j = 1; ok && j < descriptors[i].length; j++)
+            ok = a[j - 1] <= a[j];
+    }
+
+    // Generic records, stable, 100 arrays of 50.
+    for (size_t i = 0; i < arrays; i++)
+    {
+        records[i].key = rand() % 10;
+        records[i].sequence = (int)i;
+    }
+    size_t record_offsets[101];
+    for (size_t i = 0; i <= 100; i++)
+        record_offsets[i] = i * 50;
+    options.data = records;
+    options.offsets = record_offsets;
+    options.arrays = NULL;
+    options.count = 100;
+    options.element_size = sizeof(generic_record_t);
+    options.kind = VSORT_KIND_GENERIC;
+    options.comparator = compare_record_key;
+    options.flags = VSORT_FLAG_FORCE_STABLE;
+    ok = ok && vsort_sort_batch(&options) == VSORT_OK;
+    for (size_t i = 1; ok && i < 100 * 50; i++)
+    {
+        if (i % 50 == 0)
+            ok = records[i].sequence / 50 == (int)(i / 50);
+        else
+            ok = records[i - 1].key < records[i].key ||
+                 (records[i - 1].key == records[i].key && records[i - 1].sequence < records[i].sequence);
+    }
+
+    // Errors: no comparator, decreasing offsets, missing data, unknown kind.
+    options.comparator = NULL;
+    ok = ok && vsort_sort_batch(&options) == VSORT_ERR_INVALID_ARGUMENT;
+    options.comparator = compare_record_key;
+    record_offsets[50] = record_offsets[49] - 1;
+    ok = ok && vsort_sort_batch(&options) == VSORT_ERR_INVALID_ARGUMENT;
+    options.offsets = NULL;
+    ok = ok && vsort_sort_batch(&options) == VSORT_ERR_INVALID_ARGUMENT;
+    options.kind = (vsort_data_kind_t)99;
+    options.offsets = offsets;
+    ok = ok && vsort_sort_batch(&options) == VSORT_ERR_UNSUPPORTED_TYPE;
+    ok = ok && vsort_sort_batch(NULL) == VSORT_ERR_INVALID_ARGUMENT;
+
+    free(offsets);
+    free(arr);
+    free(wide);
+    free(records);
+    free(descriptors);
+    if (!ok)
+    {
+        printf("FAILED: Batch not sorted or unexpected result code\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+#define TUNING_PATH "vsort_test_tuning.txt"
+
+static int test_tuning()
+{
+    printf("Testing threshold tuning and profiles... ");
+
+    vsort_tuning_t original;
+    vsort_get_tuning(&original);
+
+    // Zero fields keep their value; invalid settings change nothing.
+    vsort_tuning_t update = {0};
+    update.radix_threshold = 1000;
+    int ok = vsort_set_tuning(&update) == VSORT_OK;
+    vsort_tuning_t current;
+    vsort_get_tuning(&current);
+    ok = ok && current.radix_threshold == 1000 && current.insertion_threshold == original.insertion_threshold;
+    update.radix_bits = 16;
+    ok = ok && vsort_set_tuning(&update) == VSORT_ERR_INVALID_ARGUMENT && vsort_set_tuning(NULL) == VSORT_ERR_INVALID_ARGUMENT;
+    vsort_get_tuning(&current);
+    ok = ok && current.radix_bits == original.radix_bits;
+
+    // Sorting still works with the lowered radix threshold.
+    int *arr = create_random_array(5000, 100000);
+    vsort(arr, 5000);
+    ok = ok && arr && is_sorted(arr, 5000);
+    free(arr);
+
+    // A saved profile restores the saved values; one from another host is rejected.
+    ok = ok && vsort_save_tuning(TUNING_PATH) == VSORT_OK && vsort_set_tuning(&original) == VSORT_OK &&
+         vsort_load_tuning(TUNING_PATH) == VSORT_OK;
+    vsort_get_tuning(&current);
+    ok = ok && current.radix_threshold == 1000;
+    FILE *file = fopen(TUNING_PATH, "a");
+    if (file)
+    {
+        fprintf(file, "cpu=Another CPU\n");
+        fclose(file);
+    }
+    ok = ok && file && vsort_load_tuning(TUNING_PATH) == VSORT_ERR_INVALID_ARGUMENT;
+    remove(TUNING_PATH);
+    ok = ok && vsort_load_tuning(TUNING_PATH) == VSORT_ERR_IO;
+
+    vsort_tuning_t tuned;
+    ok = ok && vsort_autotune(&tuned) == VSORT_OK && tuned.insertion_threshold >= 4 && tuned.radix_threshold > 1 &&
+         tuned.radix_bits >= 8 && tuned.radix_bits <= 11;
+
+    ok = vsort_set_tuning(&original) == VSORT_OK && ok;
+    if (!ok)
+    {
+        printf("FAILED: Unexpected tuning result\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int compare_string_slice(const vsort_string_slice_t *a, const vsort_string_slice_t *b)
+{
+    int order = memcmp(a->data, b->data, a->length < b->length ? a->length : b->length);
+    if (order != 0)
+        return order;
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+static int test_sort_strings()
+{
+    printf("Testing string sorting... ");
+
+    // Strings share prefixes longer than one cached word and repeat often;
+    // they sit back to back in index order, so pointer order is input order.
+    static const char *prefixes[] = {"", "http://example.com/", "http://example.com/a", "b"};
+    size_t n = 5000;
+    char *pool = (char *)malloc(n * 48);
+    const char **strings = (const char **)malloc(n * sizeof(const char *));
+    vsort_string_slice_t *slices = (vsort_string_slice_t *)malloc(n * sizeof(vsort_string_slice_t));
+    if (!pool || !strings || !slices)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(pool);
+        free(strings);
+        free(slices);
+        return 0;
+    }
+
+    char *cursor = pool;
+    for (size_t i = 0; i < n; i++)
+    {
+        strings[i] = cursor;
+        cursor += sprintf(cursor, "%s", prefixes[rand() % 4]);
+        int length = rand() % 12;
+        for (int c = 0; c < length; c++)
+            *cursor++ = (char)('a' + rand() % 3);
+        *cursor++ = '\0';
+    }
+
+    int ok = 1;
+    for (int pass = 0; pass < 3 && ok; pass++)
+    {
+        vsort_string_options_t options = {.strings = strings,
+                                          .count = n,
+                                          .order = pass == 2 ? VSORT_ORDER_DESCENDING : VSORT_ORDER_ASCENDING,
+                                          .flags = pass == 0 ? 0 : VSORT_FLAG_FORCE_STABLE};
+        ok = vsort_sort_strings(&options) == VSORT_OK;
+        for (size_t i = 1; i < n && ok; i++)
+        {
+            int order = strcmp(strings[i - 1], strings[i]);
+            if (pass == 2)
+                order = -order;
+            ok = order < 0 || (order == 0 && (pass == 0 || strings[i - 1] < strings[i]));
+        }
+        // Restore input order for the next pass.
+        cursor = pool;
+        for (size_t i = 0; i < n; i++)
+        {
+            strings[i] = cursor;
+            cursor += strlen(cursor) + 1;
+        }
+    }
+
+    // Slices may hold zero bytes and sort before their extensions.
+    for (size_t i = 0; i < n && ok; i++)
+    {
+        slices[i].data = pool + (size_t)(rand() % 64);
+        slices[i].length = (size_t)(rand() % 24);
+        pool[rand() % 64] = (char)(rand() % 2 ? '\0' : 'a');
+    }
+    vsort_string_options_t options = {.slices = slices, .count = n, .flags = VSORT_FLAG_FORCE_STABLE};
+    ok = ok && vsort_sort_strings(&options) == VSORT_OK;
+    for (size_t i = 1; i < n && ok; i++)
+        ok = compare_string_slice(&slices[i - 1], &slices[i]) <= 0;
+
+    options.slices = NULL;
+    ok = ok && vsort_sort_strings(&options) == VSORT_ERR_INVALID_ARGUMENT &&
+         vsort_sort_strings(NULL) == VSORT_ERR_INVALID_ARGUMENT;
+
+    free(pool);
+    free(strings);
+    free(slices);
+    if (!ok)
+    {
+        printf("FAILED: Strings not sorted\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
 static int test_edge_cases()
 {
     printf("Testing edge cases... ");
@@ -214,6 +1726,26 @@ int main()
     passed &= test_sort_already_sorted_array();
     passed &= test_sort_reverse_sorted_array();
     passed &= test_sort_duplicate_values();
+    passed &= test_radix_key_ranges();
+    passed &= test_low_memory_radix();
+    passed &= test_float_radix_total_order();
+    passed &= test_sort_64bit_kinds();
+    passed &= test_simd_partition();
+    passed &= test_small_float_leaves();
+    passed &= test_presorted_runs();
+    passed &= test_adversarial_patterns();
+    passed &= test_generic_engine();
+    passed &= test_argsort();
+    passed &= test_sort_by_key();
+    passed &= test_sort_kv();
+    passed &= test_selection();
+    passed &= test_merge_runs();
+    passed &= test_stream();
+    passed &= test_context();
+    passed &= test_scratch_cache();
+    passed &= test_sort_batch();
+    passed &= test_tuning();
+    passed &= test_sort_strings();
     passed &= test_edge_cases();
 
     printf("\nTest summary: %s\n", passed ? "ALL PASSED" : "SOME TESTS FAILED");
@@ -0,0 +1,241 @@
+/**
+ * test_external.c - Tests for the external (file-to-file) sort
+ *
+ * Small memory budgets force many runs and several merge passes, so the
+ * out-of-core path is exercised without large files.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../vsort.h"
+
+#define INPUT_PATH "vsort_test_external_in.bin"
+#define OUTPUT_PATH "vsort_test_external_out.bin"
+
+static int write_file(const char *path, const void *data, size_t bytes)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return 0;
+    int ok = fwrite(data, 1, bytes, file) == bytes;
+    return fclose(file) == 0 && ok;
+}
+
+// Reads exactly bytes from path; a longer or shorter file fails.
+static int read_file(const char *path, void *data, size_t bytes)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return 0;
+    int ok = fread(data, 1, bytes, file) == bytes && fgetc(file) == EOF;
+    fclose(file);
+    return ok;
+}
+
+static uint64_t random_word64(void)
+{
+    uint64_t word = 0;
+    for (int i = 0; i < 4; i++)
+        word = (word << 16) ^ (uint64_t)(rand() & 0xFFFF);
+    return word;
+}
+
+static int test_external_int32_multi_pass()
+{
+    printf("Testing external int32 sort with multiple merge passes... ");
+
+    size_t n = 3000000;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    long long expected = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        arr[i] = rand() % 2000000 - 1000000;
+        expected += arr[i];
+    }
+
+    vsort_external_options_t options = {
+        .input_path = INPUT_PATH,
+        .output_path = OUTPUT_PATH,
+        .temp_dir = NULL,
+        .kind = VSORT_KIND_INT32,
+        .memory_budget = (size_t)1 << 20,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    int ok = write_file(INPUT_PATH, arr, n * sizeof(int));
+    ok = ok && vsort_sort_file(&options) == VSORT_OK;
+    memset(arr, 0, n * sizeof(int));
+    ok = ok && read_file(OUTPUT_PATH, arr, n * sizeof(int));
+
+    long long total = ok ? arr[0] : 0;
+    for (size_t i = 1; ok && i < n; i++)
+    {
+        ok = arr[i - 1] <= arr[i];
+        total += arr[i];
+    }
+
+    free(arr);
+    remove(INPUT_PATH);
+    remove(OUTPUT_PATH);
+    if (!ok || total != expected)
+    {
+        printf("FAILED: Output is not a sorted permutation of the input\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_external_int64_in_place()
+{
+    printf("Testing external int64 sort onto its own input... ");
+
+    size_t n = 400000;
+    int64_t *arr = (int64_t *)malloc(n * sizeof(int64_t));
+    int64_t *expected = (int64_t *)malloc(n * sizeof(int64_t));
+    if (!arr || !expected)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        free(expected);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        arr[i] = (int64_t)random_word64();
+    memcpy(expected, arr, n * sizeof(int64_t));
+
+    vsort_options_t sort_options = {
+        .data = expected,
+        .length = n,
+        .element_size = sizeof(int64_t),
+        .kind = VSORT_KIND_INT64,
+        .comparator = NULL,
+        .flags = 0};
+
+    // Named run files in the working directory, output replacing the input.
+    vsort_external_options_t options = {
+        .input_path = INPUT_PATH,
+        .output_path = INPUT_PATH,
+        .temp_dir = ".",
+        .kind = VSORT_KIND_INT64,
+        .memory_budget = (size_t)1 << 20,
+        .flags = 0};
+
+    int ok = vsort_sort(&sort_options) == VSORT_OK && write_file(INPUT_PATH, arr, n * sizeof(int64_t));
+    ok = ok && vsort_sort_file(&options) == VSORT_OK;
+    ok = ok && read_file(INPUT_PATH, arr, n * sizeof(int64_t)) && memcmp(arr, expected, n * sizeof(int64_t)) == 0;
+
+    free(arr);
+    free(expected);
+    remove(INPUT_PATH);
+    if (!ok)
+    {
+        printf("FAILED: Output does not match the in-memory sort\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_external_double_single_run()
+{
+    printf("Testing external float64 sort within one run... ");
+
+    size_t n = 10000;
+    double arr[10000];
+    for (size_t i = 0; i < n; i++)
+        arr[i] = (double)(rand() % 20000 - 10000) / 7.0;
+
+    vsort_external_options_t options = {
+        .input_path = INPUT_PATH,
+        .output_path = OUTPUT_PATH,
+        .temp_dir = NULL,
+        .kind = VSORT_KIND_FLOAT64,
+        .memory_budget = 0,
+        .flags = 0};
+
+    int ok = write_file(INPUT_PATH, arr, sizeof(arr));
+    ok = ok && vsort_sort_file(&options) == VSORT_OK && read_file(OUTPUT_PATH, arr, sizeof(arr));
+    for (size_t i = 1; ok && i < n; i++)
+        ok = arr[i - 1] <= arr[i];
+
+    // An empty input gives an empty output.
+    ok = ok && write_file(INPUT_PATH, arr, 0);
+    ok = ok && vsort_sort_file(&options) == VSORT_OK && read_file(OUTPUT_PATH, arr, 0);
+
+    remove(INPUT_PATH);
+    remove(OUTPUT_PATH);
+    if (!ok)
+    {
+        printf("FAILED: Output is not sorted\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_external_errors()
+{
+    printf("Testing external sort error handling... ");
+
+    vsort_external_options_t options = {
+        .input_path = INPUT_PATH,
+        .output_path = OUTPUT_PATH,
+        .temp_dir = NULL,
+        .kind = VSORT_KIND_GENERIC,
+        .memory_budget = 0,
+        .flags = 0};
+
+    int ok = vsort_sort_file(NULL) == VSORT_ERR_INVALID_ARGUMENT;
+    ok = ok && vsort_sort_file(&options) == VSORT_ERR_UNSUPPORTED_TYPE;
+
+    options.kind = VSORT_KIND_INT32;
+    remove(INPUT_PATH);
+    ok = ok && vsort_sort_file(&options) == VSORT_ERR_IO;
+
+    // Seven bytes are not a whole number of int32 elements.
+    const unsigned char bytes[7] = {1, 2, 3, 4, 5, 6, 7};
+    ok = ok && write_file(INPUT_PATH, bytes, sizeof(bytes));
+    ok = ok && vsort_sort_file(&options) == VSORT_ERR_IO;
+
+    remove(INPUT_PATH);
+    remove(OUTPUT_PATH);
+    if (!ok)
+    {
+        printf("FAILED: Unexpected result code\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+int main()
+{
+    printf("Running external vsort tests...\n\n");
+
+    srand(time(NULL));
+    vsort_set_thread_count(4);
+
+    int passed = 1;
+    passed &= test_external_int32_multi_pass();
+    passed &= test_external_int64_in_place();
+    passed &= test_external_double_single_run();
+    passed &= test_external_errors();
+
+    printf("\nTest summary: %s\n", passed ? "ALL PASSED" : "SOME TESTS FAILED");
+
+    return passed ? 0 : 1;
+}
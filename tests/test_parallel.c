@@ -0,0 +1,1167 @@
+/**
+ * test_parallel.c - Tests for the portable parallel sorting paths
+ *
+ * These tests force a multi-threaded worker pool (regardless of the
+ * detected core count) and verify the parallel engines sort correctly.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../vsort.h"
+
+static int is_sorted_int(const int *arr, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (arr[i] < arr[i - 1])
+            return 0;
+    }
+    return 1;
+}
+
+static int is_sorted_float(const float *arr, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (arr[i] < arr[i - 1])
+            return 0;
+    }
+    return 1;
+}
+
+static long long sum_int(const int *arr, size_t n)
+{
+    long long total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += arr[i];
+    return total;
+}
+
+static int test_parallel_int32()
+{
+    printf("Testing parallel int32 sort... ");
+
+    size_t sizes[] = {1000003, ((size_t)1 << 22) + 17};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        size_t n = sizes[s];
+        int *arr = (int *)malloc(n * sizeof(int));
+        if (!arr)
+        {
+            printf("FAILED: Memory allocation error\n");
+            return 0;
+        }
+
+        for (size_t i = 0; i < n; i++)
+            arr[i] = rand() - RAND_MAX / 2;
+        long long before = sum_int(arr, n);
+
+        vsort_options_t options = {
+            .data = arr,
+            .length = n,
+            .element_size = sizeof(int),
+            .kind = VSORT_KIND_INT32,
+            .comparator = NULL,
+            .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+        if (vsort_sort(&options) != VSORT_OK || !is_sorted_int(arr, n) || sum_int(arr, n) != before)
+        {
+            printf("FAILED: Array of size %zu not sorted correctly\n", n);
+            free(arr);
+            return 0;
+        }
+
+        free(arr);
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_float32()
+{
+    printf("Testing parallel float32 sort... ");
+
+    size_t n = ((size_t)1 << 22) + 1;
+    float *arr = (float *)malloc(n * sizeof(float));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        arr[i] = (float)rand() / (float)RAND_MAX * 2000.0f - 1000.0f;
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(float),
+        .kind = VSORT_KIND_FLOAT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    if (vsort_sort(&options) != VSORT_OK || !is_sorted_float(arr, n))
+    {
+        printf("FAILED: Float array not sorted correctly\n");
+        free(arr);
+        return 0;
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_64bit()
+{
+    printf("Testing parallel int64/double sort... ");
+
+    size_t n = ((size_t)1 << 22) + 11;
+    long long *keys = (long long *)malloc(n * sizeof(long long));
+    double *values = (double *)malloc(n * sizeof(double));
+    if (!keys || !values)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(keys);
+        free(values);
+        return 0;
+    }
+
+    unsigned int flag_sets[] = {VSORT_FLAG_ALLOW_PARALLEL, VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_ALLOW_RADIX};
+    int ok = 1;
+    for (int f = 0; ok && f < 2; f++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            keys[i] = ((long long)rand() - RAND_MAX / 2) * ((long long)1 << 31) + rand();
+            values[i] = ((double)rand() - RAND_MAX / 2) * 1.0e9;
+        }
+
+        vsort_options_t options = {
+            .data = keys,
+            .length = n,
+            .element_size = sizeof(long long),
+            .kind = VSORT_KIND_INT64,
+            .comparator = NULL,
+            .flags = flag_sets[f]};
+        ok = vsort_sort(&options) == VSORT_OK;
+
+        options.data = values;
+        options.element_size = sizeof(double);
+        options.kind = VSORT_KIND_FLOAT64;
+        ok = ok && vsort_sort(&options) == VSORT_OK;
+
+        for (size_t i = 1; ok && i < n; i++)
+            ok = keys[i - 1] <= keys[i] && values[i - 1] <= values[i];
+    }
+
+    free(keys);
+    free(values);
+    if (!ok)
+    {
+        printf("FAILED: 64-bit arrays not sorted correctly\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_merge_duplicates()
+{
+    printf("Testing parallel merge with heavy duplicates... ");
+
+    size_t n = ((size_t)1 << 22) + 4099;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        arr[i] = rand() % 7;
+    long long before = sum_int(arr, n);
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    if (vsort_sort(&options) != VSORT_OK || !is_sorted_int(arr, n) || sum_int(arr, n) != before)
+    {
+        printf("FAILED: Duplicate-heavy array not sorted correctly\n");
+        free(arr);
+        return 0;
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_fork_join()
+{
+    printf("Testing fork-join parallel introsort... ");
+
+    // VSORT_FLAG_LOW_MEMORY rules out the merge buffer, so the parallel
+    // comparison sort takes the fork-join path.
+    size_t n = ((size_t)1 << 22) + 333;
+    int *arr = (int *)malloc(n * sizeof(int));
+    int64_t *wide = (int64_t *)malloc(n * sizeof(int64_t));
+    if (!arr || !wide)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        free(wide);
+        return 0;
+    }
+
+    for (int pattern = 0; pattern < 3; pattern++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (pattern == 0)
+                arr[i] = rand() - RAND_MAX / 2;
+            else if (pattern == 1)
+                arr[i] = rand() % 5;
+            else
+                arr[i] = (int)(i < n / 2 ? i : n - i) ^ (rand() & 3);
+        }
+        long long before = sum_int(arr, n);
+
+        vsort_options_t options = {
+            .data = arr,
+            .length = n,
+            .element_size = sizeof(int),
+            .kind = VSORT_KIND_INT32,
+            .comparator = NULL,
+            .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_LOW_MEMORY};
+
+        if (vsort_sort(&options) != VSORT_OK || !is_sorted_int(arr, n) || sum_int(arr, n) != before)
+        {
+            printf("FAILED: int32 pattern %d not sorted correctly\n", pattern);
+            free(arr);
+            free(wide);
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+        wide[i] = ((int64_t)rand() << 32) ^ rand();
+    vsort_options_t options = {
+        .data = wide,
+        .length = n,
+        .element_size = sizeof(int64_t),
+        .kind = VSORT_KIND_INT64,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_LOW_MEMORY};
+    int ok = vsort_sort(&options) == VSORT_OK;
+    for (size_t i = 1; ok && i < n; i++)
+        ok = wide[i - 1] <= wide[i];
+
+    free(arr);
+    free(wide);
+    if (!ok)
+    {
+        printf("FAILED: int64 array not sorted correctly\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_radix_int32()
+{
+    printf("Testing parallel radix int32 sort... ");
+
+    size_t n = ((size_t)1 << 22) + 31;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        arr[i] = (rand() % 2000001) - 1000000;
+    long long before = sum_int(arr, n);
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_ALLOW_RADIX};
+
+    if (vsort_sort(&options) != VSORT_OK || !is_sorted_int(arr, n) || sum_int(arr, n) != before)
+    {
+        printf("FAILED: Radix-sorted array not sorted correctly\n");
+        free(arr);
+        return 0;
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_in_place_radix()
+{
+    printf("Testing parallel in-place radix sort... ");
+
+    size_t n = ((size_t)1 << 22) + 77;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        arr[i] = rand() - RAND_MAX / 2;
+    long long before = sum_int(arr, n);
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_ALLOW_RADIX | VSORT_FLAG_LOW_MEMORY};
+
+    if (vsort_sort(&options) != VSORT_OK || !is_sorted_int(arr, n) || sum_int(arr, n) != before)
+    {
+        printf("FAILED: In-place radix produced unsorted output\n");
+        free(arr);
+        return 0;
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+typedef struct
+{
+    long long key;
+    long long sequence;
+} parallel_record_t;
+
+static int compare_parallel_record(const void *a, const void *b)
+{
+    const parallel_record_t *x = (const parallel_record_t *)a;
+    const parallel_record_t *y = (const parallel_record_t *)b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static int test_parallel_generic_stable()
+{
+    printf("Testing parallel stable generic sort... ");
+
+    size_t n = ((size_t)1 << 21) + 13;
+    parallel_record_t *arr = (parallel_record_t *)malloc(n * sizeof(parallel_record_t));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        arr[i].key = rand() % 1000;
+        arr[i].sequence = (long long)i;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(parallel_record_t),
+        .kind = VSORT_KIND_GENERIC,
+        .comparator = compare_parallel_record,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_FORCE_STABLE};
+
+    if (vsort_sort(&options) != VSORT_OK)
+    {
+        printf("FAILED: Generic sort returned an error\n");
+        free(arr);
+        return 0;
+    }
+
+    for (size_t i = 1; i < n; i++)
+    {
+        if (arr[i - 1].key > arr[i].key || (arr[i - 1].key == arr[i].key && arr[i - 1].sequence > arr[i].sequence))
+        {
+            printf("FAILED: Records not stably sorted at %zu\n", i);
+            free(arr);
+            return 0;
+        }
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_sort_by_key()
+{
+    printf("Testing parallel key-extraction sort... ");
+
+    size_t n = ((size_t)1 << 21) + 5;
+    parallel_record_t *arr = (parallel_record_t *)malloc(n * sizeof(parallel_record_t));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        arr[i].key = (long long)(rand() % 100000) - 50000;
+        arr[i].sequence = (long long)i;
+    }
+
+    vsort_key_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(parallel_record_t),
+        .key_offset = 0,
+        .key_type = VSORT_KEY_INT64,
+        .order = VSORT_ORDER_DESCENDING,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    if (vsort_sort_by_key(&options) != VSORT_OK)
+    {
+        printf("FAILED: Key sort returned an error\n");
+        free(arr);
+        return 0;
+    }
+
+    for (size_t i = 1; i < n; i++)
+    {
+        if (arr[i - 1].key < arr[i].key || (arr[i - 1].key == arr[i].key && arr[i - 1].sequence > arr[i].sequence))
+        {
+            printf("FAILED: Records not stably sorted at %zu\n", i);
+            free(arr);
+            return 0;
+        }
+    }
+
+    free(arr);
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_sort_kv()
+{
+    printf("Testing parallel key-value sort... ");
+
+    size_t n = ((size_t)1 << 21) + 3;
+    float *keys = (float *)malloc(n * sizeof(float));
+    unsigned int *values = (unsigned int *)malloc(n * sizeof(unsigned int));
+    float *original = (float *)malloc(n * sizeof(float));
+    if (!keys || !values || !original)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(keys);
+        free(values);
+        free(original);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = original[i] = (float)(rand() % 100000) * 0.5f - 25000.0f;
+        values[i] = (unsigned int)i;
+    }
+
+    vsort_kv_options_t options = {
+        .keys = keys,
+        .values = values,
+        .length = n,
+        .key_type = VSORT_KEY_FLOAT32,
+        .value_size = sizeof(unsigned int),
+        .order = VSORT_ORDER_ASCENDING,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    int ok = vsort_sort_kv(&options) == VSORT_OK;
+    for (size_t i = 0; ok && i < n; i++)
+        ok = keys[i] == original[values[i]] &&
+             (i == 0 || keys[i - 1] < keys[i] || (keys[i - 1] == keys[i] && values[i - 1] < values[i]));
+
+    free(keys);
+    free(values);
+    free(original);
+    if (!ok)
+    {
+        printf("FAILED: Keys and values not sorted together\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_argsort()
+{
+    printf("Testing parallel argsort... ");
+
+    size_t n = ((size_t)1 << 21) + 9;
+    int *arr = (int *)malloc(n * sizeof(int));
+    size_t *order = (size_t *)malloc(n * sizeof(size_t));
+    if (!arr || !order)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        free(order);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        arr[i] = rand() % 50000 - 25000;
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    int ok = vsort_argsort(&options, order, VSORT_INDEX_SIZE) == VSORT_OK;
+    for (size_t i = 1; ok && i < n; i++)
+        ok = arr[order[i - 1]] < arr[order[i]] || (arr[order[i - 1]] == arr[order[i]] && order[i - 1] < order[i]);
+
+    free(arr);
+    free(order);
+    if (!ok)
+    {
+        printf("FAILED: Permutation does not stably sort the input\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_selection()
+{
+    printf("Testing parallel sample select... ");
+
+    size_t n = ((size_t)1 << 22) + 21;
+    int *arr = (int *)malloc(n * sizeof(int));
+    int *sorted = (int *)malloc(n * sizeof(int));
+    if (!arr || !sorted)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        free(sorted);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        sorted[i] = rand() % 1000000 - 500000;
+    memcpy(arr, sorted, n * sizeof(int));
+
+    vsort_options_t options = {
+        .data = sorted,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+    int ok = vsort_sort(&options) == VSORT_OK;
+
+    // p99 through nth_element, then the top-of-list prefix through partial_sort.
+    size_t nth = n / 100 * 99;
+    options.data = arr;
+    ok = ok && vsort_nth_element(&options, nth) == VSORT_OK && arr[nth] == sorted[nth];
+    for (size_t i = 0; ok && i < n; i++)
+        ok = i < nth ? arr[i] <= arr[nth] : arr[i] >= arr[nth];
+
+    ok = ok && vsort_partial_sort(&options, 1000) == VSORT_OK;
+    for (size_t i = 0; ok && i < 1000; i++)
+        ok = arr[i] == sorted[i];
+
+    free(arr);
+    free(sorted);
+    if (!ok)
+    {
+        printf("FAILED: Selected elements do not match the sorted order\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_merge_runs()
+{
+    printf("Testing parallel K-way merge... ");
+
+    // One shard per producer; heavy duplication makes ties straddle the
+    // slice boundaries of the output.
+    size_t run_count = 16;
+    size_t n = ((size_t)1 << 22) + 35;
+    uint64_t *input = (uint64_t *)malloc(n * sizeof(uint64_t));
+    uint64_t *merged = (uint64_t *)malloc(n * sizeof(uint64_t));
+    vsort_sorted_run_t runs[16];
+    if (!input || !merged)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(input);
+        free(merged);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        input[i] = (uint64_t)(rand() % 5000) << 40;
+
+    vsort_options_t sort_options = {
+        .element_size = sizeof(uint64_t),
+        .kind = VSORT_KIND_UINT64,
+        .comparator = NULL,
+        .flags = 0};
+    int ok = 1;
+    size_t offset = 0;
+    for (size_t r = 0; r < run_count; r++)
+    {
+        // Uneven shards: the last one takes the remainder.
+        size_t length = r + 1 < run_count ? n / run_count / 2 * (1 + r % 3) : n - offset;
+        sort_options.data = input + offset;
+        sort_options.length = length;
+        ok = ok && vsort_sort(&sort_options) == VSORT_OK;
+        runs[r].data = input + offset;
+        runs[r].length = length;
+        offset += length;
+    }
+
+    vsort_merge_options_t options = {
+        .runs = runs,
+        .run_count = run_count,
+        .output = merged,
+        .kind = VSORT_KIND_UINT64,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+    ok = ok && vsort_merge_runs(&options) == VSORT_OK;
+
+    sort_options.data = input;
+    sort_options.length = n;
+    ok = ok && vsort_sort(&sort_options) == VSORT_OK && memcmp(input, merged, n * sizeof(uint64_t)) == 0;
+
+    free(input);
+    free(merged);
+    if (!ok)
+    {
+        printf("FAILED: Merged output does not match the sorted concatenation\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_stream()
+{
+    printf("Testing parallel streaming sort... ");
+
+    // Large pushes take the parallel run sort; the merges of the cascade and
+    // of finalize are split over the pool.
+    size_t batch = ((size_t)1 << 18) + 11;
+    size_t batches = 20;
+    size_t n = batch * batches;
+    double *pushed = (double *)malloc(n * sizeof(double));
+    double *sorted = (double *)malloc(n * sizeof(double));
+    vsort_stream_t *stream = NULL;
+    if (!pushed || !sorted || vsort_stream_create(&stream, VSORT_KIND_FLOAT64, VSORT_FLAG_ALLOW_PARALLEL) != VSORT_OK)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(pushed);
+        free(sorted);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        pushed[i] = (double)(rand() % 1000000 - 500000) / 3.0;
+
+    int ok = 1;
+    for (size_t b = 0; ok && b < batches; b++)
+        ok = vsort_stream_push(stream, pushed + b * batch, batch) == VSORT_OK;
+    ok = ok && vsort_stream_finalize(stream, sorted) == VSORT_OK;
+    vsort_stream_destroy(stream);
+
+    vsort_options_t options = {
+        .data = pushed,
+        .length = n,
+        .element_size = sizeof(double),
+        .kind = VSORT_KIND_FLOAT64,
+        .comparator = NULL,
+        .flags = 0};
+    ok = ok && vsort_sort(&options) == VSORT_OK && memcmp(pushed, sorted, n * sizeof(double)) == 0;
+
+    free(pushed);
+    free(sorted);
+    if (!ok)
+    {
+        printf("FAILED: Finalized output does not match the sorted input\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_context()
+{
+    printf("Testing parallel sort under a context... ");
+
+    size_t n = ((size_t)1 << 21) + 3;
+    float *arr = (float *)malloc(n * sizeof(float));
+    vsort_context_t *context = NULL;
+    if (!arr || vsort_context_create(&context, n * sizeof(float)) != VSORT_OK)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(float),
+        .kind = VSORT_KIND_FLOAT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    // Large parallel sorts may take fork-join introsort, which needs almost
+    // no scratch, so every round also runs a stable sort with its N-element
+    // merge buffer.
+    int ok = 1;
+    size_t capacity = 0;
+    for (int round = 0; ok && round < 4; round++)
+    {
+        for (size_t i = 0; i < n; i++)
+            arr[i] = (float)(rand() % 1000000) / 7.0f - 70000.0f;
+        options.flags = (round & 1) ? VSORT_FLAG_FORCE_STABLE : VSORT_FLAG_ALLOW_PARALLEL;
+        ok = vsort_sort_with_context(context, &options) == VSORT_OK && is_sorted_float(arr, n);
+        ok = ok && (round < 2 || vsort_context_capacity(context) == capacity);
+        capacity = vsort_context_capacity(context);
+    }
+    ok = ok && vsort_context_peak(context) >= n * sizeof(float);
+
+    vsort_context_destroy(context);
+    free(arr);
+    if (!ok)
+    {
+        printf("FAILED: Array not sorted or arena regrown\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_scratch_cache()
+{
+    printf("Testing parallel sorts under a scratch cache limit... ");
+
+    size_t n = ((size_t)1 << 20) + 11;
+    int64_t *arr = (int64_t *)malloc(n * sizeof(int64_t));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int64_t),
+        .kind = VSORT_KIND_INT64,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    // Workers release blocks concurrently; the total must stay capped. Blocks
+    // workers cached before the limit was lowered still count against it.
+    vsort_scratch_cache_trim();
+    size_t limit = (size_t)4 << 20;
+    vsort_set_scratch_cache_limit(limit);
+    size_t cap = vsort_scratch_cache_bytes() > limit ? vsort_scratch_cache_bytes() : limit;
+    int ok = 1;
+    unsigned int flag_sets[] = {VSORT_FLAG_ALLOW_PARALLEL, VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_FORCE_STABLE,
+                                VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_ALLOW_RADIX};
+    for (int round = 0; ok && round < 6; round++)
+    {
+        for (size_t i = 0; i < n; i++)
+            arr[i] = (int64_t)(((uint64_t)rand() << 32) ^ (uint64_t)rand()) - (int64_t)RAND_MAX;
+        options.flags = flag_sets[round % 3];
+        ok = vsort_sort(&options) == VSORT_OK;
+        for (size_t i = 1; ok && i < n; i++)
+            ok = arr[i - 1] <= arr[i];
+        ok = ok && vsort_scratch_cache_bytes() <= cap;
+    }
+    vsort_set_scratch_cache_limit((size_t)64 << 20);
+    vsort_scratch_cache_trim();
+
+    free(arr);
+    if (!ok)
+    {
+        printf("FAILED: Array not sorted or cache over its limit\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_sort_batch()
+{
+    printf("Testing parallel batched sort... ");
+
+    // Many short arrays around two long ones that sort in parallel themselves.
+    size_t arrays = 60000;
+    size_t *offsets = (size_t *)malloc((arrays + 1) * sizeof(size_t));
+    if (!offsets)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+    offsets[0] = 0;
+    for (size_t i = 0; i < arrays; i++)
+    {
+        size_t length = (i == 17 || i == arrays / 2) ? ((size_t)1 << 21) + 5 : (size_t)(rand() % 200);
+        offsets[i + 1] = offsets[i] + length;
+    }
+
+    size_t n = offsets[arrays];
+    float *arr = (float *)malloc(n * sizeof(float));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(offsets);
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++)
+        arr[i] = (float)(rand() % 1000000) / 13.0f - 30000.0f;
+
+    vsort_batch_options_t options = {
+        .data = arr,
+        .offsets = offsets,
+        .arrays = NULL,
+        .count = arrays,
+        .element_size = sizeof(float),
+        .kind = VSORT_KIND_FLOAT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_ALLOW_RADIX};
+    int ok = vsort_sort_batch(&options) == VSORT_OK;
+    for (size_t i = 0; ok && i < arrays; i++)
+        ok = is_sorted_float(arr + offsets[i], offsets[i + 1] - offsets[i]);
+
+    free(arr);
+    free(offsets);
+    if (!ok)
+    {
+        printf("FAILED: An array of the batch is not sorted\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static void count_async_completion(vsort_result_t result, void *user_data)
+{
+    if (result == VSORT_OK || result == VSORT_ERR_CANCELLED)
+        ++*(int *)user_data;
+}
+
+static int test_parallel_async()
+{
+    printf("Testing asynchronous sort... ");
+
+    size_t n = ((size_t)1 << 22) + 5;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    int completions = 0;
+    int ok = 1;
+    for (int round = 0; ok && round < 2; round++)
+    {
+        for (size_t i = 0; i < n; i++)
+            arr[i] = rand() - RAND_MAX / 2;
+        long long before = sum_int(arr, n);
+
+        vsort_async_t *handle = NULL;
+        ok = vsort_sort_async(&options, count_async_completion, &completions, &handle) == VSORT_OK && handle;
+        if (!ok)
+            break;
+
+        // The second round is cancelled right away: it either finished first
+        // or stops early, leaving a permutation of the input.
+        if (round == 1)
+            vsort_async_cancel(handle);
+        vsort_result_t result = vsort_async_wait(handle);
+        vsort_result_t polled = VSORT_ERR_IO;
+        ok = vsort_async_poll(handle, &polled) && polled == result && sum_int(arr, n) == before;
+        if (round == 0 || result == VSORT_OK)
+            ok = ok && result == VSORT_OK && is_sorted_int(arr, n);
+        else
+            ok = ok && result == VSORT_ERR_CANCELLED;
+        vsort_async_destroy(handle);
+    }
+
+    free(arr);
+    if (!ok || completions != 2)
+    {
+        printf("FAILED: Asynchronous sort did not complete correctly\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_stats()
+{
+    printf("Testing sort telemetry... ");
+
+    size_t n = ((size_t)1 << 22) + 3;
+    int *arr = (int *)malloc(n * sizeof(int));
+    if (!arr)
+    {
+        printf("FAILED: Memory allocation error\n");
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    vsort_set_counters_enabled(1);
+    vsort_counters_reset();
+
+    // Parallel comparison sort, LSD radix sort, then presorted input.
+    vsort_stats_t stats[3];
+    int ok = 1;
+    for (int round = 0; ok && round < 3; round++)
+    {
+        if (round < 2)
+            for (size_t i = 0; i < n; i++)
+                arr[i] = rand() - RAND_MAX / 2;
+        options.flags = VSORT_FLAG_ALLOW_PARALLEL | (round == 1 ? VSORT_FLAG_ALLOW_RADIX : 0);
+        ok = vsort_sort_with_stats(&options, &stats[round]) == VSORT_OK && is_sorted_int(arr, n) &&
+             stats[round].length == n;
+
+        uint64_t phases = 0;
+        for (int phase = 0; phase < VSORT_PHASE_COUNT; phase++)
+            phases += stats[round].phase_ns[phase];
+        ok = ok && phases > 0 && phases <= stats[round].total_ns;
+    }
+
+    vsort_counters_t counters;
+    vsort_counters_read(&counters);
+    vsort_set_counters_enabled(0);
+    (void)vsort_sort(&options);
+
+    vsort_counters_t after;
+    vsort_counters_read(&after);
+    free(arr);
+
+    ok = ok && (stats[0].engine == VSORT_ENGINE_PARALLEL_MERGE || stats[0].engine == VSORT_ENGINE_FORK_JOIN) &&
+         stats[0].threads > 1 && stats[0].phase_ns[VSORT_PHASE_SORT] > 0;
+    ok = ok && stats[1].engine == VSORT_ENGINE_RADIX_LSD && stats[1].radix_passes > 0 &&
+         stats[1].bytes_allocated >= n * sizeof(int) && stats[1].phase_ns[VSORT_PHASE_RADIX] > 0;
+    ok = ok && stats[2].engine == VSORT_ENGINE_RUN_MERGE && stats[2].phase_ns[VSORT_PHASE_PRESCAN] > 0;
+    ok = ok && counters.calls == 3 && counters.elements == 3 * (uint64_t)n &&
+         counters.engine_calls[VSORT_ENGINE_RADIX_LSD] == 1 && counters.engine_calls[VSORT_ENGINE_RUN_MERGE] == 1 &&
+         counters.radix_passes == stats[1].radix_passes && after.calls == counters.calls;
+    if (!ok)
+    {
+        printf("FAILED: Unexpected telemetry\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_strings()
+{
+    printf("Testing parallel string sort... ");
+
+    // Few distinct strings behind a shared 16-byte prefix, laid out in index
+    // order so pointer order checks stability.
+    size_t n = ((size_t)1 << 18) + 9;
+    char *pool = (char *)malloc(n * 32);
+    const char **strings = (const char **)malloc(n * sizeof(const char *));
+    if (!pool || !strings)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(pool);
+        free(strings);
+        return 0;
+    }
+
+    char *cursor = pool;
+    for (size_t i = 0; i < n; i++)
+    {
+        strings[i] = cursor;
+        cursor += sprintf(cursor, "/var/log/service/%x", (unsigned int)(rand() % 5000)) + 1;
+    }
+
+    vsort_string_options_t options = {
+        .strings = strings,
+        .count = n,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_FORCE_STABLE};
+    int ok = vsort_sort_strings(&options) == VSORT_OK;
+    for (size_t i = 1; i < n && ok; i++)
+    {
+        int order = strcmp(strings[i - 1], strings[i]);
+        ok = order < 0 || (order == 0 && strings[i - 1] < strings[i]);
+    }
+
+    free(pool);
+    free(strings);
+    if (!ok)
+    {
+        printf("FAILED: Strings not stably sorted\n");
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+static int test_parallel_numa()
+{
+    printf("Testing NUMA stripe sort... ");
+
+    size_t n = ((size_t)1 << 22) + 5;
+    int *arr = (int *)malloc(n * sizeof(int));
+    vsort_context_t *context = NULL;
+    if (!arr || vsort_context_create(&context, 0) != VSORT_OK)
+    {
+        printf("FAILED: Memory allocation error\n");
+        free(arr);
+        return 0;
+    }
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = VSORT_FLAG_ALLOW_PARALLEL};
+
+    // Back-to-back sorts under a context: the second must not reuse the
+    // first one's stripe blocks through the arena or the scratch cache.
+    int ok = 1;
+    vsort_stats_t stats = {.engine = VSORT_ENGINE_NONE};
+    vsort_context_t *previous = vsort_context_bind(context);
+    for (int round = 0; ok && round < 2; round++)
+    {
+        for (size_t i = 0; i < n; i++)
+            arr[i] = rand() - RAND_MAX / 2;
+        ok = vsort_sort_with_stats(&options, &stats) == VSORT_OK && is_sorted_int(arr, n);
+        if (stats.engine != VSORT_ENGINE_NUMA)
+            break;
+    }
+    vsort_context_bind(previous);
+    int numa = stats.engine == VSORT_ENGINE_NUMA;
+    ok = ok && (!numa || (stats.bytes_allocated >= n * sizeof(int) && vsort_context_peak(context) < n * sizeof(int)));
+
+    vsort_context_destroy(context);
+    free(arr);
+    if (!ok)
+    {
+        printf("FAILED: Array not sorted or stripes taken from the arena\n");
+        return 0;
+    }
+
+    printf(numa ? "PASSED\n" : "SKIPPED (single NUMA node; set VSORT_NUMA_NODES)\n");
+    return 1;
+}
+
+static int test_thread_count_override()
+{
+    printf("Testing thread count override... ");
+
+    vsort_set_thread_count(3);
+    int configured = vsort_thread_count();
+    vsort_set_thread_count(4);
+
+    if (configured != 3 || vsort_thread_count() != 4)
+    {
+        printf("FAILED: Unexpected thread count %d\n", configured);
+        return 0;
+    }
+
+    printf("PASSED\n");
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    printf("Running parallel vsort tests...\n\n");
+
+    srand(time(NULL));
+    vsort_set_thread_count(4);
+
+    // "numa" runs only the stripe sort test (under VSORT_NUMA_NODES, where
+    // the other parallel engines are not selected).
+    if (argc > 1 && strcmp(argv[1], "numa") == 0)
+        return test_parallel_numa() ? 0 : 1;
+
+    int passed = 1;
+    passed &= test_thread_count_override();
+    passed &= test_parallel_int32();
+    passed &= test_parallel_float32();
+    passed &= test_parallel_64bit();
+    passed &= test_parallel_merge_duplicates();
+    passed &= test_parallel_fork_join();
+    passed &= test_parallel_radix_int32();
+    passed &= test_parallel_in_place_radix();
+    passed &= test_parallel_generic_stable();
+    passed &= test_parallel_sort_by_key();
+    passed &= test_parallel_argsort();
+    passed &= test_parallel_sort_kv();
+    passed &= test_parallel_selection();
+    passed &= test_parallel_merge_runs();
+    passed &= test_parallel_stream();
+    passed &= test_parallel_context();
+    passed &= test_parallel_scratch_cache();
+    passed &= test_parallel_sort_batch();
+    passed &= test_parallel_async();
+    passed &= test_parallel_stats();
+    passed &= test_parallel_strings();
+    passed &= test_parallel_numa();
+
+    printf("\nTest summary: %s\n", passed ? "ALL PASSED" : "SOME TESTS FAILED");
+
+    return passed ? 0 : 1;
+}
@@ -2,7 +2,8 @@
  * VSort: High-Performance Sorting Algorithm (1.0.0)
  *
  * Modernized runtime with adaptive calibration, hybrid sorting strategies,
- * optional parallel execution on Apple Silicon, and an extensible public API.
+ * portable parallel execution on a persistent worker pool, and an extensible
+ * public API.
  */
 
 #if defined(__APPLE__)
@@ -11,6 +12,12 @@
 #endif
 #endif
 
+#if defined(__linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // sched_setaffinity and cpu_set_t for NUMA binding
+#endif
+#endif
+
 #if !defined(_WIN32) && !defined(_MSC_VER)
 #ifndef _POSIX_C_SOURCE
 #define _POSIX_C_SOURCE 200112L
@@ -26,7 +33,12 @@
 #include <string.h>
 
 #include "vsort.h"
+#include "vsort_flags.h"
 #include "vsort_logger.h"
+#include "vsort_merge.h"
+#include "vsort_pool.h"
+#include "vsort_scratch.h"
+#include "vsort_stats.h"
 
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -40,7 +52,6 @@
 #include <sys/types.h>
 #include <unistd.h>
 #if defined(VSORT_APPLE)
-#include <dispatch/dispatch.h>
 #include <sys/sysctl.h>
 #endif
 #endif
@@ -49,21 +60,55 @@
 #include <arm_neon.h>
 #endif
 
+#if defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define VSORT_NEON64 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64)) && !defined(VSORT_NO_X86_SIMD)
+#define VSORT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VSORT_TARGET_AVX2
+#define VSORT_TARGET_AVX512
+#else
+#define VSORT_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define VSORT_TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+#include <cpuid.h>
+#endif
+#endif
+
 #define VSORT_ALIGN 16
+#define VSORT_SCRATCH_ALIGN 64 // Arena blocks start on a cache line
+#define VSORT_NETWORK_MAX 64 // Largest leaf handled by the SIMD sorting networks
+#define VSORT_MIN_RUN 32      // Shortest natural run before it is extended by insertion sort
+#define VSORT_NINTHER_THRESHOLD 128     // Ranges above this use a ninther pivot
+#define VSORT_PARTIAL_INSERTION_LIMIT 8 // Moves before a partial insertion sort gives up
+#define VSORT_APPLE_E_THROUGHPUT 40     // Apple efficiency core, percent of a performance core
+#define VSORT_X86_E_THROUGHPUT 60       // Intel E-core (Gracemont and later), percent of a P-core
+#define VSORT_MAX_NUMA_NODES 16         // NUMA nodes tracked; CPUs of further nodes count towards none
 #define VSORT_UNUSED(x) ((void)(x))
+#define VSORT_CAT_(a, b) a##b
+#define VSORT_CAT(a, b) VSORT_CAT_(a, b)
+#define VSORT_CAT3_(a, b, c) a##b##c
+#define VSORT_CAT3(a, b, c) VSORT_CAT3_(a, b, c)
 #define VSORT_MIN(a, b) ((a) < (b) ? (a) : (b))
 #define VSORT_MAX(a, b) ((a) > (b) ? (a) : (b))
 #define VSORT_CLAMP(x, lo, hi) (VSORT_MAX((lo), VSORT_MIN((x), (hi))))
 
-static unsigned int vsort_clz32(unsigned int value)
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VSORT_THREAD_LOCAL __declspec(thread)
+#else
+#define VSORT_THREAD_LOCAL _Thread_local
+#endif
+
+static unsigned int vsort_popcount32(unsigned int value)
 {
-#if defined(_MSC_VER)
-    unsigned long index;
-    if (_BitScanReverse(&index, value))
-        return 31u - index;
-    return 32u;
+#if defined(_MSC_VER) && !defined(__clang__)
+    value = value - ((value >> 1) & 0x55555555u);
+    value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+    return (((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
 #else
-    return value ? (unsigned int)__builtin_clz(value) : 32u;
+    return (unsigned int)__builtin_popcount(value);
 #endif
 }
 
@@ -72,7 +117,8 @@ typedef struct
     size_t insertion_threshold;
     size_t parallel_threshold;
     size_t radix_threshold;
-    size_t sample_size;
+    size_t radix_bits;
+    size_t adaptive_run_length;
     size_t cache_optimal_elements;
 } vsort_thresholds_t;
 
@@ -81,6 +127,9 @@ typedef struct
     int total_cores;
     int performance_cores;
     int efficiency_cores;
+    int efficiency_throughput; /**< Work an efficiency core does, percent of a performance core */
+    int numa_nodes;                      /**< Nodes with CPUs, 1 when not NUMA */
+    int numa_cpus[VSORT_MAX_NUMA_NODES]; /**< CPUs per node */
     size_t l1_cache;
     size_t l2_cache;
     size_t l3_cache;
@@ -91,29 +140,14 @@ typedef struct
     char cpu_model[128];
 } vsort_hardware_t;
 
-typedef struct
-{
-    size_t int_size;
-    int *int_buffer;
-    size_t float_size;
-    float *float_buffer;
-#if defined(_WIN32) || defined(_MSC_VER)
-    volatile LONG int_in_use;
-    volatile LONG float_in_use;
-#else
-    atomic_flag int_in_use;
-    atomic_flag float_in_use;
-#endif
-} vsort_merge_pool_t;
-
 typedef struct
 {
     vsort_thresholds_t thresholds;
     vsort_hardware_t hardware;
     unsigned int default_flags;
+    int thread_count;
     vsort_log_level_t log_level;
     bool logger_ready;
-    vsort_merge_pool_t merge_pool;
 } vsort_runtime_t;
 
 static vsort_runtime_t g_runtime = {
@@ -121,12 +155,15 @@ static vsort_runtime_t g_runtime = {
         .insertion_threshold = 32,
         .parallel_threshold = 1u << 17,
         .radix_threshold = 1u << 18,
-        .sample_size = 96,
+        .radix_bits = 8,
+        .adaptive_run_length = 64,
         .cache_optimal_elements = 8192},
     .hardware = {
         .total_cores = 1,
         .performance_cores = 1,
         .efficiency_cores = 0,
+        .efficiency_throughput = 100,
+        .numa_nodes = 1,
         .l1_cache = 32768,
         .l2_cache = 2097152,
         .l3_cache = 0,
@@ -136,13 +173,9 @@ static vsort_runtime_t g_runtime = {
         .has_simd = false,
         .cpu_model = "Generic CPU"},
     .default_flags = VSORT_FLAG_ALLOW_PARALLEL | VSORT_FLAG_ALLOW_RADIX | VSORT_FLAG_PREFER_THROUGHPUT,
+    .thread_count = 0,
     .log_level = VSORT_LOG_WARNING,
     .logger_ready = false,
-#if defined(_WIN32) || defined(_MSC_VER)
-    .merge_pool = {.int_size = 0, .int_buffer = NULL, .float_size = 0, .float_buffer = NULL, .int_in_use = 0, .float_in_use = 0},
-#else
-    .merge_pool = {.int_size = 0, .int_buffer = NULL, .float_size = 0, .float_buffer = NULL, .int_in_use = ATOMIC_FLAG_INIT, .float_in_use = ATOMIC_FLAG_INIT},
-#endif
 };
 
 #if defined(_WIN32) || defined(_MSC_VER)
@@ -156,50 +189,37 @@ static vsort_runtime_t *vsort_runtime(void);
 static void vsort_runtime_initialize(void);
 static void vsort_detect_hardware(vsort_runtime_t *rt);
 static void vsort_calibrate_thresholds(vsort_runtime_t *rt);
+static size_t vsort_network_lanes(const vsort_hardware_t *hw);
 static int vsort_detect_physical_core_count(void);
+static void vsort_tuning_startup(void);
 
 static void *vsort_aligned_malloc(size_t size);
 static void vsort_aligned_free(void *ptr);
+static void *vsort_scratch_alloc(size_t size);
+static void vsort_scratch_free(void *ptr);
+static size_t vsort_available_memory(void);
 
 static void vsort_counting_sort_char(unsigned char *data, size_t count);
 
+// Generated from vsort_template.h further down, used by the per-type hooks.
 static void vsort_insertion_sort_int32(int *data, size_t count);
 static void vsort_insertion_sort_float32(float *data, size_t count);
-
-static void vsort_heapsort_int32(int *data, size_t count);
-static void vsort_heapsort_float32(float *data, size_t count);
-
-static void vsort_introsort_int32_impl(int *data, size_t count, size_t depth_limit, unsigned int flags);
-static void vsort_introsort_float32_impl(float *data, size_t count, size_t depth_limit);
+static void vsort_insertion_sort_int64(int64_t *data, size_t count);
+static void vsort_insertion_sort_uint64(uint64_t *data, size_t count);
+static void vsort_insertion_sort_float64(double *data, size_t count);
 static void vsort_introsort_int32(int *data, size_t count, unsigned int flags);
-static void vsort_introsort_float32(float *data, size_t count);
-
-static bool vsort_mergesort_int32(int *data, size_t count);
-static bool vsort_mergesort_float32(float *data, size_t count);
-static void vsort_mergesort_int32_impl(int *data, int *buffer, size_t left, size_t right);
-static void vsort_mergesort_float32_impl(float *data, float *buffer, size_t left, size_t right);
-static void vsort_merge_int32(int *data, int *buffer, size_t left, size_t mid, size_t right);
-static void vsort_merge_float32(float *data, float *buffer, size_t left, size_t mid, size_t right);
-
-static bool vsort_radix_sort_int32(int *data, size_t count);
-
-static bool vsort_is_nearly_sorted_int32(const int *data, size_t count, size_t sample_hint);
-static bool vsort_is_nearly_sorted_float32(const float *data, size_t count, size_t sample_hint);
+static void vsort_introsort_int64(int64_t *data, size_t count, unsigned int flags);
 
 static size_t vsort_floor_log2(size_t value);
-static size_t vsort_partition_int32(int *data, size_t count, unsigned int flags);
-static size_t vsort_partition_float32(float *data, size_t count);
+static void vsort_build_simd_tables(void);
 
-static int *vsort_merge_buffer_int32(size_t count);
-static void vsort_merge_buffer_release_int32(void);
-static float *vsort_merge_buffer_float32(size_t count);
-static void vsort_merge_buffer_release_float32(void);
-static void vsort_merge_pool_release(void);
+static int vsort_parallel_threads(unsigned int flags);
+static size_t vsort_parallel_slices(int threads);
 
-#if defined(VSORT_APPLE) && defined(__arm64__)
-static bool vsort_parallel_int32(int *data, size_t count, unsigned int flags);
-static bool vsort_parallel_float32(float *data, size_t count, unsigned int flags);
-#endif
+// Sorts one NUMA stripe; the per-type engines pass their sequential sort.
+typedef void (*vsort_numa_sort_fn)(void *data, size_t count, unsigned int flags);
+static bool vsort_numa_sort(void *data, size_t count, size_t element_size, vsort_data_kind_t kind,
+                            vsort_numa_sort_fn sort, unsigned int flags);
 
 // -----------------------------------------------------------------------------
 // Runtime helpers
@@ -225,6 +245,27 @@ VSORT_API unsigned int vsort_default_flags(void)
     return vsort_runtime()->default_flags;
 }
 
+unsigned int vsort_resolve_flags(unsigned int requested)
+{
+    unsigned int flags = requested ? requested : vsort_runtime()->default_flags;
+    if ((flags & VSORT_FLAG_PREFER_EFFICIENCY) && (flags & VSORT_FLAG_PREFER_THROUGHPUT))
+        flags &= ~VSORT_FLAG_PREFER_EFFICIENCY;
+    if (!(flags & VSORT_FLAG_PREFER_EFFICIENCY))
+        flags |= VSORT_FLAG_PREFER_THROUGHPUT;
+    return flags;
+}
+
+VSORT_API void vsort_set_thread_count(int threads)
+{
+    vsort_runtime()->thread_count = threads > 0 ? threads : 0;
+}
+
+VSORT_API int vsort_thread_count(void)
+{
+    vsort_init();
+    return vsort_parallel_threads(0);
+}
+
 #if defined(VSORT_APPLE)
 static bool vsort_sysctl_value(const char *name, void *value, size_t *size)
 {
@@ -234,6 +275,198 @@ static bool vsort_sysctl_value(const char *name, void *value, size_t *size)
 }
 #endif
 
+#if defined(VSORT_X86)
+// Widest usable vector register in bytes: 64 (AVX-512F), 32 (AVX2), 16 (SSE2).
+static int vsort_detect_x86_simd_width(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return 16;
+
+    __cpuidex(info, 1, 0);
+    bool osxsave = ((unsigned int)info[2] >> 27) & 1u;
+    bool avx = ((unsigned int)info[2] >> 28) & 1u;
+    if (!osxsave || !avx)
+        return 16;
+
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if ((xcr0 & 0xE6u) == 0xE6u && (((unsigned int)info[1] >> 16) & 1u))
+        return 64;
+    if ((xcr0 & 0x6u) == 0x6u && (((unsigned int)info[1] >> 5) & 1u))
+        return 32;
+    return 16;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return 64;
+    if (__builtin_cpu_supports("avx2"))
+        return 32;
+    return 16;
+#endif
+}
+#endif
+
+#if defined(VSORT_X86)
+// CPUID.07H:EDX[15]: the package mixes performance and efficiency cores.
+static bool vsort_detect_x86_hybrid(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuidex(info, 7, 0);
+    return ((unsigned int)info[3] >> 15) & 1u;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (edx >> 15) & 1u;
+#endif
+}
+#endif
+
+#if defined(VSORT_LINUX)
+// CPU sets of the NUMA nodes counted in vsort_hardware_t::numa_cpus.
+static cpu_set_t g_numa_cpusets[VSORT_MAX_NUMA_NODES];
+
+// Number of CPUs in a sysfs CPU list such as "0-7,16-23" (0 when unreadable),
+// added to set unless it is NULL.
+static int vsort_read_cpulist(const char *path, cpu_set_t *set)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return 0;
+
+    int count = 0;
+    int first = 0;
+    while (fscanf(f, "%d", &first) == 1)
+    {
+        int last = first;
+        int separator = fgetc(f);
+        if (separator == '-')
+        {
+            if (fscanf(f, "%d", &last) != 1)
+                break;
+            separator = fgetc(f);
+        }
+        if (last >= first)
+            count += last - first + 1;
+        for (int cpu = first; set && cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+            CPU_SET(cpu, set);
+        if (separator != ',')
+            break;
+    }
+    fclose(f);
+    return count;
+}
+
+// Splits the CPUs into performance and efficiency classes. Per-CPU
+// cpu_capacity (big.LITTLE and recent hybrid x86 kernels) gives both the
+// classes and their relative throughput; otherwise hybrid Intel parts list
+// their P- and E-cores under the cpu_core and cpu_atom PMU devices.
+static void vsort_detect_linux_core_classes(vsort_hardware_t *hw)
+{
+    char path[256];
+    long capacity_max = 0;
+    long capacity_other = 0;
+    int top = 0;
+    int other = 0;
+    for (int cpu = 0; cpu < hw->total_cores; ++cpu)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+        FILE *f = fopen(path, "r");
+        long capacity = 0;
+        if (!f)
+            break;
+        if (fscanf(f, "%ld", &capacity) != 1)
+            capacity = 0;
+        fclose(f);
+        if (capacity <= 0)
+            break;
+
+        if (capacity > capacity_max)
+        {
+            other += top;
+            capacity_other += capacity_max * top;
+            capacity_max = capacity;
+            top = 1;
+        }
+        else if (capacity == capacity_max)
+            top++;
+        else
+        {
+            other++;
+            capacity_other += capacity;
+        }
+    }
+
+    if (top + other == hw->total_cores && other > 0)
+    {
+        hw->performance_cores = top;
+        hw->efficiency_cores = other;
+        hw->efficiency_throughput = (int)(capacity_other * 100 / ((long)other * capacity_max));
+        return;
+    }
+
+#if defined(VSORT_X86)
+    if (!vsort_detect_x86_hybrid())
+        return;
+    int p_cores = vsort_read_cpulist("/sys/devices/cpu_core/cpus", NULL);
+    int e_cores = vsort_read_cpulist("/sys/devices/cpu_atom/cpus", NULL);
+    if (p_cores > 0 && e_cores > 0 && p_cores + e_cores <= hw->total_cores)
+    {
+        hw->performance_cores = hw->total_cores - e_cores;
+        hw->efficiency_cores = e_cores;
+        hw->efficiency_throughput = VSORT_X86_E_THROUGHPUT;
+    }
+#endif
+}
+
+// Nodes with CPUs, as listed by /sys/devices/system/node/has_cpu (node
+// numbers need not be contiguous); memory-only nodes are skipped.
+static void vsort_detect_linux_numa(vsort_hardware_t *hw)
+{
+    char path[256];
+    int nodes = 0;
+    cpu_set_t listed; // Node numbers, parsed with the cpulist reader
+    CPU_ZERO(&listed);
+    if (vsort_read_cpulist("/sys/devices/system/node/has_cpu", &listed) == 0)
+        vsort_read_cpulist("/sys/devices/system/node/online", &listed);
+    for (int node = 0; node < CPU_SETSIZE && nodes < VSORT_MAX_NUMA_NODES; ++node)
+    {
+        if (!CPU_ISSET(node, &listed))
+            continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        CPU_ZERO(&g_numa_cpusets[nodes]);
+        int cpus = vsort_read_cpulist(path, &g_numa_cpusets[nodes]);
+        if (cpus > 0)
+            hw->numa_cpus[nodes++] = cpus;
+    }
+
+    // VSORT_NUMA_NODES splits a host with fewer nodes into that many
+    // simulated nodes spanning every CPU, so the stripe sort can be tested
+    // without NUMA hardware.
+    const char *simulate = getenv("VSORT_NUMA_NODES");
+    int simulated = simulate ? atoi(simulate) : 0;
+    cpu_set_t all;
+    if (simulated > nodes && simulated <= VSORT_MAX_NUMA_NODES && sched_getaffinity(0, sizeof(all), &all) == 0)
+    {
+        for (nodes = 0; nodes < simulated; ++nodes)
+        {
+            g_numa_cpusets[nodes] = all;
+            hw->numa_cpus[nodes] = VSORT_MAX(1, hw->total_cores / simulated);
+        }
+    }
+
+    if (nodes > 1)
+        hw->numa_nodes = nodes;
+}
+#endif
+
 static void vsort_detect_hardware(vsort_runtime_t *rt)
 {
     vsort_hardware_t *hw = &rt->hardware;
@@ -243,6 +476,9 @@ static void vsort_detect_hardware(vsort_runtime_t *rt)
         hw->total_cores = 1;
     hw->performance_cores = hw->total_cores;
     hw->efficiency_cores = 0;
+    hw->efficiency_throughput = 100;
+    hw->numa_nodes = 1;
+    hw->numa_cpus[0] = hw->total_cores;
     hw->simd_width = 0;
     hw->has_simd = false;
     hw->has_neon = false;
@@ -282,6 +518,8 @@ static void vsort_detect_hardware(vsort_runtime_t *rt)
         if (hw->efficiency_cores < 0)
             hw->efficiency_cores = 0;
     }
+    if (hw->efficiency_cores > 0)
+        hw->efficiency_throughput = VSORT_APPLE_E_THROUGHPUT;
 
     size = sizeof(hw->cache_line);
     if (!vsort_sysctl_value("hw.cachelinesize", &hw->cache_line, &size))
@@ -316,6 +554,13 @@ static void vsort_detect_hardware(vsort_runtime_t *rt)
 #elif defined(VSORT_LINUX)
     hw->performance_cores = hw->total_cores;
     hw->efficiency_cores = 0;
+    vsort_detect_linux_core_classes(hw);
+    vsort_detect_linux_numa(hw);
+
+#if defined(VSORT_X86)
+    hw->simd_width = vsort_detect_x86_simd_width();
+    hw->has_simd = hw->simd_width > 0;
+#endif
 
 #ifdef __ARM_NEON
     hw->has_simd = true;
@@ -384,6 +629,10 @@ static void vsort_detect_hardware(vsort_runtime_t *rt)
         hw->cpu_model[sizeof(hw->cpu_model) - 1] = '\0';
     }
 #else
+#if defined(VSORT_X86)
+    hw->simd_width = vsort_detect_x86_simd_width();
+    hw->has_simd = hw->simd_width > 0;
+#endif
     strncpy(hw->cpu_model, "Generic CPU", sizeof(hw->cpu_model) - 1);
     hw->cpu_model[sizeof(hw->cpu_model) - 1] = '\0';
 #endif
@@ -399,10 +648,19 @@ static void vsort_calibrate_thresholds(vsort_runtime_t *rt)
 
     size_t insertion = l1 / (sizeof(int) * 4);
     insertion = VSORT_CLAMP(insertion, 16, 64);
+
+    // With a leaf network the leaf cost grows with the padded register
+    // count rather than quadratically, so larger leaves pay off.
+    size_t lanes = vsort_network_lanes(hw);
+    if (lanes >= 8)
+        insertion = VSORT_NETWORK_MAX;
+    else if (lanes >= 4)
+        insertion = VSORT_NETWORK_MAX / 2;
     th->insertion_threshold = insertion;
 
-    size_t sample = VSORT_CLAMP(insertion * 6, 48, 256);
-    th->sample_size = sample;
+    // Runs must on average beat a couple of leaves for merging them to be
+    // cheaper than sorting from scratch.
+    th->adaptive_run_length = VSORT_MAX(insertion * 2, (size_t)VSORT_MIN_RUN * 2);
 
     size_t parallel = l2 / sizeof(int);
     if (parallel < (size_t)1 << 15)
@@ -419,8 +677,16 @@ static void vsort_calibrate_thresholds(vsort_runtime_t *rt)
     size_t radix = (l2 / sizeof(int)) * 2;
     if (radix < (size_t)1 << 18)
         radix = (size_t)1 << 18;
+    if (radix > (size_t)1 << 22)
+        radix = (size_t)1 << 22;
     th->radix_threshold = radix;
 
+    // 11-bit digits save a pass when the 2048-bucket histogram fits in L1 and
+    // L2 can hold a line per bucket for the scatter write streams.
+    size_t line = hw->cache_line ? hw->cache_line : 64;
+    bool wide_digits = l1 >= ((size_t)1 << 11) * sizeof(size_t) * 2 && l2 >= ((size_t)1 << 11) * line * 4;
+    th->radix_bits = wide_digits ? 11 : 8;
+
     size_t cache_optimal = l1 / sizeof(int);
     if (cache_optimal < insertion * 4)
         cache_optimal = insertion * 4;
@@ -464,31 +730,26 @@ static void vsort_runtime_initialize(void)
 
     vsort_detect_hardware(rt);
     vsort_calibrate_thresholds(rt);
+    vsort_build_simd_tables();
+    vsort_scratch_cache_init();
+    vsort_tuning_startup();
 
-    vsort_log_info("VSort runtime initialized on %s with %d total core(s) (%d performance, %d efficiency).",
+    vsort_log_info("VSort runtime initialized on %s with %d total core(s) (%d performance, %d efficiency at %d%%).",
                    rt->hardware.cpu_model,
                    rt->hardware.total_cores,
                    rt->hardware.performance_cores,
-                   rt->hardware.efficiency_cores);
-    vsort_log_debug("Threshold configuration - insertion: %zu, sample: %zu, parallel: %zu, radix: %zu, cache-optimal: %zu",
+                   rt->hardware.efficiency_cores,
+                   rt->hardware.efficiency_throughput);
+    if (rt->hardware.numa_nodes > 1)
+        vsort_log_info("%d NUMA nodes detected.", rt->hardware.numa_nodes);
+    vsort_log_debug("Threshold configuration - insertion: %zu, adaptive run: %zu, parallel: %zu, radix: %zu (%zu-bit), cache-optimal: %zu",
                     rt->thresholds.insertion_threshold,
-                    rt->thresholds.sample_size,
+                    rt->thresholds.adaptive_run_length,
                     rt->thresholds.parallel_threshold,
                     rt->thresholds.radix_threshold,
+                    rt->thresholds.radix_bits,
                     rt->thresholds.cache_optimal_elements);
 
-    rt->merge_pool.int_size = 0;
-    rt->merge_pool.int_buffer = NULL;
-    rt->merge_pool.float_size = 0;
-    rt->merge_pool.float_buffer = NULL;
-#if defined(_WIN32) || defined(_MSC_VER)
-    rt->merge_pool.int_in_use = 0;
-    rt->merge_pool.float_in_use = 0;
-#else
-    atomic_flag_clear(&rt->merge_pool.int_in_use);
-    atomic_flag_clear(&rt->merge_pool.float_in_use);
-#endif
-
 #if !defined(_WIN32) && !defined(_MSC_VER)
     atomic_store(&g_runtime_ready, true);
 #endif
@@ -510,7 +771,8 @@ VSORT_API void vsort_init(void)
     static bool release_registered = false;
     if (!release_registered)
     {
-        atexit(vsort_merge_pool_release);
+        atexit(vsort_scratch_cache_shutdown);
+        atexit(vsort_pool_shutdown);
         release_registered = true;
     }
 }
@@ -521,7 +783,8 @@ VSORT_API void vsort_init(void)
     if (atomic_compare_exchange_strong(&g_runtime_init_requested, &expected, true))
     {
         vsort_runtime_initialize();
-        atexit(vsort_merge_pool_release);
+        atexit(vsort_scratch_cache_shutdown);
+        atexit(vsort_pool_shutdown);
     }
     else
     {
@@ -570,152 +833,187 @@ static void vsort_aligned_free(void *ptr)
 #endif
 }
 
-static void vsort_merge_pool_release(void)
-{
-    vsort_runtime_t *rt = vsort_runtime();
-    vsort_aligned_free(rt->merge_pool.int_buffer);
-    vsort_aligned_free(rt->merge_pool.float_buffer);
-    rt->merge_pool.int_buffer = NULL;
-    rt->merge_pool.float_buffer = NULL;
-    rt->merge_pool.int_size = 0;
-    rt->merge_pool.float_size = 0;
-#if defined(_WIN32) || defined(_MSC_VER)
-    rt->merge_pool.int_in_use = 0;
-    rt->merge_pool.float_in_use = 0;
-#else
-    atomic_flag_clear(&rt->merge_pool.int_in_use);
-    atomic_flag_clear(&rt->merge_pool.float_in_use);
-#endif
-}
-
-static int *vsort_merge_buffer_int32(size_t count)
+// Best-effort estimate of physical memory available to this process.
+// Returns 0 when the platform offers no usable figure.
+static size_t vsort_available_memory(void)
 {
-    vsort_runtime_t *rt = vsort_runtime();
 #if defined(_WIN32) || defined(_MSC_VER)
-    if (InterlockedExchange(&rt->merge_pool.int_in_use, 1) != 0)
-        return NULL;
-#else
-    if (atomic_flag_test_and_set(&rt->merge_pool.int_in_use))
-        return NULL;
-#endif
-
-    if (rt->merge_pool.int_size < count)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status))
+        return (size_t)VSORT_MIN(status.ullAvailPhys, (DWORDLONG)SIZE_MAX);
+    return 0;
+#elif defined(VSORT_APPLE)
+    uint64_t total = 0;
+    size_t size = sizeof(total);
+    if (!vsort_sysctl_value("hw.memsize", &total, &size))
+        return 0;
+    return (size_t)VSORT_MIN(total / 2, (uint64_t)SIZE_MAX);
+#elif defined(VSORT_LINUX)
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f)
     {
-        vsort_aligned_free(rt->merge_pool.int_buffer);
-        rt->merge_pool.int_buffer = vsort_aligned_malloc(count * sizeof(int));
-        if (!rt->merge_pool.int_buffer)
+        char line[256];
+        unsigned long long kib = 0;
+        while (fgets(line, sizeof(line), f))
         {
-            rt->merge_pool.int_size = 0;
-#if defined(_WIN32) || defined(_MSC_VER)
-            InterlockedExchange(&rt->merge_pool.int_in_use, 0);
-#else
-            atomic_flag_clear(&rt->merge_pool.int_in_use);
-#endif
-            return NULL;
+            if (sscanf(line, "MemAvailable: %llu kB", &kib) == 1)
+                break;
         }
-        rt->merge_pool.int_size = count;
+        fclose(f);
+        if (kib > 0)
+            return (size_t)VSORT_MIN(kib * 1024ull, (unsigned long long)SIZE_MAX);
     }
-    return rt->merge_pool.int_buffer;
-}
-
-static void vsort_merge_buffer_release_int32(void)
-{
-    vsort_runtime_t *rt = vsort_runtime();
-#if defined(_WIN32) || defined(_MSC_VER)
-    InterlockedExchange(&rt->merge_pool.int_in_use, 0);
+#if defined(_SC_AVPHYS_PAGES) && defined(_SC_PAGESIZE)
+    long pages = sysconf(_SC_AVPHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0)
+        return (size_t)pages * (size_t)page_size;
+#endif
+    return 0;
 #else
-    atomic_flag_clear(&rt->merge_pool.int_in_use);
+    return 0;
 #endif
 }
 
-static float *vsort_merge_buffer_float32(size_t count)
+// -----------------------------------------------------------------------------
+// Scratch memory
+// -----------------------------------------------------------------------------
+//
+// Engine scratch (merge and radix buffers, histograms, key entries) comes
+// from vsort_scratch_alloc. With a vsort_context_t bound to the calling
+// thread it is carved from the context's arena as a stack: a freed block is
+// reclaimed once every block above it is free as well. Demand beyond the
+// arena is served from the heap and recorded, and an owned arena grows to
+// the recorded peak when the last block is released, so repeated calls of
+// the same size allocate nothing. Without a context scratch comes from the
+// process-wide size-classed cache in vsort_scratch.c.
+
+typedef struct
 {
-    vsort_runtime_t *rt = vsort_runtime();
-#if defined(_WIN32) || defined(_MSC_VER)
-    if (InterlockedExchange(&rt->merge_pool.float_in_use, 1) != 0)
-        return NULL;
-#else
-    if (atomic_flag_test_and_set(&rt->merge_pool.float_in_use))
-        return NULL;
-#endif
+    size_t prev;  /**< Arena offset of the block below, SIZE_MAX for none */
+    size_t bytes; /**< Block size including this header */
+    bool released;
+    bool heap;    /**< Served from the heap because the arena was full */
+} vsort_scratch_header_t;
 
-    if (rt->merge_pool.float_size < count)
-    {
-        vsort_aligned_free(rt->merge_pool.float_buffer);
-        rt->merge_pool.float_buffer = vsort_aligned_malloc(count * sizeof(float));
-        if (!rt->merge_pool.float_buffer)
-        {
-            rt->merge_pool.float_size = 0;
-#if defined(_WIN32) || defined(_MSC_VER)
-            InterlockedExchange(&rt->merge_pool.float_in_use, 0);
-#else
-            atomic_flag_clear(&rt->merge_pool.float_in_use);
-#endif
-            return NULL;
-        }
-        rt->merge_pool.float_size = count;
-    }
-    return rt->merge_pool.float_buffer;
-}
+#define VSORT_SCRATCH_HEADER VSORT_SCRATCH_ALIGN
 
-static void vsort_merge_buffer_release_float32(void)
+struct vsort_context
 {
-    vsort_runtime_t *rt = vsort_runtime();
-#if defined(_WIN32) || defined(_MSC_VER)
-    InterlockedExchange(&rt->merge_pool.float_in_use, 0);
-#else
-    atomic_flag_clear(&rt->merge_pool.float_in_use);
-#endif
-}
+    unsigned char *memory; /**< As allocated or handed over */
+    unsigned char *base;   /**< memory rounded up to VSORT_SCRATCH_ALIGN */
+    size_t capacity;
+    size_t top;            /**< Arena bytes in use */
+    size_t last;           /**< Offset of the topmost block, SIZE_MAX for none */
+    size_t blocks;         /**< Outstanding blocks, arena and heap */
+    size_t demand;         /**< Outstanding bytes, arena and heap */
+    size_t peak;           /**< Largest demand seen */
+    bool owned;            /**< memory belongs to the context and may grow */
+};
 
-// -----------------------------------------------------------------------------
-// Sorting primitives
-// -----------------------------------------------------------------------------
+static VSORT_THREAD_LOCAL vsort_context_t *t_vsort_context = NULL;
 
-static inline void vsort_swap_int(int *a, int *b)
+static void vsort_context_attach(vsort_context_t *context, unsigned char *memory, size_t bytes)
 {
-    int tmp = *a;
-    *a = *b;
-    *b = tmp;
+    uintptr_t address = (uintptr_t)memory;
+    size_t skew = (size_t)((VSORT_SCRATCH_ALIGN - address % VSORT_SCRATCH_ALIGN) % VSORT_SCRATCH_ALIGN);
+    context->memory = memory;
+    context->base = memory ? memory + VSORT_MIN(skew, bytes) : NULL;
+    context->capacity = memory && bytes > skew ? (bytes - skew) / VSORT_SCRATCH_ALIGN * VSORT_SCRATCH_ALIGN : 0;
+    context->top = 0;
+    context->last = SIZE_MAX;
 }
 
-static inline void vsort_swap_float(float *a, float *b)
+// Replaces an idle owned arena with one of at least bytes.
+static bool vsort_context_grow(vsort_context_t *context, size_t bytes)
 {
-    float tmp = *a;
-    *a = *b;
-    *b = tmp;
+    if (bytes > SIZE_MAX - VSORT_SCRATCH_ALIGN)
+        return false;
+    vsort_aligned_free(context->memory);
+    unsigned char *memory = (unsigned char *)vsort_aligned_malloc(bytes + VSORT_SCRATCH_ALIGN);
+    vsort_context_attach(context, memory, memory ? bytes + VSORT_SCRATCH_ALIGN : 0);
+    return memory != NULL;
 }
 
-static void vsort_insertion_sort_int32(int *data, size_t count)
+static vsort_scratch_header_t *vsort_scratch_block(const vsort_context_t *context, size_t offset)
 {
-    for (size_t i = 1; i < count; ++i)
+    return (vsort_scratch_header_t *)(context->base + offset);
+}
+
+static void *vsort_scratch_alloc(size_t size)
+{
+    vsort_context_t *context = t_vsort_context;
+    vsort_stats_allocated(size);
+    if (!context)
+        return vsort_scratch_cache_acquire(size);
+    if (size == 0 || size > SIZE_MAX - 2 * VSORT_SCRATCH_ALIGN)
+        return NULL;
+
+    size_t bytes = VSORT_SCRATCH_HEADER + (size + VSORT_SCRATCH_ALIGN - 1) / VSORT_SCRATCH_ALIGN * VSORT_SCRATCH_ALIGN;
+    vsort_scratch_header_t *header;
+    if (bytes <= context->capacity - context->top)
     {
-        int value = data[i];
-        size_t j = i;
-        while (j > 0 && data[j - 1] > value)
-        {
-            data[j] = data[j - 1];
-            --j;
-        }
-        data[j] = value;
+        header = vsort_scratch_block(context, context->top);
+        header->prev = context->last;
+        header->heap = false;
+        context->last = context->top;
+        context->top += bytes;
     }
+    else
+    {
+        header = (vsort_scratch_header_t *)vsort_aligned_malloc(bytes);
+        if (!header)
+            return NULL;
+        header->prev = SIZE_MAX;
+        header->heap = true;
+    }
+
+    header->bytes = bytes;
+    header->released = false;
+    context->blocks++;
+    context->demand += bytes;
+    context->peak = VSORT_MAX(context->peak, context->demand);
+    return (unsigned char *)header + VSORT_SCRATCH_HEADER;
 }
 
-static void vsort_insertion_sort_float32(float *data, size_t count)
+static void vsort_scratch_free(void *ptr)
 {
-    for (size_t i = 1; i < count; ++i)
+    vsort_context_t *context = t_vsort_context;
+    if (!context)
     {
-        float value = data[i];
-        size_t j = i;
-        while (j > 0 && data[j - 1] > value)
+        vsort_scratch_cache_release(ptr);
+        return;
+    }
+    if (!ptr)
+        return;
+
+    vsort_scratch_header_t *header = (vsort_scratch_header_t *)((unsigned char *)ptr - VSORT_SCRATCH_HEADER);
+    context->blocks--;
+    context->demand -= header->bytes;
+    if (header->heap)
+        vsort_aligned_free(header);
+    else
+    {
+        header->released = true;
+        while (context->last != SIZE_MAX && vsort_scratch_block(context, context->last)->released)
         {
-            data[j] = data[j - 1];
-            --j;
+            context->top = context->last;
+            context->last = vsort_scratch_block(context, context->last)->prev;
         }
-        data[j] = value;
+    }
+
+    if (context->blocks == 0 && context->owned && context->peak > context->capacity)
+    {
+        vsort_log_debug("Growing sort context arena from %zu to %zu bytes.", context->capacity, context->peak);
+        vsort_context_grow(context, context->peak);
     }
 }
 
+// -----------------------------------------------------------------------------
+// Sorting primitives
+// -----------------------------------------------------------------------------
+
 static void vsort_counting_sort_char(unsigned char *data, size_t count)
 {
     size_t histogram[256] = {0};
@@ -743,894 +1041,3958 @@ static size_t vsort_floor_log2(size_t value)
     return result;
 }
 
-static void vsort_heapify_down_int32(int *data, size_t count, size_t root)
+// -----------------------------------------------------------------------------
+// Partition kernels
+// -----------------------------------------------------------------------------
+//
+// Every kernel partitions data[0, count) around pivot so that the elements
+// that compare < pivot (<= pivot when strict is false) end up in data[0, k)
+// and the rest in data[k, count), and returns k. The vector kernels work on
+// 32-bit lanes for both int32 and float32 (is_float selects the comparison),
+// and on 64-bit lanes for int64, uint64 and double (vsort_lane_order_t
+// selects it), in the style of vqsort: one vector is buffered at each end,
+// the next vector is read from whichever side has less free space, and its
+// lanes are compressed to the left write cursor and the right write cursor.
+// The unread tail and the two buffered vectors are finished by a scalar pass
+// at the end.
+
+#define VSORT_SIMD_PARTITION_MIN 64
+
+static inline bool vsort_lane_goes_left32(int32_t value, int32_t pivot, bool is_float, bool strict)
 {
-    while (true)
+    if (is_float)
     {
-        size_t child = root * 2 + 1;
-        if (child >= count)
-            break;
-
-        if (child + 1 < count && data[child] < data[child + 1])
-            child++;
-
-        if (data[root] >= data[child])
-            break;
-
-        vsort_swap_int(&data[root], &data[child]);
-        root = child;
+        float a;
+        float b;
+        memcpy(&a, &value, sizeof(a));
+        memcpy(&b, &pivot, sizeof(b));
+        return strict ? a < b : a <= b;
     }
+    return strict ? value < pivot : value <= pivot;
 }
 
-static void vsort_heapsort_int32(int *data, size_t count)
+// Scalar finish shared by the vector kernels: tmp holds count lanes that are
+// no longer stored anywhere in data, and [left, right) is exactly their room.
+static size_t vsort_partition_drain32(int32_t *data, size_t left, size_t right, const int32_t *tmp, size_t count,
+                                      int32_t pivot, bool is_float, bool strict)
 {
-    if (count < 2)
-        return;
-
-    for (size_t i = count / 2; i-- > 0;)
-        vsort_heapify_down_int32(data, count, i);
-
-    for (size_t i = count - 1; i > 0; --i)
+    for (size_t i = 0; i < count; ++i)
     {
-        vsort_swap_int(&data[0], &data[i]);
-        vsort_heapify_down_int32(data, i, 0);
+        if (vsort_lane_goes_left32(tmp[i], pivot, is_float, strict))
+            memcpy(data + left++, tmp + i, sizeof(int32_t));
+        else
+            memcpy(data + --right, tmp + i, sizeof(int32_t));
     }
+    return left;
 }
 
-static void vsort_heapify_down_float32(float *data, size_t count, size_t root)
+#if defined(VSORT_X86)
+
+VSORT_TARGET_AVX512 static inline size_t vsort_partition_avx512_32(int32_t *data, size_t count, int32_t pivot, bool is_float,
+                                                                   bool strict)
 {
-    while (true)
+    const size_t width = 16;
+    const __m512i pivot_vec = _mm512_set1_epi32(pivot);
+    __m512i left_vec = _mm512_loadu_si512((const void *)data);
+    __m512i right_vec = _mm512_loadu_si512((const void *)(data + count - width));
+    size_t read_left = width;
+    size_t read_right = count - width;
+    size_t write_left = 0;
+    size_t write_right = count;
+
+    while (read_right - read_left >= width)
     {
-        size_t child = root * 2 + 1;
-        if (child >= count)
-            break;
-
-        if (child + 1 < count && data[child] < data[child + 1])
-            child++;
-
-        if (data[root] >= data[child])
-            break;
+        __m512i values;
+        if (read_left - write_left <= write_right - read_right)
+        {
+            values = _mm512_loadu_si512((const void *)(data + read_left));
+            read_left += width;
+        }
+        else
+        {
+            read_right -= width;
+            values = _mm512_loadu_si512((const void *)(data + read_right));
+        }
 
-        vsort_swap_float(&data[root], &data[child]);
-        root = child;
+        __mmask16 le;
+        if (is_float)
+            le = strict ? _mm512_cmp_ps_mask(_mm512_castsi512_ps(values), _mm512_castsi512_ps(pivot_vec), _CMP_LT_OQ)
+                        : _mm512_cmp_ps_mask(_mm512_castsi512_ps(values), _mm512_castsi512_ps(pivot_vec), _CMP_LE_OQ);
+        else
+            le = strict ? _mm512_cmplt_epi32_mask(values, pivot_vec) : _mm512_cmple_epi32_mask(values, pivot_vec);
+        size_t le_count = vsort_popcount32((unsigned int)le);
+        _mm512_mask_compressstoreu_epi32((void *)(data + write_left), le, values);
+        write_left += le_count;
+        write_right -= width - le_count;
+        _mm512_mask_compressstoreu_epi32((void *)(data + write_right), (__mmask16)~le, values);
     }
+
+    int32_t tmp[3 * 16];
+    size_t tail = read_right - read_left;
+    memcpy(tmp, data + read_left, tail * sizeof(int32_t));
+    _mm512_storeu_si512((void *)(tmp + tail), left_vec);
+    _mm512_storeu_si512((void *)(tmp + tail + width), right_vec);
+    return vsort_partition_drain32(data, write_left, write_right, tmp, tail + 2 * width, pivot, is_float, strict);
 }
 
-static void vsort_heapsort_float32(float *data, size_t count)
-{
-    if (count < 2)
-        return;
+// permutevar8x32 indices that move the lanes selected by mask to the front
+// (in order) and the remaining lanes to the back (in order).
+static uint32_t g_vsort_avx2_compress[256][8];
 
-    for (size_t i = count / 2; i-- > 0;)
-        vsort_heapify_down_float32(data, count, i);
+// The same for 64-bit lanes: each selected lane moves as two 32-bit halves.
+static uint32_t g_vsort_avx2_compress64[16][8];
 
-    for (size_t i = count - 1; i > 0; --i)
+static void vsort_build_avx2_tables(void)
+{
+    for (unsigned int mask = 0; mask < 256; ++mask)
+    {
+        unsigned int out = 0;
+        for (unsigned int lane = 0; lane < 8; ++lane)
+            if (mask & (1u << lane))
+                g_vsort_avx2_compress[mask][out++] = lane;
+        for (unsigned int lane = 0; lane < 8; ++lane)
+            if (!(mask & (1u << lane)))
+                g_vsort_avx2_compress[mask][out++] = lane;
+    }
+
+    for (unsigned int mask = 0; mask < 16; ++mask)
     {
-        vsort_swap_float(&data[0], &data[i]);
-        vsort_heapify_down_float32(data, i, 0);
+        unsigned int out = 0;
+        for (unsigned int pass = 0; pass < 2; ++pass)
+        {
+            for (unsigned int lane = 0; lane < 4; ++lane)
+            {
+                bool selected = (mask & (1u << lane)) != 0;
+                if (selected != (pass == 0))
+                    continue;
+                g_vsort_avx2_compress64[mask][out++] = lane * 2;
+                g_vsort_avx2_compress64[mask][out++] = lane * 2 + 1;
+            }
+        }
     }
 }
 
-static size_t vsort_partition_int32(int *data, size_t count, unsigned int flags)
+VSORT_TARGET_AVX2 static inline size_t vsort_partition_avx2_32(int32_t *data, size_t count, int32_t pivot, bool is_float,
+                                                               bool strict)
 {
-    size_t last = count - 1;
-    size_t mid = count / 2;
+    const size_t width = 8;
+    const __m256i pivot_vec = _mm256_set1_epi32(pivot);
+    __m256i left_vec = _mm256_loadu_si256((const __m256i *)data);
+    __m256i right_vec = _mm256_loadu_si256((const __m256i *)(data + count - width));
+    size_t read_left = width;
+    size_t read_right = count - width;
+    size_t write_left = 0;
+    size_t write_right = count;
+
+    while (read_right - read_left >= width)
+    {
+        __m256i values;
+        if (read_left - write_left <= write_right - read_right)
+        {
+            values = _mm256_loadu_si256((const __m256i *)(data + read_left));
+            read_left += width;
+        }
+        else
+        {
+            read_right -= width;
+            values = _mm256_loadu_si256((const __m256i *)(data + read_right));
+        }
 
-    if (data[0] > data[mid])
-        vsort_swap_int(&data[0], &data[mid]);
-    if (data[mid] > data[last])
-        vsort_swap_int(&data[mid], &data[last]);
-    if (data[0] > data[mid])
-        vsort_swap_int(&data[0], &data[mid]);
+        unsigned int le;
+        if (is_float && strict)
+            le = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_castsi256_ps(values), _mm256_castsi256_ps(pivot_vec), _CMP_LT_OQ));
+        else if (is_float)
+            le = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_castsi256_ps(values), _mm256_castsi256_ps(pivot_vec), _CMP_LE_OQ));
+        else if (strict)
+            le = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot_vec, values)));
+        else
+            le = ~(unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(values, pivot_vec))) & 0xFFu;
+
+        // Both sides have at least one vector of free space here, so the two
+        // full-width stores cannot clobber unread input.
+        size_t le_count = vsort_popcount32(le);
+        __m256i order = _mm256_loadu_si256((const __m256i *)g_vsort_avx2_compress[le]);
+        __m256i packed = _mm256_permutevar8x32_epi32(values, order);
+        _mm256_storeu_si256((__m256i *)(data + write_left), packed);
+        _mm256_storeu_si256((__m256i *)(data + write_right - width), packed);
+        write_left += le_count;
+        write_right -= width - le_count;
+    }
 
-    vsort_swap_int(&data[mid], &data[last]);
-    int pivot = data[last];
+    int32_t tmp[3 * 8];
+    size_t tail = read_right - read_left;
+    memcpy(tmp, data + read_left, tail * sizeof(int32_t));
+    _mm256_storeu_si256((__m256i *)(tmp + tail), left_vec);
+    _mm256_storeu_si256((__m256i *)(tmp + tail + width), right_vec);
+    return vsort_partition_drain32(data, write_left, write_right, tmp, tail + 2 * width, pivot, is_float, strict);
+}
 
-    size_t i = 0;
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    bool allow_simd = (flags & VSORT_FLAG_FORCE_SIMD) != 0u && vsort_runtime()->hardware.has_neon;
-    if (allow_simd && count >= 32)
-    {
-        int32x4_t pivot_vec = vdupq_n_s32(pivot);
-        size_t j = 0;
-        for (; j + 4 <= last; j += 4)
-        {
-            int32x4_t values = vld1q_s32(data + j);
-            uint32x4_t mask = vcleq_s32(values, pivot_vec);
-            uint64_t mask_bits = vgetq_lane_u64(vreinterpretq_u64_u32(mask), 0) |
-                                 (vgetq_lane_u64(vreinterpretq_u64_u32(mask), 1) << 32);
-            if (mask_bits == 0xFFFFFFFFFFFFFFFFULL)
-            {
-                if (i == j)
-                {
-                    i += 4;
-                }
-                else
-                {
-                    for (size_t k = 0; k < 4; ++k)
-                    {
-                        if (data[j + k] <= pivot)
-                        {
-                            vsort_swap_int(&data[i], &data[j + k]);
-                            ++i;
-                        }
-                    }
-                }
-            }
-            else if (mask_bits != 0)
-            {
-                for (size_t k = 0; k < 4; ++k)
-                {
-                    if (data[j + k] <= pivot)
-                    {
-                        vsort_swap_int(&data[i], &data[j + k]);
-                        ++i;
-                    }
-                }
-            }
-        }
-        for (; j < last; ++j)
+#endif
+
+#if defined(VSORT_NEON64)
+
+// vqtbl1q_u8 byte shuffles that move the 32-bit lanes selected by mask to
+// the front and the remaining lanes to the back.
+static uint8_t g_vsort_neon_compress[16][16];
+
+static void vsort_build_neon_tables(void)
+{
+    for (unsigned int mask = 0; mask < 16; ++mask)
+    {
+        unsigned int out = 0;
+        for (unsigned int pass = 0; pass < 2; ++pass)
         {
-            if (data[j] <= pivot)
+            for (unsigned int lane = 0; lane < 4; ++lane)
             {
-                vsort_swap_int(&data[i], &data[j]);
-                ++i;
+                bool selected = (mask & (1u << lane)) != 0;
+                if (selected != (pass == 0))
+                    continue;
+                for (unsigned int byte = 0; byte < 4; ++byte)
+                    g_vsort_neon_compress[mask][out * 4 + byte] = (uint8_t)(lane * 4 + byte);
+                out++;
             }
         }
-        vsort_swap_int(&data[i], &data[last]);
-        return i;
     }
-#endif
-    for (size_t j = 0; j < last; ++j)
+}
+
+static inline size_t vsort_partition_neon_32(int32_t *data, size_t count, int32_t pivot, bool is_float, bool strict)
+{
+    const size_t width = 4;
+    const uint32x4_t lane_bits = {1u, 2u, 4u, 8u};
+    const int32x4_t pivot_vec = vdupq_n_s32(pivot);
+    int32x4_t left_vec = vld1q_s32(data);
+    int32x4_t right_vec = vld1q_s32(data + count - width);
+    size_t read_left = width;
+    size_t read_right = count - width;
+    size_t write_left = 0;
+    size_t write_right = count;
+
+    while (read_right - read_left >= width)
     {
-        if (data[j] <= pivot)
+        int32x4_t values;
+        if (read_left - write_left <= write_right - read_right)
         {
-            vsort_swap_int(&data[i], &data[j]);
-            ++i;
+            values = vld1q_s32(data + read_left);
+            read_left += width;
+        }
+        else
+        {
+            read_right -= width;
+            values = vld1q_s32(data + read_right);
         }
+
+        uint32x4_t le_lanes;
+        if (is_float)
+            le_lanes = strict ? vcltq_f32(vreinterpretq_f32_s32(values), vreinterpretq_f32_s32(pivot_vec))
+                              : vcleq_f32(vreinterpretq_f32_s32(values), vreinterpretq_f32_s32(pivot_vec));
+        else
+            le_lanes = strict ? vcltq_s32(values, pivot_vec) : vcleq_s32(values, pivot_vec);
+        unsigned int le = vaddvq_u32(vandq_u32(le_lanes, lane_bits));
+        size_t le_count = vsort_popcount32(le);
+        int32x4_t packed = vreinterpretq_s32_u8(vqtbl1q_u8(vreinterpretq_u8_s32(values), vld1q_u8(g_vsort_neon_compress[le])));
+        vst1q_s32(data + write_left, packed);
+        vst1q_s32(data + write_right - width, packed);
+        write_left += le_count;
+        write_right -= width - le_count;
     }
-    vsort_swap_int(&data[i], &data[last]);
-    return i;
+
+    int32_t tmp[3 * 4];
+    size_t tail = read_right - read_left;
+    memcpy(tmp, data + read_left, tail * sizeof(int32_t));
+    vst1q_s32(tmp + tail, left_vec);
+    vst1q_s32(tmp + tail + width, right_vec);
+    return vsort_partition_drain32(data, write_left, write_right, tmp, tail + 2 * width, pivot, is_float, strict);
 }
 
-static size_t vsort_partition_float32(float *data, size_t count)
-{
-    size_t last = count - 1;
-    size_t mid = count / 2;
+#endif
 
-    if (data[0] > data[mid])
-        vsort_swap_float(&data[0], &data[mid]);
-    if (data[mid] > data[last])
-        vsort_swap_float(&data[mid], &data[last]);
-    if (data[0] > data[mid])
-        vsort_swap_float(&data[0], &data[mid]);
+// Picks the widest kernel the CPU supports (hardware.simd_width) and falls
+// back to the branchless scalar loop for small ranges.
+static size_t vsort_partition_block32(int32_t *data, size_t count, int32_t pivot, bool is_float, bool strict,
+                                      unsigned int flags)
+{
+    size_t minimum = (flags & VSORT_FLAG_FORCE_SIMD) ? 0 : VSORT_SIMD_PARTITION_MIN;
+    const vsort_hardware_t *hw = &vsort_runtime()->hardware;
+    VSORT_UNUSED(hw);
+    VSORT_UNUSED(minimum);
+
+#if defined(VSORT_X86)
+    if (hw->simd_width >= 64 && count >= VSORT_MAX(minimum, (size_t)32))
+        return vsort_partition_avx512_32(data, count, pivot, is_float, strict);
+    if (hw->simd_width >= 32 && count >= VSORT_MAX(minimum, (size_t)16))
+        return vsort_partition_avx2_32(data, count, pivot, is_float, strict);
+#endif
+#if defined(VSORT_NEON64)
+    if (hw->has_neon && count >= VSORT_MAX(minimum, (size_t)8))
+        return vsort_partition_neon_32(data, count, pivot, is_float, strict);
+#endif
+    return SIZE_MAX;
+}
 
-    vsort_swap_float(&data[mid], &data[last]);
-    float pivot = data[last];
+typedef enum
+{
+    VSORT_LANES_SIGNED,
+    VSORT_LANES_UNSIGNED,
+    VSORT_LANES_FLOAT
+} vsort_lane_order_t;
 
-    size_t i = 0;
-    for (size_t j = 0; j < last; ++j)
+static inline bool vsort_lane_goes_left64(int64_t value, int64_t pivot, vsort_lane_order_t order, bool strict)
+{
+    if (order == VSORT_LANES_FLOAT)
     {
-        if (data[j] <= pivot)
-        {
-            vsort_swap_float(&data[i], &data[j]);
-            ++i;
-        }
+        double a;
+        double b;
+        memcpy(&a, &value, sizeof(a));
+        memcpy(&b, &pivot, sizeof(b));
+        return strict ? a < b : a <= b;
     }
-    vsort_swap_float(&data[i], &data[last]);
-    return i;
+    if (order == VSORT_LANES_UNSIGNED)
+        return strict ? (uint64_t)value < (uint64_t)pivot : (uint64_t)value <= (uint64_t)pivot;
+    return strict ? value < pivot : value <= pivot;
 }
 
-static void vsort_introsort_int32_impl(int *data, size_t count, size_t depth_limit, unsigned int flags)
+static size_t vsort_partition_drain64(int64_t *data, size_t left, size_t right, const int64_t *tmp, size_t count,
+                                      int64_t pivot, vsort_lane_order_t order, bool strict)
 {
-    size_t threshold = vsort_runtime()->thresholds.insertion_threshold;
-
-    while (count > threshold)
+    for (size_t i = 0; i < count; ++i)
     {
-        if (depth_limit == 0)
-        {
-            vsort_heapsort_int32(data, count);
-            return;
-        }
+        if (vsort_lane_goes_left64(tmp[i], pivot, order, strict))
+            memcpy(data + left++, tmp + i, sizeof(int64_t));
+        else
+            memcpy(data + --right, tmp + i, sizeof(int64_t));
+    }
+    return left;
+}
 
-        size_t pivot_index = vsort_partition_int32(data, count, flags);
-        size_t left_count = pivot_index;
-        size_t right_count = count - pivot_index - 1;
+#if defined(VSORT_X86)
 
-        if (left_count < right_count)
+VSORT_TARGET_AVX512 static inline size_t vsort_partition_avx512_64(int64_t *data, size_t count, int64_t pivot,
+                                                                   vsort_lane_order_t order, bool strict)
+{
+    const size_t width = 8;
+    const __m512i pivot_vec = _mm512_set1_epi64(pivot);
+    __m512i left_vec = _mm512_loadu_si512((const void *)data);
+    __m512i right_vec = _mm512_loadu_si512((const void *)(data + count - width));
+    size_t read_left = width;
+    size_t read_right = count - width;
+    size_t write_left = 0;
+    size_t write_right = count;
+
+    while (read_right - read_left >= width)
+    {
+        __m512i values;
+        if (read_left - write_left <= write_right - read_right)
         {
-            if (left_count > 0)
-                vsort_introsort_int32_impl(data, left_count, depth_limit - 1, flags);
-            data += pivot_index + 1;
-            count = right_count;
+            values = _mm512_loadu_si512((const void *)(data + read_left));
+            read_left += width;
         }
         else
         {
-            if (right_count > 0)
-                vsort_introsort_int32_impl(data + pivot_index + 1, right_count, depth_limit - 1, flags);
-            count = left_count;
+            read_right -= width;
+            values = _mm512_loadu_si512((const void *)(data + read_right));
         }
+
+        __mmask8 le;
+        if (order == VSORT_LANES_FLOAT)
+            le = strict ? _mm512_cmp_pd_mask(_mm512_castsi512_pd(values), _mm512_castsi512_pd(pivot_vec), _CMP_LT_OQ)
+                        : _mm512_cmp_pd_mask(_mm512_castsi512_pd(values), _mm512_castsi512_pd(pivot_vec), _CMP_LE_OQ);
+        else if (order == VSORT_LANES_UNSIGNED)
+            le = strict ? _mm512_cmp_epu64_mask(values, pivot_vec, _MM_CMPINT_LT)
+                        : _mm512_cmp_epu64_mask(values, pivot_vec, _MM_CMPINT_LE);
+        else
+            le = strict ? _mm512_cmp_epi64_mask(values, pivot_vec, _MM_CMPINT_LT)
+                        : _mm512_cmp_epi64_mask(values, pivot_vec, _MM_CMPINT_LE);
+        size_t le_count = vsort_popcount32((unsigned int)le);
+        _mm512_mask_compressstoreu_epi64((void *)(data + write_left), le, values);
+        write_left += le_count;
+        write_right -= width - le_count;
+        _mm512_mask_compressstoreu_epi64((void *)(data + write_right), (__mmask8)~le, values);
     }
 
-    vsort_insertion_sort_int32(data, count);
+    int64_t tmp[3 * 8];
+    size_t tail = read_right - read_left;
+    memcpy(tmp, data + read_left, tail * sizeof(int64_t));
+    _mm512_storeu_si512((void *)(tmp + tail), left_vec);
+    _mm512_storeu_si512((void *)(tmp + tail + width), right_vec);
+    return vsort_partition_drain64(data, write_left, write_right, tmp, tail + 2 * width, pivot, order, strict);
 }
 
-static void vsort_introsort_float32_impl(float *data, size_t count, size_t depth_limit)
+VSORT_TARGET_AVX2 static inline size_t vsort_partition_avx2_64(int64_t *data, size_t count, int64_t pivot,
+                                                               vsort_lane_order_t order, bool strict)
 {
-    size_t threshold = vsort_runtime()->thresholds.insertion_threshold;
-
-    while (count > threshold)
+    const size_t width = 4;
+    const __m256i pivot_vec = _mm256_set1_epi64x(pivot);
+    // AVX2 only has a signed 64-bit compare; flipping the sign bit of both
+    // sides turns it into the unsigned one.
+    const __m256i bias = _mm256_set1_epi64x(order == VSORT_LANES_UNSIGNED ? INT64_MIN : 0);
+    const __m256i biased_pivot = _mm256_xor_si256(pivot_vec, bias);
+    __m256i left_vec = _mm256_loadu_si256((const __m256i *)data);
+    __m256i right_vec = _mm256_loadu_si256((const __m256i *)(data + count - width));
+    size_t read_left = width;
+    size_t read_right = count - width;
+    size_t write_left = 0;
+    size_t write_right = count;
+
+    while (read_right - read_left >= width)
     {
-        if (depth_limit == 0)
+        __m256i values;
+        if (read_left - write_left <= write_right - read_right)
         {
-            vsort_heapsort_float32(data, count);
-            return;
+            values = _mm256_loadu_si256((const __m256i *)(data + read_left));
+            read_left += width;
         }
-
-        size_t pivot_index = vsort_partition_float32(data, count);
-        size_t left_count = pivot_index;
-        size_t right_count = count - pivot_index - 1;
-
-        if (left_count < right_count)
+        else
         {
-            if (left_count > 0)
-                vsort_introsort_float32_impl(data, left_count, depth_limit - 1);
-            data += pivot_index + 1;
-            count = right_count;
+            read_right -= width;
+            values = _mm256_loadu_si256((const __m256i *)(data + read_right));
         }
+
+        unsigned int le;
+        if (order == VSORT_LANES_FLOAT && strict)
+            le = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_castsi256_pd(values), _mm256_castsi256_pd(pivot_vec), _CMP_LT_OQ));
+        else if (order == VSORT_LANES_FLOAT)
+            le = (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_castsi256_pd(values), _mm256_castsi256_pd(pivot_vec), _CMP_LE_OQ));
         else
         {
-            if (right_count > 0)
-                vsort_introsort_float32_impl(data + pivot_index + 1, right_count, depth_limit - 1);
-            count = left_count;
+            __m256i biased = _mm256_xor_si256(values, bias);
+            if (strict)
+                le = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(biased_pivot, biased)));
+            else
+                le = ~(unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(biased, biased_pivot))) & 0xFu;
         }
+
+        size_t le_count = vsort_popcount32(le);
+        __m256i shuffle = _mm256_loadu_si256((const __m256i *)g_vsort_avx2_compress64[le]);
+        __m256i packed = _mm256_permutevar8x32_epi32(values, shuffle);
+        _mm256_storeu_si256((__m256i *)(data + write_left), packed);
+        _mm256_storeu_si256((__m256i *)(data + write_right - width), packed);
+        write_left += le_count;
+        write_right -= width - le_count;
     }
 
-    vsort_insertion_sort_float32(data, count);
+    int64_t tmp[3 * 4];
+    size_t tail = read_right - read_left;
+    memcpy(tmp, data + read_left, tail * sizeof(int64_t));
+    _mm256_storeu_si256((__m256i *)(tmp + tail), left_vec);
+    _mm256_storeu_si256((__m256i *)(tmp + tail + width), right_vec);
+    return vsort_partition_drain64(data, write_left, write_right, tmp, tail + 2 * width, pivot, order, strict);
+}
+
+#endif
+
+// 64-bit counterpart of vsort_partition_block32. There is no NEON kernel:
+// two lanes per vector do not pay for the shuffle, so NEON uses the scalar loop.
+static size_t vsort_partition_block64(int64_t *data, size_t count, int64_t pivot, vsort_lane_order_t order, bool strict,
+                                      unsigned int flags)
+{
+    size_t minimum = (flags & VSORT_FLAG_FORCE_SIMD) ? 0 : VSORT_SIMD_PARTITION_MIN;
+    const vsort_hardware_t *hw = &vsort_runtime()->hardware;
+    VSORT_UNUSED(hw);
+    VSORT_UNUSED(minimum);
+    VSORT_UNUSED(order);
+
+#if defined(VSORT_X86)
+    if (hw->simd_width >= 64 && count >= VSORT_MAX(minimum, (size_t)16))
+        return vsort_partition_avx512_64(data, count, pivot, order, strict);
+    if (hw->simd_width >= 32 && count >= VSORT_MAX(minimum, (size_t)8))
+        return vsort_partition_avx2_64(data, count, pivot, order, strict);
+#endif
+    return SIZE_MAX;
 }
 
-static void vsort_introsort_int32(int *data, size_t count, unsigned int flags)
+// Per-type partition hooks used by vsort_template.h; SIZE_MAX means no
+// vector kernel applies and the caller runs its scalar loop.
+static size_t vsort_partition_kernel_int32(int *data, size_t count, int pivot, bool strict, unsigned int flags)
 {
-    if (count <= 1)
-        return;
+    return vsort_partition_block32((int32_t *)data, count, (int32_t)pivot, false, strict, flags);
+}
 
-    size_t depth_limit = 2 * vsort_floor_log2(count);
-    if (depth_limit == 0)
-        depth_limit = 1;
-    vsort_introsort_int32_impl(data, count, depth_limit, flags);
+static size_t vsort_partition_kernel_float32(float *data, size_t count, float pivot, bool strict, unsigned int flags)
+{
+    int32_t bits;
+    memcpy(&bits, &pivot, sizeof(bits));
+    return vsort_partition_block32((int32_t *)data, count, bits, true, strict, flags);
 }
 
-static void vsort_introsort_float32(float *data, size_t count)
+static size_t vsort_partition_kernel_int64(int64_t *data, size_t count, int64_t pivot, bool strict, unsigned int flags)
 {
-    if (count <= 1)
-        return;
+    return vsort_partition_block64(data, count, pivot, VSORT_LANES_SIGNED, strict, flags);
+}
 
-    size_t depth_limit = 2 * vsort_floor_log2(count);
-    if (depth_limit == 0)
-        depth_limit = 1;
-    vsort_introsort_float32_impl(data, count, depth_limit);
+static size_t vsort_partition_kernel_uint64(uint64_t *data, size_t count, uint64_t pivot, bool strict, unsigned int flags)
+{
+    int64_t bits;
+    memcpy(&bits, &pivot, sizeof(bits));
+    return vsort_partition_block64((int64_t *)data, count, bits, VSORT_LANES_UNSIGNED, strict, flags);
 }
 
-static void vsort_merge_int32(int *data, int *buffer, size_t left, size_t mid, size_t right)
+static size_t vsort_partition_kernel_float64(double *data, size_t count, double pivot, bool strict, unsigned int flags)
 {
-    size_t left_count = mid - left;
-    if (left_count == 0)
-        return;
+    int64_t bits;
+    memcpy(&bits, &pivot, sizeof(bits));
+    return vsort_partition_block64((int64_t *)data, count, bits, VSORT_LANES_FLOAT, strict, flags);
+}
+
+// -----------------------------------------------------------------------------
+// Leaf sorting networks
+// -----------------------------------------------------------------------------
+//
+// Introsort leaves are padded to the next power of two (at most 64 lanes),
+// held in vector registers and sorted with a bitonic network: exchanges
+// between registers are plain min/max, exchanges inside a register permute
+// the lanes with a partner table first. Floats are sorted as ordered int32
+// keys (the radix sign-flip mapping), so NaNs and signed zeros never make
+// min/max drop or duplicate values.
 
-    memcpy(buffer + left, data + left, left_count * sizeof(int));
 
-    size_t i = 0;
-    size_t j = mid;
-    size_t dest = left;
+#if defined(VSORT_X86)
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    VSORT_UNUSED(left_count);
-#endif
+// [distance mask][0] = partner lane (i ^ mask), [1] = all-ones where the
+// lane keeps the maximum of the pair.
+static int32_t g_vsort_avx2_exchange[8][2][8];
 
-    while (i < left_count && j < right)
+static void vsort_build_avx2_network_tables(void)
+{
+    for (unsigned int mask = 1; mask < 8; ++mask)
     {
-        if (buffer[left + i] <= data[j])
-        {
-            data[dest++] = buffer[left + i];
-            ++i;
-        }
-        else
+        unsigned int high = 1u << vsort_floor_log2(mask);
+        for (unsigned int lane = 0; lane < 8; ++lane)
         {
-            data[dest++] = data[j++];
+            g_vsort_avx2_exchange[mask][0][lane] = (int32_t)(lane ^ mask);
+            g_vsort_avx2_exchange[mask][1][lane] = (lane & high) ? -1 : 0;
         }
     }
-
-    while (i < left_count)
-        data[dest++] = buffer[left + i++];
 }
 
-static void vsort_merge_float32(float *data, float *buffer, size_t left, size_t mid, size_t right)
+VSORT_TARGET_AVX2 static inline __m256i vsort_avx2_exchange(__m256i values, unsigned int mask)
 {
-    size_t left_count = mid - left;
-    if (left_count == 0)
-        return;
-
-    memcpy(buffer + left, data + left, left_count * sizeof(float));
+    __m256i partner = _mm256_permutevar8x32_epi32(values, _mm256_loadu_si256((const __m256i *)g_vsort_avx2_exchange[mask][0]));
+    __m256i keep_max = _mm256_loadu_si256((const __m256i *)g_vsort_avx2_exchange[mask][1]);
+    return _mm256_blendv_epi8(_mm256_min_epi32(values, partner), _mm256_max_epi32(values, partner), keep_max);
+}
 
-    size_t i = 0;
-    size_t j = mid;
-    size_t dest = left;
+VSORT_TARGET_AVX2 static inline __m256i vsort_avx2_reverse(__m256i values)
+{
+    return _mm256_permutevar8x32_epi32(values, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    VSORT_UNUSED(left_count);
-#endif
+VSORT_TARGET_AVX2 static void vsort_network_avx2_32(int32_t *data, size_t count, bool is_float)
+{
+    const size_t width = 8;
+    size_t regs = 1;
+    while (regs * width < count)
+        regs <<= 1;
+    size_t total = regs * width;
+
+    int32_t tmp[VSORT_NETWORK_MAX];
+    memcpy(tmp, data, count * sizeof(int32_t));
+    for (size_t i = count; i < total; ++i)
+        tmp[i] = INT32_MAX;
+
+    const __m256i key_mask = _mm256_set1_epi32(is_float ? 0x7FFFFFFF : 0);
+    __m256i v[VSORT_NETWORK_MAX / 8];
+    for (size_t r = 0; r < regs; ++r)
+    {
+        __m256i raw = _mm256_loadu_si256((const __m256i *)(tmp + r * width));
+        v[r] = _mm256_xor_si256(raw, _mm256_and_si256(_mm256_srai_epi32(raw, 31), key_mask));
+    }
 
-    while (i < left_count && j < right)
+    for (size_t block = 2; block <= total; block <<= 1)
     {
-        if (buffer[left + i] <= data[j])
+        // First step of each merge compares mirrored positions of the block.
+        if (block <= width)
         {
-            data[dest++] = buffer[left + i];
-            ++i;
+            for (size_t r = 0; r < regs; ++r)
+                v[r] = vsort_avx2_exchange(v[r], (unsigned int)(block - 1));
         }
         else
         {
-            data[dest++] = data[j++];
+            size_t span = block / width;
+            for (size_t b = 0; b < regs; b += span)
+            {
+                for (size_t r = 0; r < span / 2; ++r)
+                {
+                    __m256i lo = v[b + r];
+                    __m256i hi = vsort_avx2_reverse(v[b + span - 1 - r]);
+                    v[b + r] = _mm256_min_epi32(lo, hi);
+                    v[b + span - 1 - r] = vsort_avx2_reverse(_mm256_max_epi32(lo, hi));
+                }
+            }
         }
-    }
 
-    while (i < left_count)
-        data[dest++] = buffer[left + i++];
-}
+        for (size_t distance = block / 4; distance > 0; distance >>= 1)
+        {
+            if (distance >= width)
+            {
+                size_t step = distance / width;
+                for (size_t b = 0; b < regs; b += 2 * step)
+                {
+                    for (size_t r = b; r < b + step; ++r)
+                    {
+                        __m256i lo = v[r];
+                        v[r] = _mm256_min_epi32(lo, v[r + step]);
+                        v[r + step] = _mm256_max_epi32(lo, v[r + step]);
+                    }
+                }
+            }
+            else
+            {
+                for (size_t r = 0; r < regs; ++r)
+                    v[r] = vsort_avx2_exchange(v[r], (unsigned int)distance);
+            }
+        }
+    }
 
-static void vsort_mergesort_int32_impl(int *data, int *buffer, size_t left, size_t right)
-{
-    size_t count = right - left;
-    if (count <= vsort_runtime()->thresholds.insertion_threshold)
+    for (size_t r = 0; r < regs; ++r)
     {
-        vsort_insertion_sort_int32(data + left, count);
-        return;
+        __m256i key = v[r];
+        __m256i raw = _mm256_xor_si256(key, _mm256_and_si256(_mm256_srai_epi32(key, 31), key_mask));
+        _mm256_storeu_si256((__m256i *)(tmp + r * width), raw);
     }
+    memcpy(data, tmp, count * sizeof(int32_t));
+}
 
-    size_t mid = left + count / 2;
-    vsort_mergesort_int32_impl(data, buffer, left, mid);
-    vsort_mergesort_int32_impl(data, buffer, mid, right);
+#endif
 
-    if (data[mid - 1] <= data[mid])
-        return;
+#if defined(VSORT_NEON64)
 
-    vsort_merge_int32(data, buffer, left, mid, right);
-}
+// [distance mask][0] = vqtbl1q_u8 bytes of the partner lane (i ^ mask),
+// [1] = all-ones bytes where the lane keeps the maximum of the pair.
+static uint8_t g_vsort_neon_exchange[4][2][16];
 
-static void vsort_mergesort_float32_impl(float *data, float *buffer, size_t left, size_t right)
+static void vsort_build_neon_network_tables(void)
 {
-    size_t count = right - left;
-    if (count <= vsort_runtime()->thresholds.insertion_threshold)
+    for (unsigned int mask = 1; mask < 4; ++mask)
     {
-        vsort_insertion_sort_float32(data + left, count);
-        return;
+        unsigned int high = 1u << vsort_floor_log2(mask);
+        for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+            for (unsigned int byte = 0; byte < 4; ++byte)
+            {
+                g_vsort_neon_exchange[mask][0][lane * 4 + byte] = (uint8_t)((lane ^ mask) * 4 + byte);
+                g_vsort_neon_exchange[mask][1][lane * 4 + byte] = (lane & high) ? 0xFF : 0x00;
+            }
+        }
     }
-
-    size_t mid = left + count / 2;
-    vsort_mergesort_float32_impl(data, buffer, left, mid);
-    vsort_mergesort_float32_impl(data, buffer, mid, right);
-
-    if (data[mid - 1] <= data[mid])
-        return;
-
-    vsort_merge_float32(data, buffer, left, mid, right);
 }
 
-static bool vsort_mergesort_int32(int *data, size_t count)
+static inline int32x4_t vsort_neon_exchange(int32x4_t values, unsigned int mask)
 {
-    if (count <= 1)
-        return true;
-
-    int *buffer = vsort_merge_buffer_int32(count);
-    bool pooled = buffer != NULL;
-    if (!buffer)
-        buffer = vsort_aligned_malloc(count * sizeof(int));
-    if (!buffer)
-        return false;
-
-    vsort_mergesort_int32_impl(data, buffer, 0, count);
-    if (pooled)
-        vsort_merge_buffer_release_int32();
-    else
-        vsort_aligned_free(buffer);
-    return true;
+    int32x4_t partner = vreinterpretq_s32_u8(vqtbl1q_u8(vreinterpretq_u8_s32(values), vld1q_u8(g_vsort_neon_exchange[mask][0])));
+    uint32x4_t keep_max = vreinterpretq_u32_u8(vld1q_u8(g_vsort_neon_exchange[mask][1]));
+    return vbslq_s32(keep_max, vmaxq_s32(values, partner), vminq_s32(values, partner));
 }
 
-static bool vsort_mergesort_float32(float *data, size_t count)
+static inline int32x4_t vsort_neon_reverse(int32x4_t values)
 {
-    if (count <= 1)
-        return true;
-
-    float *buffer = vsort_merge_buffer_float32(count);
-    bool pooled = buffer != NULL;
-    if (!buffer)
-        buffer = vsort_aligned_malloc(count * sizeof(float));
-    if (!buffer)
-        return false;
-
-    vsort_mergesort_float32_impl(data, buffer, 0, count);
-    if (pooled)
-        vsort_merge_buffer_release_float32();
-    else
-        vsort_aligned_free(buffer);
-    return true;
+    int32x4_t swapped = vrev64q_s32(values);
+    return vextq_s32(swapped, swapped, 2);
 }
 
-static bool vsort_radix_sort_int32(int *data, size_t count)
+static void vsort_network_neon_32(int32_t *data, size_t count, bool is_float)
 {
-    if (count <= 1)
-        return true;
-
-    int min_value = data[0];
-    int max_value = data[0];
-    for (size_t i = 1; i < count; ++i)
+    const size_t width = 4;
+    size_t regs = 1;
+    while (regs * width < count)
+        regs <<= 1;
+    size_t total = regs * width;
+
+    int32_t tmp[VSORT_NETWORK_MAX];
+    memcpy(tmp, data, count * sizeof(int32_t));
+    for (size_t i = count; i < total; ++i)
+        tmp[i] = INT32_MAX;
+
+    const int32x4_t key_mask = vdupq_n_s32(is_float ? 0x7FFFFFFF : 0);
+    int32x4_t v[VSORT_NETWORK_MAX / 4];
+    for (size_t r = 0; r < regs; ++r)
     {
-        if (data[i] < min_value)
-            min_value = data[i];
-        if (data[i] > max_value)
-            max_value = data[i];
+        int32x4_t raw = vld1q_s32(tmp + r * width);
+        v[r] = veorq_s32(raw, vandq_s32(vshrq_n_s32(raw, 31), key_mask));
     }
 
-    long long range = (long long)max_value - (long long)min_value;
-    if (range > (long long)UINT_MAX)
+    for (size_t block = 2; block <= total; block <<= 1)
     {
-        vsort_log_debug("Radix sort skipped due to excessive value range.");
-        return false;
-    }
-
-    unsigned int shift = 0;
-    if (min_value < 0)
-        shift = (unsigned int)(-min_value);
-
-    unsigned int *shifted = vsort_aligned_malloc(count * sizeof(unsigned int));
-    if (!shifted)
-        return false;
-
-    for (size_t i = 0; i < count; ++i)
-        shifted[i] = (unsigned int)(data[i] + shift);
-
-    unsigned int *buffer = vsort_aligned_malloc(count * sizeof(unsigned int));
-    if (!buffer)
-    {
-        vsort_aligned_free(shifted);
-        return false;
-    }
-
-    const size_t bits = 8;
-    const size_t bins = 1u << bits;
-    const unsigned int mask = (unsigned int)(bins - 1u);
-    unsigned int histogram[256];
-
-    unsigned int maximum = 0;
-    for (size_t i = 0; i < count; ++i)
-        if (shifted[i] > maximum)
-            maximum = shifted[i];
-
-    size_t passes = 0;
-    if (maximum == 0)
-    {
-        passes = 1;
-    }
-    else
-    {
-        unsigned int leading = vsort_clz32(maximum);
-        size_t bits_required = (sizeof(unsigned int) * CHAR_BIT) - leading;
-        passes = (bits_required + bits - 1) / bits;
-        if (passes == 0)
-            passes = 1;
-    }
-
-    unsigned int *input = shifted;
-    unsigned int *output = buffer;
-
-    for (size_t pass = 0; pass < passes; ++pass)
-    {
-        size_t offset = pass * bits;
-        memset(histogram, 0, sizeof(histogram));
-
-        for (size_t i = 0; i < count; ++i)
+        if (block <= width)
         {
-            unsigned int bucket = (input[i] >> offset) & mask;
-            histogram[bucket]++;
+            for (size_t r = 0; r < regs; ++r)
+                v[r] = vsort_neon_exchange(v[r], (unsigned int)(block - 1));
         }
-
-        unsigned int total = 0;
-        for (size_t i = 0; i < bins; ++i)
+        else
         {
-            unsigned int tmp = histogram[i];
-            histogram[i] = total + tmp;
-            total += tmp;
+            size_t span = block / width;
+            for (size_t b = 0; b < regs; b += span)
+            {
+                for (size_t r = 0; r < span / 2; ++r)
+                {
+                    int32x4_t lo = v[b + r];
+                    int32x4_t hi = vsort_neon_reverse(v[b + span - 1 - r]);
+                    v[b + r] = vminq_s32(lo, hi);
+                    v[b + span - 1 - r] = vsort_neon_reverse(vmaxq_s32(lo, hi));
+                }
+            }
         }
 
-        for (size_t i = count; i-- > 0;)
+        for (size_t distance = block / 4; distance > 0; distance >>= 1)
         {
-            unsigned int value = input[i];
-            unsigned int bucket = (value >> offset) & mask;
-            output[--histogram[bucket]] = value;
+            if (distance >= width)
+            {
+                size_t step = distance / width;
+                for (size_t b = 0; b < regs; b += 2 * step)
+                {
+                    for (size_t r = b; r < b + step; ++r)
+                    {
+                        int32x4_t lo = v[r];
+                        v[r] = vminq_s32(lo, v[r + step]);
+                        v[r + step] = vmaxq_s32(lo, v[r + step]);
+                    }
+                }
+            }
+            else
+            {
+                for (size_t r = 0; r < regs; ++r)
+                    v[r] = vsort_neon_exchange(v[r], (unsigned int)distance);
+            }
         }
-
-        unsigned int *swap = input;
-        input = output;
-        output = swap;
     }
 
-    for (size_t i = 0; i < count; ++i)
-        data[i] = (int)(input[i] - shift);
-
-    vsort_aligned_free(shifted);
-    vsort_aligned_free(buffer);
-    return true;
+    for (size_t r = 0; r < regs; ++r)
+    {
+        int32x4_t key = v[r];
+        vst1q_s32(tmp + r * width, veorq_s32(key, vandq_s32(vshrq_n_s32(key, 31), key_mask)));
+    }
+    memcpy(data, tmp, count * sizeof(int32_t));
 }
 
-static bool vsort_is_nearly_sorted_int32(const int *data, size_t count, size_t sample_hint)
-{
-    if (count < 32)
-        return false;
-
-    size_t samples = VSORT_MIN(sample_hint, count / 2);
-    if (samples < 8)
-        return false;
-
-    size_t step = VSORT_MAX((size_t)1, count / samples);
-    size_t inversions = 0;
-    size_t observed = 0;
-
-    for (size_t i = 0; i + step < count && observed < samples; i += step, ++observed)
-        if (data[i] > data[i + step])
-            ++inversions;
-
-    if (observed == 0)
-        return false;
+#endif
 
-    return inversions * 10 < observed;
+// Vector lanes of the leaf network available on this CPU (0 when none).
+static size_t vsort_network_lanes(const vsort_hardware_t *hw)
+{
+    VSORT_UNUSED(hw);
+#if defined(VSORT_X86)
+    if (hw->simd_width >= 32)
+        return 8;
+#endif
+#if defined(VSORT_NEON64)
+    if (hw->has_neon)
+        return 4;
+#endif
+    return 0;
 }
 
-static bool vsort_is_nearly_sorted_float32(const float *data, size_t count, size_t sample_hint)
+static bool vsort_network_sort32(int32_t *data, size_t count, bool is_float)
 {
-    if (count < 32)
-        return false;
-
-    size_t samples = VSORT_MIN(sample_hint, count / 2);
-    if (samples < 8)
+    if (count > VSORT_NETWORK_MAX)
         return false;
 
-    size_t step = VSORT_MAX((size_t)1, count / samples);
-    size_t inversions = 0;
-    size_t observed = 0;
-
-    for (size_t i = 0; i + step < count && observed < samples; i += step, ++observed)
-        if (data[i] > data[i + step])
-            ++inversions;
+    size_t lanes = vsort_network_lanes(&vsort_runtime()->hardware);
+    VSORT_UNUSED(lanes);
+#if defined(VSORT_X86)
+    if (lanes == 8)
+    {
+        vsort_network_avx2_32(data, count, is_float);
+        return true;
+    }
+#endif
+#if defined(VSORT_NEON64)
+    if (lanes == 4)
+    {
+        vsort_network_neon_32(data, count, is_float);
+        return true;
+    }
+#endif
+    return false;
+}
 
-    if (observed == 0)
-        return false;
+static void vsort_leaf_sort_int32(int *data, size_t count)
+{
+    if (count > 1 && vsort_network_sort32((int32_t *)data, count, false))
+        return;
+    vsort_insertion_sort_int32(data, count);
+}
+
+static void vsort_leaf_sort_float32(float *data, size_t count)
+{
+    if (count > 1 && vsort_network_sort32((int32_t *)data, count, true))
+        return;
+    vsort_insertion_sort_float32(data, count);
+}
+
+// The networks are built for 32-bit lanes; 64-bit leaves use insertion sort.
+static void vsort_leaf_sort_int64(int64_t *data, size_t count)
+{
+    vsort_insertion_sort_int64(data, count);
+}
+
+static void vsort_leaf_sort_uint64(uint64_t *data, size_t count)
+{
+    vsort_insertion_sort_uint64(data, count);
+}
+
+static void vsort_leaf_sort_float64(double *data, size_t count)
+{
+    vsort_insertion_sort_float64(data, count);
+}
 
-    return inversions * 10 < observed;
+static void vsort_build_simd_tables(void)
+{
+#if defined(VSORT_X86)
+    vsort_build_avx2_tables();
+    vsort_build_avx2_network_tables();
+#endif
+#if defined(VSORT_NEON64)
+    vsort_build_neon_tables();
+    vsort_build_neon_network_tables();
+#endif
 }
 
 // -----------------------------------------------------------------------------
-// Parallel helpers (Apple Silicon)
+// Radix sort
 // -----------------------------------------------------------------------------
+//
+// LSD (and, under memory pressure, in-place MSD) radix sort on the bit
+// patterns of the elements, generated from vsort_radix_template.h for 32-bit
+// and 64-bit words. LSD scratch comes from vsort_scratch_alloc; the hooks
+// vsort_radix_signed_sort32/64 below are the signed introsorts that finish
+// small MSD buckets.
+
+#define VSORT_RADIX_BITS 8
+#define VSORT_RADIX_BINS (1u << VSORT_RADIX_BITS)
+#define VSORT_RADIX_MAX_BITS 11
+#define VSORT_RADIX_MAX_BINS (1u << VSORT_RADIX_MAX_BITS)
+#define VSORT_RADIX_MAX_PASSES 8
+#define VSORT_RADIX_MIN_BLOCK ((size_t)1 << 16)
+#define VSORT_MSD_CUTOFF 256
+
+#define VSORT_SIGN32 0x80000000u
+#define VSORT_SIGN64 ((uint64_t)1 << 63)
+#define VSORT_FLOAT_MASK32 0x7FFFFFFFu
+#define VSORT_FLOAT_MASK64 0x7FFFFFFFFFFFFFFFull
+
+static void vsort_radix_signed_sort32(uint32_t *data, size_t count, unsigned int flags)
+{
+    vsort_introsort_int32((int *)data, count, flags);
+}
 
-#if defined(VSORT_APPLE) && defined(__arm64__)
-
-static bool vsort_parallel_int32(int *data, size_t count, unsigned int flags)
+static void vsort_radix_signed_sort64(uint64_t *data, size_t count, unsigned int flags)
 {
-    if (count < 2)
-        return true;
+    vsort_introsort_int64((int64_t *)data, count, flags);
+}
 
-    vsort_runtime_t *rt = vsort_runtime();
-    size_t chunk = VSORT_MAX(rt->thresholds.cache_optimal_elements, rt->thresholds.insertion_threshold * 8);
-    if (chunk == 0)
-        chunk = 4096;
+#define VSORT_WORD uint32_t
+#define VSORT_SWORD int32_t
+#define VSORT_WIDTH 32
+#include "vsort_radix_template.h"
 
-    size_t chunk_count = (count + chunk - 1) / chunk;
-    if (chunk_count == 0)
-        return false;
+#define VSORT_WORD uint64_t
+#define VSORT_SWORD int64_t
+#define VSORT_WIDTH 64
+#include "vsort_radix_template.h"
 
-    dispatch_qos_class_t qos = QOS_CLASS_USER_INITIATED;
-    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
-        qos = QOS_CLASS_UTILITY;
+static bool vsort_radix_sort_int32(int *data, size_t count, int threads)
+{
+    return vsort_radix_sort32((uint32_t *)data, count, threads, 0u, VSORT_SIGN32);
+}
 
-    dispatch_queue_t queue = dispatch_get_global_queue(qos, 0);
+static bool vsort_radix_sort_float32(float *data, size_t count, int threads)
+{
+    return vsort_radix_sort32((uint32_t *)data, count, threads, VSORT_FLOAT_MASK32, VSORT_SIGN32);
+}
 
-    dispatch_apply(chunk_count, queue, ^(size_t index) {
-      size_t begin = index * chunk;
-      size_t end = VSORT_MIN(begin + chunk, count);
-      size_t local = end - begin;
+static bool vsort_radix_sort_int64(int64_t *data, size_t count, int threads)
+{
+    return vsort_radix_sort64((uint64_t *)data, count, threads, 0u, VSORT_SIGN64);
+}
 
-      if (local <= 1)
-          return;
+static bool vsort_radix_sort_uint64(uint64_t *data, size_t count, int threads)
+{
+    return vsort_radix_sort64(data, count, threads, 0u, 0u);
+}
 
-      if (local <= rt->thresholds.insertion_threshold)
-      {
-          vsort_insertion_sort_int32(data + begin, local);
-          return;
-      }
+static bool vsort_radix_sort_float64(double *data, size_t count, int threads)
+{
+    return vsort_radix_sort64((uint64_t *)data, count, threads, VSORT_FLOAT_MASK64, VSORT_SIGN64);
+}
 
-      size_t depth = 2 * vsort_floor_log2(local);
-      if (depth == 0)
-          depth = 1;
-      vsort_introsort_int32_impl(data + begin, local, depth, flags);
-    });
+static void vsort_msd_radix_int32(int *data, size_t count, int threads, unsigned int flags)
+{
+    vsort_msd_radix32((uint32_t *)data, count, threads, 0u, VSORT_SIGN32, flags);
+}
 
-    int *buffer = vsort_merge_buffer_int32(count);
-    bool pooled = buffer != NULL;
-    if (!buffer)
-        buffer = vsort_aligned_malloc(count * sizeof(int));
-    if (!buffer)
-        return false;
+static void vsort_msd_radix_float32(float *data, size_t count, int threads, unsigned int flags)
+{
+    vsort_msd_radix32((uint32_t *)data, count, threads, VSORT_FLOAT_MASK32, VSORT_SIGN32, flags);
+}
 
-    for (size_t width = chunk; width < count; width *= 2)
-    {
-        size_t pair_count = (count + (width * 2) - 1) / (width * 2);
-        dispatch_apply(pair_count, queue, ^(size_t pair) {
-          size_t left = pair * width * 2;
-          size_t mid = VSORT_MIN(left + width, count);
-          size_t right = VSORT_MIN(left + width * 2, count);
+static void vsort_msd_radix_int64(int64_t *data, size_t count, int threads, unsigned int flags)
+{
+    vsort_msd_radix64((uint64_t *)data, count, threads, 0u, VSORT_SIGN64, flags);
+}
 
-          if (mid < right)
-          {
-              if (data[mid - 1] <= data[mid])
-                  return;
-              vsort_merge_int32(data, buffer, left, mid, right);
-          }
-        });
-    }
+static void vsort_msd_radix_uint64(uint64_t *data, size_t count, int threads, unsigned int flags)
+{
+    vsort_msd_radix64(data, count, threads, 0u, 0u, flags);
+}
 
-    if (pooled)
-        vsort_merge_buffer_release_int32();
-    else
-        vsort_aligned_free(buffer);
-    return true;
+static void vsort_msd_radix_float64(double *data, size_t count, int threads, unsigned int flags)
+{
+    vsort_msd_radix64((uint64_t *)data, count, threads, VSORT_FLOAT_MASK64, VSORT_SIGN64, flags);
 }
 
-static bool vsort_parallel_float32(float *data, size_t count, unsigned int flags)
+// True when the N-element scratch of the LSD radix sort would crowd out the
+// memory that is actually available.
+static bool vsort_radix_prefers_in_place(size_t count, size_t element_size, unsigned int flags)
 {
-    if (count < 2)
+    if (flags & VSORT_FLAG_LOW_MEMORY)
         return true;
 
-    vsort_runtime_t *rt = vsort_runtime();
-    size_t chunk = VSORT_MAX(rt->thresholds.cache_optimal_elements, rt->thresholds.insertion_threshold * 8);
-    if (chunk == 0)
-        chunk = 4096;
-
-    size_t chunk_count = (count + chunk - 1) / chunk;
-    if (chunk_count == 0)
+    size_t scratch = count * element_size;
+    if (scratch < ((size_t)64 << 20))
         return false;
 
-    dispatch_qos_class_t qos = QOS_CLASS_USER_INITIATED;
-    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
-        qos = QOS_CLASS_UTILITY;
+    size_t available = vsort_available_memory();
+    return available != 0 && scratch > available / 2;
+}
 
-    dispatch_queue_t queue = dispatch_get_global_queue(qos, 0);
+// -----------------------------------------------------------------------------
+// Adaptive run merging
+// -----------------------------------------------------------------------------
+//
+// Run stack bookkeeping and the powersort merge policy shared by the per-type
+// natural merge sorts in vsort_template.h.
+
+#define VSORT_MIN_GALLOP 7
+#define VSORT_RUN_STACK 64
+
+typedef struct
+{
+    size_t start;
+    unsigned int power;
+} vsort_run_t;
+
+// Powersort node power of the boundary between the runs
+// [start, start + left_count) and [start + left_count, ... + right_count):
+// the depth at which their midpoints first fall in different halves of
+// [0, count).
+static unsigned int vsort_run_power(size_t count, size_t start, size_t left_count, size_t right_count)
+{
+    size_t total = 2 * count;
+    size_t a = 2 * start + left_count;
+    size_t b = a + left_count + right_count;
+    unsigned int power = 0;
 
-    dispatch_apply(chunk_count, queue, ^(size_t index) {
-      size_t begin = index * chunk;
-      size_t end = VSORT_MIN(begin + chunk, count);
-      size_t local = end - begin;
+    while (true)
+    {
+        ++power;
+        if (a >= total)
+        {
+            a -= total;
+            b -= total;
+        }
+        else if (b >= total)
+        {
+            break;
+        }
+        a <<= 1;
+        b <<= 1;
+    }
+    return power;
+}
 
-      if (local <= 1)
-          return;
+// -----------------------------------------------------------------------------
+// Parallel helpers
+// -----------------------------------------------------------------------------
 
-      if (local <= rt->thresholds.insertion_threshold)
-      {
-          vsort_insertion_sort_float32(data + begin, local);
-          return;
-      }
+// Sample select draws this many splitter candidates and keeps the band of
+// +/- VSORT_SELECT_SLACK sample ranks around the target, about four standard
+// deviations of the sample quantile, so nth almost always lands inside it.
+#define VSORT_SELECT_SAMPLE 16384
+#define VSORT_SELECT_SLACK 256
 
-      size_t depth = 2 * vsort_floor_log2(local);
-      if (depth == 0)
-          depth = 1;
-      vsort_introsort_float32_impl(data + begin, local, depth);
-    });
+// Fork-join introsort splits with parallel partitions into at most this many
+// seed ranges, and replaces the chunk sort plus merge once the chunk count
+// reaches VSORT_FORK_JOIN_CHUNKS per thread.
+#define VSORT_FORK_MAX_SEEDS 64
+#define VSORT_FORK_JOIN_CHUNKS 16
 
-    float *buffer = vsort_merge_buffer_float32(count);
-    bool pooled = buffer != NULL;
-    if (!buffer)
-        buffer = vsort_aligned_malloc(count * sizeof(float));
-    if (!buffer)
-        return false;
+static int vsort_parallel_threads(unsigned int flags)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    int threads = rt->thread_count > 0 ? rt->thread_count : rt->hardware.total_cores;
+    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
+        threads /= 2;
+    return VSORT_MAX(1, threads);
+}
 
-    for (size_t width = chunk; width < count; width *= 2)
+// Equal slices to cut a parallel pass into. Threads claim slices as they
+// finish, so on hybrid CPUs the passes are cut finer, in proportion to how
+// much slower an efficiency core is, and whatever an efficiency core still
+// holds at the end of a pass is short.
+static size_t vsort_parallel_slices(int threads)
+{
+    const vsort_hardware_t *hw = &vsort_runtime()->hardware;
+    size_t slices = (size_t)VSORT_MAX(1, threads);
+    if (threads > 1 && hw->efficiency_cores > 0)
     {
-        size_t pair_count = (count + (width * 2) - 1) / (width * 2);
-        dispatch_apply(pair_count, queue, ^(size_t pair) {
-          size_t left = pair * width * 2;
-          size_t mid = VSORT_MIN(left + width, count);
-          size_t right = VSORT_MIN(left + width * 2, count);
-
-          if (mid < right)
-          {
-              if (data[mid - 1] <= data[mid])
-                  return;
-              vsort_merge_float32(data, buffer, left, mid, right);
-          }
-        });
+        size_t throughput = (size_t)VSORT_CLAMP(hw->efficiency_throughput, 10, 100);
+        slices *= 2 * ((100 + throughput - 1) / throughput);
     }
+    return slices;
+}
 
-    if (pooled)
-        vsort_merge_buffer_release_float32();
-    else
-        vsort_aligned_free(buffer);
-    return true;
+// Node that owns position index of count, splitting [0, count) between the
+// NUMA nodes in proportion to their CPUs.
+static int vsort_numa_node_of(size_t index, size_t count)
+{
+    const vsort_hardware_t *hw = &vsort_runtime()->hardware;
+    size_t cpus = 0;
+    for (int node = 0; node < hw->numa_nodes; ++node)
+        cpus += (size_t)hw->numa_cpus[node];
+
+    // index * cpus / count without overflowing for large arrays
+    size_t target = (size_t)((double)index * (double)cpus / (double)VSORT_MAX(count, (size_t)1));
+    for (int node = 0; node < hw->numa_nodes; ++node)
+    {
+        if (target < (size_t)hw->numa_cpus[node])
+            return node;
+        target -= (size_t)hw->numa_cpus[node];
+    }
+    return hw->numa_nodes - 1;
 }
 
+typedef struct
+{
+#if defined(VSORT_LINUX)
+    cpu_set_t saved;
 #endif
+    bool bound;
+} vsort_numa_binding_t;
 
-// -----------------------------------------------------------------------------
-// Public API
-// -----------------------------------------------------------------------------
-
-VSORT_API vsort_result_t vsort_sort(const vsort_options_t *options)
+// Pins the calling thread to the CPUs of node until vsort_numa_unbind, so
+// the pages it touches first are allocated on that node. A no-op on hosts
+// without NUMA nodes.
+static void vsort_numa_bind(int node, vsort_numa_binding_t *binding)
 {
-    if (!options)
-        return VSORT_ERR_INVALID_ARGUMENT;
-
-    if (!options->data && options->length > 0)
-        return VSORT_ERR_INVALID_ARGUMENT;
-
-    if (options->length <= 1)
-        return VSORT_OK;
+    binding->bound = false;
+#if defined(VSORT_LINUX)
+    if (vsort_runtime()->hardware.numa_nodes > 1 && sched_getaffinity(0, sizeof(binding->saved), &binding->saved) == 0)
+        binding->bound = sched_setaffinity(0, sizeof(g_numa_cpusets[node]), &g_numa_cpusets[node]) == 0;
+#else
+    VSORT_UNUSED(node);
+#endif
+}
 
-    vsort_init();
+static void vsort_numa_unbind(vsort_numa_binding_t *binding)
+{
+#if defined(VSORT_LINUX)
+    if (binding->bound)
+        sched_setaffinity(0, sizeof(binding->saved), &binding->saved);
+#endif
+    binding->bound = false;
+}
 
+static size_t vsort_parallel_chunk_size(void)
+{
     vsort_runtime_t *rt = vsort_runtime();
-    unsigned int flags = options->flags ? options->flags : rt->default_flags;
-    if ((flags & VSORT_FLAG_PREFER_EFFICIENCY) && (flags & VSORT_FLAG_PREFER_THROUGHPUT))
-        flags &= ~VSORT_FLAG_PREFER_EFFICIENCY;
-    if (!(flags & VSORT_FLAG_PREFER_EFFICIENCY))
-        flags |= VSORT_FLAG_PREFER_THROUGHPUT;
+    size_t chunk = VSORT_MAX(rt->thresholds.cache_optimal_elements, rt->thresholds.insertion_threshold * 8);
+    if (chunk == 0)
+        chunk = 4096;
+    return chunk;
+}
 
-    switch (options->kind)
-    {
-    case VSORT_KIND_INT32:
-    {
-        int *data = (int *)options->data;
-        size_t count = options->length;
+// The chunk sort needs an N-element merge buffer and log2(chunks) merge
+// passes over the whole array; fork-join introsort needs no buffer and about
+// log2(threads) parallel partition passes before the threads work on
+// disjoint ranges. Fork-join is used when the buffer would not fit the
+// memory budget and when the array is large enough that the extra merge
+// passes cost more than partitioning.
+static bool vsort_prefers_fork_join(size_t count, size_t element_size, unsigned int flags)
+{
+    if (vsort_radix_prefers_in_place(count, element_size, flags))
+        return true;
 
-        if ((flags & VSORT_FLAG_FORCE_STABLE))
-        {
-            if (!vsort_mergesort_int32(data, count))
-            {
-                vsort_log_warning("Stable sort allocation failed, falling back to introsort.");
-                vsort_introsort_int32(data, count, flags);
-            }
-            return VSORT_OK;
-        }
+    size_t chunks = count / vsort_parallel_chunk_size();
+    return chunks >= (size_t)vsort_parallel_threads(flags) * VSORT_FORK_JOIN_CHUNKS;
+}
 
-        if (vsort_is_nearly_sorted_int32(data, count, rt->thresholds.sample_size))
-        {
-            vsort_insertion_sort_int32(data, count);
-            return VSORT_OK;
-        }
+// -----------------------------------------------------------------------------
+// Per-type engines
+// -----------------------------------------------------------------------------
+//
+// Introsort, merge sort, run merging, the parallel chunk sort, fork-join
+// introsort, the engine selection of vsort_sort and introselect/sample
+// select are generated from vsort_template.h once per element type, on top
+// of the per-type hooks defined above.
+
+#define VSORT_T int
+#define VSORT_DATA_KIND VSORT_KIND_INT32
+#define VSORT_SUFFIX int32
+#define VSORT_TYPE_NAME "int"
+#include "vsort_template.h"
+
+#define VSORT_T float
+#define VSORT_DATA_KIND VSORT_KIND_FLOAT32
+#define VSORT_SUFFIX float32
+#define VSORT_TYPE_NAME "float"
+#include "vsort_template.h"
+
+#define VSORT_T int64_t
+#define VSORT_DATA_KIND VSORT_KIND_INT64
+#define VSORT_SUFFIX int64
+#define VSORT_TYPE_NAME "int64"
+#include "vsort_template.h"
+
+#define VSORT_T uint64_t
+#define VSORT_DATA_KIND VSORT_KIND_UINT64
+#define VSORT_SUFFIX uint64
+#define VSORT_TYPE_NAME "uint64"
+#include "vsort_template.h"
+
+#define VSORT_T double
+#define VSORT_DATA_KIND VSORT_KIND_FLOAT64
+#define VSORT_SUFFIX float64
+#define VSORT_TYPE_NAME "double"
+#include "vsort_template.h"
 
-        bool attempted_radix = false;
-        if ((flags & VSORT_FLAG_ALLOW_RADIX) && count >= rt->thresholds.radix_threshold)
-        {
-            attempted_radix = true;
-            if (vsort_radix_sort_int32(data, count))
-                return VSORT_OK;
-        }
+// -----------------------------------------------------------------------------
+// Generic engine
+// -----------------------------------------------------------------------------
+//
+// Comparator-driven sorting of opaque element_size-byte elements: the same
+// pdqsort scheme as the typed introsort (Hoare partitions, since moving
+// large elements is what costs), a stable top-down merge sort, and parallel
+// chunk sorting followed by co-ranked merge passes on the worker pool.
+// Element swaps go through a routine picked once per sort, with fixed-width
+// versions for 4, 8, 16 and 32 byte elements.
 
-        bool use_parallel = (flags & VSORT_FLAG_ALLOW_PARALLEL) && count >= rt->thresholds.parallel_threshold;
-        if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
-            use_parallel = use_parallel && count >= (rt->thresholds.parallel_threshold * 2);
-#if defined(VSORT_APPLE) && defined(__arm64__)
-        if (use_parallel)
-        {
-            if (vsort_parallel_int32(data, count, flags))
-                return VSORT_OK;
-            vsort_log_debug("Parallel path unavailable, reverting to sequential sort for %zu int elements.", count);
-        }
-#else
-        VSORT_UNUSED(use_parallel);
-#endif
+#define VSORT_GENERIC_LEAF 16
 
-        if (attempted_radix)
-            vsort_log_debug("Radix sort unavailable, using introsort for %zu int elements.", count);
+typedef int (*vsort_compare_fn)(const void *, const void *);
+typedef void (*vsort_swap_fn)(void *a, void *b, size_t size);
 
-        vsort_introsort_int32(data, count, flags);
-        return VSORT_OK;
-    }
-    case VSORT_KIND_FLOAT32:
-    {
-        float *data = (float *)options->data;
-        size_t count = options->length;
+typedef struct
+{
+    size_t size;
+    vsort_compare_fn compare;
+    vsort_swap_fn swap;
+    const char *base; /**< Indirect mode: elements are indices into base */
+    size_t stride;    /**< Size of the records base points to */
+} vsort_generic_t;
+
+static void vsort_swap_4(void *a, void *b, size_t size)
+{
+    VSORT_UNUSED(size);
+    uint32_t tmp;
+    memcpy(&tmp, a, sizeof(tmp));
+    memcpy(a, b, sizeof(tmp));
+    memcpy(b, &tmp, sizeof(tmp));
+}
 
-        if ((flags & VSORT_FLAG_FORCE_STABLE))
-        {
-            if (!vsort_mergesort_float32(data, count))
-            {
-                vsort_log_warning("Stable float sort allocation failed, falling back to introsort.");
-                vsort_introsort_float32(data, count);
-            }
-            return VSORT_OK;
-        }
+static void vsort_swap_8(void *a, void *b, size_t size)
+{
+    VSORT_UNUSED(size);
+    uint64_t tmp;
+    memcpy(&tmp, a, sizeof(tmp));
+    memcpy(a, b, sizeof(tmp));
+    memcpy(b, &tmp, sizeof(tmp));
+}
 
-        if (vsort_is_nearly_sorted_float32(data, count, rt->thresholds.sample_size))
-        {
-            vsort_insertion_sort_float32(data, count);
-            return VSORT_OK;
-        }
+static void vsort_swap_16(void *a, void *b, size_t size)
+{
+    VSORT_UNUSED(size);
+    uint64_t tmp[2];
+    memcpy(tmp, a, sizeof(tmp));
+    memcpy(a, b, sizeof(tmp));
+    memcpy(b, tmp, sizeof(tmp));
+}
 
-        bool use_parallel = (flags & VSORT_FLAG_ALLOW_PARALLEL) && count >= rt->thresholds.parallel_threshold;
-        if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
-            use_parallel = use_parallel && count >= (rt->thresholds.parallel_threshold * 2);
-#if defined(VSORT_APPLE) && defined(__arm64__)
-        if (use_parallel)
-        {
-            if (vsort_parallel_float32(data, count, flags))
-                return VSORT_OK;
-            vsort_log_debug("Parallel path unavailable, reverting to sequential sort for %zu float elements.", count);
-        }
-#else
-        VSORT_UNUSED(use_parallel);
-#endif
+static void vsort_swap_32(void *a, void *b, size_t size)
+{
+    VSORT_UNUSED(size);
+    uint64_t tmp[4];
+    memcpy(tmp, a, sizeof(tmp));
+    memcpy(a, b, sizeof(tmp));
+    memcpy(b, tmp, sizeof(tmp));
+}
 
-        vsort_introsort_float32(data, count);
-        return VSORT_OK;
-    }
-    case VSORT_KIND_CHAR8:
+static void vsort_swap_bytes(void *a, void *b, size_t size)
+{
+    unsigned char *x = (unsigned char *)a;
+    unsigned char *y = (unsigned char *)b;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), x += sizeof(uint64_t), y += sizeof(uint64_t))
     {
-        unsigned char *data = (unsigned char *)options->data;
-        vsort_counting_sort_char(data, options->length);
-        return VSORT_OK;
+        uint64_t tmp;
+        memcpy(&tmp, x, sizeof(tmp));
+        memcpy(x, y, sizeof(tmp));
+        memcpy(y, &tmp, sizeof(tmp));
     }
-    case VSORT_KIND_GENERIC:
+    for (; size > 0; --size, ++x, ++y)
     {
-        if (!options->comparator || options->element_size == 0)
-            return VSORT_ERR_INVALID_ARGUMENT;
-        qsort(options->data, options->length, options->element_size, options->comparator);
-        return VSORT_OK;
+        unsigned char tmp = *x;
+        *x = *y;
+        *y = tmp;
     }
+}
+
+static vsort_swap_fn vsort_pick_swap(size_t size)
+{
+    switch (size)
+    {
+    case 4:
+        return vsort_swap_4;
+    case 8:
+        return vsort_swap_8;
+    case 16:
+        return vsort_swap_16;
+    case 32:
+        return vsort_swap_32;
     default:
-        return VSORT_ERR_UNSUPPORTED_TYPE;
+        return vsort_swap_bytes;
     }
 }
 
-VSORT_API void vsort(int arr[], int n)
+static inline char *vsort_generic_at(const vsort_generic_t *g, char *data, size_t index)
 {
-    if (!arr || n <= 1)
-        return;
-
-    vsort_options_t options = {
-        .data = arr,
-        .length = (size_t)n,
-        .element_size = sizeof(int),
-        .kind = VSORT_KIND_INT32,
-        .comparator = NULL,
-        .flags = vsort_default_flags()};
-    (void)vsort_sort(&options);
+    return data + index * g->size;
 }
 
-VSORT_API void vsort_float(float arr[], int n)
+// In indirect mode (argsort) elements are uint32_t or size_t indices; the
+// records they name are compared and ties fall back to the index, which makes
+// every engine produce the stable permutation.
+static inline int vsort_generic_compare(const vsort_generic_t *g, const char *a, const char *b)
 {
-    if (!arr || n <= 1)
-        return;
+    if (!g->base)
+        return g->compare(a, b);
 
-    vsort_options_t options = {
-        .data = arr,
-        .length = (size_t)n,
-        .element_size = sizeof(float),
-        .kind = VSORT_KIND_FLOAT32,
-        .comparator = NULL,
-        .flags = vsort_default_flags() & ~VSORT_FLAG_ALLOW_RADIX};
-    (void)vsort_sort(&options);
+    size_t left, right;
+    if (g->size == sizeof(uint32_t))
+    {
+        uint32_t narrow_left, narrow_right;
+        memcpy(&narrow_left, a, sizeof(narrow_left));
+        memcpy(&narrow_right, b, sizeof(narrow_right));
+        left = narrow_left;
+        right = narrow_right;
+    }
+    else
+    {
+        memcpy(&left, a, sizeof(left));
+        memcpy(&right, b, sizeof(right));
+    }
+
+    int order = g->compare(g->base + left * g->stride, g->base + right * g->stride);
+    return order ? order : (left > right) - (left < right);
 }
 
-VSORT_API void vsort_char(char arr[], int n)
+static inline bool vsort_generic_less(const vsort_generic_t *g, const char *a, const char *b)
 {
-    if (!arr || n <= 1)
-        return;
+    return vsort_generic_compare(g, a, b) < 0;
+}
 
-    vsort_options_t options = {
-        .data = arr,
-        .length = (size_t)n,
-        .element_size = sizeof(char),
-        .kind = VSORT_KIND_CHAR8,
-        .comparator = NULL,
-        .flags = 0};
-    (void)vsort_sort(&options);
+static void vsort_generic_insertion_sort(const vsort_generic_t *g, char *data, size_t count)
+{
+    for (size_t i = 1; i < count; ++i)
+    {
+        for (size_t j = i; j > 0; --j)
+        {
+            char *prev = vsort_generic_at(g, data, j - 1);
+            char *cur = prev + g->size;
+            if (!vsort_generic_less(g, cur, prev))
+                break;
+            g->swap(prev, cur, g->size);
+        }
+    }
+}
+
+static bool vsort_generic_partial_insertion_sort(const vsort_generic_t *g, char *data, size_t count)
+{
+    size_t moves = 0;
+    for (size_t i = 1; i < count; ++i)
+    {
+        for (size_t j = i; j > 0; --j)
+        {
+            char *prev = vsort_generic_at(g, data, j - 1);
+            char *cur = prev + g->size;
+            if (!vsort_generic_less(g, cur, prev))
+                break;
+            g->swap(prev, cur, g->size);
+            if (++moves > VSORT_PARTIAL_INSERTION_LIMIT)
+                return false;
+        }
+    }
+    return true;
+}
+
+static void vsort_generic_heapify_down(const vsort_generic_t *g, char *data, size_t count, size_t root)
+{
+    while (true)
+    {
+        size_t child = root * 2 + 1;
+        if (child >= count)
+            break;
+
+        if (child + 1 < count && vsort_generic_less(g, vsort_generic_at(g, data, child), vsort_generic_at(g, data, child + 1)))
+            child++;
+
+        if (!vsort_generic_less(g, vsort_generic_at(g, data, root), vsort_generic_at(g, data, child)))
+            break;
+
+        g->swap(vsort_generic_at(g, data, root), vsort_generic_at(g, data, child), g->size);
+        root = child;
+    }
+}
+
+static void vsort_generic_heapsort(const vsort_generic_t *g, char *data, size_t count)
+{
+    if (count < 2)
+        return;
+
+    for (size_t i = count / 2; i-- > 0;)
+        vsort_generic_heapify_down(g, data, count, i);
+
+    for (size_t i = count - 1; i > 0; --i)
+    {
+        g->swap(data, vsort_generic_at(g, data, i), g->size);
+        vsort_generic_heapify_down(g, data, i, 0);
+    }
+}
+
+static void vsort_generic_sort3(const vsort_generic_t *g, char *data, size_t a, size_t b, size_t c)
+{
+    char *pa = vsort_generic_at(g, data, a);
+    char *pb = vsort_generic_at(g, data, b);
+    char *pc = vsort_generic_at(g, data, c);
+    if (vsort_generic_less(g, pb, pa))
+        g->swap(pa, pb, g->size);
+    if (vsort_generic_less(g, pc, pb))
+        g->swap(pb, pc, g->size);
+    if (vsort_generic_less(g, pb, pa))
+        g->swap(pa, pb, g->size);
+}
+
+static void vsort_generic_choose_pivot(const vsort_generic_t *g, char *data, size_t count)
+{
+    size_t last = count - 1;
+    size_t mid = count / 2;
+
+    if (count > VSORT_NINTHER_THRESHOLD)
+    {
+        vsort_generic_sort3(g, data, 0, mid, last);
+        vsort_generic_sort3(g, data, 1, mid - 1, last - 1);
+        vsort_generic_sort3(g, data, 2, mid + 1, last - 2);
+        vsort_generic_sort3(g, data, mid - 1, mid, mid + 1);
+    }
+    else
+    {
+        vsort_generic_sort3(g, data, 0, mid, last);
+    }
+    g->swap(vsort_generic_at(g, data, mid), vsort_generic_at(g, data, last), g->size);
+}
+
+// Hoare partition around the pivot at data[count - 1]: with strict set,
+// elements < pivot go left (partition_right), otherwise elements <= pivot
+// (partition_left). Returns the final pivot index.
+static size_t vsort_generic_partition(const vsort_generic_t *g, char *data, size_t count, bool strict,
+                                      bool *already_partitioned)
+{
+    size_t last = count - 1;
+    const char *pivot = vsort_generic_at(g, data, last);
+    size_t lo = 0;
+    size_t hi = last;
+    bool moved = false;
+
+    while (true)
+    {
+        while (lo < hi)
+        {
+            int order = vsort_generic_compare(g, vsort_generic_at(g, data, lo), pivot);
+            if (strict ? order >= 0 : order > 0)
+                break;
+            lo++;
+        }
+        while (lo < hi)
+        {
+            int order = vsort_generic_compare(g, vsort_generic_at(g, data, hi - 1), pivot);
+            if (strict ? order < 0 : order <= 0)
+                break;
+            hi--;
+        }
+        if (lo >= hi)
+            break;
+
+        g->swap(vsort_generic_at(g, data, lo), vsort_generic_at(g, data, hi - 1), g->size);
+        moved = true;
+        lo++;
+        hi--;
+    }
+
+    if (already_partitioned)
+        *already_partitioned = !moved;
+    if (lo != last)
+        g->swap(vsort_generic_at(g, data, lo), vsort_generic_at(g, data, last), g->size);
+    return lo;
+}
+
+static void vsort_generic_break_patterns(const vsort_generic_t *g, char *data, size_t count)
+{
+    if (count < VSORT_GENERIC_LEAF)
+        return;
+
+    size_t quarter = count / 4;
+    g->swap(vsort_generic_at(g, data, 0), vsort_generic_at(g, data, quarter), g->size);
+    g->swap(vsort_generic_at(g, data, count - 1), vsort_generic_at(g, data, count - quarter), g->size);
+    if (count > VSORT_NINTHER_THRESHOLD)
+    {
+        g->swap(vsort_generic_at(g, data, 1), vsort_generic_at(g, data, quarter + 1), g->size);
+        g->swap(vsort_generic_at(g, data, 2), vsort_generic_at(g, data, quarter + 2), g->size);
+        g->swap(vsort_generic_at(g, data, count - 2), vsort_generic_at(g, data, count - quarter - 1), g->size);
+        g->swap(vsort_generic_at(g, data, count - 3), vsort_generic_at(g, data, count - quarter - 2), g->size);
+    }
+}
+
+static void vsort_introsort_generic_impl(const vsort_generic_t *g, char *data, size_t count, size_t bad_allowed,
+                                         bool leftmost)
+{
+    while (count > VSORT_GENERIC_LEAF)
+    {
+        vsort_generic_choose_pivot(g, data, count);
+
+        if (!leftmost && !vsort_generic_less(g, data - g->size, vsort_generic_at(g, data, count - 1)))
+        {
+            size_t split = vsort_generic_partition(g, data, count, false, NULL);
+            data = vsort_generic_at(g, data, split + 1);
+            count -= split + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        size_t pivot_index = vsort_generic_partition(g, data, count, true, &already_partitioned);
+        size_t left_count = pivot_index;
+        size_t right_count = count - pivot_index - 1;
+        char *right = vsort_generic_at(g, data, pivot_index + 1);
+
+        if (left_count < count / 8 || right_count < count / 8)
+        {
+            if (--bad_allowed == 0)
+            {
+                vsort_generic_heapsort(g, data, count);
+                return;
+            }
+            vsort_generic_break_patterns(g, data, left_count);
+            vsort_generic_break_patterns(g, right, right_count);
+        }
+        else if (already_partitioned && vsort_generic_partial_insertion_sort(g, data, left_count) &&
+                 vsort_generic_partial_insertion_sort(g, right, right_count))
+        {
+            return;
+        }
+
+        if (left_count < right_count)
+        {
+            if (left_count > 0)
+                vsort_introsort_generic_impl(g, data, left_count, bad_allowed, leftmost);
+            data = right;
+            count = right_count;
+            leftmost = false;
+        }
+        else
+        {
+            if (right_count > 0)
+                vsort_introsort_generic_impl(g, right, right_count, bad_allowed, false);
+            count = left_count;
+        }
+    }
+
+    vsort_generic_insertion_sort(g, data, count);
+}
+
+static void vsort_introsort_generic(const vsort_generic_t *g, char *data, size_t count)
+{
+    if (count <= 1)
+        return;
+
+    vsort_introsort_generic_impl(g, data, count, vsort_floor_log2(count) + 1, true);
+}
+
+// Introselect counterpart of vsort_introsort_generic_impl (see
+// vsort_select_<suffix> in vsort_template.h).
+static void vsort_generic_select(const vsort_generic_t *g, char *data, size_t count, size_t nth)
+{
+    size_t bad_allowed = vsort_floor_log2(count) + 1;
+    bool leftmost = true;
+
+    while (count > VSORT_GENERIC_LEAF)
+    {
+        vsort_generic_choose_pivot(g, data, count);
+
+        if (!leftmost && !vsort_generic_less(g, data - g->size, vsort_generic_at(g, data, count - 1)))
+        {
+            size_t split = vsort_generic_partition(g, data, count, false, NULL);
+            if (nth <= split)
+                return;
+            data = vsort_generic_at(g, data, split + 1);
+            count -= split + 1;
+            nth -= split + 1;
+            continue;
+        }
+
+        size_t pivot_index = vsort_generic_partition(g, data, count, true, NULL);
+        if (nth == pivot_index)
+            return;
+
+        size_t left_count = pivot_index;
+        size_t right_count = count - pivot_index - 1;
+        char *right = vsort_generic_at(g, data, pivot_index + 1);
+        if (left_count < count / 8 || right_count < count / 8)
+        {
+            if (--bad_allowed == 0)
+            {
+                vsort_generic_heapsort(g, data, count);
+                return;
+            }
+            vsort_generic_break_patterns(g, data, left_count);
+            vsort_generic_break_patterns(g, right, right_count);
+        }
+
+        if (nth < pivot_index)
+        {
+            count = left_count;
+        }
+        else
+        {
+            data = right;
+            count = right_count;
+            nth -= pivot_index + 1;
+            leftmost = false;
+        }
+    }
+
+    vsort_generic_insertion_sort(g, data, count);
+}
+
+// Stable merge of data[left, mid) and data[mid, right); buffer holds at
+// least mid - left elements.
+static void vsort_generic_merge(const vsort_generic_t *g, char *data, char *buffer, size_t left, size_t mid, size_t right)
+{
+    size_t size = g->size;
+    if (!vsort_generic_less(g, vsort_generic_at(g, data, mid), vsort_generic_at(g, data, mid - 1)))
+        return;
+
+    memcpy(buffer, vsort_generic_at(g, data, left), (mid - left) * size);
+
+    const char *a = buffer;
+    const char *a_end = buffer + (mid - left) * size;
+    const char *b = vsort_generic_at(g, data, mid);
+    const char *b_end = vsort_generic_at(g, data, right);
+    char *out = vsort_generic_at(g, data, left);
+
+    while (a < a_end && b < b_end)
+    {
+        if (vsort_generic_less(g, b, a))
+        {
+            memcpy(out, b, size);
+            b += size;
+        }
+        else
+        {
+            memcpy(out, a, size);
+            a += size;
+        }
+        out += size;
+    }
+    memcpy(out, a, (size_t)(a_end - a));
+}
+
+static void vsort_mergesort_generic_impl(const vsort_generic_t *g, char *data, char *buffer, size_t left, size_t right)
+{
+    size_t count = right - left;
+    if (count <= VSORT_GENERIC_LEAF)
+    {
+        vsort_generic_insertion_sort(g, vsort_generic_at(g, data, left), count);
+        return;
+    }
+
+    size_t mid = left + count / 2;
+    vsort_mergesort_generic_impl(g, data, buffer, left, mid);
+    vsort_mergesort_generic_impl(g, data, buffer, mid, right);
+    vsort_generic_merge(g, data, buffer, left, mid, right);
+}
+
+// buffer must hold count / 2 + 1 elements.
+static void vsort_mergesort_generic_with(const vsort_generic_t *g, char *data, char *buffer, size_t count)
+{
+    if (count > 1)
+        vsort_mergesort_generic_impl(g, data, buffer, 0, count);
+}
+
+static bool vsort_mergesort_generic(const vsort_generic_t *g, char *data, size_t count)
+{
+    if (count <= 1)
+        return true;
+
+    char *buffer = (char *)vsort_scratch_alloc((count / 2 + 1) * g->size);
+    if (!buffer)
+        return false;
+
+    vsort_mergesort_generic_with(g, data, buffer, count);
+    vsort_scratch_free(buffer);
+    return true;
+}
+
+typedef struct
+{
+    const vsort_generic_t *g;
+    const char *src;
+    char *dst;
+    char *scratch;
+    size_t count;
+    size_t width;
+    size_t part;
+    bool stable;
+    vsort_cancel_t *cancel;
+} vsort_parallel_job_generic_t;
+
+static void vsort_parallel_chunk_generic(void *context, size_t index)
+{
+    const vsort_parallel_job_generic_t *job = (const vsort_parallel_job_generic_t *)context;
+    const vsort_generic_t *g = job->g;
+    size_t begin = index * job->width;
+    size_t end = VSORT_MIN(begin + job->width, job->count);
+    char *chunk = vsort_generic_at(g, job->dst, begin);
+    if (vsort_cancel_check(job->cancel))
+        return;
+
+    // The merge buffer is idle while chunks sort, so each chunk borrows its
+    // own slice of it as merge sort scratch.
+    if (job->stable)
+        vsort_mergesort_generic_with(g, chunk, vsort_generic_at(g, job->scratch, begin), end - begin);
+    else
+        vsort_introsort_generic(g, chunk, end - begin);
+}
+
+static size_t vsort_co_rank_generic(const vsort_generic_t *g, const char *a, size_t a_count, const char *b,
+                                    size_t b_count, size_t k)
+{
+    size_t lo = k > b_count ? k - b_count : 0;
+    size_t hi = VSORT_MIN(k, a_count);
+    while (lo < hi)
+    {
+        size_t i = lo + (hi - lo) / 2;
+        if (!vsort_generic_less(g, b + (k - i - 1) * g->size, a + i * g->size))
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+static void vsort_merge_range_generic(const vsort_generic_t *g, const char *a, size_t a_count, const char *b,
+                                      size_t b_count, char *out)
+{
+    size_t size = g->size;
+    const char *a_end = a + a_count * size;
+    const char *b_end = b + b_count * size;
+    while (a < a_end && b < b_end)
+    {
+        if (vsort_generic_less(g, b, a))
+        {
+            memcpy(out, b, size);
+            b += size;
+        }
+        else
+        {
+            memcpy(out, a, size);
+            a += size;
+        }
+        out += size;
+    }
+    memcpy(out, a, (size_t)(a_end - a));
+    out += a_end - a;
+    memcpy(out, b, (size_t)(b_end - b));
+}
+
+static void vsort_parallel_merge_part_generic(void *context, size_t index)
+{
+    const vsort_parallel_job_generic_t *job = (const vsort_parallel_job_generic_t *)context;
+    const vsort_generic_t *g = job->g;
+    size_t pos = index * job->part;
+    size_t stop = VSORT_MIN(pos + job->part, job->count);
+
+    while (pos < stop)
+    {
+        size_t left = pos - pos % (job->width * 2);
+        size_t mid = VSORT_MIN(left + job->width, job->count);
+        size_t right = VSORT_MIN(left + job->width * 2, job->count);
+        size_t end = VSORT_MIN(stop, right);
+
+        const char *a = job->src + left * g->size;
+        const char *b = job->src + mid * g->size;
+        size_t a_count = mid - left;
+        size_t b_count = right - mid;
+        size_t k0 = pos - left;
+        size_t k1 = end - left;
+        size_t i0 = vsort_co_rank_generic(g, a, a_count, b, b_count, k0);
+        size_t i1 = vsort_co_rank_generic(g, a, a_count, b, b_count, k1);
+
+        vsort_merge_range_generic(g, a + i0 * g->size, i1 - i0, b + (k0 - i0) * g->size, (k1 - i1) - (k0 - i0),
+                                  vsort_generic_at(g, job->dst, pos));
+        pos = end;
+    }
+}
+
+static void vsort_parallel_copy_part_generic(void *context, size_t index)
+{
+    const vsort_parallel_job_generic_t *job = (const vsort_parallel_job_generic_t *)context;
+    size_t begin = index * job->part;
+    size_t end = VSORT_MIN(begin + job->part, job->count);
+    if (begin < end)
+        memcpy(vsort_generic_at(job->g, job->dst, begin), job->src + begin * job->g->size, (end - begin) * job->g->size);
+}
+
+static bool vsort_parallel_generic(const vsort_generic_t *g, char *data, size_t count, unsigned int flags)
+{
+    int threads = vsort_parallel_threads(flags);
+    if (threads < 2)
+        return false;
+
+    // Keep chunks about as many bytes as the int32 engine uses.
+    size_t chunk = VSORT_MAX(vsort_parallel_chunk_size() * sizeof(int) / g->size, (size_t)VSORT_GENERIC_LEAF * 8);
+    size_t chunk_count = (count + chunk - 1) / chunk;
+    if (chunk_count < 2)
+        return false;
+
+    char *buffer = (char *)vsort_scratch_alloc(count * g->size);
+    if (!buffer)
+    {
+        vsort_stats_fallback(VSORT_FALLBACK_MERGE_BUFFER);
+        return false;
+    }
+
+    size_t slices = vsort_parallel_slices(threads);
+    vsort_parallel_job_generic_t job = {
+        .g = g,
+        .src = data,
+        .dst = data,
+        .scratch = buffer,
+        .count = count,
+        .width = chunk,
+        .part = (count + slices - 1) / slices,
+        .stable = (flags & VSORT_FLAG_FORCE_STABLE) != 0,
+        .cancel = vsort_cancel_current()};
+    uint64_t phase = vsort_stats_phase_begin();
+    vsort_pool_parallel_for(chunk_count, vsort_parallel_chunk_generic, &job, threads, flags);
+    vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+
+    phase = vsort_stats_phase_begin();
+    job.dst = buffer;
+    for (size_t width = chunk; width < count && !vsort_cancel_check(job.cancel); width *= 2)
+    {
+        job.width = width;
+        vsort_pool_parallel_for(slices, vsort_parallel_merge_part_generic, &job, threads, flags);
+        vsort_stats_merge_pass();
+        char *swap = (char *)job.src;
+        job.src = job.dst;
+        job.dst = swap;
+    }
+
+    if (job.src != data)
+    {
+        job.dst = data;
+        vsort_pool_parallel_for(slices, vsort_parallel_copy_part_generic, &job, threads, flags);
+    }
+    vsort_stats_phase_end(VSORT_PHASE_MERGE, phase);
+
+    vsort_scratch_free(buffer);
+    vsort_stats_engine(VSORT_ENGINE_PARALLEL_MERGE, threads);
+    return true;
+}
+
+static void vsort_sort_generic_with(const vsort_generic_t *g, char *data, size_t count, unsigned int flags)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    bool use_parallel = (flags & VSORT_FLAG_ALLOW_PARALLEL) && count >= rt->thresholds.parallel_threshold;
+    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
+        use_parallel = use_parallel && count >= (rt->thresholds.parallel_threshold * 2);
+
+    if (use_parallel)
+    {
+        if (vsort_parallel_generic(g, data, count, flags))
+            return;
+        vsort_log_debug("Parallel path unavailable, reverting to sequential sort for %zu generic elements.", count);
+        if (vsort_parallel_threads(flags) < 2)
+            vsort_stats_fallback(VSORT_FALLBACK_SEQUENTIAL);
+    }
+
+    uint64_t phase = vsort_stats_phase_begin();
+    if (flags & VSORT_FLAG_FORCE_STABLE)
+    {
+        if (vsort_mergesort_generic(g, data, count))
+        {
+            vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+            vsort_stats_engine(VSORT_ENGINE_MERGESORT, 1);
+            return;
+        }
+        vsort_log_warning("Stable generic sort allocation failed, falling back to introsort.");
+        vsort_stats_fallback(VSORT_FALLBACK_STABLE_BUFFER);
+    }
+
+    vsort_introsort_generic(g, data, count);
+    vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+    vsort_stats_engine(VSORT_ENGINE_INTROSORT, 1);
+}
+
+static void vsort_sort_generic(void *data, size_t count, size_t size, vsort_compare_fn compare, unsigned int flags)
+{
+    vsort_generic_t g = {
+        .size = size,
+        .compare = compare,
+        .swap = vsort_pick_swap(size),
+        .base = NULL,
+        .stride = 0};
+    vsort_sort_generic_with(&g, (char *)data, count, flags);
+}
+
+// -----------------------------------------------------------------------------
+// Key extraction
+// -----------------------------------------------------------------------------
+//
+// vsort_sort_by_key turns every record into a (key, index) pair whose key is
+// an unsigned word with the requested order, LSD radix sorts the pairs on
+// the worker pool (the pair-building pass doubles as the histogram pass),
+// and finally moves every record once: gathered into a scratch copy, or
+// permuted in place cycle by cycle under VSORT_FLAG_LOW_MEMORY. vsort_argsort
+// runs the same engine and writes the sorted indices out instead, and
+// vsort_sort_kv carries the payload in place of the index and writes the
+// keys and values back from the sorted pairs.
+
+#define VSORT_KEY_PASSES 8
+
+typedef struct
+{
+    uint64_t key;
+    uint64_t index; /**< Record index, or the payload for vsort_sort_kv */
+} vsort_key_pair_t;
+
+typedef struct
+{
+    const unsigned char *records;
+    unsigned char *scratch;
+    size_t element_size;
+    size_t key_offset;
+    vsort_key_type_t key_type;
+    uint64_t invert;
+    bool packed; /**< 32-bit keys: (key << 32 | index) words instead of pairs */
+    unsigned char *values; /**< vsort_sort_kv payload, NULL otherwise */
+    size_t value_size;
+    size_t passes;
+    const vsort_key_pair_t *src;
+    vsort_key_pair_t *dst;
+    const uint64_t *packed_src;
+    uint64_t *packed_dst;
+    void *indices;
+    vsort_index_type_t index_type;
+    size_t count;
+    size_t block;
+    size_t pass;
+    size_t *histograms;
+} vsort_key_job_t;
+
+// Order-preserving record key -> unsigned word mapping.
+static inline uint64_t vsort_key_word(const unsigned char *field, vsort_key_type_t type)
+{
+    switch (type)
+    {
+    case VSORT_KEY_INT32:
+    case VSORT_KEY_UINT32:
+    case VSORT_KEY_FLOAT32:
+    {
+        uint32_t bits;
+        memcpy(&bits, field, sizeof(bits));
+        if (type == VSORT_KEY_INT32)
+            return bits ^ VSORT_SIGN32;
+        if (type == VSORT_KEY_FLOAT32)
+            return vsort_radix_key32(bits, VSORT_FLOAT_MASK32, VSORT_SIGN32);
+        return bits;
+    }
+    default:
+    {
+        uint64_t bits;
+        memcpy(&bits, field, sizeof(bits));
+        if (type == VSORT_KEY_INT64)
+            return bits ^ VSORT_SIGN64;
+        if (type == VSORT_KEY_FLOAT64)
+            return vsort_radix_key64(bits, VSORT_FLOAT_MASK64, VSORT_SIGN64);
+        return bits;
+    }
+    }
+}
+
+// Inverse of vsort_key_word; the float mapping is its own inverse once the
+// sign flip is undone.
+static inline void vsort_key_store(unsigned char *field, uint64_t word, vsort_key_type_t type)
+{
+    switch (type)
+    {
+    case VSORT_KEY_INT32:
+    case VSORT_KEY_UINT32:
+    case VSORT_KEY_FLOAT32:
+    {
+        uint32_t bits = (uint32_t)word;
+        if (type == VSORT_KEY_INT32)
+            bits ^= VSORT_SIGN32;
+        else if (type == VSORT_KEY_FLOAT32)
+            bits = vsort_radix_ordered32(bits ^ VSORT_SIGN32, VSORT_FLOAT_MASK32);
+        memcpy(field, &bits, sizeof(bits));
+        return;
+    }
+    default:
+    {
+        uint64_t bits = word;
+        if (type == VSORT_KEY_INT64)
+            bits ^= VSORT_SIGN64;
+        else if (type == VSORT_KEY_FLOAT64)
+            bits = vsort_radix_ordered64(bits ^ VSORT_SIGN64, VSORT_FLOAT_MASK64);
+        memcpy(field, &bits, sizeof(bits));
+        return;
+    }
+    }
+}
+
+static size_t vsort_key_size(vsort_key_type_t type)
+{
+    switch (type)
+    {
+    case VSORT_KEY_INT32:
+    case VSORT_KEY_UINT32:
+    case VSORT_KEY_FLOAT32:
+        return 4;
+    case VSORT_KEY_INT64:
+    case VSORT_KEY_UINT64:
+    case VSORT_KEY_FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+// Digit of the given pass; packed words keep the key in their upper half.
+static inline size_t vsort_key_digit(const vsort_key_job_t *job, size_t i, size_t pass)
+{
+    if (job->packed)
+        return (size_t)(job->packed_src[i] >> (32 + pass * VSORT_RADIX_BITS)) & (VSORT_RADIX_BINS - 1u);
+    return (size_t)(job->src[i].key >> (pass * VSORT_RADIX_BITS)) & (VSORT_RADIX_BINS - 1u);
+}
+
+static inline size_t vsort_key_index(const vsort_key_job_t *job, size_t i)
+{
+    return job->packed ? (size_t)(uint32_t)job->packed_src[i] : (size_t)job->src[i].index;
+}
+
+// What travels with key i: its payload for vsort_sort_kv, its index otherwise.
+static inline uint64_t vsort_key_payload(const vsort_key_job_t *job, size_t i)
+{
+    if (!job->values)
+        return (uint64_t)i;
+    if (job->value_size == sizeof(uint32_t))
+    {
+        uint32_t value;
+        memcpy(&value, job->values + i * sizeof(uint32_t), sizeof(value));
+        return value;
+    }
+    uint64_t value;
+    memcpy(&value, job->values + i * sizeof(uint64_t), sizeof(value));
+    return value;
+}
+
+// Builds the pairs of one block and counts the digits of every pass.
+static void vsort_key_extract(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t *histogram = job->histograms + index * VSORT_KEY_PASSES * VSORT_RADIX_BINS;
+    const size_t passes = job->passes;
+
+    memset(histogram, 0, VSORT_KEY_PASSES * VSORT_RADIX_BINS * sizeof(size_t));
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t key = vsort_key_word(job->records + i * job->element_size + job->key_offset, job->key_type) ^ job->invert;
+        uint64_t payload = vsort_key_payload(job, i);
+        if (job->packed)
+        {
+            job->packed_dst[i] = (key << 32) | payload;
+        }
+        else
+        {
+            job->dst[i].key = key;
+            job->dst[i].index = payload;
+        }
+        for (size_t pass = 0; pass < passes; ++pass)
+            histogram[pass * VSORT_RADIX_BINS + ((key >> (pass * VSORT_RADIX_BITS)) & (VSORT_RADIX_BINS - 1u))]++;
+    }
+}
+
+static void vsort_key_histogram(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t *histogram = job->histograms + (index * VSORT_KEY_PASSES + job->pass) * VSORT_RADIX_BINS;
+
+    memset(histogram, 0, VSORT_RADIX_BINS * sizeof(size_t));
+    for (size_t i = begin; i < end; ++i)
+        histogram[vsort_key_digit(job, i, job->pass)]++;
+}
+
+static void vsort_key_scatter(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t *histogram = job->histograms + (index * VSORT_KEY_PASSES + job->pass) * VSORT_RADIX_BINS;
+
+    if (job->packed)
+    {
+        for (size_t i = begin; i < end; ++i)
+            job->packed_dst[histogram[vsort_key_digit(job, i, job->pass)]++] = job->packed_src[i];
+        return;
+    }
+
+    for (size_t i = begin; i < end; ++i)
+        job->dst[histogram[vsort_key_digit(job, i, job->pass)]++] = job->src[i];
+}
+
+static void vsort_key_gather(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+
+    for (size_t i = begin; i < end; ++i)
+        memcpy(job->scratch + i * job->element_size, job->records + vsort_key_index(job, i) * job->element_size,
+               job->element_size);
+}
+
+static void vsort_key_write_indices(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+
+    if (job->index_type == VSORT_INDEX_UINT32)
+    {
+        uint32_t *out = (uint32_t *)job->indices;
+        for (size_t i = begin; i < end; ++i)
+            out[i] = (uint32_t)vsort_key_index(job, i);
+        return;
+    }
+
+    size_t *out = (size_t *)job->indices;
+    for (size_t i = begin; i < end; ++i)
+        out[i] = vsort_key_index(job, i);
+}
+
+// vsort_sort_kv: splits the sorted pairs back into the key and value arrays.
+static void vsort_key_write_pairs(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    unsigned char *keys = (unsigned char *)job->records;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t word = job->packed ? job->packed_src[i] >> 32 : job->src[i].key;
+        uint64_t payload = job->packed ? (uint32_t)job->packed_src[i] : job->src[i].index;
+        vsort_key_store(keys + i * job->element_size, word ^ job->invert, job->key_type);
+        if (job->value_size == sizeof(uint32_t))
+        {
+            uint32_t value = (uint32_t)payload;
+            memcpy(job->values + i * sizeof(uint32_t), &value, sizeof(value));
+        }
+        else
+        {
+            memcpy(job->values + i * sizeof(uint64_t), &payload, sizeof(payload));
+        }
+    }
+}
+
+static void vsort_key_copy_back(void *context, size_t index)
+{
+    const vsort_key_job_t *job = (const vsort_key_job_t *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    if (begin < end)
+        memcpy((unsigned char *)job->records + begin * job->element_size, job->scratch + begin * job->element_size,
+               (end - begin) * job->element_size);
+}
+
+static bool vsort_key_pass_is_trivial(const vsort_key_job_t *job, size_t tasks, size_t pass)
+{
+    for (size_t bucket = 0; bucket < VSORT_RADIX_BINS; ++bucket)
+    {
+        size_t total = 0;
+        for (size_t t = 0; t < tasks; ++t)
+            total += job->histograms[(t * VSORT_KEY_PASSES + pass) * VSORT_RADIX_BINS + bucket];
+        if (total != 0)
+            return total == job->count;
+    }
+    return true;
+}
+
+static void vsort_key_prefix(const vsort_key_job_t *job, size_t tasks, size_t pass)
+{
+    size_t total = 0;
+    for (size_t bucket = 0; bucket < VSORT_RADIX_BINS; ++bucket)
+    {
+        for (size_t t = 0; t < tasks; ++t)
+        {
+            size_t *slot = &job->histograms[(t * VSORT_KEY_PASSES + pass) * VSORT_RADIX_BINS + bucket];
+            size_t tmp = *slot;
+            *slot = total;
+            total += tmp;
+        }
+    }
+}
+
+// Applies the sorted order in place: the i-th sorted entry names the record
+// that belongs at position i. Each cycle is rotated through one spare record;
+// visited positions are marked in a bitmap.
+static bool vsort_key_permute_in_place(const vsort_key_job_t *job)
+{
+    unsigned char *records = (unsigned char *)job->records;
+    size_t element_size = job->element_size;
+    size_t count = job->count;
+    unsigned char *spare = (unsigned char *)vsort_scratch_alloc(element_size);
+    uint64_t *placed = (uint64_t *)vsort_scratch_alloc((count + 63) / 64 * sizeof(uint64_t));
+    if (!spare || !placed)
+    {
+        vsort_scratch_free(spare);
+        vsort_scratch_free(placed);
+        return false;
+    }
+    memset(placed, 0, (count + 63) / 64 * sizeof(uint64_t));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if ((placed[i / 64] >> (i % 64)) & 1u)
+            continue;
+
+        memcpy(spare, records + i * element_size, element_size);
+        size_t j = i;
+        while (true)
+        {
+            size_t source = vsort_key_index(job, j);
+            placed[j / 64] |= (uint64_t)1 << (j % 64);
+            if (source == i)
+            {
+                memcpy(records + j * element_size, spare, element_size);
+                break;
+            }
+            memcpy(records + j * element_size, records + source * element_size, element_size);
+            j = source;
+        }
+    }
+
+    vsort_scratch_free(spare);
+    vsort_scratch_free(placed);
+    return true;
+}
+
+// Sorts the records, or leaves them untouched and writes the sorting
+// permutation to indices when it is non-NULL. With values set, records is a
+// packed key array and the value array of value_size words is sorted along.
+static vsort_result_t vsort_key_sort(unsigned char *records, size_t count, size_t element_size, size_t key_offset,
+                                     vsort_key_type_t key_type, bool descending, unsigned int flags, void *indices,
+                                     vsort_index_type_t index_type, unsigned char *values, size_t value_size)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    bool use_parallel = (flags & VSORT_FLAG_ALLOW_PARALLEL) && count >= rt->thresholds.parallel_threshold;
+    int workers = use_parallel ? vsort_parallel_threads(flags) : 1;
+    size_t tasks = workers > 1 ? vsort_parallel_slices(workers) : 1;
+    if (tasks > 1 && count / tasks < VSORT_RADIX_MIN_BLOCK)
+        tasks = VSORT_MAX((size_t)1, count / VSORT_RADIX_MIN_BLOCK);
+    workers = (int)VSORT_MIN((size_t)workers, tasks);
+
+    // Descending order inverts the key but not the index, which keeps equal
+    // keys in their original order.
+    size_t key_size = vsort_key_size(key_type);
+    uint64_t width_mask = key_size == 4 ? 0xFFFFFFFFull : ~(uint64_t)0;
+    vsort_key_job_t job = {
+        .records = records,
+        .scratch = NULL,
+        .element_size = element_size,
+        .key_offset = key_offset,
+        .key_type = key_type,
+        .invert = descending ? width_mask : 0,
+        .packed = key_size == 4 && (values ? value_size == sizeof(uint32_t) : count <= UINT32_MAX),
+        .values = values,
+        .value_size = value_size,
+        .passes = key_size,
+        .src = NULL,
+        .dst = NULL,
+        .packed_src = NULL,
+        .packed_dst = NULL,
+        .indices = indices,
+        .index_type = index_type,
+        .count = count,
+        .block = (count + tasks - 1) / tasks,
+        .pass = 0,
+        .histograms = NULL};
+    tasks = (count + job.block - 1) / job.block;
+
+    size_t entry_size = job.packed ? sizeof(uint64_t) : sizeof(vsort_key_pair_t);
+    char *entries = vsort_scratch_alloc(count * entry_size);
+    char *spare = vsort_scratch_alloc(count * entry_size);
+    job.histograms = vsort_scratch_alloc(tasks * VSORT_KEY_PASSES * VSORT_RADIX_BINS * sizeof(size_t));
+    if (!entries || !spare || !job.histograms)
+    {
+        vsort_scratch_free(entries);
+        vsort_scratch_free(spare);
+        vsort_scratch_free(job.histograms);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+
+    job.dst = (vsort_key_pair_t *)entries;
+    job.packed_dst = (uint64_t *)entries;
+    vsort_pool_parallel_for(tasks, vsort_key_extract, &job, workers, flags);
+
+    char *input = entries;
+    char *output = spare;
+    bool first = true;
+    for (size_t pass = 0; pass < job.passes; ++pass)
+    {
+        job.pass = pass;
+        job.src = (const vsort_key_pair_t *)input;
+        job.packed_src = (const uint64_t *)input;
+
+        // The pre-pass rows stay valid for the first active pass only.
+        if (!first && tasks > 1)
+            vsort_pool_parallel_for(tasks, vsort_key_histogram, &job, workers, flags);
+        if (vsort_key_pass_is_trivial(&job, tasks, pass))
+            continue;
+
+        job.dst = (vsort_key_pair_t *)output;
+        job.packed_dst = (uint64_t *)output;
+        vsort_key_prefix(&job, tasks, pass);
+        vsort_pool_parallel_for(tasks, vsort_key_scatter, &job, workers, flags);
+        first = false;
+
+        char *swap = input;
+        input = output;
+        output = swap;
+    }
+
+    vsort_result_t result = VSORT_OK;
+    job.src = (const vsort_key_pair_t *)input;
+    job.packed_src = (const uint64_t *)input;
+    bool direct = indices || values;
+    unsigned char *scratch = (direct || (flags & VSORT_FLAG_LOW_MEMORY)) ? NULL : vsort_scratch_alloc(count * element_size);
+    if (values)
+    {
+        vsort_pool_parallel_for(tasks, vsort_key_write_pairs, &job, workers, flags);
+    }
+    else if (indices)
+    {
+        vsort_pool_parallel_for(tasks, vsort_key_write_indices, &job, workers, flags);
+    }
+    else if (scratch)
+    {
+        job.scratch = scratch;
+        vsort_pool_parallel_for(tasks, vsort_key_gather, &job, workers, flags);
+        vsort_pool_parallel_for(tasks, vsort_key_copy_back, &job, workers, flags);
+        vsort_scratch_free(scratch);
+    }
+    else if (!vsort_key_permute_in_place(&job))
+    {
+        result = VSORT_ERR_ALLOCATION_FAILED;
+    }
+
+    vsort_scratch_free(entries);
+    vsort_scratch_free(spare);
+    vsort_scratch_free(job.histograms);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// K-way run merging
+// -----------------------------------------------------------------------------
+//
+// vsort_merge_runs drives the loser tree of vsort_merge.c. Large merges cut
+// the output into equal slices at ranks located by vsort_merge_split; each
+// slice is an independent merge of the matching run segments, so the slices
+// run on the worker pool without sharing state.
+
+typedef struct
+{
+    vsort_merge_cursor_t *runs;    /**< Whole runs */
+    size_t run_count;
+    vsort_data_kind_t kind;
+    size_t element_size;
+    unsigned char *output;
+    size_t total;
+    size_t parts;
+    size_t *splits;                /**< (parts + 1) rows of run_count positions */
+    vsort_merge_cursor_t *cursors; /**< parts rows of run_count cursors */
+    bool *failed;                  /**< Per slice: its loser tree was not allocated */
+    bool numa;                     /**< Merge each slice on the node that owns its output */
+} vsort_merge_runs_job_t;
+
+static void vsort_merge_runs_split_task(void *context, size_t index)
+{
+    vsort_merge_runs_job_t *job = (vsort_merge_runs_job_t *)context;
+    size_t part = index + 1;
+    size_t rank = job->total / job->parts * part + job->total % job->parts * part / job->parts;
+    vsort_merge_split(job->kind, job->runs, job->run_count, rank, job->splits + part * job->run_count);
+}
+
+static void vsort_merge_runs_task(void *context, size_t part)
+{
+    vsort_merge_runs_job_t *job = (vsort_merge_runs_job_t *)context;
+    const size_t *begin = job->splits + part * job->run_count;
+    const size_t *end = begin + job->run_count;
+    vsort_merge_cursor_t *cursors = job->cursors + part * job->run_count;
+
+    size_t offset = 0;
+    size_t count = 0;
+    for (size_t r = 0; r < job->run_count; ++r)
+    {
+        cursors[r].data = job->runs[r].data + begin[r] * job->element_size;
+        cursors[r].remaining = end[r] - begin[r];
+        offset += begin[r];
+        count += cursors[r].remaining;
+    }
+
+    vsort_numa_binding_t binding = {.bound = false};
+    if (job->numa)
+        vsort_numa_bind(vsort_numa_node_of(offset, job->total), &binding);
+
+    vsort_loser_tree_t tree;
+    job->failed[part] = !vsort_loser_tree_init(&tree, job->kind, cursors, job->run_count, NULL, NULL);
+    if (!job->failed[part])
+    {
+        vsort_loser_tree_merge(&tree, job->output + offset * job->element_size, count);
+        vsort_loser_tree_destroy(&tree);
+    }
+    vsort_numa_unbind(&binding);
+}
+
+static vsort_result_t vsort_merge_runs_impl(const vsort_merge_options_t *options, size_t element_size, size_t total,
+                                            bool numa)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    size_t run_count = options->run_count;
+
+    size_t parts = 1;
+    int threads = vsort_parallel_threads(flags);
+    if ((flags & VSORT_FLAG_ALLOW_PARALLEL) && threads > 1 && total >= rt->thresholds.parallel_threshold)
+    {
+        // A couple of slices per thread absorbs uneven slice costs.
+        parts = VSORT_MIN(VSORT_MAX((size_t)threads * 2, vsort_parallel_slices(threads)), total / vsort_parallel_chunk_size());
+        parts = VSORT_MAX(parts, (size_t)1);
+    }
+
+    vsort_merge_runs_job_t job = {
+        .run_count = run_count,
+        .kind = options->kind,
+        .element_size = element_size,
+        .output = (unsigned char *)options->output,
+        .total = total,
+        .parts = parts,
+        .numa = numa};
+    job.runs = (vsort_merge_cursor_t *)vsort_scratch_alloc(run_count * sizeof(vsort_merge_cursor_t));
+    job.cursors = (vsort_merge_cursor_t *)vsort_scratch_alloc(parts * run_count * sizeof(vsort_merge_cursor_t));
+    job.splits = (size_t *)vsort_scratch_alloc((parts + 1) * run_count * sizeof(size_t));
+    job.failed = (bool *)vsort_scratch_alloc(parts * sizeof(bool));
+    if (!job.runs || !job.cursors || !job.splits || !job.failed)
+    {
+        vsort_scratch_free(job.runs);
+        vsort_scratch_free(job.cursors);
+        vsort_scratch_free(job.splits);
+        vsort_scratch_free(job.failed);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+    memset(job.splits, 0, run_count * sizeof(size_t));
+
+    size_t *last = job.splits + parts * run_count;
+    for (size_t r = 0; r < run_count; ++r)
+    {
+        job.runs[r].data = (const unsigned char *)options->runs[r].data;
+        job.runs[r].remaining = options->runs[r].length;
+        last[r] = options->runs[r].length;
+    }
+
+    if (parts > 1)
+    {
+        vsort_pool_parallel_for(parts - 1, vsort_merge_runs_split_task, &job, threads, flags);
+        // Keeps every slice well-formed even if a run is not quite ascending
+        // (e.g. -0.0 and +0.0 interleaved): the output stays a permutation.
+        for (size_t p = 1; p <= parts; ++p)
+        {
+            size_t *row = job.splits + p * run_count;
+            for (size_t r = 0; r < run_count; ++r)
+                row[r] = VSORT_MAX(row[r], row[r - run_count]);
+        }
+        vsort_log_debug("Merging %zu runs (%zu elements) in %zu slices.", run_count, total, parts);
+    }
+    vsort_pool_parallel_for(parts, vsort_merge_runs_task, &job, threads, flags);
+
+    vsort_result_t result = VSORT_OK;
+    for (size_t p = 0; p < parts; ++p)
+    {
+        if (job.failed[p])
+            result = VSORT_ERR_ALLOCATION_FAILED;
+    }
+    vsort_scratch_free(job.runs);
+    vsort_scratch_free(job.cursors);
+    vsort_scratch_free(job.splits);
+    vsort_scratch_free(job.failed);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// NUMA-aware sorting
+// -----------------------------------------------------------------------------
+//
+// On hosts with several NUMA nodes a large parallel sort is cut into one
+// stripe per thread, the stripes being spread over the nodes in proportion
+// to their CPUs. A thread pinned to the stripe's node copies it into a block
+// freshly allocated for that node, where first touch places the pages, and
+// sorts it there, so the sorting traffic stays node-local. The blocks bypass
+// the scratch cache and context arenas: a reused block keeps the pages of
+// whichever node touched it first. One K-way merge of all stripes then
+// writes the result back, each slice merged on the node that owns its part
+// of the output: every element crosses the interconnect at most once on the
+// way out and once on the way back.
+
+#define VSORT_NUMA_MAX_STRIPES 256
+
+typedef struct
+{
+    unsigned char *data;
+    size_t count;
+    size_t element_size;
+    size_t stripe;                /**< Elements per stripe (the last may be short) */
+    unsigned char **stripe_data;  /**< Per stripe: its copy in a node-local block */
+    int *stripe_node;
+    vsort_numa_sort_fn sort;
+    unsigned int flags;
+    vsort_cancel_t *cancel;
+} vsort_numa_job_t;
+
+static void vsort_numa_stripe_task(void *context, size_t index)
+{
+    const vsort_numa_job_t *job = (const vsort_numa_job_t *)context;
+    size_t begin = index * job->stripe;
+    size_t length = VSORT_MIN(job->stripe, job->count - begin);
+
+    // Stripes the calling thread sorts must not report their own engine.
+    vsort_stats_collector_t *stats = vsort_stats_bind(NULL);
+    vsort_numa_binding_t binding;
+    vsort_numa_bind(job->stripe_node[index], &binding);
+    memcpy(job->stripe_data[index], job->data + begin * job->element_size, length * job->element_size);
+    if (!vsort_cancel_check(job->cancel))
+        job->sort(job->stripe_data[index], length, job->flags);
+    vsort_numa_unbind(&binding);
+    vsort_stats_bind(stats);
+}
+
+static bool vsort_numa_sort(void *data, size_t count, size_t element_size, vsort_data_kind_t kind,
+                            vsort_numa_sort_fn sort, unsigned int flags)
+{
+    const vsort_hardware_t *hw = &vsort_runtime()->hardware;
+    int nodes = hw->numa_nodes;
+    if (nodes < 2 || count / (size_t)nodes < vsort_runtime()->thresholds.parallel_threshold)
+        return false;
+
+    int threads = vsort_parallel_threads(flags);
+    size_t stripes = VSORT_MIN((size_t)VSORT_MAX(threads, nodes), (size_t)VSORT_NUMA_MAX_STRIPES);
+    size_t stripe = (count + stripes - 1) / stripes;
+    stripes = (count + stripe - 1) / stripe;
+
+    unsigned char *stripe_data[VSORT_NUMA_MAX_STRIPES];
+    int stripe_node[VSORT_NUMA_MAX_STRIPES];
+    vsort_sorted_run_t runs[VSORT_NUMA_MAX_STRIPES];
+    unsigned char *node_scratch[VSORT_MAX_NUMA_NODES] = {NULL};
+    size_t node_first[VSORT_MAX_NUMA_NODES + 1];
+
+    // Stripes of one node are consecutive and share one scratch block.
+    for (int node = 0; node <= nodes; ++node)
+        node_first[node] = stripes;
+    for (size_t s = stripes; s-- > 0;)
+    {
+        stripe_node[s] = vsort_numa_node_of(s, stripes);
+        node_first[stripe_node[s]] = s;
+    }
+    for (int node = nodes; node-- > 0;)
+        node_first[node] = VSORT_MIN(node_first[node], node_first[node + 1]);
+
+    bool allocated = true;
+    for (int node = 0; node < nodes && allocated; ++node)
+    {
+        size_t begin = node_first[node] * stripe;
+        size_t end = VSORT_MIN(node_first[node + 1] * stripe, count);
+        if (begin < end)
+        {
+            node_scratch[node] = (unsigned char *)vsort_aligned_malloc((end - begin) * element_size);
+            allocated = node_scratch[node] != NULL;
+            if (allocated)
+                vsort_stats_allocated((end - begin) * element_size);
+        }
+    }
+
+    vsort_result_t result = VSORT_ERR_ALLOCATION_FAILED;
+    if (allocated)
+    {
+        for (size_t s = 0; s < stripes; ++s)
+        {
+            int node = stripe_node[s];
+            stripe_data[s] = node_scratch[node] + (s - node_first[node]) * stripe * element_size;
+            runs[s].data = stripe_data[s];
+            runs[s].length = VSORT_MIN(stripe, count - s * stripe);
+        }
+
+        vsort_numa_job_t job = {
+            .data = (unsigned char *)data,
+            .count = count,
+            .element_size = element_size,
+            .stripe = stripe,
+            .stripe_data = stripe_data,
+            .stripe_node = stripe_node,
+            .sort = sort,
+            .flags = flags & ~VSORT_FLAG_ALLOW_PARALLEL,
+            .cancel = vsort_cancel_current()};
+        vsort_log_debug("NUMA sort of %zu elements in %zu stripe(s) over %d nodes.", count, stripes, nodes);
+        uint64_t phase = vsort_stats_phase_begin();
+        vsort_pool_parallel_for(stripes, vsort_numa_stripe_task, &job, threads, flags);
+        vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+
+        vsort_merge_options_t merge = {
+            .runs = runs,
+            .run_count = stripes,
+            .output = data,
+            .kind = kind,
+            .flags = flags};
+        phase = vsort_stats_phase_begin();
+        result = vsort_cancel_check(job.cancel) ? VSORT_ERR_CANCELLED : vsort_merge_runs_impl(&merge, element_size, count, true);
+        vsort_stats_phase_end(VSORT_PHASE_MERGE, phase);
+        if (result == VSORT_OK)
+        {
+            vsort_stats_merge_pass();
+            vsort_stats_engine(VSORT_ENGINE_NUMA, threads);
+        }
+        else
+        {
+            // A failed slice left its output unwritten; restoring the sorted
+            // stripes keeps the array a permutation for the fallback sort.
+            for (size_t s = 0; s < stripes; ++s)
+                memcpy((unsigned char *)data + s * stripe * element_size, stripe_data[s], runs[s].length * element_size);
+        }
+    }
+
+    for (int node = 0; node < nodes; ++node)
+        vsort_aligned_free(node_scratch[node]);
+    if (result == VSORT_ERR_ALLOCATION_FAILED)
+        vsort_stats_fallback(VSORT_FALLBACK_NUMA_BUFFER);
+    return result == VSORT_OK || result == VSORT_ERR_CANCELLED;
+}
+
+// -----------------------------------------------------------------------------
+// Threshold tuning
+// -----------------------------------------------------------------------------
+//
+// vsort_autotune replaces the cache-size formulas of
+// vsort_calibrate_thresholds with measured crossover points: the leaf size,
+// then the digit width, then the radix and parallel thresholds, each step
+// using the values found before it. Every candidate sorts copies of one
+// random int32 array, repeated until about VSORT_TUNE_WORK elements were
+// sorted, and is timed by its fastest run. Profiles are text files of
+// key=value lines that name the host they were measured on.
+
+#define VSORT_TUNE_MIN ((size_t)1 << 10)  // Smallest size of a crossover search
+#define VSORT_TUNE_MAX ((size_t)1 << 22)  // Largest size, also the threshold when the challenger never wins
+#define VSORT_TUNE_WORK ((size_t)1 << 18) // Elements sorted per measurement
+#define VSORT_TUNE_LEAF_ARRAY ((size_t)1 << 16)
+#define VSORT_TUNE_DIGIT_ARRAY ((size_t)1 << 20)
+#define VSORT_TUNE_PROFILE_VERSION 1
+
+typedef enum
+{
+    VSORT_TUNE_INTROSORT,
+    VSORT_TUNE_RADIX,
+    VSORT_TUNE_PARALLEL
+} vsort_tune_engine_t;
+
+typedef struct
+{
+    const int *source;
+    int *data;
+} vsort_tune_bench_t;
+
+static bool vsort_thresholds_valid(const vsort_thresholds_t *th)
+{
+    return th->insertion_threshold >= 4 && th->insertion_threshold <= 256 && th->parallel_threshold > 1 &&
+           th->radix_threshold > 1 && th->radix_bits >= VSORT_RADIX_BITS && th->radix_bits <= VSORT_RADIX_MAX_BITS &&
+           th->adaptive_run_length > 1 && th->cache_optimal_elements >= th->insertion_threshold;
+}
+
+// Fastest of the repeated sorts of the first count source elements, in
+// nanoseconds; UINT64_MAX when the engine could not run.
+static uint64_t vsort_tune_time(const vsort_tune_bench_t *bench, vsort_tune_engine_t engine, size_t count)
+{
+    size_t repeats = VSORT_MAX((size_t)1, VSORT_TUNE_WORK / count);
+    uint64_t best = UINT64_MAX;
+    for (size_t r = 0; r < repeats; ++r)
+    {
+        memcpy(bench->data, bench->source, count * sizeof(int));
+        uint64_t start = vsort_stats_clock_ns();
+        if (engine == VSORT_TUNE_RADIX && !vsort_radix_sort_int32(bench->data, count, 1))
+            return UINT64_MAX;
+        if (engine == VSORT_TUNE_PARALLEL && !vsort_parallel_int32(bench->data, count, VSORT_FLAG_ALLOW_PARALLEL))
+            return UINT64_MAX;
+        if (engine == VSORT_TUNE_INTROSORT)
+            vsort_introsort_int32(bench->data, count, 0);
+        best = VSORT_MIN(best, vsort_stats_clock_ns() - start);
+    }
+    return best;
+}
+
+// First size from which challenger beats introsort both there and at twice
+// the size, so a single noisy win does not move the threshold.
+static size_t vsort_tune_crossover(const vsort_tune_bench_t *bench, vsort_tune_engine_t challenger, size_t from)
+{
+    bool won = false;
+    for (size_t count = from; count <= VSORT_TUNE_MAX; count *= 2)
+    {
+        bool wins = vsort_tune_time(bench, challenger, count) < vsort_tune_time(bench, VSORT_TUNE_INTROSORT, count);
+        if (won && wins)
+            return count / 2;
+        won = wins;
+    }
+    return VSORT_TUNE_MAX;
+}
+
+static vsort_result_t vsort_tune_measure(vsort_thresholds_t *tuned)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    int *source = (int *)malloc(VSORT_TUNE_MAX * sizeof(int));
+    int *data = (int *)malloc(VSORT_TUNE_MAX * sizeof(int));
+    if (!source || !data)
+    {
+        free(source);
+        free(data);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+
+    uint32_t state = 0x9E3779B9u;
+    for (size_t i = 0; i < VSORT_TUNE_MAX; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        source[i] = (int)state;
+    }
+    vsort_tune_bench_t bench = {.source = source, .data = data};
+
+    // The engines read the runtime thresholds, so candidates are tried in
+    // place and the previous values restored at the end.
+    vsort_thresholds_t saved = rt->thresholds;
+    vsort_thresholds_t *th = &rt->thresholds;
+
+    static const size_t leaves[] = {8, 16, 24, 32, 48, 64};
+    size_t best_leaf = saved.insertion_threshold;
+    uint64_t best_time = UINT64_MAX;
+    for (size_t i = 0; i < sizeof(leaves) / sizeof(leaves[0]); ++i)
+    {
+        th->insertion_threshold = leaves[i];
+        uint64_t time = vsort_tune_time(&bench, VSORT_TUNE_INTROSORT, VSORT_TUNE_LEAF_ARRAY);
+        if (time < best_time)
+        {
+            best_time = time;
+            best_leaf = leaves[i];
+        }
+    }
+    th->insertion_threshold = best_leaf;
+    th->adaptive_run_length = VSORT_MAX(best_leaf * 2, (size_t)VSORT_MIN_RUN * 2);
+    th->cache_optimal_elements = VSORT_MAX(saved.cache_optimal_elements, best_leaf * 4);
+
+    th->radix_bits = VSORT_RADIX_BITS;
+    uint64_t narrow = vsort_tune_time(&bench, VSORT_TUNE_RADIX, VSORT_TUNE_DIGIT_ARRAY);
+    th->radix_bits = VSORT_RADIX_MAX_BITS;
+    uint64_t wide = vsort_tune_time(&bench, VSORT_TUNE_RADIX, VSORT_TUNE_DIGIT_ARRAY);
+    th->radix_bits = wide < narrow ? VSORT_RADIX_MAX_BITS : VSORT_RADIX_BITS;
+
+    th->radix_threshold = vsort_tune_crossover(&bench, VSORT_TUNE_RADIX, VSORT_TUNE_MIN);
+    if (vsort_parallel_threads(VSORT_FLAG_ALLOW_PARALLEL) > 1)
+        th->parallel_threshold = vsort_tune_crossover(&bench, VSORT_TUNE_PARALLEL, VSORT_TUNE_MIN * 8);
+
+    *tuned = *th;
+    rt->thresholds = saved;
+    free(source);
+    free(data);
+
+    vsort_log_info("Autotuned thresholds - insertion: %zu, parallel: %zu, radix: %zu (%zu-bit).",
+                   tuned->insertion_threshold, tuned->parallel_threshold, tuned->radix_threshold, tuned->radix_bits);
+    return VSORT_OK;
+}
+
+static vsort_result_t vsort_tuning_write(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return VSORT_ERR_IO;
+
+    const vsort_runtime_t *rt = vsort_runtime();
+    const vsort_thresholds_t *th = &rt->thresholds;
+    fprintf(file, "# VSort tuning profile\n");
+    fprintf(file, "version=%d\n", VSORT_TUNE_PROFILE_VERSION);
+    fprintf(file, "cpu=%s\n", rt->hardware.cpu_model);
+    fprintf(file, "cores=%d\n", rt->hardware.total_cores);
+    fprintf(file, "insertion_threshold=%zu\n", th->insertion_threshold);
+    fprintf(file, "parallel_threshold=%zu\n", th->parallel_threshold);
+    fprintf(file, "radix_threshold=%zu\n", th->radix_threshold);
+    fprintf(file, "radix_bits=%zu\n", th->radix_bits);
+    fprintf(file, "adaptive_run_length=%zu\n", th->adaptive_run_length);
+    fprintf(file, "cache_optimal_elements=%zu\n", th->cache_optimal_elements);
+
+    bool failed = ferror(file) != 0;
+    failed = fclose(file) != 0 || failed;
+    return failed ? VSORT_ERR_IO : VSORT_OK;
+}
+
+// Parses a profile into th; every threshold must be present and the host
+// must match the one it was written on.
+static vsort_result_t vsort_tuning_read(const char *path, vsort_thresholds_t *th)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return VSORT_ERR_IO;
+
+    const vsort_hardware_t *hw = &vsort_runtime()->hardware;
+    struct
+    {
+        const char *key;
+        size_t *value;
+    } fields[] = {
+        {"insertion_threshold", &th->insertion_threshold},
+        {"parallel_threshold", &th->parallel_threshold},
+        {"radix_threshold", &th->radix_threshold},
+        {"radix_bits", &th->radix_bits},
+        {"adaptive_run_length", &th->adaptive_run_length},
+        {"cache_optimal_elements", &th->cache_optimal_elements}};
+    size_t field_count = sizeof(fields) / sizeof(fields[0]);
+    unsigned int seen = 0;
+    bool host = true;
+    bool version = false;
+    char line[256];
+
+    while (fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *value = strchr(line, '=');
+        if (line[0] == '#' || !value)
+            continue;
+        *value++ = '\0';
+
+        if (strcmp(line, "version") == 0)
+            version = atoi(value) == VSORT_TUNE_PROFILE_VERSION;
+        else if (strcmp(line, "cpu") == 0)
+            host = host && strcmp(value, hw->cpu_model) == 0;
+        else if (strcmp(line, "cores") == 0)
+            host = host && atoi(value) == hw->total_cores;
+        for (size_t i = 0; i < field_count; ++i)
+        {
+            if (strcmp(line, fields[i].key) == 0)
+            {
+                *fields[i].value = (size_t)strtoull(value, NULL, 10);
+                seen |= 1u << i;
+            }
+        }
+    }
+
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    if (failed)
+        return VSORT_ERR_IO;
+    if (!version || !host || seen != (1u << field_count) - 1 || !vsort_thresholds_valid(th))
+        return VSORT_ERR_INVALID_ARGUMENT;
+    return VSORT_OK;
+}
+
+// Runs from vsort_init: loads VSORT_TUNING_PROFILE when it was written on
+// this host, otherwise autotunes when VSORT_AUTOTUNE asks for it.
+static void vsort_tuning_startup(void)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    const char *profile = getenv("VSORT_TUNING_PROFILE");
+    if (profile && *profile)
+    {
+        vsort_thresholds_t loaded = rt->thresholds;
+        vsort_result_t result = vsort_tuning_read(profile, &loaded);
+        if (result == VSORT_OK)
+        {
+            rt->thresholds = loaded;
+            vsort_log_info("Loaded tuning profile %s.", profile);
+            return;
+        }
+        if (result == VSORT_ERR_INVALID_ARGUMENT)
+            vsort_log_warning("Ignoring tuning profile %s written for another host or malformed.", profile);
+    }
+
+    const char *autotune = getenv("VSORT_AUTOTUNE");
+    if (!autotune || !*autotune || strcmp(autotune, "0") == 0)
+        return;
+
+    vsort_thresholds_t tuned;
+    if (vsort_tune_measure(&tuned) != VSORT_OK)
+        return;
+    rt->thresholds = tuned;
+    if (profile && *profile && vsort_tuning_write(profile) != VSORT_OK)
+        vsort_log_warning("Could not write tuning profile %s.", profile);
+}
+
+// -----------------------------------------------------------------------------
+// String sorting
+// -----------------------------------------------------------------------------
+//
+// vsort_sort_strings copies every string into an entry holding its pointer,
+// length, input index and a cached prefix: the eight bytes at the current
+// depth as a big-endian word, zero padded. A multikey quicksort partitions
+// the entries three ways on (prefix, tail), where the tail says how many of
+// those eight bytes the string still has (9 when it goes on). The equal
+// range either holds identical strings, which are done, or moves eight
+// bytes deeper and reloads its prefixes; only then are the strings touched
+// again. Small ranges, stable ties and ranges out of bad-partition budget are
+// finished with full comparisons. Large arrays are loaded and written back
+// in parallel slices and sorted as a task group, every partition queueing its
+// smaller ranges for idle threads.
+
+#define VSORT_STRING_INSERTION 16   // Ranges this short are insertion sorted
+#define VSORT_STRING_COST 8         // A string comparison costs about this many integer ones
+#define VSORT_STRING_BUDGET_BITS 7  // Low bits of a group range budget: bad partitions left
+
+typedef struct
+{
+    uint64_t prefix;           /**< Bytes [depth, depth + 8) big-endian, zero padded */
+    const unsigned char *text;
+    size_t length;
+    size_t index;              /**< Input position, the tie-break of stable sorts */
+} vsort_string_entry_t;
+
+typedef struct
+{
+    vsort_string_entry_t *entries;
+    const char **strings;
+    vsort_string_slice_t *slices;
+    size_t count;
+    size_t parts;              /**< Slices of the parallel load and write-back */
+    size_t cutoff;             /**< Group ranges up to this long are sorted by one thread */
+    bool stable;
+    bool descending;
+    vsort_cancel_t *cancel;
+} vsort_string_job_t;
+
+typedef struct
+{
+    size_t offset;             /**< First entry, relative to the range that was split */
+    size_t count;
+    size_t depth;
+    size_t allowance;          /**< Bad partitions left before heapsort */
+} vsort_string_piece_t;
+
+static inline uint64_t vsort_string_prefix(const unsigned char *text, size_t length, size_t depth)
+{
+    if (length <= depth)
+        return 0;
+    text += depth;
+    if (length - depth >= 8)
+    {
+        return (uint64_t)text[0] << 56 | (uint64_t)text[1] << 48 | (uint64_t)text[2] << 40 |
+               (uint64_t)text[3] << 32 | (uint64_t)text[4] << 24 | (uint64_t)text[5] << 16 |
+               (uint64_t)text[6] << 8 | (uint64_t)text[7];
+    }
+
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < length - depth; ++i)
+        prefix |= (uint64_t)text[i] << (56 - 8 * i);
+    return prefix;
+}
+
+// Bytes of the prefix the string has, 9 when it continues past them.
+static inline size_t vsort_string_tail(const vsort_string_entry_t *entry, size_t depth)
+{
+    return VSORT_MIN(entry->length - depth, (size_t)9);
+}
+
+static inline int vsort_string_compare_block(const vsort_string_entry_t *a, const vsort_string_entry_t *b,
+                                             size_t depth)
+{
+    if (a->prefix != b->prefix)
+        return a->prefix < b->prefix ? -1 : 1;
+    size_t ta = vsort_string_tail(a, depth);
+    size_t tb = vsort_string_tail(b, depth);
+    return (ta > tb) - (ta < tb);
+}
+
+// Full order of two entries that agree on their first depth bytes.
+static int vsort_string_compare(const vsort_string_job_t *job, const vsort_string_entry_t *a,
+                                const vsort_string_entry_t *b, size_t depth)
+{
+    int order = vsort_string_compare_block(a, b, depth);
+    if (order != 0)
+        return order;
+    if (vsort_string_tail(a, depth) == 9)
+    {
+        size_t from = depth + 8;
+        size_t la = a->length - from;
+        size_t lb = b->length - from;
+        order = memcmp(a->text + from, b->text + from, VSORT_MIN(la, lb));
+        if (order != 0)
+            return order;
+        if (la != lb)
+            return la < lb ? -1 : 1;
+    }
+    if (!job->stable)
+        return 0;
+    // Descending output is written in reverse, so its ties sort backwards here.
+    if (job->descending)
+        return (a->index < b->index) - (a->index > b->index);
+    return (a->index > b->index) - (a->index < b->index);
+}
+
+static inline void vsort_string_swap(vsort_string_entry_t *a, vsort_string_entry_t *b)
+{
+    vsort_string_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void vsort_string_insertion_sort(const vsort_string_job_t *job, vsort_string_entry_t *entries, size_t count,
+                                        size_t depth)
+{
+    for (size_t i = 1; i < count; ++i)
+    {
+        vsort_string_entry_t value = entries[i];
+        size_t j = i;
+        while (j > 0 && vsort_string_compare(job, &value, &entries[j - 1], depth) < 0)
+        {
+            entries[j] = entries[j - 1];
+            --j;
+        }
+        entries[j] = value;
+    }
+}
+
+static void vsort_string_sift_down(const vsort_string_job_t *job, vsort_string_entry_t *entries, size_t root,
+                                   size_t count, size_t depth)
+{
+    for (size_t child = 2 * root + 1; child < count; child = 2 * root + 1)
+    {
+        if (child + 1 < count && vsort_string_compare(job, &entries[child], &entries[child + 1], depth) < 0)
+            ++child;
+        if (vsort_string_compare(job, &entries[root], &entries[child], depth) >= 0)
+            return;
+        vsort_string_swap(&entries[root], &entries[child]);
+        root = child;
+    }
+}
+
+// Full-comparison sort for short ranges, stable ties and exhausted budgets.
+static void vsort_string_finish(const vsort_string_job_t *job, vsort_string_entry_t *entries, size_t count,
+                                size_t depth)
+{
+    if (count <= VSORT_STRING_INSERTION)
+    {
+        vsort_string_insertion_sort(job, entries, count, depth);
+        return;
+    }
+    for (size_t i = count / 2; i-- > 0;)
+        vsort_string_sift_down(job, entries, i, count, depth);
+    for (size_t end = count - 1; end > 0; --end)
+    {
+        vsort_string_swap(&entries[0], &entries[end]);
+        vsort_string_sift_down(job, entries, 0, end, depth);
+    }
+}
+
+static size_t vsort_string_median3(const vsort_string_entry_t *entries, size_t a, size_t b, size_t c, size_t depth)
+{
+    if (vsort_string_compare_block(&entries[a], &entries[b], depth) < 0)
+    {
+        if (vsort_string_compare_block(&entries[b], &entries[c], depth) < 0)
+            return b;
+        return vsort_string_compare_block(&entries[a], &entries[c], depth) < 0 ? c : a;
+    }
+    if (vsort_string_compare_block(&entries[a], &entries[c], depth) < 0)
+        return a;
+    return vsort_string_compare_block(&entries[b], &entries[c], depth) < 0 ? c : b;
+}
+
+// Partitions a range around a pivot block and returns the ranges still to
+// sort (up to three, largest first): below and above at depth, the equal
+// range eight bytes deeper with its prefixes reloaded. Identical strings are
+// finished here; a range out of budget is heapsorted and yields nothing.
+static size_t vsort_string_split(const vsort_string_job_t *job, vsort_string_entry_t *entries, size_t count,
+                                 size_t depth, size_t allowance, vsort_string_piece_t pieces[3])
+{
+    size_t pivot;
+    if (count > VSORT_NINTHER_THRESHOLD)
+    {
+        size_t step = count / 8;
+        size_t mid = count / 2;
+        pivot = vsort_string_median3(entries, vsort_string_median3(entries, 0, step, 2 * step, depth),
+                                     vsort_string_median3(entries, mid - step, mid, mid + step, depth),
+                                     vsort_string_median3(entries, count - 1 - 2 * step, count - 1 - step, count - 1,
+                                                          depth),
+                                     depth);
+    }
+    else
+        pivot = vsort_string_median3(entries, 0, count / 2, count - 1, depth);
+
+    vsort_string_entry_t key = entries[pivot];
+    size_t below = 0;
+    size_t i = 0;
+    size_t above = count;
+    while (i < above)
+    {
+        int order = vsort_string_compare_block(&entries[i], &key, depth);
+        if (order < 0)
+            vsort_string_swap(&entries[below++], &entries[i++]);
+        else if (order > 0)
+            vsort_string_swap(&entries[i], &entries[--above]);
+        else
+            ++i;
+    }
+
+    size_t equal = above - below;
+    if (VSORT_MAX(below, count - above) > count - count / 8 && --allowance == 0)
+    {
+        vsort_string_finish(job, entries, count, depth);
+        return 0;
+    }
+
+    size_t found = 0;
+    if (below > 1)
+        pieces[found++] = (vsort_string_piece_t){.offset = 0, .count = below, .depth = depth, .allowance = allowance};
+    if (count - above > 1)
+        pieces[found++] =
+            (vsort_string_piece_t){.offset = above, .count = count - above, .depth = depth, .allowance = allowance};
+    if (vsort_string_tail(&key, depth) == 9)
+    {
+        if (equal > 1)
+        {
+            for (size_t e = below; e < above; ++e)
+                entries[e].prefix = vsort_string_prefix(entries[e].text, entries[e].length, depth + 8);
+            pieces[found++] = (vsort_string_piece_t){
+                .offset = below, .count = equal, .depth = depth + 8, .allowance = vsort_floor_log2(equal) + 1};
+        }
+    }
+    else if (job->stable && equal > 1)
+        vsort_string_finish(job, entries + below, equal, depth);
+
+    for (size_t p = 1; p < found; ++p)
+    {
+        if (pieces[p].count > pieces[0].count)
+        {
+            vsort_string_piece_t largest = pieces[p];
+            pieces[p] = pieces[0];
+            pieces[0] = largest;
+        }
+    }
+    return found;
+}
+
+static void vsort_string_sort_range(const vsort_string_job_t *job, vsort_string_entry_t *entries, size_t count,
+                                    size_t depth, size_t allowance)
+{
+    while (count > VSORT_STRING_INSERTION)
+    {
+        vsort_string_piece_t pieces[3];
+        size_t found = vsort_string_split(job, entries, count, depth, allowance, pieces);
+        if (found == 0)
+            return;
+        // Recursing into the smaller ranges only bounds the stack by log2(count).
+        for (size_t p = 1; p < found; ++p)
+            vsort_string_sort_range(job, entries + pieces[p].offset, pieces[p].count, pieces[p].depth,
+                                    pieces[p].allowance);
+        entries += pieces[0].offset;
+        count = pieces[0].count;
+        depth = pieces[0].depth;
+        allowance = pieces[0].allowance;
+    }
+    if (count > 1)
+        vsort_string_insertion_sort(job, entries, count, depth);
+}
+
+// Multikey quicksort over one range of a task group; the range budget packs
+// the depth above VSORT_STRING_BUDGET_BITS bits of bad-partition allowance.
+static void vsort_string_task(vsort_pool_group_t *group, void *context, const vsort_pool_range_t *range)
+{
+    const vsort_string_job_t *job = (const vsort_string_job_t *)context;
+    size_t begin = range->begin;
+    size_t count = range->end - range->begin;
+    size_t depth = range->budget >> VSORT_STRING_BUDGET_BITS;
+    size_t allowance = range->budget & ((1u << VSORT_STRING_BUDGET_BITS) - 1);
+
+    while (count > job->cutoff)
+    {
+        if (vsort_cancel_check(job->cancel))
+            return;
+
+        vsort_string_piece_t pieces[3];
+        size_t found = vsort_string_split(job, job->entries + begin, count, depth, allowance, pieces);
+        if (found == 0)
+            return;
+        for (size_t p = 1; p < found; ++p)
+        {
+            vsort_pool_range_t queued = {.begin = begin + pieces[p].offset,
+                                         .end = begin + pieces[p].offset + pieces[p].count,
+                                         .budget = pieces[p].depth << VSORT_STRING_BUDGET_BITS | pieces[p].allowance};
+            if (pieces[p].count <= job->cutoff || !vsort_pool_group_spawn(group, &queued))
+                vsort_string_sort_range(job, job->entries + queued.begin, pieces[p].count, pieces[p].depth,
+                                        pieces[p].allowance);
+        }
+        begin += pieces[0].offset;
+        count = pieces[0].count;
+        depth = pieces[0].depth;
+        allowance = pieces[0].allowance;
+    }
+
+    if (count > 1 && !vsort_cancel_check(job->cancel))
+        vsort_string_sort_range(job, job->entries + begin, count, depth, allowance);
+}
+
+static void vsort_string_load_task(void *context, size_t part)
+{
+    const vsort_string_job_t *job = (const vsort_string_job_t *)context;
+    size_t begin = job->count / job->parts * part + job->count % job->parts * part / job->parts;
+    size_t end = job->count / job->parts * (part + 1) + job->count % job->parts * (part + 1) / job->parts;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        vsort_string_entry_t *entry = &job->entries[i];
+        if (job->slices)
+        {
+            entry->text = (const unsigned char *)job->slices[i].data;
+            entry->length = job->slices[i].length;
+        }
+        else
+        {
+            entry->text = (const unsigned char *)job->strings[i];
+            entry->length = strlen(job->strings[i]);
+        }
+        entry->prefix = vsort_string_prefix(entry->text, entry->length, 0);
+        entry->index = i;
+    }
+}
+
+static void vsort_string_store_task(void *context, size_t part)
+{
+    const vsort_string_job_t *job = (const vsort_string_job_t *)context;
+    size_t begin = job->count / job->parts * part + job->count % job->parts * part / job->parts;
+    size_t end = job->count / job->parts * (part + 1) + job->count % job->parts * (part + 1) / job->parts;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const vsort_string_entry_t *entry = &job->entries[job->descending ? job->count - 1 - i : i];
+        if (job->slices)
+        {
+            job->slices[i].data = (const char *)entry->text;
+            job->slices[i].length = entry->length;
+        }
+        else
+            job->strings[i] = (const char *)entry->text;
+    }
+}
+
+static vsort_result_t vsort_string_sort(const vsort_string_options_t *options, unsigned int flags)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    size_t count = options->count;
+    vsort_string_job_t job = {
+        .strings = options->strings,
+        .slices = options->slices,
+        .count = count,
+        .parts = 1,
+        .cutoff = VSORT_MAX(vsort_parallel_chunk_size() / VSORT_STRING_COST, (size_t)VSORT_STRING_INSERTION * 4),
+        .stable = (flags & VSORT_FLAG_FORCE_STABLE) != 0,
+        .descending = options->order == VSORT_ORDER_DESCENDING,
+        .cancel = vsort_cancel_current()};
+
+    int threads = 1;
+    if ((flags & VSORT_FLAG_ALLOW_PARALLEL) &&
+        count >= VSORT_MAX(rt->thresholds.parallel_threshold / VSORT_STRING_COST, job.cutoff * 2))
+    {
+        threads = vsort_parallel_threads(flags);
+        job.parts = VSORT_MIN(vsort_parallel_slices(threads), count / job.cutoff);
+    }
+
+    job.entries = (vsort_string_entry_t *)vsort_scratch_alloc(count * sizeof(vsort_string_entry_t));
+    if (!job.entries)
+        return VSORT_ERR_ALLOCATION_FAILED;
+
+    vsort_pool_parallel_for(job.parts, vsort_string_load_task, &job, threads, flags);
+    size_t allowance = vsort_floor_log2(count) + 1;
+    if (threads > 1)
+    {
+        vsort_pool_range_t seed = {.begin = 0, .end = count, .budget = allowance};
+        vsort_log_debug("Multikey quicksort of %zu strings on %d threads.", count, threads);
+        vsort_pool_run_group(vsort_string_task, &job, &seed, 1, threads, flags);
+    }
+    else
+        vsort_string_sort_range(&job, job.entries, count, 0, allowance);
+    vsort_pool_parallel_for(job.parts, vsort_string_store_task, &job, threads, flags);
+
+    vsort_scratch_free(job.entries);
+    return VSORT_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Batched sorting
+// -----------------------------------------------------------------------------
+//
+// vsort_sort_batch validates and resolves its options once for the whole
+// batch and sorts every array with vsort_batch_sort_<suffix>, which takes
+// short arrays straight to the leaf sort or introsort. Large batches are cut
+// into groups of consecutive arrays of about equal element count (plus one
+// per array for its fixed cost) that run on the worker pool, each array on a
+// single thread; arrays long enough to be sorted in parallel on their own
+// are left out of the groups and sorted afterwards, one at a time.
+
+#define VSORT_BATCH_GROUPS_PER_THREAD 4
+
+typedef struct
+{
+    unsigned char *data;               /**< CSR layout */
+    const size_t *offsets;             /**< CSR layout, NULL for descriptors */
+    const vsort_batch_array_t *arrays; /**< Descriptor layout */
+    size_t element_size;
+    vsort_data_kind_t kind;
+    vsort_generic_t generic;
+    unsigned int flags;
+    size_t defer;                      /**< Arrays at least this long are left to the caller */
+    const size_t *bounds;              /**< First array of every group, then the array count */
+} vsort_batch_job_t;
+
+static size_t vsort_batch_length(const vsort_batch_job_t *job, size_t index)
+{
+    return job->offsets ? job->offsets[index + 1] - job->offsets[index] : job->arrays[index].length;
+}
+
+static void vsort_batch_sort_one(const vsort_batch_job_t *job, size_t index, unsigned int flags)
+{
+    size_t count = vsort_batch_length(job, index);
+    if (count <= 1)
+        return;
+
+    void *data = job->offsets ? job->data + job->offsets[index] * job->element_size : job->arrays[index].data;
+    switch (job->kind)
+    {
+    case VSORT_KIND_INT32:
+        vsort_batch_sort_int32((int *)data, count, flags);
+        break;
+    case VSORT_KIND_FLOAT32:
+        vsort_batch_sort_float32((float *)data, count, flags);
+        break;
+    case VSORT_KIND_INT64:
+        vsort_batch_sort_int64((int64_t *)data, count, flags);
+        break;
+    case VSORT_KIND_UINT64:
+        vsort_batch_sort_uint64((uint64_t *)data, count, flags);
+        break;
+    case VSORT_KIND_FLOAT64:
+        vsort_batch_sort_float64((double *)data, count, flags);
+        break;
+    case VSORT_KIND_CHAR8:
+        vsort_counting_sort_char((unsigned char *)data, count);
+        break;
+    default:
+        vsort_sort_generic_with(&job->generic, (char *)data, count, flags);
+        break;
+    }
+}
+
+static void vsort_batch_task(void *context, size_t index)
+{
+    const vsort_batch_job_t *job = (const vsort_batch_job_t *)context;
+    unsigned int flags = job->flags & ~VSORT_FLAG_ALLOW_PARALLEL;
+    for (size_t i = job->bounds[index]; i < job->bounds[index + 1]; ++i)
+    {
+        if (vsort_batch_length(job, i) < job->defer)
+            vsort_batch_sort_one(job, i, flags);
+    }
+}
+
+// Splits the non-deferred arrays into groups of about equal weight.
+static void vsort_batch_plan(const vsort_batch_job_t *job, size_t count, size_t groups, size_t *bounds)
+{
+    size_t weight = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t length = vsort_batch_length(job, i);
+        if (length < job->defer)
+            weight += length + 1;
+    }
+
+    size_t group = 0;
+    size_t seen = 0;
+    bounds[0] = 0;
+    for (size_t i = 0; i < count && group + 1 < groups; ++i)
+    {
+        size_t length = vsort_batch_length(job, i);
+        if (length < job->defer)
+            seen += length + 1;
+        while (group + 1 < groups && seen >= weight / groups * (group + 1) + weight % groups * (group + 1) / groups)
+            bounds[++group] = i + 1;
+    }
+    while (group < groups)
+        bounds[++group] = count;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+// Shared by vsort_nth_element and vsort_partial_sort: places rank nth, and
+// with sort_prefix also sorts the nth elements in front of it.
+static vsort_result_t vsort_select_kind(const vsort_options_t *options, size_t nth, bool sort_prefix)
+{
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    size_t count = options->length;
+    size_t k = nth + 1;
+
+    switch (options->kind)
+    {
+    case VSORT_KIND_INT32:
+        if (sort_prefix)
+            vsort_partial_sort_int32((int *)options->data, count, k, flags);
+        else
+            vsort_nth_element_int32((int *)options->data, count, nth, flags);
+        return VSORT_OK;
+    case VSORT_KIND_FLOAT32:
+        if (sort_prefix)
+            vsort_partial_sort_float32((float *)options->data, count, k, flags);
+        else
+            vsort_nth_element_float32((float *)options->data, count, nth, flags);
+        return VSORT_OK;
+    case VSORT_KIND_INT64:
+        if (sort_prefix)
+            vsort_partial_sort_int64((int64_t *)options->data, count, k, flags);
+        else
+            vsort_nth_element_int64((int64_t *)options->data, count, nth, flags);
+        return VSORT_OK;
+    case VSORT_KIND_UINT64:
+        if (sort_prefix)
+            vsort_partial_sort_uint64((uint64_t *)options->data, count, k, flags);
+        else
+            vsort_nth_element_uint64((uint64_t *)options->data, count, nth, flags);
+        return VSORT_OK;
+    case VSORT_KIND_FLOAT64:
+        if (sort_prefix)
+            vsort_partial_sort_float64((double *)options->data, count, k, flags);
+        else
+            vsort_nth_element_float64((double *)options->data, count, nth, flags);
+        return VSORT_OK;
+    case VSORT_KIND_CHAR8:
+        // Counting sort is already linear.
+        vsort_counting_sort_char((unsigned char *)options->data, count);
+        return VSORT_OK;
+    case VSORT_KIND_GENERIC:
+    {
+        if (!options->comparator || options->element_size == 0 || count > SIZE_MAX / options->element_size)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        vsort_generic_t g = {
+            .size = options->element_size,
+            .compare = options->comparator,
+            .swap = vsort_pick_swap(options->element_size),
+            .base = NULL,
+            .stride = 0};
+        char *data = (char *)options->data;
+        vsort_generic_select(&g, data, count, nth);
+        if (sort_prefix && nth > 1)
+            vsort_sort_generic_with(&g, data, nth, flags & ~VSORT_FLAG_FORCE_STABLE);
+        return VSORT_OK;
+    }
+    default:
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+    }
+}
+
+static vsort_result_t vsort_sort_dispatch(const vsort_options_t *options)
+{
+    if (!options)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (!options->data && options->length > 0)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->length <= 1)
+        return VSORT_OK;
+
+    vsort_init();
+
+    unsigned int flags = vsort_resolve_flags(options->flags);
+
+    switch (options->kind)
+    {
+    case VSORT_KIND_INT32:
+        vsort_sort_int32((int *)options->data, options->length, flags);
+        return VSORT_OK;
+    case VSORT_KIND_FLOAT32:
+        vsort_sort_float32((float *)options->data, options->length, flags);
+        return VSORT_OK;
+    case VSORT_KIND_INT64:
+        vsort_sort_int64((int64_t *)options->data, options->length, flags);
+        return VSORT_OK;
+    case VSORT_KIND_UINT64:
+        vsort_sort_uint64((uint64_t *)options->data, options->length, flags);
+        return VSORT_OK;
+    case VSORT_KIND_FLOAT64:
+        vsort_sort_float64((double *)options->data, options->length, flags);
+        return VSORT_OK;
+    case VSORT_KIND_CHAR8:
+    {
+        unsigned char *data = (unsigned char *)options->data;
+        uint64_t phase = vsort_stats_phase_begin();
+        vsort_counting_sort_char(data, options->length);
+        vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+        vsort_stats_engine(VSORT_ENGINE_COUNTING, 1);
+        return VSORT_OK;
+    }
+    case VSORT_KIND_GENERIC:
+    {
+        if (!options->comparator || options->element_size == 0)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        if (options->length > SIZE_MAX / options->element_size)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        vsort_sort_generic(options->data, options->length, options->element_size, options->comparator, flags);
+        return VSORT_OK;
+    }
+    default:
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+    }
+}
+
+VSORT_API vsort_result_t vsort_sort(const vsort_options_t *options)
+{
+    if (VSORT_LIKELY(!vsort_counters_enabled()))
+        return vsort_sort_dispatch(options);
+    return vsort_sort_with_stats(options, NULL);
+}
+
+VSORT_API vsort_result_t vsort_sort_with_stats(const vsort_options_t *options, vsort_stats_t *stats)
+{
+    bool counted = vsort_counters_enabled() != 0;
+    if (!stats && !counted)
+        return vsort_sort_dispatch(options);
+
+    vsort_stats_collector_t collector;
+    memset(&collector, 0, sizeof(collector));
+    collector.stats.length = options ? options->length : 0;
+
+    vsort_stats_collector_t *previous = vsort_stats_bind(&collector);
+    uint64_t start = vsort_stats_clock_ns();
+    vsort_result_t result = vsort_sort_dispatch(options);
+    collector.stats.total_ns = vsort_stats_clock_ns() - start;
+    vsort_stats_bind(previous);
+
+    if (counted && result == VSORT_OK)
+        vsort_counters_add(&collector.stats);
+    if (stats)
+        *stats = collector.stats;
+    return result;
+}
+
+VSORT_API void vsort(int arr[], int n)
+{
+    if (!arr || n <= 1)
+        return;
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = (size_t)n,
+        .element_size = sizeof(int),
+        .kind = VSORT_KIND_INT32,
+        .comparator = NULL,
+        .flags = vsort_default_flags()};
+    (void)vsort_sort(&options);
+}
+
+VSORT_API void vsort_float(float arr[], int n)
+{
+    if (!arr || n <= 1)
+        return;
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = (size_t)n,
+        .element_size = sizeof(float),
+        .kind = VSORT_KIND_FLOAT32,
+        .comparator = NULL,
+        .flags = vsort_default_flags()};
+    (void)vsort_sort(&options);
+}
+
+VSORT_API void vsort_char(char arr[], int n)
+{
+    if (!arr || n <= 1)
+        return;
+
+    vsort_options_t options = {
+        .data = arr,
+        .length = (size_t)n,
+        .element_size = sizeof(char),
+        .kind = VSORT_KIND_CHAR8,
+        .comparator = NULL,
+        .flags = 0};
+    (void)vsort_sort(&options);
+}
+
+VSORT_API vsort_result_t vsort_sort_by_key(const vsort_key_options_t *options)
+{
+    if (!options)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (!options->data && options->length > 0)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    size_t key_size = vsort_key_size(options->key_type);
+    if (key_size == 0)
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+
+    if (options->element_size < key_size || options->key_offset > options->element_size - key_size)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->length > SIZE_MAX / options->element_size)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->length <= 1)
+        return VSORT_OK;
+
+    vsort_init();
+
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    return vsort_key_sort((unsigned char *)options->data, options->length, options->element_size, options->key_offset,
+                          options->key_type, options->order == VSORT_ORDER_DESCENDING, flags, NULL, VSORT_INDEX_SIZE,
+                          NULL, 0);
+}
+
+VSORT_API vsort_result_t vsort_sort_kv(const vsort_kv_options_t *options)
+{
+    if (!options)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if ((!options->keys || !options->values) && options->length > 0)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    size_t key_size = vsort_key_size(options->key_type);
+    if (key_size == 0)
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+
+    if (options->value_size != sizeof(uint32_t) && options->value_size != sizeof(uint64_t))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->length > SIZE_MAX / sizeof(uint64_t))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->length <= 1)
+        return VSORT_OK;
+
+    vsort_init();
+
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    return vsort_key_sort((unsigned char *)options->keys, options->length, key_size, 0, options->key_type,
+                          options->order == VSORT_ORDER_DESCENDING, flags, NULL, VSORT_INDEX_SIZE,
+                          (unsigned char *)options->values, options->value_size);
+}
+
+VSORT_API vsort_result_t vsort_argsort(const vsort_options_t *options, void *indices, vsort_index_type_t index_type)
+{
+    if (!options || (!indices && options->length > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (!options->data && options->length > 0)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (index_type != VSORT_INDEX_UINT32 && index_type != VSORT_INDEX_SIZE)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (index_type == VSORT_INDEX_UINT32 && options->length > UINT32_MAX)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    vsort_key_type_t key_type;
+    size_t element_size = options->element_size;
+    switch (options->kind)
+    {
+    case VSORT_KIND_INT32:
+        key_type = VSORT_KEY_INT32;
+        element_size = sizeof(int);
+        break;
+    case VSORT_KIND_FLOAT32:
+        key_type = VSORT_KEY_FLOAT32;
+        element_size = sizeof(float);
+        break;
+    case VSORT_KIND_INT64:
+        key_type = VSORT_KEY_INT64;
+        element_size = sizeof(int64_t);
+        break;
+    case VSORT_KIND_UINT64:
+        key_type = VSORT_KEY_UINT64;
+        element_size = sizeof(uint64_t);
+        break;
+    case VSORT_KIND_FLOAT64:
+        key_type = VSORT_KEY_FLOAT64;
+        element_size = sizeof(double);
+        break;
+    case VSORT_KIND_GENERIC:
+        if (!options->comparator || element_size == 0 || options->length > SIZE_MAX / element_size)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        key_type = VSORT_KEY_INT32;
+        break;
+    default:
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+    }
+
+    vsort_init();
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    size_t count = options->length;
+
+    if (options->kind != VSORT_KIND_GENERIC)
+    {
+        if (count == 0)
+            return VSORT_OK;
+        return vsort_key_sort((unsigned char *)options->data, count, element_size, 0, key_type, false, flags, indices,
+                              index_type, NULL, 0);
+    }
+
+    // Generic data: sort the index array itself, comparing through it.
+    size_t index_size = index_type == VSORT_INDEX_UINT32 ? sizeof(uint32_t) : sizeof(size_t);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (index_type == VSORT_INDEX_UINT32)
+            ((uint32_t *)indices)[i] = (uint32_t)i;
+        else
+            ((size_t *)indices)[i] = i;
+    }
+
+    vsort_generic_t g = {
+        .size = index_size,
+        .compare = options->comparator,
+        .swap = vsort_pick_swap(index_size),
+        .base = (const char *)options->data,
+        .stride = element_size};
+    if (count > 1)
+        vsort_sort_generic_with(&g, (char *)indices, count, flags & ~VSORT_FLAG_FORCE_STABLE);
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_nth_element(const vsort_options_t *options, size_t nth)
+{
+    if (!options || !options->data || nth >= options->length)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->length == 1)
+        return VSORT_OK;
+
+    vsort_init();
+    return vsort_select_kind(options, nth, false);
+}
+
+VSORT_API vsort_result_t vsort_partial_sort(const vsort_options_t *options, size_t k)
+{
+    if (!options || (!options->data && options->length > 0) || k > options->length)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (k == 0 || options->length <= 1)
+        return VSORT_OK;
+
+    vsort_init();
+    return vsort_select_kind(options, k - 1, true);
+}
+
+VSORT_API vsort_result_t vsort_sort_batch(const vsort_batch_options_t *options)
+{
+    if (!options || (!options->offsets && !options->arrays && options->count > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    size_t element_size;
+    switch (options->kind)
+    {
+    case VSORT_KIND_CHAR8:
+        element_size = 1;
+        break;
+    case VSORT_KIND_GENERIC:
+        if (!options->comparator || options->element_size == 0)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        element_size = options->element_size;
+        break;
+    default:
+        element_size = vsort_merge_element_size(options->kind);
+        if (element_size == 0)
+            return VSORT_ERR_UNSUPPORTED_TYPE;
+        break;
+    }
+
+    const size_t count = options->count;
+    const size_t *offsets = options->offsets;
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (offsets ? offsets[i + 1] < offsets[i] : (!options->arrays[i].data && options->arrays[i].length > 0))
+            return VSORT_ERR_INVALID_ARGUMENT;
+        size_t length = offsets ? offsets[i + 1] - offsets[i] : options->arrays[i].length;
+        if (length > SIZE_MAX / element_size - total)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        total += length;
+    }
+    if (offsets && count > 0 && (offsets[count] > SIZE_MAX / element_size || (!options->data && total > 0)))
+        return VSORT_ERR_INVALID_ARGUMENT;
+    if (total <= 1)
+        return VSORT_OK;
+
+    vsort_init();
+    vsort_runtime_t *rt = vsort_runtime();
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    vsort_batch_job_t job = {
+        .data = (unsigned char *)options->data,
+        .offsets = offsets,
+        .arrays = options->arrays,
+        .element_size = element_size,
+        .kind = options->kind,
+        .generic = {
+            .size = element_size,
+            .compare = options->comparator,
+            .swap = vsort_pick_swap(element_size),
+            .base = NULL,
+            .stride = 0},
+        .flags = flags,
+        .defer = rt->thresholds.parallel_threshold,
+        .bounds = NULL};
+
+    int threads = vsort_parallel_threads(flags);
+    size_t *bounds = NULL;
+    size_t groups = 0;
+    if ((flags & VSORT_FLAG_ALLOW_PARALLEL) && threads > 1 && count > 1 && total >= rt->thresholds.parallel_threshold)
+    {
+        groups = VSORT_MIN(count, vsort_parallel_slices(threads) * VSORT_BATCH_GROUPS_PER_THREAD);
+        bounds = (size_t *)vsort_scratch_alloc((groups + 1) * sizeof(size_t));
+    }
+
+    if (!bounds)
+    {
+        for (size_t i = 0; i < count; ++i)
+            vsort_batch_sort_one(&job, i, flags);
+        return VSORT_OK;
+    }
+
+    vsort_batch_plan(&job, count, groups, bounds);
+    job.bounds = bounds;
+    vsort_log_debug("Sorting a batch of %zu arrays (%zu elements) in %zu groups.", count, total, groups);
+    vsort_pool_parallel_for(groups, vsort_batch_task, &job, threads, flags);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (vsort_batch_length(&job, i) >= job.defer)
+            vsort_batch_sort_one(&job, i, flags);
+    }
+    vsort_scratch_free(bounds);
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_merge_runs(const vsort_merge_options_t *options)
+{
+    if (!options || (!options->runs && options->run_count > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    size_t element_size = vsort_merge_element_size(options->kind);
+    if (element_size == 0)
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+
+    size_t total = 0;
+    for (size_t r = 0; r < options->run_count; ++r)
+    {
+        if (!options->runs[r].data && options->runs[r].length > 0)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        if (options->runs[r].length > SIZE_MAX / element_size - total)
+            return VSORT_ERR_INVALID_ARGUMENT;
+        total += options->runs[r].length;
+    }
+    if (total == 0)
+        return VSORT_OK;
+    if (!options->output)
+        return VSORT_ERR_INVALID_ARGUMENT;
+    if (options->run_count == 1)
+    {
+        memcpy(options->output, options->runs[0].data, total * element_size);
+        return VSORT_OK;
+    }
+
+    vsort_init();
+    return vsort_merge_runs_impl(options, element_size, total, false);
+}
+
+VSORT_API vsort_result_t vsort_sort_strings(const vsort_string_options_t *options)
+{
+    if (!options || (!options->strings && !options->slices && options->count > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->count > SIZE_MAX / sizeof(vsort_string_entry_t))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    if (options->count <= 1)
+        return VSORT_OK;
+
+    vsort_init();
+    return vsort_string_sort(options, vsort_resolve_flags(options->flags));
+}
+
+VSORT_API vsort_result_t vsort_context_create(vsort_context_t **context, size_t reserve)
+{
+    if (!context)
+        return VSORT_ERR_INVALID_ARGUMENT;
+    *context = NULL;
+
+    vsort_context_t *created = (vsort_context_t *)calloc(1, sizeof(vsort_context_t));
+    if (!created)
+        return VSORT_ERR_ALLOCATION_FAILED;
+    created->owned = true;
+    vsort_context_attach(created, NULL, 0);
+    if (reserve > 0 && !vsort_context_grow(created, reserve))
+    {
+        free(created);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+    *context = created;
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_context_create_with_memory(vsort_context_t **context, void *memory, size_t bytes)
+{
+    if (!context || (!memory && bytes > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+    *context = NULL;
+
+    vsort_context_t *created = (vsort_context_t *)calloc(1, sizeof(vsort_context_t));
+    if (!created)
+        return VSORT_ERR_ALLOCATION_FAILED;
+    created->owned = false;
+    vsort_context_attach(created, (unsigned char *)memory, bytes);
+    *context = created;
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_context_reserve(vsort_context_t *context, size_t bytes)
+{
+    if (!context || !context->owned || context->blocks > 0)
+        return VSORT_ERR_INVALID_ARGUMENT;
+    if (bytes <= context->capacity)
+        return VSORT_OK;
+    return vsort_context_grow(context, bytes) ? VSORT_OK : VSORT_ERR_ALLOCATION_FAILED;
+}
+
+VSORT_API size_t vsort_context_capacity(const vsort_context_t *context)
+{
+    return context ? context->capacity : 0;
+}
+
+VSORT_API size_t vsort_context_peak(const vsort_context_t *context)
+{
+    return context ? context->peak : 0;
+}
+
+VSORT_API vsort_context_t *vsort_context_bind(vsort_context_t *context)
+{
+    vsort_context_t *previous = t_vsort_context;
+    t_vsort_context = context;
+    return previous;
+}
+
+VSORT_API vsort_result_t vsort_sort_with_context(vsort_context_t *context, const vsort_options_t *options)
+{
+    vsort_context_t *previous = vsort_context_bind(context);
+    vsort_result_t result = vsort_sort(options);
+    vsort_context_bind(previous);
+    return result;
+}
+
+VSORT_API void vsort_context_destroy(vsort_context_t *context)
+{
+    if (!context)
+        return;
+    if (t_vsort_context == context)
+        t_vsort_context = NULL;
+    if (context->owned)
+        vsort_aligned_free(context->memory);
+    free(context);
+}
+
+VSORT_API void vsort_get_tuning(vsort_tuning_t *tuning)
+{
+    if (!tuning)
+        return;
+
+    vsort_init();
+    const vsort_thresholds_t *th = &vsort_runtime()->thresholds;
+    tuning->insertion_threshold = th->insertion_threshold;
+    tuning->parallel_threshold = th->parallel_threshold;
+    tuning->radix_threshold = th->radix_threshold;
+    tuning->radix_bits = th->radix_bits;
+    tuning->adaptive_run_length = th->adaptive_run_length;
+    tuning->cache_optimal_elements = th->cache_optimal_elements;
+}
+
+VSORT_API vsort_result_t vsort_set_tuning(const vsort_tuning_t *tuning)
+{
+    if (!tuning)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    vsort_init();
+    vsort_runtime_t *rt = vsort_runtime();
+    vsort_thresholds_t th = rt->thresholds;
+    th.insertion_threshold = tuning->insertion_threshold ? tuning->insertion_threshold : th.insertion_threshold;
+    th.parallel_threshold = tuning->parallel_threshold ? tuning->parallel_threshold : th.parallel_threshold;
+    th.radix_threshold = tuning->radix_threshold ? tuning->radix_threshold : th.radix_threshold;
+    th.radix_bits = tuning->radix_bits ? tuning->radix_bits : th.radix_bits;
+    th.adaptive_run_length = tuning->adaptive_run_length ? tuning->adaptive_run_length : th.adaptive_run_length;
+    th.cache_optimal_elements = tuning->cache_optimal_elements ? tuning->cache_optimal_elements : th.cache_optimal_elements;
+    if (!vsort_thresholds_valid(&th))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    rt->thresholds = th;
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_autotune(vsort_tuning_t *tuning)
+{
+    vsort_init();
+    vsort_thresholds_t tuned;
+    vsort_result_t result = vsort_tune_measure(&tuned);
+    if (result != VSORT_OK)
+        return result;
+
+    vsort_runtime()->thresholds = tuned;
+    vsort_get_tuning(tuning);
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_save_tuning(const char *path)
+{
+    if (!path)
+        return VSORT_ERR_INVALID_ARGUMENT;
+    vsort_init();
+    return vsort_tuning_write(path);
+}
+
+VSORT_API vsort_result_t vsort_load_tuning(const char *path)
+{
+    if (!path)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    vsort_init();
+    vsort_thresholds_t loaded = vsort_runtime()->thresholds;
+    vsort_result_t result = vsort_tuning_read(path, &loaded);
+    if (result == VSORT_OK)
+        vsort_runtime()->thresholds = loaded;
+    return result;
 }
 
 VSORT_API void vsort_with_comparator(void *arr, int n, size_t size, int (*compare)(const void *, const void *))
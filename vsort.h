@@ -14,6 +14,7 @@ extern "C"
 #endif
 
 #include <stddef.h> // For size_t
+#include <stdint.h> // For uint64_t
 
 // Platform detection
 #if defined(_WIN32) || defined(_MSC_VER)
@@ -68,7 +69,10 @@ typedef enum
     VSORT_KIND_INT32 = 0,
     VSORT_KIND_FLOAT32,
     VSORT_KIND_CHAR8,
-    VSORT_KIND_GENERIC
+    VSORT_KIND_GENERIC,
+    VSORT_KIND_INT64,  /**< int64_t elements */
+    VSORT_KIND_UINT64, /**< uint64_t elements */
+    VSORT_KIND_FLOAT64 /**< double elements, radix sorted in IEEE-754 total order */
 } vsort_data_kind_t;
 
 typedef enum
@@ -76,7 +80,9 @@ typedef enum
     VSORT_OK = 0,
     VSORT_ERR_INVALID_ARGUMENT = -1,
     VSORT_ERR_ALLOCATION_FAILED = -2,
-    VSORT_ERR_UNSUPPORTED_TYPE = -3
+    VSORT_ERR_UNSUPPORTED_TYPE = -3,
+    VSORT_ERR_IO = -4,
+    VSORT_ERR_CANCELLED = -5 /**< An asynchronous sort was cancelled */
 } vsort_result_t;
 
 #define VSORT_FLAG_ALLOW_PARALLEL (1u << 0)
@@ -85,6 +91,7 @@ typedef enum
 #define VSORT_FLAG_PREFER_THROUGHPUT (1u << 3)
 #define VSORT_FLAG_PREFER_EFFICIENCY (1u << 4)
 #define VSORT_FLAG_FORCE_SIMD (1u << 5)
+#define VSORT_FLAG_LOW_MEMORY (1u << 6) /**< Prefer in-place engines over O(n) scratch */
 
 typedef struct
 {
@@ -96,18 +103,640 @@ typedef struct
     unsigned int flags;                      /**< Behavioural flags (VSORT_FLAG_*) */
 } vsort_options_t;
 
+typedef enum
+{
+    VSORT_KEY_INT32 = 0,
+    VSORT_KEY_UINT32,
+    VSORT_KEY_FLOAT32,
+    VSORT_KEY_INT64,
+    VSORT_KEY_UINT64,
+    VSORT_KEY_FLOAT64
+} vsort_key_type_t;
+
+typedef enum
+{
+    VSORT_ORDER_ASCENDING = 0,
+    VSORT_ORDER_DESCENDING
+} vsort_order_t;
+
+typedef struct
+{
+    void *data;                 /**< Records to sort in place */
+    size_t length;              /**< Number of records */
+    size_t element_size;        /**< Size of each record (bytes) */
+    size_t key_offset;          /**< Byte offset of the key inside a record */
+    vsort_key_type_t key_type;  /**< Type of the embedded key */
+    vsort_order_t order;        /**< Sort direction */
+    unsigned int flags;         /**< Behavioural flags (VSORT_FLAG_*) */
+} vsort_key_options_t;
+
+typedef struct
+{
+    void *keys;                 /**< Key array, sorted in place */
+    void *values;               /**< Payload array moved along with the keys */
+    size_t length;              /**< Number of key/value pairs */
+    vsort_key_type_t key_type;  /**< Type of the keys */
+    size_t value_size;          /**< 4 (uint32_t) or 8 (uint64_t) bytes per value */
+    vsort_order_t order;        /**< Sort direction */
+    unsigned int flags;         /**< Behavioural flags (VSORT_FLAG_*) */
+} vsort_kv_options_t;
+
+typedef enum
+{
+    VSORT_INDEX_UINT32 = 0, /**< Write uint32_t indices (length <= UINT32_MAX) */
+    VSORT_INDEX_SIZE        /**< Write size_t indices */
+} vsort_index_type_t;
+
+typedef struct
+{
+    const void *data;           /**< Ascending elements of one run */
+    size_t length;              /**< Number of elements in the run */
+} vsort_sorted_run_t;
+
+typedef struct
+{
+    const vsort_sorted_run_t *runs; /**< Runs to merge */
+    size_t run_count;               /**< Number of runs */
+    void *output;                   /**< Receives every element; must not overlap the runs */
+    vsort_data_kind_t kind;         /**< INT32, FLOAT32, INT64, UINT64 or FLOAT64 */
+    unsigned int flags;             /**< Behavioural flags (VSORT_FLAG_*) */
+} vsort_merge_options_t;
+
+typedef struct
+{
+    const char *data; /**< First byte of the string; need not be NUL-terminated */
+    size_t length;    /**< Bytes in the string */
+} vsort_string_slice_t;
+
+typedef struct
+{
+    const char **strings;         /**< NUL-terminated strings, sorted in place (when slices is NULL) */
+    vsort_string_slice_t *slices; /**< (pointer, length) strings, sorted in place */
+    size_t count;                 /**< Number of strings */
+    vsort_order_t order;          /**< Sort direction */
+    unsigned int flags;           /**< Behavioural flags (VSORT_FLAG_*) */
+} vsort_string_options_t;
+
+typedef struct
+{
+    const char *input_path;   /**< Binary file of packed native-endian elements */
+    const char *output_path;  /**< Destination; may be the input file */
+    const char *temp_dir;     /**< Directory for run files, NULL for tmpfile() */
+    vsort_data_kind_t kind;   /**< INT32, FLOAT32, INT64, UINT64 or FLOAT64 */
+    size_t memory_budget;     /**< Bytes for run and merge buffers, 0 for 256 MiB */
+    unsigned int flags;       /**< Flags for the in-memory run sorts (VSORT_FLAG_*) */
+} vsort_external_options_t;
+
+typedef struct
+{
+    void *data;                 /**< Elements of one array, sorted in place */
+    size_t length;              /**< Number of elements */
+} vsort_batch_array_t;
+
+typedef struct
+{
+    void *data;                        /**< CSR layout: every array back to back */
+    const size_t *offsets;             /**< CSR layout: count + 1 non-decreasing element offsets into data */
+    const vsort_batch_array_t *arrays; /**< Descriptor layout, used when offsets is NULL */
+    size_t count;                      /**< Number of arrays */
+    size_t element_size;               /**< Size of each element (bytes, VSORT_KIND_GENERIC only) */
+    vsort_data_kind_t kind;            /**< Data classification shared by every array */
+    int (*comparator)(const void *, const void *); /**< Comparator for VSORT_KIND_GENERIC */
+    unsigned int flags;                /**< Behavioural flags (VSORT_FLAG_*) */
+} vsort_batch_options_t;
+
+/** Scratch-memory context (see vsort_context_create) */
+typedef struct vsort_context vsort_context_t;
+
+/** Streaming sort handle (see vsort_stream_create) */
+typedef struct vsort_stream vsort_stream_t;
+
+/** Asynchronous sort handle (see vsort_sort_async) */
+typedef struct vsort_async vsort_async_t;
+
+/** Completion callback of vsort_sort_async, called on the thread that ran the sort */
+typedef void (*vsort_async_callback_t)(vsort_result_t result, void *user_data);
+
+/** Engine that produced the result of a vsort_sort call (see vsort_stats_t) */
+typedef enum
+{
+    VSORT_ENGINE_NONE = 0,       /**< Nothing to sort, or an invalid call */
+    VSORT_ENGINE_INTROSORT,      /**< Sequential introsort (pdqsort for generic data) */
+    VSORT_ENGINE_MERGESORT,      /**< Stable merge sort (VSORT_FLAG_FORCE_STABLE) */
+    VSORT_ENGINE_RUN_MERGE,      /**< Natural run merging of presorted input */
+    VSORT_ENGINE_RADIX_LSD,      /**< LSD radix sort */
+    VSORT_ENGINE_RADIX_MSD,      /**< In-place MSD radix sort */
+    VSORT_ENGINE_PARALLEL_MERGE, /**< Parallel chunk sort plus merge passes */
+    VSORT_ENGINE_FORK_JOIN,      /**< Fork-join parallel introsort */
+    VSORT_ENGINE_NUMA,           /**< Node-local stripe sort plus one K-way merge */
+    VSORT_ENGINE_COUNTING,       /**< Counting sort of single bytes */
+    VSORT_ENGINE_COUNT
+} vsort_engine_t;
+
+/** Timed phases of a vsort_sort call (indices of vsort_stats_t::phase_ns) */
+typedef enum
+{
+    VSORT_PHASE_PRESCAN = 0, /**< Natural run detection */
+    VSORT_PHASE_SORT,        /**< Comparison sorting: whole array, chunks, stripes or fork-join ranges */
+    VSORT_PHASE_MERGE,       /**< Run merging and parallel or NUMA merge passes */
+    VSORT_PHASE_RADIX,       /**< LSD or MSD radix passes */
+    VSORT_PHASE_COUNT
+} vsort_phase_t;
+
+/** Fallbacks taken by a vsort_sort call (bits of vsort_stats_t::fallbacks) */
+#define VSORT_FALLBACK_STABLE_BUFFER (1u << 0) /**< No stable merge buffer, introsort ran instead */
+#define VSORT_FALLBACK_RUN_BUFFER (1u << 1)    /**< No run merge buffer, presorted input was sorted normally */
+#define VSORT_FALLBACK_MERGE_BUFFER (1u << 2)  /**< No parallel merge buffer, fork-join or sequential sort ran */
+#define VSORT_FALLBACK_RADIX_BUFFER (1u << 3)  /**< No LSD radix scratch, in-place MSD radix ran */
+#define VSORT_FALLBACK_NUMA_BUFFER (1u << 4)   /**< No node-local stripe scratch, the array was sorted in place */
+#define VSORT_FALLBACK_SEQUENTIAL (1u << 5)    /**< Parallel sorting was allowed but fewer than two threads were available */
+#define VSORT_FALLBACK_COUNT 6
+
+/** Telemetry of one vsort_sort call (see vsort_sort_with_stats) */
+typedef struct
+{
+    vsort_engine_t engine;              /**< Engine that produced the result */
+    size_t length;                      /**< Elements sorted */
+    int threads;                        /**< Threads the engine ran on */
+    unsigned int fallbacks;             /**< VSORT_FALLBACK_* bits */
+    size_t merge_passes;                /**< Parallel or NUMA merge passes */
+    size_t radix_passes;                /**< LSD passes that moved data (MSD sorts report 0) */
+    size_t bytes_allocated;             /**< Scratch bytes requested by the calling thread */
+    uint64_t total_ns;                  /**< Wall time of the call */
+    uint64_t phase_ns[VSORT_PHASE_COUNT]; /**< Wall time per vsort_phase_t */
+} vsort_stats_t;
+
+/** Process-wide totals of vsort_sort calls (see vsort_set_counters_enabled) */
+typedef struct
+{
+    uint64_t calls;                          /**< Completed vsort_sort calls */
+    uint64_t elements;                       /**< Elements they sorted */
+    uint64_t engine_calls[VSORT_ENGINE_COUNT]; /**< Calls per vsort_engine_t */
+    uint64_t fallbacks[VSORT_FALLBACK_COUNT];  /**< Calls per fallback, bit i of VSORT_FALLBACK_* at index i */
+    uint64_t merge_passes;
+    uint64_t radix_passes;
+    uint64_t bytes_allocated;
+    uint64_t total_ns;
+    uint64_t phase_ns[VSORT_PHASE_COUNT];
+} vsort_counters_t;
+
+/** Engine selection thresholds (see vsort_get_tuning) */
+typedef struct
+{
+    size_t insertion_threshold;    /**< Introsort leaf size */
+    size_t parallel_threshold;     /**< Elements from which VSORT_FLAG_ALLOW_PARALLEL sorts in parallel */
+    size_t radix_threshold;        /**< Elements from which VSORT_FLAG_ALLOW_RADIX sorts by radix */
+    size_t radix_bits;             /**< LSD digit width, 8 to 11 bits */
+    size_t adaptive_run_length;    /**< Average natural run length from which runs are merged */
+    size_t cache_optimal_elements; /**< Elements a cache-resident block holds */
+} vsort_tuning_t;
+
 VSORT_API vsort_result_t vsort_sort(const vsort_options_t *options);
 VSORT_API void vsort_set_default_flags(unsigned int flags);
 VSORT_API unsigned int vsort_default_flags(void);
 VSORT_API const char *vsort_version(void);
 
+    /**
+     * @brief Overrides the number of threads used by parallel sorting paths.
+     *
+     * @param threads Thread count including the caller; 0 restores the
+     *                detected core count.
+     */
+    VSORT_API void vsort_set_thread_count(int threads);
+
+    /**
+     * @brief Gets the number of threads parallel sorting paths will use.
+     *
+     * @return The configured override, or the detected core count.
+     */
+    VSORT_API int vsort_thread_count(void);
+
+    /**
+     * @brief Sorts records by a key embedded at a fixed offset.
+     *
+     * Radix-sorts (key, index) pairs extracted from the records and then
+     * moves every record once, so no comparator is involved. The sort is
+     * stable in both directions; float keys use the IEEE-754 total order.
+     * Honours VSORT_FLAG_ALLOW_PARALLEL and VSORT_FLAG_LOW_MEMORY (records
+     * are permuted in place instead of through an N-record buffer).
+     *
+     * @param options Records, key location/type, direction and flags.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT when the key does not fit
+     *         in a record, VSORT_ERR_UNSUPPORTED_TYPE for an unknown key type
+     *         or VSORT_ERR_ALLOCATION_FAILED when scratch is unavailable.
+     */
+    VSORT_API vsort_result_t vsort_sort_by_key(const vsort_key_options_t *options);
+
+    /**
+     * @brief Sorts a key array and carries a parallel value array along.
+     *
+     * Keys and values travel together through a stable radix sort: 32-bit
+     * keys with 32-bit values as one packed 64-bit word, other widths as
+     * (key, value) pairs, so no permutation or comparator is involved.
+     * Equal keys keep their original order in both directions; float keys
+     * use the IEEE-754 total order. Honours VSORT_FLAG_ALLOW_PARALLEL.
+     *
+     * @param options Keys, values, key type, value width, direction and flags.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT for a missing array or a
+     *         value width other than 4 or 8, VSORT_ERR_UNSUPPORTED_TYPE for
+     *         an unknown key type or VSORT_ERR_ALLOCATION_FAILED.
+     */
+    VSORT_API vsort_result_t vsort_sort_kv(const vsort_kv_options_t *options);
+
+    /**
+     * @brief Computes the permutation that sorts an array, leaving it untouched.
+     *
+     * After the call, data[indices[0]], data[indices[1]], ... is in ascending
+     * order; equal elements keep their original relative order. Numeric
+     * kinds are radix-sorted as (key, index) pairs (floats in IEEE-754
+     * total order), GENERIC data sorts the index array through the
+     * comparator. Honours VSORT_FLAG_ALLOW_PARALLEL.
+     *
+     * @param options Data, length, kind, comparator (GENERIC) and flags.
+     * @param indices Output array of options->length indices.
+     * @param index_type Width of the written indices.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT, VSORT_ERR_UNSUPPORTED_TYPE
+     *         (CHAR8) or VSORT_ERR_ALLOCATION_FAILED.
+     */
+    VSORT_API vsort_result_t vsort_argsort(const vsort_options_t *options, void *indices, vsort_index_type_t index_type);
+
+    /**
+     * @brief Moves the element of rank nth to data[nth] (like std::nth_element).
+     *
+     * Afterwards no element before nth is greater and no element after it is
+     * smaller; both sides are otherwise unordered. Uses introselect on the
+     * introsort partitions (heapsort bounds the worst case). Numeric arrays
+     * above the parallel threshold use a sample select on the worker pool
+     * when VSORT_FLAG_ALLOW_PARALLEL is set.
+     *
+     * @param options Data, length, kind, comparator (GENERIC) and flags.
+     * @param nth Rank to place, below options->length.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT or VSORT_ERR_UNSUPPORTED_TYPE.
+     */
+    VSORT_API vsort_result_t vsort_nth_element(const vsort_options_t *options, size_t nth);
+
+    /**
+     * @brief Sorts the k smallest elements into the first k positions.
+     *
+     * Selects the k-th element as vsort_nth_element does, then sorts the
+     * prefix in front of it; the remaining elements are left unordered.
+     * Costs O(n + k log k) instead of a full sort.
+     *
+     * @param options Data, length, kind, comparator (GENERIC) and flags.
+     * @param k Number of leading elements to sort, at most options->length.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT or VSORT_ERR_UNSUPPORTED_TYPE.
+     */
+    VSORT_API vsort_result_t vsort_partial_sort(const vsort_options_t *options, size_t k);
+
+    /**
+     * @brief Sorts a binary file that may be larger than memory.
+     *
+     * The input is cut into runs of about a third of the memory budget,
+     * each sorted with vsort_sort (reading the next run overlaps sorting and
+     * writing the current one) and spilled to a temporary file. The runs are
+     * then merged with a loser tree, in extra passes when the budget cannot
+     * buffer all of them; output is double-buffered so writes overlap the
+     * merge. Inputs that fit in one run are sorted in memory.
+     *
+     * @param options Paths, element kind, memory budget and flags.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT, VSORT_ERR_UNSUPPORTED_TYPE
+     *         (CHAR8, GENERIC), VSORT_ERR_ALLOCATION_FAILED or VSORT_ERR_IO
+     *         (unreadable input, a size that is not a whole number of
+     *         elements, or a failed temporary/output write).
+     */
+    VSORT_API vsort_result_t vsort_sort_file(const vsort_external_options_t *options);
+
+    /**
+     * @brief Merges already sorted runs into one sorted array.
+     *
+     * K-way merge with a loser tree (log2(K) comparisons per element) instead
+     * of re-sorting the concatenation. Equal elements keep run order, so the
+     * merge is stable across runs. With VSORT_FLAG_ALLOW_PARALLEL large merges
+     * split the output into slices at exact ranks and merge the slices on the
+     * worker pool.
+     *
+     * Runs must be ascending; floats are compared in IEEE-754 total order, as
+     * the radix engine sorts them (-0.0 before +0.0).
+     *
+     * @param options Runs, output buffer, element kind and flags.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT, VSORT_ERR_UNSUPPORTED_TYPE
+     *         (CHAR8, GENERIC) or VSORT_ERR_ALLOCATION_FAILED.
+     */
+    VSORT_API vsort_result_t vsort_merge_runs(const vsort_merge_options_t *options);
+
+    /**
+     * @brief Sorts an array of strings by their bytes (unsigned, like memcmp).
+     *
+     * Caching multikey quicksort: every string is loaded once into an entry
+     * that holds its next eight bytes as one big-endian word, so partitions
+     * compare words in a contiguous array instead of chasing pointers, and
+     * only strings sharing those eight bytes read the next ones. A string
+     * sorts before its extensions; slices may contain zero bytes. With
+     * VSORT_FLAG_FORCE_STABLE equal strings keep their original order (in
+     * both directions); with VSORT_FLAG_ALLOW_PARALLEL large arrays are
+     * loaded and sorted on the worker pool.
+     *
+     * @param options Either a NUL-terminated string array or a slice array,
+     *        the count, direction and flags.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT or VSORT_ERR_ALLOCATION_FAILED.
+     */
+    VSORT_API vsort_result_t vsort_sort_strings(const vsort_string_options_t *options);
+
+    /**
+     * @brief Creates a streaming sort that accepts data in batches.
+     *
+     * Pushed elements are sorted into runs as they arrive and the runs are
+     * merged log-structured (eight runs of one level become one run of the
+     * next), so the work is spread over the pushes and finalizing is a single
+     * K-way merge over a few runs per level. A stream is not thread-safe;
+     * callers sharing one must serialize their calls.
+     *
+     * @param stream Receives the new handle (NULL on failure).
+     * @param kind INT32, FLOAT32, INT64, UINT64 or FLOAT64.
+     * @param flags Flags for the run sorts and merges (VSORT_FLAG_*), 0 for the defaults.
+     * @return VSORT_OK, VSORT_ERR_INVALID_ARGUMENT, VSORT_ERR_UNSUPPORTED_TYPE
+     *         or VSORT_ERR_ALLOCATION_FAILED.
+     */
+    VSORT_API vsort_result_t vsort_stream_create(vsort_stream_t **stream, vsort_data_kind_t kind, unsigned int flags);
+
+    /**
+     * @brief Adds length elements to the stream; data is copied.
+     *
+     * Small batches are staged until 64K elements have accumulated; larger
+     * ones are sorted into a run of their own right away.
+     */
+    VSORT_API vsort_result_t vsort_stream_push(vsort_stream_t *stream, const void *data, size_t length);
+
+    /**
+     * @brief Number of elements pushed since the stream was created or last finalized.
+     */
+    VSORT_API size_t vsort_stream_length(const vsort_stream_t *stream);
+
+    /**
+     * @brief Writes every pushed element, sorted, to output and empties the stream.
+     *
+     * output must hold vsort_stream_length(stream) elements. The stream can
+     * be reused for the next window afterwards; on failure it keeps its
+     * elements.
+     */
+    VSORT_API vsort_result_t vsort_stream_finalize(vsort_stream_t *stream, void *output);
+
+    /**
+     * @brief Frees the stream and any elements it still holds (NULL is ignored).
+     */
+    VSORT_API void vsort_stream_destroy(vsort_stream_t *stream);
+
+    /**
+     * @brief Creates a context that owns a reusable scratch arena.
+     *
+     * While a context is bound to a thread (vsort_context_bind, or for one
+     * call vsort_sort_with_context), every engine takes its scratch memory
+     * (merge and radix buffers, histograms, key entries) from the arena
+     * instead of the heap. If a call needs more than the arena holds, the
+     * excess comes from the heap and the arena grows to that call's peak
+     * once it returns, so repeated sorts of similar size reach zero
+     * allocations. A context serves one thread at a time.
+     *
+     * @param context Receives the new context (NULL on failure).
+     * @param reserve Initial arena size in bytes (0 to grow on first use).
+     */
+    VSORT_API vsort_result_t vsort_context_create(vsort_context_t **context, size_t reserve);
+
+    /**
+     * @brief Creates a context whose arena is caller-provided memory.
+     *
+     * The arena never grows; demand beyond bytes falls back to the heap.
+     * vsort_context_peak tells how much a workload needs. memory must stay
+     * valid until the context is destroyed and is not freed by it.
+     */
+    VSORT_API vsort_result_t vsort_context_create_with_memory(vsort_context_t **context, void *memory, size_t bytes);
+
+    /**
+     * @brief Grows an owned, idle context's arena to at least bytes.
+     *
+     * @return VSORT_ERR_INVALID_ARGUMENT for caller-provided memory or while a
+     *         sort is using the context.
+     */
+    VSORT_API vsort_result_t vsort_context_reserve(vsort_context_t *context, size_t bytes);
+
+    /**
+     * @brief Usable arena size in bytes.
+     */
+    VSORT_API size_t vsort_context_capacity(const vsort_context_t *context);
+
+    /**
+     * @brief Largest scratch demand (bytes, including block headers) of any call so far.
+     */
+    VSORT_API size_t vsort_context_peak(const vsort_context_t *context);
+
+    /**
+     * @brief Binds context to the calling thread for all following vsort calls.
+     *
+     * @param context Context to bind, or NULL to return to the scratch cache.
+     * @return The previously bound context (or NULL).
+     */
+    VSORT_API vsort_context_t *vsort_context_bind(vsort_context_t *context);
+
+    /**
+     * @brief vsort_sort with context bound for the duration of the call.
+     */
+    VSORT_API vsort_result_t vsort_sort_with_context(vsort_context_t *context, const vsort_options_t *options);
+
+    /**
+     * @brief Frees the context (unbinding it from the calling thread; NULL is ignored).
+     */
+    VSORT_API void vsort_context_destroy(vsort_context_t *context);
+
+    /**
+     * @brief Caps the scratch cache shared by sorts without a context.
+     *
+     * Released engine scratch is kept for reuse in size classes, a few
+     * blocks per thread plus a lock-free shared depot, as long as the bytes
+     * cached by all threads stay within this limit (default 64 MiB). Blocks
+     * that would exceed it are freed; 0 disables caching. Lowering the limit
+     * does not free blocks already cached (see vsort_scratch_cache_trim).
+     */
+    VSORT_API void vsort_set_scratch_cache_limit(size_t bytes);
+
+    /**
+     * @brief Frees cached scratch blocks unused for at least milliseconds.
+     *
+     * Trimming happens during later scratch requests, without a background
+     * thread; 0 (the default) keeps blocks until the limit or a trim.
+     */
+    VSORT_API void vsort_set_scratch_cache_idle_ms(unsigned int milliseconds);
+
+    /**
+     * @brief Bytes currently held by the scratch cache across all threads.
+     */
+    VSORT_API size_t vsort_scratch_cache_bytes(void);
+
+    /**
+     * @brief Frees the calling thread's cached blocks and the shared depot.
+     *
+     * Blocks cached by other live threads are freed when those threads
+     * exit or trim.
+     */
+    VSORT_API void vsort_scratch_cache_trim(void);
+
+    /**
+     * @brief Sorts many independent arrays of one kind in a single call.
+     *
+     * Arrays are given either CSR-style (one buffer plus offsets, array i
+     * being elements [offsets[i], offsets[i + 1]) of data) or as an array of
+     * descriptors. Options are validated and resolved once for the batch, and
+     * short arrays go straight to the leaf sorting networks or introsort
+     * without the per-call engine selection of vsort_sort. Under
+     * VSORT_FLAG_ALLOW_PARALLEL large batches are split into groups of
+     * arrays of about equal size on the worker pool; arrays long enough for
+     * a parallel sort of their own are sorted one after another using all
+     * threads. Descriptor arrays must not overlap.
+     *
+     * @return VSORT_ERR_INVALID_ARGUMENT for missing data, decreasing offsets
+     *         or a generic batch without comparator or element size.
+     */
+    VSORT_API vsort_result_t vsort_sort_batch(const vsort_batch_options_t *options);
+
+    /**
+     * @brief Starts vsort_sort on the worker pool and returns immediately.
+     *
+     * The options are copied, but options->data must stay valid and
+     * untouched until the sort completes. On completion callback (if not
+     * NULL) runs on the worker with the result, before vsort_async_wait
+     * returns. A context bound to the calling thread is not used. On Apple
+     * platforms the sort is dispatched to a global GCD queue.
+     *
+     * @param handle Receives the handle, which must be released with
+     *        vsort_async_destroy; NULL for a detached sort that frees itself.
+     * @return VSORT_OK once the sort is queued, VSORT_ERR_INVALID_ARGUMENT or
+     *         VSORT_ERR_ALLOCATION_FAILED (nothing runs and callback is not
+     *         called).
+     */
+    VSORT_API vsort_result_t vsort_sort_async(const vsort_options_t *options, vsort_async_callback_t callback,
+                                              void *user_data, vsort_async_t **handle);
+
+    /**
+     * @brief Blocks until the sort has completed and returns its result.
+     */
+    VSORT_API vsort_result_t vsort_async_wait(vsort_async_t *handle);
+
+    /**
+     * @brief Nonzero once the sort has completed, storing its result in result (may be NULL).
+     */
+    VSORT_API int vsort_async_poll(vsort_async_t *handle, vsort_result_t *result);
+
+    /**
+     * @brief Asks the sort to stop early.
+     *
+     * A sort that has not started yet does not run; a running one stops at
+     * the next chunk or pass boundary of its parallel, fork-join, NUMA or
+     * radix engine (sequential comparison sorts run to the end). Either way
+     * it completes with VSORT_ERR_CANCELLED unless it had already finished,
+     * and the array then holds its original elements in unspecified order.
+     */
+    VSORT_API void vsort_async_cancel(vsort_async_t *handle);
+
+    /**
+     * @brief Waits for the sort to complete and frees the handle (NULL is ignored).
+     */
+    VSORT_API void vsort_async_destroy(vsort_async_t *handle);
+
+    /**
+     * @brief vsort_sort that also reports which engine ran and where the time went.
+     *
+     * stats (may be NULL) is filled in whatever the result. Phases are timed
+     * on the calling thread around whole parallel passes, so phase_ns adds
+     * up to at most total_ns; nested engines (the stripes of a NUMA sort)
+     * count towards the phase of their parent. Without stats and with the
+     * counters disabled this is vsort_sort, with no timing at all.
+     */
+    VSORT_API vsort_result_t vsort_sort_with_stats(const vsort_options_t *options, vsort_stats_t *stats);
+
+    /**
+     * @brief Enables or disables the process-wide counters (disabled by default).
+     *
+     * While enabled, every vsort_sort call (including those made by
+     * vsort_sort_async and vsort_sort_file) collects vsort_stats_t and adds
+     * it to the counters with relaxed atomic increments. While disabled the
+     * only cost is one relaxed load per call.
+     */
+    VSORT_API void vsort_set_counters_enabled(int enabled);
+
+    /**
+     * @brief Nonzero while the process-wide counters are enabled.
+     */
+    VSORT_API int vsort_counters_enabled(void);
+
+    /**
+     * @brief Copies the process-wide counters; every field is monotonic until vsort_counters_reset.
+     */
+    VSORT_API void vsort_counters_read(vsort_counters_t *counters);
+
+    /**
+     * @brief Zeroes the process-wide counters.
+     */
+    VSORT_API void vsort_counters_reset(void);
+
+    /**
+     * @brief Copies the thresholds currently used by engine selection.
+     *
+     * vsort_init derives them from the cache sizes, unless the profile named
+     * by the VSORT_TUNING_PROFILE environment variable was written for this
+     * host (same CPU model and core count), in which case it is loaded
+     * instead. With VSORT_AUTOTUNE set to anything but 0 and no usable
+     * profile, vsort_init runs vsort_autotune and saves the result to that
+     * profile when one is named.
+     */
+    VSORT_API void vsort_get_tuning(vsort_tuning_t *tuning);
+
+    /**
+     * @brief Overrides the thresholds for the whole process.
+     *
+     * Zero fields keep their current value. Call it while no sort is
+     * running; sorts already in progress may see a mix of old and new values.
+     *
+     * @return VSORT_ERR_INVALID_ARGUMENT (nothing changes) for a leaf size
+     *         outside 4-256, digits outside 8-11 bits, or a cache-resident
+     *         block smaller than a leaf.
+     */
+    VSORT_API vsort_result_t vsort_set_tuning(const vsort_tuning_t *tuning);
+
+    /**
+     * @brief Measures the engine crossover points on this host and applies them.
+     *
+     * Times introsort leaf sizes, 8- against 11-bit radix digits, and
+     * introsort against LSD radix and against the parallel chunk sort on
+     * random int32 arrays of doubling size (up to 4M elements, 32 MiB of
+     * scratch). A threshold is the first size from which the faster engine
+     * also wins at twice the size. It takes up to about a second, and like
+     * vsort_set_tuning must not overlap other sorts.
+     *
+     * @param tuning Receives the measured thresholds (may be NULL).
+     */
+    VSORT_API vsort_result_t vsort_autotune(vsort_tuning_t *tuning);
+
+    /**
+     * @brief Writes the current thresholds and the host they were tuned on to a text profile.
+     */
+    VSORT_API vsort_result_t vsort_save_tuning(const char *path);
+
+    /**
+     * @brief Applies a profile written by vsort_save_tuning.
+     *
+     * @return VSORT_ERR_IO when the file cannot be read,
+     *         VSORT_ERR_INVALID_ARGUMENT when it is malformed or was written
+     *         on a host with another CPU model or core count.
+     */
+    VSORT_API vsort_result_t vsort_load_tuning(const char *path);
+
     /**
      * @brief Sorts an array of integers in ascending order.
      *
      * Automatically selects the optimal sorting strategy based on array size,
      * data distribution (detects nearly sorted), and hardware characteristics.
-     * Uses optimizations like NEON (if available and implemented), GCD parallelism
-     * (including parallel merge passes), radix sort, quicksort, and insertion sort.
+     * Uses optimizations like NEON (if available and implemented), worker-pool
+     * parallelism (GCD on Apple, pthreads/Win32 threads elsewhere) including
+     * parallel merge passes, radix sort, quicksort, and insertion sort.
      *
      * @param arr The integer array to be sorted.
      * @param n The number of elements in the array.
@@ -119,9 +748,8 @@ VSORT_API const char *vsort_version(void);
      *
      * Applies similar optimization strategies as vsort() for floats,
      * including parallelism (with parallel merge passes) and adaptive algorithm selection.
-     * Note: Radix sort is not typically used for floats; primarily uses
-     * optimized quicksort/insertion sort. NEON optimizations for floats
-     * are possible but not yet implemented.
+     * Large arrays use radix sort on the IEEE-754 bit patterns, which orders
+     * -0.0 before +0.0, negative NaNs before -inf and positive NaNs after +inf.
      *
      * @param arr The float array to be sorted.
      * @param n The number of elements in the array.
@@ -142,10 +770,10 @@ VSORT_API const char *vsort_version(void);
     /**
      * @brief Generic sorting function with a custom comparator.
      *
-     * Currently falls back to standard qsort. For optimal performance,
-     * this should be adapted using the library's internal sorting logic,
-     * potentially requiring modifications to quicksort/merge to handle
-     * the custom comparator efficiently.
+     * Uses the native generic engine (pdqsort, or a stable merge sort under
+     * VSORT_FLAG_FORCE_STABLE in the default flags) with swaps specialized
+     * for 4/8/16/32-byte elements. Large arrays are sorted on the worker
+     * pool, so the comparator must be safe to call from several threads.
      *
      * @param arr Pointer to the start of the array.
      * @param n Number of elements in the array.
@@ -0,0 +1,187 @@
+/**
+ * Implementation of VSort asynchronous sorting
+ *
+ * vsort_sort_async copies the options into a handle and submits the sort
+ * to the worker pool (GCD on Apple platforms). The worker binds the
+ * handle's cancellation token for the duration of vsort_sort, so the
+ * parallel and radix engines can stop at their next chunk or pass boundary,
+ * then runs the callback and wakes any waiter.
+ */
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "vsort.h"
+#include "vsort_flags.h"
+#include "vsort_pool.h"
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(_WIN32) || defined(_MSC_VER)
+typedef SRWLOCK vsort_mutex_t;
+typedef CONDITION_VARIABLE vsort_cond_t;
+
+static void vsort_mutex_init(vsort_mutex_t *m) { InitializeSRWLock(m); }
+static void vsort_mutex_destroy(vsort_mutex_t *m) { (void)m; }
+static void vsort_mutex_lock(vsort_mutex_t *m) { AcquireSRWLockExclusive(m); }
+static void vsort_mutex_unlock(vsort_mutex_t *m) { ReleaseSRWLockExclusive(m); }
+static void vsort_cond_init(vsort_cond_t *c) { InitializeConditionVariable(c); }
+static void vsort_cond_destroy(vsort_cond_t *c) { (void)c; }
+static void vsort_cond_wait(vsort_cond_t *c, vsort_mutex_t *m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void vsort_cond_broadcast(vsort_cond_t *c) { WakeAllConditionVariable(c); }
+#else
+typedef pthread_mutex_t vsort_mutex_t;
+typedef pthread_cond_t vsort_cond_t;
+
+static void vsort_mutex_init(vsort_mutex_t *m) { pthread_mutex_init(m, NULL); }
+static void vsort_mutex_destroy(vsort_mutex_t *m) { pthread_mutex_destroy(m); }
+static void vsort_mutex_lock(vsort_mutex_t *m) { pthread_mutex_lock(m); }
+static void vsort_mutex_unlock(vsort_mutex_t *m) { pthread_mutex_unlock(m); }
+static void vsort_cond_init(vsort_cond_t *c) { pthread_cond_init(c, NULL); }
+static void vsort_cond_destroy(vsort_cond_t *c) { pthread_cond_destroy(c); }
+static void vsort_cond_wait(vsort_cond_t *c, vsort_mutex_t *m) { pthread_cond_wait(c, m); }
+static void vsort_cond_broadcast(vsort_cond_t *c) { pthread_cond_broadcast(c); }
+#endif
+
+struct vsort_async
+{
+    vsort_mutex_t mutex;
+    vsort_cond_t finished;
+    vsort_options_t options;
+    vsort_async_callback_t callback;
+    void *user_data;
+    vsort_cancel_t *cancel;
+    vsort_result_t result;
+    bool done;
+    bool detached; /**< No handle was returned; the worker frees it */
+};
+
+static void vsort_async_free(vsort_async_t *async)
+{
+    vsort_cond_destroy(&async->finished);
+    vsort_mutex_destroy(&async->mutex);
+    vsort_cancel_destroy(async->cancel);
+    free(async);
+}
+
+static void vsort_async_run(void *context, size_t index)
+{
+    vsort_async_t *async = (vsort_async_t *)context;
+    (void)index;
+
+    vsort_result_t result = VSORT_ERR_CANCELLED;
+    if (!vsort_cancel_requested(async->cancel))
+    {
+        vsort_cancel_t *previous = vsort_cancel_bind(async->cancel);
+        result = vsort_sort(&async->options);
+        vsort_cancel_bind(previous);
+        if (result == VSORT_OK && vsort_cancel_stopped(async->cancel))
+            result = VSORT_ERR_CANCELLED;
+    }
+
+    if (async->callback)
+        async->callback(result, async->user_data);
+
+    if (async->detached)
+    {
+        vsort_async_free(async);
+        return;
+    }
+
+    vsort_mutex_lock(&async->mutex);
+    async->result = result;
+    async->done = true;
+    vsort_cond_broadcast(&async->finished);
+    vsort_mutex_unlock(&async->mutex);
+}
+
+VSORT_API vsort_result_t vsort_sort_async(const vsort_options_t *options, vsort_async_callback_t callback,
+                                          void *user_data, vsort_async_t **handle)
+{
+    if (handle)
+        *handle = NULL;
+    if (!options || (!options->data && options->length > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    vsort_init();
+
+    vsort_async_t *async = (vsort_async_t *)malloc(sizeof(vsort_async_t));
+    if (!async)
+        return VSORT_ERR_ALLOCATION_FAILED;
+    async->cancel = vsort_cancel_create();
+    if (!async->cancel)
+    {
+        free(async);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+    vsort_mutex_init(&async->mutex);
+    vsort_cond_init(&async->finished);
+    async->options = *options;
+    async->callback = callback;
+    async->user_data = user_data;
+    async->result = VSORT_OK;
+    async->done = false;
+    async->detached = handle == NULL;
+
+    unsigned int flags = vsort_resolve_flags(options->flags);
+    if (!vsort_pool_submit(vsort_async_run, async, flags))
+    {
+        vsort_async_free(async);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+
+    if (handle)
+        *handle = async;
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_async_wait(vsort_async_t *handle)
+{
+    if (!handle)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    vsort_mutex_lock(&handle->mutex);
+    while (!handle->done)
+        vsort_cond_wait(&handle->finished, &handle->mutex);
+    vsort_result_t result = handle->result;
+    vsort_mutex_unlock(&handle->mutex);
+    return result;
+}
+
+VSORT_API int vsort_async_poll(vsort_async_t *handle, vsort_result_t *result)
+{
+    if (!handle)
+        return 0;
+
+    vsort_mutex_lock(&handle->mutex);
+    bool done = handle->done;
+    if (done && result)
+        *result = handle->result;
+    vsort_mutex_unlock(&handle->mutex);
+    return done ? 1 : 0;
+}
+
+VSORT_API void vsort_async_cancel(vsort_async_t *handle)
+{
+    if (handle)
+        vsort_cancel_request(handle->cancel);
+}
+
+VSORT_API void vsort_async_destroy(vsort_async_t *handle)
+{
+    if (!handle)
+        return;
+
+    vsort_async_wait(handle);
+    vsort_async_free(handle);
+}
@@ -0,0 +1,471 @@
+/**
+ * Implementation of VSort external sort
+ *
+ * Sorts binary files of packed numeric elements that need not fit in
+ * memory: budget-sized runs are sorted with vsort_sort and spilled to
+ * temporary files, then merged with the loser tree of vsort_merge.c, in
+ * several passes when the budget cannot buffer every run at once.
+ */
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vsort.h"
+#include "vsort_flags.h"
+#include "vsort_logger.h"
+#include "vsort_merge.h"
+#include "vsort_pool.h"
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <process.h>
+#define vsort_getpid() ((unsigned long)_getpid())
+#else
+#include <unistd.h>
+#define vsort_getpid() ((unsigned long)getpid())
+#endif
+
+#define VSORT_EXTERNAL_DEFAULT_BUDGET ((size_t)256 << 20)
+#define VSORT_EXTERNAL_MIN_BUDGET ((size_t)1 << 20)
+#define VSORT_EXTERNAL_MIN_BUFFER ((size_t)64 << 10) // Smallest per-run read buffer of a merge
+#define VSORT_EXTERNAL_MAX_FAN_IN 128                // Runs merged at once (bounds open files)
+#define VSORT_EXTERNAL_PATH_MAX 4096
+
+// -----------------------------------------------------------------------------
+// Run files
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    FILE *file;
+    char *path; /**< NULL for tmpfile() runs, which vanish on close */
+    uint64_t count;
+} vsort_run_file_t;
+
+typedef struct
+{
+    vsort_run_file_t *items;
+    size_t count;
+    size_t capacity;
+    size_t created; /**< Names handed out so far */
+    const char *temp_dir;
+} vsort_run_list_t;
+
+static bool vsort_run_create(vsort_run_list_t *list, vsort_run_file_t *run)
+{
+    run->count = 0;
+    run->path = NULL;
+    if (!list->temp_dir)
+    {
+        run->file = tmpfile();
+        return run->file != NULL;
+    }
+
+    // The list address keeps names of concurrent sorts in one process apart.
+    char name[VSORT_EXTERNAL_PATH_MAX];
+    int length = snprintf(name, sizeof(name), "%s/vsort-%lu-%lx-%zu.run", list->temp_dir, vsort_getpid(),
+                          (unsigned long)(uintptr_t)list, list->created++);
+    if (length < 0 || (size_t)length >= sizeof(name))
+        return false;
+
+    run->path = (char *)malloc((size_t)length + 1);
+    if (!run->path)
+        return false;
+    memcpy(run->path, name, (size_t)length + 1);
+    run->file = fopen(run->path, "wb+");
+    if (!run->file)
+    {
+        free(run->path);
+        run->path = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void vsort_run_discard(vsort_run_file_t *run)
+{
+    if (run->file)
+        fclose(run->file);
+    if (run->path)
+    {
+        remove(run->path);
+        free(run->path);
+    }
+    run->file = NULL;
+    run->path = NULL;
+}
+
+static bool vsort_run_list_push(vsort_run_list_t *list, const vsort_run_file_t *run)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        vsort_run_file_t *items = (vsort_run_file_t *)realloc(list->items, capacity * sizeof(vsort_run_file_t));
+        if (!items)
+            return false;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = *run;
+    return true;
+}
+
+static void vsort_run_list_release(vsort_run_list_t *list)
+{
+    for (size_t i = 0; i < list->count; ++i)
+        vsort_run_discard(&list->items[i]);
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// Reads up to capacity elements; a trailing partial element is an error.
+static bool vsort_read_elements(FILE *file, void *buffer, size_t capacity, size_t element_size, size_t *count)
+{
+    size_t bytes = fread(buffer, 1, capacity * element_size, file);
+    *count = bytes / element_size;
+    return !ferror(file) && bytes % element_size == 0;
+}
+
+static bool vsort_write_elements(FILE *file, const void *buffer, size_t count, size_t element_size)
+{
+    return count == 0 || fwrite(buffer, element_size, count, file) == count;
+}
+
+// -----------------------------------------------------------------------------
+// Run formation
+// -----------------------------------------------------------------------------
+//
+// Two budget-sized buffers alternate: while one is sorted and written to its
+// run file, the next chunk of the input is read into the other. The two
+// stages are submitted as one two-index job on the worker pool, so they run
+// concurrently whenever the pool has a spare thread.
+
+typedef struct
+{
+    FILE *input;
+    size_t element_size;
+    vsort_data_kind_t kind;
+    unsigned int flags;
+    void *sort_buffer;
+    size_t sort_count;
+    FILE *sort_output;
+    bool write_failed;
+    void *read_buffer;
+    size_t read_capacity;
+    size_t read_count;
+    bool read_failed;
+} vsort_run_stage_t;
+
+static void vsort_sort_chunk(void *buffer, size_t count, size_t element_size, vsort_data_kind_t kind, unsigned int flags)
+{
+    vsort_options_t options = {
+        .data = buffer,
+        .length = count,
+        .element_size = element_size,
+        .kind = kind,
+        .comparator = NULL,
+        .flags = flags};
+    (void)vsort_sort(&options);
+}
+
+static void vsort_run_stage_task(void *context, size_t index)
+{
+    vsort_run_stage_t *stage = (vsort_run_stage_t *)context;
+    if (index == 0)
+    {
+        vsort_sort_chunk(stage->sort_buffer, stage->sort_count, stage->element_size, stage->kind, stage->flags);
+        stage->write_failed = !vsort_write_elements(stage->sort_output, stage->sort_buffer, stage->sort_count,
+                                                    stage->element_size);
+        return;
+    }
+    stage->read_failed = !vsort_read_elements(stage->input, stage->read_buffer, stage->read_capacity,
+                                              stage->element_size, &stage->read_count);
+}
+
+// -----------------------------------------------------------------------------
+// Merging
+// -----------------------------------------------------------------------------
+//
+// Each run gets an equal read buffer that is refilled sequentially when its
+// cursor runs dry; merged output alternates between two buffers so one is
+// written while the loser tree fills the other.
+
+typedef struct
+{
+    vsort_run_file_t *runs;
+    unsigned char *buffers;
+    size_t buffer_elements;
+    size_t element_size;
+} vsort_merge_input_t;
+
+static bool vsort_run_refill(void *context, size_t run, vsort_merge_cursor_t *cursor)
+{
+    vsort_merge_input_t *input = (vsort_merge_input_t *)context;
+    unsigned char *buffer = input->buffers + run * input->buffer_elements * input->element_size;
+    size_t count;
+    bool ok = vsort_read_elements(input->runs[run].file, buffer, input->buffer_elements, input->element_size, &count);
+    cursor->data = buffer;
+    cursor->remaining = ok ? count : 0;
+    return ok;
+}
+
+typedef struct
+{
+    vsort_loser_tree_t *tree;
+    FILE *output;
+    size_t element_size;
+    void *fill_buffer;
+    size_t fill_capacity;
+    size_t fill_count;
+    const void *write_buffer;
+    size_t write_count;
+    bool write_failed;
+} vsort_merge_stage_t;
+
+static void vsort_merge_stage_task(void *context, size_t index)
+{
+    vsort_merge_stage_t *stage = (vsort_merge_stage_t *)context;
+    if (index == 0)
+    {
+        stage->write_failed = !vsort_write_elements(stage->output, stage->write_buffer, stage->write_count,
+                                                    stage->element_size);
+        return;
+    }
+    stage->fill_count = vsort_loser_tree_merge(stage->tree, stage->fill_buffer, stage->fill_capacity);
+}
+
+// Merges runs[0, count) into output; budget bounds the read and write buffers.
+static vsort_result_t vsort_merge_run_files(vsort_run_file_t *runs, size_t count, FILE *output, size_t element_size,
+                                            vsort_data_kind_t kind, size_t budget, unsigned int flags)
+{
+    size_t share = budget / (count + 2) / element_size;
+    size_t buffer_elements = share > 0 ? share : 1;
+    unsigned char *buffers = (unsigned char *)malloc((count + 2) * buffer_elements * element_size);
+    vsort_merge_cursor_t *cursors = (vsort_merge_cursor_t *)calloc(count, sizeof(vsort_merge_cursor_t));
+    if (!buffers || !cursors)
+    {
+        free(buffers);
+        free(cursors);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        fflush(runs[i].file);
+        rewind(runs[i].file);
+    }
+
+    vsort_merge_input_t input = {
+        .runs = runs,
+        .buffers = buffers,
+        .buffer_elements = buffer_elements,
+        .element_size = element_size};
+    vsort_loser_tree_t tree;
+    if (!vsort_loser_tree_init(&tree, kind, cursors, count, vsort_run_refill, &input))
+    {
+        free(buffers);
+        free(cursors);
+        return VSORT_ERR_ALLOCATION_FAILED;
+    }
+
+    unsigned char *out_a = buffers + count * buffer_elements * element_size;
+    unsigned char *out_b = out_a + buffer_elements * element_size;
+    vsort_merge_stage_t stage = {
+        .tree = &tree,
+        .output = output,
+        .element_size = element_size,
+        .fill_buffer = out_a,
+        .fill_capacity = buffer_elements,
+        .fill_count = 0,
+        .write_buffer = out_b,
+        .write_count = 0,
+        .write_failed = false};
+
+    do
+    {
+        vsort_pool_parallel_for(2, vsort_merge_stage_task, &stage, 2, flags);
+        if (stage.write_failed)
+            break;
+        stage.write_buffer = stage.fill_buffer;
+        stage.write_count = stage.fill_count;
+        stage.fill_buffer = stage.fill_buffer == out_a ? out_b : out_a;
+    } while (stage.fill_count > 0);
+
+    vsort_result_t result = (tree.failed || stage.write_failed) ? VSORT_ERR_IO : VSORT_OK;
+    vsort_loser_tree_destroy(&tree);
+    free(buffers);
+    free(cursors);
+    return result;
+}
+
+// Merges groups of fan_in runs into new runs until one merge can finish.
+static vsort_result_t vsort_reduce_runs(vsort_run_list_t *list, size_t fan_in, size_t element_size,
+                                        vsort_data_kind_t kind, size_t budget, unsigned int flags)
+{
+    while (list->count > fan_in)
+    {
+        vsort_log_debug("External sort: merging %zu runs in groups of %zu.", list->count, fan_in);
+        size_t merged = 0;
+        for (size_t begin = 0; begin < list->count; begin += fan_in)
+        {
+            size_t group = list->count - begin < fan_in ? list->count - begin : fan_in;
+            vsort_run_file_t run;
+            if (!vsort_run_create(list, &run))
+                return VSORT_ERR_IO;
+
+            vsort_result_t result = vsort_merge_run_files(list->items + begin, group, run.file, element_size, kind,
+                                                          budget, flags);
+            for (size_t i = 0; i < group; ++i)
+            {
+                run.count += list->items[begin + i].count;
+                vsort_run_discard(&list->items[begin + i]);
+            }
+            // Merged runs are compacted to the front as the old ones close.
+            list->items[merged++] = run;
+            if (result != VSORT_OK)
+            {
+                for (size_t i = begin + group; i < list->count; ++i)
+                    list->items[merged++] = list->items[i];
+                list->count = merged;
+                return result;
+            }
+        }
+        list->count = merged;
+    }
+    return VSORT_OK;
+}
+
+// Sorts the first chunk (already in buffer_a, count elements) and every
+// following one into run files appended to list.
+static vsort_result_t vsort_form_runs(vsort_run_list_t *list, FILE *input, void *buffer_a, void *buffer_b, size_t count,
+                                      size_t run_elements, size_t element_size, vsort_data_kind_t kind,
+                                      unsigned int flags)
+{
+    vsort_run_stage_t stage = {
+        .input = input,
+        .element_size = element_size,
+        .kind = kind,
+        .flags = flags,
+        .read_capacity = run_elements};
+
+    while (count > 0)
+    {
+        vsort_run_file_t run;
+        if (!vsort_run_create(list, &run))
+            return VSORT_ERR_IO;
+        run.count = count;
+        if (!vsort_run_list_push(list, &run))
+        {
+            vsort_run_discard(&run);
+            return VSORT_ERR_ALLOCATION_FAILED;
+        }
+
+        stage.sort_buffer = buffer_a;
+        stage.sort_count = count;
+        stage.sort_output = run.file;
+        stage.read_buffer = buffer_b;
+        vsort_pool_parallel_for(2, vsort_run_stage_task, &stage, 2, flags);
+        if (stage.write_failed || stage.read_failed)
+            return VSORT_ERR_IO;
+
+        void *swap = buffer_a;
+        buffer_a = buffer_b;
+        buffer_b = swap;
+        count = stage.read_count;
+    }
+    return VSORT_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+VSORT_API vsort_result_t vsort_sort_file(const vsort_external_options_t *options)
+{
+    if (!options || !options->input_path || !options->output_path)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    size_t element_size = vsort_merge_element_size(options->kind);
+    if (element_size == 0)
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+
+    vsort_init();
+
+    size_t budget = options->memory_budget ? options->memory_budget : VSORT_EXTERNAL_DEFAULT_BUDGET;
+    if (budget < VSORT_EXTERNAL_MIN_BUDGET)
+        budget = VSORT_EXTERNAL_MIN_BUDGET;
+    unsigned int flags = vsort_resolve_flags(options->flags);
+
+    // Two I/O buffers plus about as much again for the in-memory sort's scratch.
+    size_t run_elements = budget / 3 / element_size;
+    void *buffer_a = malloc(run_elements * element_size);
+    void *buffer_b = malloc(run_elements * element_size);
+    FILE *input = fopen(options->input_path, "rb");
+    vsort_run_list_t list = {.items = NULL, .count = 0, .capacity = 0, .created = 0, .temp_dir = options->temp_dir};
+    vsort_result_t result = VSORT_OK;
+    FILE *output = NULL;
+
+    size_t count = 0;
+    if (!buffer_a || !buffer_b)
+        result = VSORT_ERR_ALLOCATION_FAILED;
+    else if (!input || !vsort_read_elements(input, buffer_a, run_elements, element_size, &count))
+        result = VSORT_ERR_IO;
+
+    if (result == VSORT_OK && count < run_elements)
+    {
+        // The whole input fits in one run: sort it in memory.
+        fclose(input);
+        input = NULL;
+        vsort_sort_chunk(buffer_a, count, element_size, options->kind, flags);
+        output = fopen(options->output_path, "wb");
+        if (!output || !vsort_write_elements(output, buffer_a, count, element_size))
+            result = VSORT_ERR_IO;
+    }
+    else if (result == VSORT_OK)
+    {
+        result = vsort_form_runs(&list, input, buffer_a, buffer_b, count, run_elements, element_size, options->kind,
+                                 flags);
+        fclose(input);
+        input = NULL;
+        free(buffer_a);
+        free(buffer_b);
+        buffer_a = NULL;
+        buffer_b = NULL;
+
+        size_t fan_in = budget / VSORT_EXTERNAL_MIN_BUFFER;
+        fan_in = fan_in > 4 ? fan_in - 2 : 2;
+        if (fan_in > VSORT_EXTERNAL_MAX_FAN_IN)
+            fan_in = VSORT_EXTERNAL_MAX_FAN_IN;
+        vsort_log_debug("External sort: %zu runs of up to %zu elements.", list.count, run_elements);
+        if (result == VSORT_OK)
+            result = vsort_reduce_runs(&list, fan_in, element_size, options->kind, budget, flags);
+
+        // The input is fully consumed by now, so the output may replace it.
+        if (result == VSORT_OK)
+        {
+            output = fopen(options->output_path, "wb");
+            result = output ? vsort_merge_run_files(list.items, list.count, output, element_size, options->kind, budget,
+                                                    flags)
+                            : VSORT_ERR_IO;
+        }
+    }
+
+    if (output && fclose(output) != 0 && result == VSORT_OK)
+        result = VSORT_ERR_IO;
+    if (input)
+        fclose(input);
+    vsort_run_list_release(&list);
+    free(buffer_a);
+    free(buffer_b);
+    return result;
+}
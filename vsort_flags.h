@@ -0,0 +1,29 @@
+/**
+ * Flag resolution for VSort library
+ *
+ * Shared by the entry points in vsort.c and the asynchronous and external
+ * sort modules, so the same VSORT_FLAG_* bits select the same engines and
+ * thread counts whichever entry point receives them.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#ifndef VSORT_FLAGS_H
+#define VSORT_FLAGS_H
+
+#include "vsort.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-call flags, or the default flags when requested is 0, with exactly one
+// of VSORT_FLAG_PREFER_THROUGHPUT and VSORT_FLAG_PREFER_EFFICIENCY set.
+unsigned int vsort_resolve_flags(unsigned int requested);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VSORT_FLAGS_H */
@@ -0,0 +1,284 @@
+/**
+ * Implementation of VSort K-way merge
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vsort_merge.h"
+
+// -----------------------------------------------------------------------------
+// Keys
+// -----------------------------------------------------------------------------
+//
+// Heads are compared as unsigned words with the order of the element kind:
+// signed integers flip the sign bit, floats use the IEEE-754 total order
+// mapping of the radix engine.
+
+size_t vsort_merge_element_size(vsort_data_kind_t kind)
+{
+    switch (kind)
+    {
+    case VSORT_KIND_INT32:
+    case VSORT_KIND_FLOAT32:
+        return 4;
+    case VSORT_KIND_INT64:
+    case VSORT_KIND_UINT64:
+    case VSORT_KIND_FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static inline uint64_t vsort_merge_key(const unsigned char *element, vsort_data_kind_t kind)
+{
+    if (kind == VSORT_KIND_INT32 || kind == VSORT_KIND_FLOAT32)
+    {
+        uint32_t bits;
+        memcpy(&bits, element, sizeof(bits));
+        if (kind == VSORT_KIND_FLOAT32 && (bits & 0x80000000u))
+            return ~bits & 0xFFFFFFFFu;
+        return bits ^ 0x80000000u;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, element, sizeof(bits));
+    if (kind == VSORT_KIND_UINT64)
+        return bits;
+    if (kind == VSORT_KIND_FLOAT64 && (bits >> 63))
+        return ~bits;
+    return bits ^ ((uint64_t)1 << 63);
+}
+
+// -----------------------------------------------------------------------------
+// Loser tree
+// -----------------------------------------------------------------------------
+//
+// Runs are the leaves runs..2*runs-1 of an implicit binary tree whose inner
+// node n has children 2n and 2n+1. Every inner node keeps the head key and
+// rank of the loser of the match played there and nodes[0] the overall
+// winner, so advancing the winner replays only its leaf-to-root path:
+// log2(runs) comparisons per element against keys stored in the nodes, with
+// no indirection through the runs. The rank is the run index; an exhausted
+// run gets the largest key and a rank past every live run, so comparisons
+// never test for the end of a run. 32-bit keys carry the rank in their low
+// half, which makes every match a single 64-bit comparison.
+
+static inline bool vsort_loser_tree_beats(vsort_loser_node_t a, vsort_loser_node_t b)
+{
+    return a.key < b.key || (a.key == b.key && a.rank < b.rank);
+}
+
+// Refills an empty cursor and returns the node of its head.
+static vsort_loser_node_t vsort_loser_tree_head(vsort_loser_tree_t *tree, size_t run)
+{
+    vsort_merge_cursor_t *cursor = &tree->cursors[run];
+    if (cursor->remaining == 0 && tree->refill && !tree->refill(tree->context, run, cursor))
+    {
+        tree->failed = true;
+        cursor->remaining = 0;
+    }
+
+    vsort_loser_node_t head = {UINT64_MAX, tree->runs + run};
+    if (cursor->remaining > 0)
+    {
+        head.key = vsort_merge_key(cursor->data, tree->kind);
+        head.rank = run;
+    }
+    if (tree->element_size == 4)
+        head.key = (head.key << 32) | head.rank;
+    return head;
+}
+
+static vsort_loser_node_t vsort_loser_tree_build(vsort_loser_tree_t *tree, size_t node)
+{
+    if (node >= tree->runs)
+        return vsort_loser_tree_head(tree, node - tree->runs);
+
+    vsort_loser_node_t left = vsort_loser_tree_build(tree, node * 2);
+    vsort_loser_node_t right = vsort_loser_tree_build(tree, node * 2 + 1);
+    if (vsort_loser_tree_beats(left, right))
+    {
+        tree->nodes[node] = right;
+        return left;
+    }
+    tree->nodes[node] = left;
+    return right;
+}
+
+bool vsort_loser_tree_init(vsort_loser_tree_t *tree, vsort_data_kind_t kind, vsort_merge_cursor_t *cursors,
+                           size_t runs, vsort_merge_refill_fn refill, void *context)
+{
+    tree->kind = kind;
+    tree->element_size = vsort_merge_element_size(kind);
+    tree->runs = runs;
+    tree->cursors = cursors;
+    tree->refill = refill;
+    tree->context = context;
+    tree->failed = false;
+    tree->nodes = (vsort_loser_node_t *)malloc((runs > 0 ? runs : 1) * sizeof(vsort_loser_node_t));
+    // Packed 32-bit keys leave 32 bits for ranks up to 2 * runs.
+    if (!tree->nodes || tree->element_size == 0 || (tree->element_size == 4 && runs > UINT32_MAX / 2))
+    {
+        vsort_loser_tree_destroy(tree);
+        return false;
+    }
+
+    tree->nodes[0].key = UINT64_MAX;
+    tree->nodes[0].rank = runs;
+    if (runs > 0)
+        tree->nodes[0] = vsort_loser_tree_build(tree, 1);
+    return true;
+}
+
+// Shared body of vsort_loser_tree_merge; packed is a constant at each call
+// so both variants compile to their own loop.
+static inline size_t vsort_loser_tree_merge_loop(vsort_loser_tree_t *tree, unsigned char *dst, size_t capacity,
+                                                 bool packed)
+{
+    // Locals, because stores through dst may alias every field of the tree.
+    const vsort_data_kind_t kind = tree->kind;
+    const size_t runs = tree->runs;
+    vsort_merge_cursor_t *cursors = tree->cursors;
+    vsort_loser_node_t *nodes = tree->nodes;
+    vsort_loser_node_t winner = nodes[0];
+    size_t written = 0;
+
+    // An exhausted winner means every run is exhausted.
+    while (written < capacity && winner.rank < runs)
+    {
+        size_t run = winner.rank;
+        vsort_merge_cursor_t *cursor = &cursors[run];
+        if (packed)
+        {
+            memcpy(dst, cursor->data, 4);
+            dst += 4;
+            cursor->data += 4;
+        }
+        else
+        {
+            memcpy(dst, cursor->data, 8);
+            dst += 8;
+            cursor->data += 8;
+        }
+        written++;
+
+        if (--cursor->remaining > 0)
+        {
+            uint64_t key = vsort_merge_key(cursor->data, kind);
+            winner.key = packed ? (key << 32) | run : key;
+        }
+        else
+        {
+            winner = vsort_loser_tree_head(tree, run);
+            if (tree->failed)
+                break;
+        }
+
+        if (packed)
+        {
+            // Keys alone decide and identify the winner; the ranks stored in
+            // the inner nodes go stale and are never read.
+            uint64_t key = winner.key;
+            for (size_t node = (run + runs) / 2; node > 0; node /= 2)
+            {
+                uint64_t rival = nodes[node].key;
+                bool swap = rival < key;
+                nodes[node].key = swap ? key : rival;
+                key = swap ? rival : key;
+            }
+            winner.key = key;
+            winner.rank = (size_t)(key & 0xFFFFFFFFu);
+            continue;
+        }
+
+        for (size_t node = (run + runs) / 2; node > 0; node /= 2)
+        {
+            vsort_loser_node_t rival = nodes[node];
+            bool swap = vsort_loser_tree_beats(rival, winner);
+            nodes[node] = swap ? winner : rival;
+            winner = swap ? rival : winner;
+        }
+    }
+    nodes[0] = winner;
+    return written;
+}
+
+size_t vsort_loser_tree_merge(vsort_loser_tree_t *tree, void *out, size_t capacity)
+{
+    if (tree->element_size == 4)
+        return vsort_loser_tree_merge_loop(tree, (unsigned char *)out, capacity, true);
+    return vsort_loser_tree_merge_loop(tree, (unsigned char *)out, capacity, false);
+}
+
+void vsort_loser_tree_destroy(vsort_loser_tree_t *tree)
+{
+    free(tree->nodes);
+    tree->nodes = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Output partitioning
+// -----------------------------------------------------------------------------
+//
+// The first rank merged elements are, per run, every element below the key
+// v of the rank-th output plus a share of the elements equal to v handed out
+// in run order (which is how the loser tree breaks ties). v itself is found
+// by bisecting the 64-bit key space, counting with one binary search per run.
+
+static size_t vsort_merge_bound(const vsort_merge_cursor_t *run, vsort_data_kind_t kind, size_t element_size,
+                                uint64_t key, bool inclusive)
+{
+    size_t lo = 0;
+    size_t hi = run->remaining;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        uint64_t probe = vsort_merge_key(run->data + mid * element_size, kind);
+        if (probe < key || (inclusive && probe == key))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void vsort_merge_split(vsort_data_kind_t kind, const vsort_merge_cursor_t *runs, size_t run_count, size_t rank,
+                       size_t *positions)
+{
+    const size_t element_size = vsort_merge_element_size(kind);
+
+    // Smallest key with at least rank elements at or below it.
+    uint64_t lo = 0;
+    uint64_t hi = UINT64_MAX;
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        size_t total = 0;
+        for (size_t r = 0; r < run_count && total < rank; ++r)
+            total += vsort_merge_bound(&runs[r], kind, element_size, mid, true);
+        if (total >= rank)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    size_t below = 0;
+    for (size_t r = 0; r < run_count; ++r)
+    {
+        positions[r] = vsort_merge_bound(&runs[r], kind, element_size, lo, false);
+        below += positions[r];
+    }
+
+    size_t need = rank > below ? rank - below : 0;
+    for (size_t r = 0; r < run_count && need > 0; ++r)
+    {
+        size_t upper = vsort_merge_bound(&runs[r], kind, element_size, lo, true);
+        size_t take = upper > positions[r] ? upper - positions[r] : 0;
+        if (take > need)
+            take = need;
+        positions[r] += take;
+        need -= take;
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * K-way merge for VSort library
+ *
+ * Loser tree over sorted runs of numeric elements. Runs are read through
+ * cursors that a callback refills, so the same tree merges in-memory runs
+ * and buffered run files.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#ifndef VSORT_MERGE_H
+#define VSORT_MERGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vsort.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Unread part of one run
+typedef struct
+{
+    const unsigned char *data; /**< Next element of the run */
+    size_t remaining;          /**< Elements left at data */
+} vsort_merge_cursor_t;
+
+// Refill callback: called once a cursor is empty. Leaves remaining at 0 when
+// the run is finished; returns false on a read error.
+typedef bool (*vsort_merge_refill_fn)(void *context, size_t run, vsort_merge_cursor_t *cursor);
+
+// Head of a run as stored in the tree
+typedef struct
+{
+    uint64_t key; /**< Order-preserving key of the head element */
+    size_t rank;  /**< Tie-break order: the run index, plus runs once exhausted */
+} vsort_loser_node_t;
+
+typedef struct
+{
+    vsort_data_kind_t kind;
+    size_t element_size;
+    size_t runs;
+    vsort_merge_cursor_t *cursors;
+    vsort_loser_node_t *nodes; /**< nodes[0] is the winner, nodes[1, runs) the losers of the inner nodes */
+    vsort_merge_refill_fn refill;
+    void *context;
+    bool failed;               /**< A refill reported an error */
+} vsort_loser_tree_t;
+
+// Element size of a numeric kind (INT32, FLOAT32, INT64, UINT64, FLOAT64), 0 otherwise
+size_t vsort_merge_element_size(vsort_data_kind_t kind);
+
+// Build the tree over runs cursors (kept by reference). refill may be NULL
+// when the cursors already cover whole runs. Returns false if out of memory
+// (or with 2^31 or more runs of a 32-bit kind).
+bool vsort_loser_tree_init(vsort_loser_tree_t *tree, vsort_data_kind_t kind, vsort_merge_cursor_t *cursors,
+                           size_t runs, vsort_merge_refill_fn refill, void *context);
+
+// Write up to capacity merged elements to out and return how many were
+// written; fewer than capacity means the runs are exhausted (or tree->failed).
+// Equal elements come out in run order.
+size_t vsort_loser_tree_merge(vsort_loser_tree_t *tree, void *out, size_t capacity);
+
+void vsort_loser_tree_destroy(vsort_loser_tree_t *tree);
+
+// Per-run element counts (written to positions) of the first rank elements
+// of the merged output, ties assigned in run order like the loser tree.
+// The cursors must cover whole runs.
+void vsort_merge_split(vsort_data_kind_t kind, const vsort_merge_cursor_t *runs, size_t run_count, size_t rank,
+                       size_t *positions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VSORT_MERGE_H */
@@ -0,0 +1,584 @@
+/**
+ * Implementation of VSort worker pool
+ */
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "vsort_pool.h"
+#include "vsort_logger.h"
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <pthread.h>
+#if defined(VSORT_APPLE)
+#include <dispatch/dispatch.h>
+#endif
+#endif
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#include <stdatomic.h>
+#endif
+
+#define VSORT_POOL_MAX_THREADS 256
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VSORT_THREAD_LOCAL __declspec(thread)
+#else
+#define VSORT_THREAD_LOCAL _Thread_local
+#endif
+
+// -----------------------------------------------------------------------------
+// Threading primitives
+// -----------------------------------------------------------------------------
+
+#if defined(_WIN32) || defined(_MSC_VER)
+typedef SRWLOCK vsort_mutex_t;
+typedef CONDITION_VARIABLE vsort_cond_t;
+typedef HANDLE vsort_thread_t;
+#define VSORT_MUTEX_INITIALIZER SRWLOCK_INIT
+#define VSORT_COND_INITIALIZER CONDITION_VARIABLE_INIT
+
+static void vsort_mutex_lock(vsort_mutex_t *m) { AcquireSRWLockExclusive(m); }
+static void vsort_mutex_unlock(vsort_mutex_t *m) { ReleaseSRWLockExclusive(m); }
+static void vsort_cond_wait(vsort_cond_t *c, vsort_mutex_t *m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void vsort_cond_broadcast(vsort_cond_t *c) { WakeAllConditionVariable(c); }
+#else
+typedef pthread_mutex_t vsort_mutex_t;
+typedef pthread_cond_t vsort_cond_t;
+typedef pthread_t vsort_thread_t;
+#define VSORT_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define VSORT_COND_INITIALIZER PTHREAD_COND_INITIALIZER
+
+static void vsort_mutex_lock(vsort_mutex_t *m) { pthread_mutex_lock(m); }
+static void vsort_mutex_unlock(vsort_mutex_t *m) { pthread_mutex_unlock(m); }
+static void vsort_cond_wait(vsort_cond_t *c, vsort_mutex_t *m) { pthread_cond_wait(c, m); }
+static void vsort_cond_broadcast(vsort_cond_t *c) { pthread_cond_broadcast(c); }
+#endif
+
+#if defined(VSORT_APPLE) && !defined(_WIN32)
+
+// -----------------------------------------------------------------------------
+// Grand Central Dispatch backend
+// -----------------------------------------------------------------------------
+
+void vsort_pool_parallel_for(size_t count, vsort_pool_task_fn task, void *context,
+                             int max_threads, unsigned int flags)
+{
+    if (count == 0)
+        return;
+
+    if (count == 1 || max_threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            task(context, i);
+        return;
+    }
+
+    dispatch_qos_class_t qos = QOS_CLASS_USER_INITIATED;
+    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
+        qos = QOS_CLASS_UTILITY;
+
+    dispatch_apply_f(count, dispatch_get_global_queue(qos, 0), context, task);
+}
+
+typedef struct
+{
+    vsort_pool_task_fn task;
+    void *context;
+} vsort_pool_submission_t;
+
+static void vsort_pool_run_submission(void *context)
+{
+    vsort_pool_submission_t submission = *(vsort_pool_submission_t *)context;
+    free(context);
+    submission.task(submission.context, 0);
+}
+
+bool vsort_pool_submit(vsort_pool_task_fn task, void *context, unsigned int flags)
+{
+    vsort_pool_submission_t *submission = (vsort_pool_submission_t *)malloc(sizeof(vsort_pool_submission_t));
+    if (!submission)
+        return false;
+    submission->task = task;
+    submission->context = context;
+
+    dispatch_qos_class_t qos = QOS_CLASS_USER_INITIATED;
+    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
+        qos = QOS_CLASS_UTILITY;
+    dispatch_async_f(dispatch_get_global_queue(qos, 0), submission, vsort_pool_run_submission);
+    return true;
+}
+
+void vsort_pool_shutdown(void)
+{
+}
+
+#else
+
+// -----------------------------------------------------------------------------
+// Pool state
+// -----------------------------------------------------------------------------
+
+typedef struct vsort_pool_job
+{
+    vsort_pool_task_fn task;
+    void *context;
+    size_t count;
+    size_t next;     /**< Next unclaimed index (guarded by pool mutex) */
+    int helpers;     /**< Workers currently attached to this job */
+    int max_helpers; /**< Upper bound on attached workers */
+    bool detached;   /**< Heap-allocated by vsort_pool_submit, freed by its worker */
+    struct vsort_pool_job *link;
+} vsort_pool_job_t;
+
+typedef struct
+{
+    vsort_mutex_t mutex;
+    vsort_cond_t work_ready;
+    vsort_cond_t job_done;
+    vsort_pool_job_t *jobs;
+    vsort_thread_t threads[VSORT_POOL_MAX_THREADS];
+    int thread_count;
+    int detached; /**< Submitted jobs not finished yet */
+    bool shutting_down;
+} vsort_pool_t;
+
+static vsort_pool_t g_pool = {
+    .mutex = VSORT_MUTEX_INITIALIZER,
+    .work_ready = VSORT_COND_INITIALIZER,
+    .job_done = VSORT_COND_INITIALIZER,
+    .jobs = NULL,
+    .thread_count = 0,
+    .detached = 0,
+    .shutting_down = false,
+};
+
+// Returns the first job that still has unclaimed indices and room for a helper.
+// Must be called with the pool mutex held.
+static vsort_pool_job_t *vsort_pool_find_job(vsort_pool_t *pool)
+{
+    for (vsort_pool_job_t *job = pool->jobs; job; job = job->link)
+    {
+        if (job->next < job->count && job->helpers < job->max_helpers)
+            return job;
+    }
+    return NULL;
+}
+
+// Claims and runs indices of job until none remain.
+// Must be called with the pool mutex held; returns with it held.
+static void vsort_pool_drain_job(vsort_pool_t *pool, vsort_pool_job_t *job)
+{
+    while (job->next < job->count)
+    {
+        size_t index = job->next++;
+        vsort_mutex_unlock(&pool->mutex);
+        job->task(job->context, index);
+        vsort_mutex_lock(&pool->mutex);
+    }
+}
+
+// Unlinks and frees a finished submitted job.
+// Must be called with the pool mutex held.
+static void vsort_pool_retire_detached(vsort_pool_t *pool, vsort_pool_job_t *job)
+{
+    vsort_pool_job_t **cursor = &pool->jobs;
+    while (*cursor != job)
+        cursor = &(*cursor)->link;
+    *cursor = job->link;
+    pool->detached--;
+    free(job);
+}
+
+#if defined(_WIN32) || defined(_MSC_VER)
+static DWORD WINAPI vsort_pool_worker(LPVOID arg)
+#else
+static void *vsort_pool_worker(void *arg)
+#endif
+{
+    vsort_pool_t *pool = (vsort_pool_t *)arg;
+
+    vsort_mutex_lock(&pool->mutex);
+    while (!pool->shutting_down)
+    {
+        vsort_pool_job_t *job = vsort_pool_find_job(pool);
+        if (!job)
+        {
+            vsort_cond_wait(&pool->work_ready, &pool->mutex);
+            continue;
+        }
+
+        job->helpers++;
+        vsort_pool_drain_job(pool, job);
+        if (--job->helpers == 0)
+        {
+            if (job->detached)
+                vsort_pool_retire_detached(pool, job);
+            else
+                vsort_cond_broadcast(&pool->job_done);
+        }
+    }
+    vsort_mutex_unlock(&pool->mutex);
+
+#if defined(_WIN32) || defined(_MSC_VER)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+// Spawns workers until the pool holds at least wanted threads.
+// Must be called with the pool mutex held.
+static void vsort_pool_grow(vsort_pool_t *pool, int wanted)
+{
+    if (wanted > VSORT_POOL_MAX_THREADS)
+        wanted = VSORT_POOL_MAX_THREADS;
+
+    while (pool->thread_count < wanted)
+    {
+        vsort_thread_t *slot = &pool->threads[pool->thread_count];
+#if defined(_WIN32) || defined(_MSC_VER)
+        *slot = CreateThread(NULL, 0, vsort_pool_worker, pool, 0, NULL);
+        if (*slot == NULL)
+#else
+        if (pthread_create(slot, NULL, vsort_pool_worker, pool) != 0)
+#endif
+        {
+            vsort_log_warning("Failed to start worker thread %d, continuing with %d.",
+                              pool->thread_count + 1, pool->thread_count);
+            return;
+        }
+        pool->thread_count++;
+    }
+}
+
+void vsort_pool_parallel_for(size_t count, vsort_pool_task_fn task, void *context,
+                             int max_threads, unsigned int flags)
+{
+    (void)flags;
+
+    if (count == 0)
+        return;
+
+    if (count == 1 || max_threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            task(context, i);
+        return;
+    }
+
+    vsort_pool_t *pool = &g_pool;
+    int helpers = max_threads - 1;
+    if ((size_t)helpers > count - 1)
+        helpers = (int)(count - 1);
+
+    vsort_pool_job_t job = {
+        .task = task,
+        .context = context,
+        .count = count,
+        .next = 0,
+        .helpers = 0,
+        .max_helpers = helpers,
+        .detached = false,
+        .link = NULL};
+
+    vsort_mutex_lock(&pool->mutex);
+    if (pool->shutting_down)
+    {
+        vsort_mutex_unlock(&pool->mutex);
+        for (size_t i = 0; i < count; ++i)
+            task(context, i);
+        return;
+    }
+
+    vsort_pool_grow(pool, max_threads - 1);
+    job.link = pool->jobs;
+    pool->jobs = &job;
+    vsort_cond_broadcast(&pool->work_ready);
+
+    vsort_pool_drain_job(pool, &job);
+    while (job.helpers > 0)
+        vsort_cond_wait(&pool->job_done, &pool->mutex);
+
+    vsort_pool_job_t **cursor = &pool->jobs;
+    while (*cursor != &job)
+        cursor = &(*cursor)->link;
+    *cursor = job.link;
+    vsort_mutex_unlock(&pool->mutex);
+}
+
+bool vsort_pool_submit(vsort_pool_task_fn task, void *context, unsigned int flags)
+{
+    (void)flags;
+
+    vsort_pool_t *pool = &g_pool;
+    vsort_pool_job_t *job = (vsort_pool_job_t *)malloc(sizeof(vsort_pool_job_t));
+    if (!job)
+        return false;
+    job->task = task;
+    job->context = context;
+    job->count = 1;
+    job->next = 0;
+    job->helpers = 0;
+    job->max_helpers = 1;
+    job->detached = true;
+
+    vsort_mutex_lock(&pool->mutex);
+    if (pool->shutting_down)
+    {
+        vsort_mutex_unlock(&pool->mutex);
+        free(job);
+        return false;
+    }
+
+    // One worker per outstanding submission, so a long sort never holds up
+    // the ones queued after it.
+    pool->detached++;
+    vsort_pool_grow(pool, pool->detached);
+    job->link = pool->jobs;
+    pool->jobs = job;
+    vsort_cond_broadcast(&pool->work_ready);
+    vsort_mutex_unlock(&pool->mutex);
+    return true;
+}
+
+void vsort_pool_shutdown(void)
+{
+    vsort_pool_t *pool = &g_pool;
+
+    vsort_mutex_lock(&pool->mutex);
+    pool->shutting_down = true;
+    vsort_cond_broadcast(&pool->work_ready);
+    int count = pool->thread_count;
+    vsort_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < count; ++i)
+    {
+#if defined(_WIN32) || defined(_MSC_VER)
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+
+    // Submissions no worker picked up still run, so nobody waits forever.
+    vsort_mutex_lock(&pool->mutex);
+    pool->thread_count = 0;
+    for (;;)
+    {
+        vsort_pool_job_t *job = pool->jobs;
+        while (job && !(job->detached && job->next < job->count))
+            job = job->link;
+        if (!job)
+            break;
+        vsort_pool_drain_job(pool, job);
+        vsort_pool_retire_detached(pool, job);
+    }
+    vsort_mutex_unlock(&pool->mutex);
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// Cancellation
+// -----------------------------------------------------------------------------
+
+struct vsort_cancel
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    volatile LONG requested;
+    volatile LONG stopped;
+#else
+    atomic_int requested;
+    atomic_int stopped;
+#endif
+};
+
+static VSORT_THREAD_LOCAL vsort_cancel_t *t_cancel = NULL;
+
+vsort_cancel_t *vsort_cancel_create(void)
+{
+    vsort_cancel_t *cancel = (vsort_cancel_t *)malloc(sizeof(vsort_cancel_t));
+    if (!cancel)
+        return NULL;
+#if defined(_WIN32) || defined(_MSC_VER)
+    cancel->requested = 0;
+    cancel->stopped = 0;
+#else
+    atomic_init(&cancel->requested, 0);
+    atomic_init(&cancel->stopped, 0);
+#endif
+    return cancel;
+}
+
+void vsort_cancel_destroy(vsort_cancel_t *cancel)
+{
+    free(cancel);
+}
+
+void vsort_cancel_request(vsort_cancel_t *cancel)
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    InterlockedExchange(&cancel->requested, 1);
+#else
+    atomic_store(&cancel->requested, 1);
+#endif
+}
+
+bool vsort_cancel_requested(const vsort_cancel_t *cancel)
+{
+    if (!cancel)
+        return false;
+#if defined(_WIN32) || defined(_MSC_VER)
+    return cancel->requested != 0;
+#else
+    return atomic_load_explicit((atomic_int *)&cancel->requested, memory_order_relaxed) != 0;
+#endif
+}
+
+bool vsort_cancel_check(vsort_cancel_t *cancel)
+{
+    if (!vsort_cancel_requested(cancel))
+        return false;
+#if defined(_WIN32) || defined(_MSC_VER)
+    InterlockedExchange(&cancel->stopped, 1);
+#else
+    atomic_store(&cancel->stopped, 1);
+#endif
+    return true;
+}
+
+bool vsort_cancel_stopped(const vsort_cancel_t *cancel)
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    return cancel->stopped != 0;
+#else
+    return atomic_load((atomic_int *)&cancel->stopped) != 0;
+#endif
+}
+
+vsort_cancel_t *vsort_cancel_bind(vsort_cancel_t *cancel)
+{
+    vsort_cancel_t *previous = t_cancel;
+    t_cancel = cancel;
+    return previous;
+}
+
+vsort_cancel_t *vsort_cancel_current(void)
+{
+    return t_cancel;
+}
+
+// -----------------------------------------------------------------------------
+// Task groups
+// -----------------------------------------------------------------------------
+
+#define VSORT_POOL_GROUP_CAPACITY 1024
+
+struct vsort_pool_group
+{
+    vsort_mutex_t mutex;
+    vsort_cond_t changed;
+    vsort_pool_group_fn task;
+    void *context;
+    size_t queued;  /**< Ranges waiting in stack */
+    size_t pending; /**< Ranges queued or running */
+    vsort_pool_range_t stack[VSORT_POOL_GROUP_CAPACITY];
+};
+
+// One group thread: pops ranges until the group has no range queued or
+// running. A thread that finds the stack empty while others are still
+// working waits, since their ranges may spawn more.
+static void vsort_pool_group_worker(void *context, size_t index)
+{
+    vsort_pool_group_t *group = (vsort_pool_group_t *)context;
+    (void)index;
+
+    vsort_mutex_lock(&group->mutex);
+    for (;;)
+    {
+        while (group->queued == 0 && group->pending > 0)
+            vsort_cond_wait(&group->changed, &group->mutex);
+        if (group->pending == 0)
+            break;
+
+        vsort_pool_range_t range = group->stack[--group->queued];
+        vsort_mutex_unlock(&group->mutex);
+        group->task(group, group->context, &range);
+        vsort_mutex_lock(&group->mutex);
+
+        if (--group->pending == 0)
+            vsort_cond_broadcast(&group->changed);
+    }
+    vsort_mutex_unlock(&group->mutex);
+}
+
+bool vsort_pool_group_spawn(vsort_pool_group_t *group, const vsort_pool_range_t *range)
+{
+    if (!group)
+        return false;
+
+    vsort_mutex_lock(&group->mutex);
+    bool queued = group->queued < VSORT_POOL_GROUP_CAPACITY;
+    if (queued)
+    {
+        group->stack[group->queued++] = *range;
+        group->pending++;
+        vsort_cond_broadcast(&group->changed);
+    }
+    vsort_mutex_unlock(&group->mutex);
+    return queued;
+}
+
+void vsort_pool_run_group(vsort_pool_group_fn task, void *context, const vsort_pool_range_t *seeds,
+                          size_t seed_count, int max_threads, unsigned int flags)
+{
+    vsort_pool_group_t *group = (vsort_pool_group_t *)malloc(sizeof(vsort_pool_group_t));
+    if (!group || max_threads <= 1)
+    {
+        // Without a queue every range, spawned ones included, runs inline.
+        free(group);
+        for (size_t i = 0; i < seed_count; ++i)
+            task(NULL, context, &seeds[i]);
+        return;
+    }
+
+#if defined(_WIN32) || defined(_MSC_VER)
+    InitializeSRWLock(&group->mutex);
+    InitializeConditionVariable(&group->changed);
+#else
+    pthread_mutex_init(&group->mutex, NULL);
+    pthread_cond_init(&group->changed, NULL);
+#endif
+    group->task = task;
+    group->context = context;
+    group->queued = 0;
+    group->pending = 0;
+
+    // Seeds beyond the queue capacity run on the calling thread up front.
+    size_t i = 0;
+    for (; i + VSORT_POOL_GROUP_CAPACITY < seed_count; ++i)
+        task(NULL, context, &seeds[i]);
+    for (size_t j = seed_count; j > i; --j)
+        group->stack[group->queued++] = seeds[j - 1];
+    group->pending = group->queued;
+
+    if (group->pending > 0)
+        vsort_pool_parallel_for((size_t)max_threads, vsort_pool_group_worker, group, max_threads, flags);
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+    pthread_cond_destroy(&group->changed);
+    pthread_mutex_destroy(&group->mutex);
+#endif
+    free(group);
+}
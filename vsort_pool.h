@@ -0,0 +1,92 @@
+/**
+ * Worker pool for VSort library
+ *
+ * Persistent pthreads/Win32 worker pool used by the parallel sorting paths.
+ * On Apple platforms work is forwarded to Grand Central Dispatch instead.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#ifndef VSORT_POOL_H
+#define VSORT_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vsort.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Task callback: invoked once for every index in [0, count)
+typedef void (*vsort_pool_task_fn)(void *context, size_t index);
+
+// Run task(context, i) for every i in [0, count) on up to max_threads threads.
+// The calling thread participates and the call returns once every index ran.
+// Safe to call concurrently and from inside a running task.
+void vsort_pool_parallel_for(size_t count, vsort_pool_task_fn task, void *context,
+                             int max_threads, unsigned int flags);
+
+// Run task(context, 0) on a worker thread without waiting for it. Returns
+// false when the pool is shutting down or out of memory; nothing runs then.
+bool vsort_pool_submit(vsort_pool_task_fn task, void *context, unsigned int flags);
+
+// Cancellation flag of an asynchronous sort. The thread running the sort
+// binds it; the engines fetch it with vsort_cancel_current before fanning
+// out and poll it at chunk and pass boundaries.
+typedef struct vsort_cancel vsort_cancel_t;
+
+vsort_cancel_t *vsort_cancel_create(void);
+void vsort_cancel_destroy(vsort_cancel_t *cancel);
+void vsort_cancel_request(vsort_cancel_t *cancel);
+
+// False for a NULL token
+bool vsort_cancel_requested(const vsort_cancel_t *cancel);
+
+// Engine-side poll: like vsort_cancel_requested, but a true result also
+// records that the sort stopped short of its end.
+bool vsort_cancel_check(vsort_cancel_t *cancel);
+
+// Whether an engine stopped because of this token
+bool vsort_cancel_stopped(const vsort_cancel_t *cancel);
+
+// Binds cancel to the calling thread and returns the previous token
+vsort_cancel_t *vsort_cancel_bind(vsort_cancel_t *cancel);
+
+// Token bound to the calling thread, NULL when none
+vsort_cancel_t *vsort_cancel_current(void);
+
+// A range of work handed to a task group. budget is opaque to the pool and
+// travels with the range (the sorts use it for their recursion allowance).
+typedef struct
+{
+    size_t begin;
+    size_t end;
+    size_t budget;
+} vsort_pool_range_t;
+
+typedef struct vsort_pool_group vsort_pool_group_t;
+
+// Group task callback: processes one range and may spawn further ranges.
+typedef void (*vsort_pool_group_fn)(vsort_pool_group_t *group, void *context, const vsort_pool_range_t *range);
+
+// Run task on every seed range and on every range spawned while the group
+// runs, on up to max_threads threads, returning once all of them finished.
+// Idle threads take the most recently spawned range first.
+void vsort_pool_run_group(vsort_pool_group_fn task, void *context, const vsort_pool_range_t *seeds,
+                          size_t seed_count, int max_threads, unsigned int flags);
+
+// Queue a range on a running group. Returns false when the queue is full or
+// the group runs inline (group is NULL), in which case the caller must
+// process the range itself.
+bool vsort_pool_group_spawn(vsort_pool_group_t *group, const vsort_pool_range_t *range);
+
+// Stop and join all worker threads (registered with atexit by vsort_init)
+void vsort_pool_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VSORT_POOL_H */
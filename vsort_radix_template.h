@@ -0,0 +1,404 @@
+/**
+ * Radix sort engines for VSort
+ *
+ * This file has no include guard: vsort.c includes it once per word width
+ * after defining
+ *
+ *   VSORT_WORD   unsigned word type (uint32_t, uint64_t)
+ *   VSORT_SWORD  signed word type of the same width (int32_t, int64_t)
+ *   VSORT_WIDTH  word width in bits (32, 64)
+ *
+ * and the hook vsort_radix_signed_sort<width> (small MSD buckets). Every
+ * function it defines is static and named vsort_<name><width>; the
+ * parameter macros are undefined at the end.
+ *
+ * Elements are mapped to unsigned keys with
+ *
+ *   key = ordered(word, float_mask) ^ sign_bit
+ *
+ * where ordered() inverts the magnitude bits of negative IEEE-754 values
+ * (float_mask is 0 for integers) and sign_bit is the top bit for signed and
+ * floating-point data, 0 for unsigned data.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#if !defined(VSORT_WORD) || !defined(VSORT_SWORD) || !defined(VSORT_WIDTH)
+#error "vsort_radix_template.h needs VSORT_WORD, VSORT_SWORD and VSORT_WIDTH"
+#endif
+
+#define VSORT_RFN(name) VSORT_CAT(name, VSORT_WIDTH)
+#define VSORT_RTYPE(name) VSORT_CAT3(name, VSORT_WIDTH, _t)
+
+// Shared state for the LSD radix tasks. Every task index t owns the
+// contiguous block [t * block, (t + 1) * block) and one histogram row per
+// pass, laid out as histograms[(t * passes + pass) * bins + digit].
+typedef struct
+{
+    const VSORT_WORD *src;
+    VSORT_WORD *dst;
+    size_t count;
+    size_t block;
+    VSORT_WORD float_mask;
+    VSORT_WORD sign_bit;
+    unsigned int bits;
+    size_t bins;
+    size_t passes;
+    size_t pass;
+    size_t *histograms;
+} VSORT_RTYPE(vsort_radix_job);
+
+// Maps an integer (float_mask == 0) or IEEE-754 (float_mask == all bits but
+// the sign) bit pattern onto a word whose signed order is the total order:
+// negative floats get their magnitude bits inverted. The mapping is an
+// involution, so applying it twice restores the original bits.
+static inline VSORT_WORD VSORT_RFN(vsort_radix_ordered)(VSORT_WORD word, VSORT_WORD float_mask)
+{
+    return word ^ ((VSORT_WORD)((VSORT_SWORD)word >> (VSORT_WIDTH - 1)) & float_mask);
+}
+
+// Order-preserving word -> unsigned key mapping.
+static inline VSORT_WORD VSORT_RFN(vsort_radix_key)(VSORT_WORD word, VSORT_WORD float_mask, VSORT_WORD sign_bit)
+{
+    return VSORT_RFN(vsort_radix_ordered)(word, float_mask) ^ sign_bit;
+}
+
+// Fused pre-pass: one read of the block fills the histograms of every pass.
+static void VSORT_RFN(vsort_radix_histogram_all)(void *context, size_t index)
+{
+    const VSORT_RTYPE(vsort_radix_job) *job = (const VSORT_RTYPE(vsort_radix_job) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t *histogram = job->histograms + index * job->passes * job->bins;
+    const unsigned int mask = (unsigned int)job->bins - 1u;
+
+    memset(histogram, 0, job->passes * job->bins * sizeof(size_t));
+    if (job->passes == 3)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            VSORT_WORD key = VSORT_RFN(vsort_radix_key)(job->src[i], job->float_mask, job->sign_bit);
+            histogram[key & mask]++;
+            histogram[job->bins + ((key >> job->bits) & mask)]++;
+            histogram[2 * job->bins + (key >> (2 * job->bits))]++;
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        VSORT_WORD key = VSORT_RFN(vsort_radix_key)(job->src[i], job->float_mask, job->sign_bit);
+        for (size_t pass = 0; pass < job->passes; ++pass)
+            histogram[pass * job->bins + ((key >> (pass * job->bits)) & mask)]++;
+    }
+}
+
+static void VSORT_RFN(vsort_radix_histogram)(void *context, size_t index)
+{
+    const VSORT_RTYPE(vsort_radix_job) *job = (const VSORT_RTYPE(vsort_radix_job) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t *histogram = job->histograms + (index * job->passes + job->pass) * job->bins;
+    const unsigned int mask = (unsigned int)job->bins - 1u;
+    const unsigned int offset = (unsigned int)(job->pass * job->bits);
+
+    memset(histogram, 0, job->bins * sizeof(size_t));
+    for (size_t i = begin; i < end; ++i)
+        histogram[(VSORT_RFN(vsort_radix_key)(job->src[i], job->float_mask, job->sign_bit) >> offset) & mask]++;
+}
+
+static void VSORT_RFN(vsort_radix_scatter)(void *context, size_t index)
+{
+    const VSORT_RTYPE(vsort_radix_job) *job = (const VSORT_RTYPE(vsort_radix_job) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t *histogram = job->histograms + (index * job->passes + job->pass) * job->bins;
+    const unsigned int mask = (unsigned int)job->bins - 1u;
+    const unsigned int offset = (unsigned int)(job->pass * job->bits);
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        VSORT_WORD value = job->src[i];
+        job->dst[histogram[(VSORT_RFN(vsort_radix_key)(value, job->float_mask, job->sign_bit) >> offset) & mask]++] = value;
+    }
+}
+
+static void VSORT_RFN(vsort_radix_copy)(void *context, size_t index)
+{
+    const VSORT_RTYPE(vsort_radix_job) *job = (const VSORT_RTYPE(vsort_radix_job) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    if (begin < end)
+        memcpy(job->dst + begin, job->src + begin, (end - begin) * sizeof(VSORT_WORD));
+}
+
+// True when every key shares one digit for this pass, so it can be skipped.
+static bool VSORT_RFN(vsort_radix_pass_is_trivial)(const VSORT_RTYPE(vsort_radix_job) *job, size_t tasks, size_t pass)
+{
+    for (size_t bucket = 0; bucket < job->bins; ++bucket)
+    {
+        size_t total = 0;
+        for (size_t t = 0; t < tasks; ++t)
+            total += job->histograms[(t * job->passes + pass) * job->bins + bucket];
+        if (total != 0)
+            return total == job->count;
+    }
+    return true;
+}
+
+// Turns the per-task histograms of one pass into scatter offsets:
+// bucket-major, then task-major, which keeps every pass stable across blocks.
+static void VSORT_RFN(vsort_radix_prefix)(const VSORT_RTYPE(vsort_radix_job) *job, size_t tasks, size_t pass)
+{
+    size_t total = 0;
+    for (size_t bucket = 0; bucket < job->bins; ++bucket)
+    {
+        for (size_t t = 0; t < tasks; ++t)
+        {
+            size_t *slot = &job->histograms[(t * job->passes + pass) * job->bins + bucket];
+            size_t tmp = *slot;
+            *slot = total;
+            total += tmp;
+        }
+    }
+}
+
+// LSD radix engine; passes whose digit is the same for every key (typically
+// the high bytes of 64-bit timestamps and ids) are skipped entirely.
+static bool VSORT_RFN(vsort_radix_sort)(VSORT_WORD *data, size_t count, int threads, VSORT_WORD float_mask, VSORT_WORD sign_bit)
+{
+    if (count <= 1)
+        return true;
+
+    vsort_runtime_t *rt = vsort_runtime();
+    size_t tasks = threads > 1 ? vsort_parallel_slices(threads) : 1;
+    if (tasks > 1 && count / tasks < VSORT_RADIX_MIN_BLOCK)
+        tasks = VSORT_MAX((size_t)1, count / VSORT_RADIX_MIN_BLOCK);
+    int workers = (int)VSORT_MIN((size_t)VSORT_MAX(threads, 1), tasks);
+
+    unsigned int bits = (unsigned int)VSORT_CLAMP(rt->thresholds.radix_bits, VSORT_RADIX_BITS, VSORT_RADIX_MAX_BITS);
+    size_t passes = (VSORT_WIDTH + bits - 1) / bits;
+
+    VSORT_RTYPE(vsort_radix_job) job = {
+        .src = data,
+        .dst = NULL,
+        .count = count,
+        .block = (count + tasks - 1) / tasks,
+        .float_mask = float_mask,
+        .sign_bit = sign_bit,
+        .bits = bits,
+        .bins = (size_t)1 << bits,
+        .passes = passes,
+        .pass = 0,
+        .histograms = NULL};
+    tasks = (count + job.block - 1) / job.block;
+
+    job.histograms = vsort_scratch_alloc(tasks * passes * job.bins * sizeof(size_t));
+    if (!job.histograms)
+        return false;
+
+    vsort_pool_parallel_for(tasks, VSORT_RFN(vsort_radix_histogram_all), &job, workers, 0);
+
+    bool active[VSORT_RADIX_MAX_PASSES];
+    size_t active_passes = 0;
+    for (size_t pass = 0; pass < passes; ++pass)
+    {
+        active[pass] = !VSORT_RFN(vsort_radix_pass_is_trivial)(&job, tasks, pass);
+        if (active[pass])
+            active_passes++;
+    }
+
+    if (active_passes == 0)
+    {
+        vsort_scratch_free(job.histograms);
+        return true;
+    }
+
+    VSORT_WORD *buffer = (VSORT_WORD *)vsort_scratch_alloc(count * sizeof(VSORT_WORD));
+    if (!buffer)
+    {
+        vsort_scratch_free(job.histograms);
+        return false;
+    }
+
+    VSORT_WORD *input = data;
+    VSORT_WORD *output = buffer;
+    bool first = true;
+    vsort_cancel_t *cancel = vsort_cancel_current();
+
+    for (size_t pass = 0; pass < passes; ++pass)
+    {
+        if (!active[pass])
+            continue;
+        if (vsort_cancel_check(cancel))
+            break;
+
+        job.pass = pass;
+        job.src = input;
+        job.dst = output;
+
+        // Pre-pass rows describe the original block order; after the first
+        // scatter they only remain valid when a single task covers the array.
+        if (!first && tasks > 1)
+            vsort_pool_parallel_for(tasks, VSORT_RFN(vsort_radix_histogram), &job, workers, 0);
+        VSORT_RFN(vsort_radix_prefix)(&job, tasks, pass);
+        vsort_pool_parallel_for(tasks, VSORT_RFN(vsort_radix_scatter), &job, workers, 0);
+        vsort_stats_radix_pass();
+        first = false;
+
+        VSORT_WORD *swap = input;
+        input = output;
+        output = swap;
+    }
+
+    if (input != data)
+    {
+        job.src = input;
+        job.dst = data;
+        vsort_pool_parallel_for(tasks, VSORT_RFN(vsort_radix_copy), &job, workers, 0);
+    }
+
+    vsort_scratch_free(buffer);
+    vsort_scratch_free(job.histograms);
+    return true;
+}
+
+typedef struct
+{
+    VSORT_WORD *data;
+    size_t starts[VSORT_RADIX_BINS + 1];
+    VSORT_WORD float_mask;
+    VSORT_WORD sign_bit;
+    unsigned int shift;
+    unsigned int flags;
+} VSORT_RTYPE(vsort_msd_job);
+
+static void VSORT_CAT3(vsort_msd_radix, VSORT_WIDTH, _impl)(VSORT_WORD *data, size_t count, unsigned int shift,
+                                                            VSORT_WORD float_mask, VSORT_WORD sign_bit, unsigned int flags);
+
+static inline unsigned int VSORT_RFN(vsort_msd_digit)(VSORT_WORD value, unsigned int shift, VSORT_WORD float_mask,
+                                                      VSORT_WORD sign_bit)
+{
+    return (unsigned int)(VSORT_RFN(vsort_radix_key)(value, float_mask, sign_bit) >> shift) & (VSORT_RADIX_BINS - 1u);
+}
+
+// Permutes data in place so every element lands in its bucket for the digit
+// at shift (American flag sort). Fills starts[0..256] with bucket bounds.
+static void VSORT_RFN(vsort_msd_partition)(VSORT_WORD *data, size_t count, unsigned int shift, VSORT_WORD float_mask,
+                                           VSORT_WORD sign_bit, size_t *starts)
+{
+    size_t counts[VSORT_RADIX_BINS] = {0};
+    size_t heads[VSORT_RADIX_BINS];
+
+    for (size_t i = 0; i < count; ++i)
+        counts[VSORT_RFN(vsort_msd_digit)(data[i], shift, float_mask, sign_bit)]++;
+
+    size_t total = 0;
+    for (size_t b = 0; b < VSORT_RADIX_BINS; ++b)
+    {
+        starts[b] = total;
+        heads[b] = total;
+        total += counts[b];
+    }
+    starts[VSORT_RADIX_BINS] = total;
+
+    for (size_t b = 0; b < VSORT_RADIX_BINS; ++b)
+    {
+        size_t end = starts[b + 1];
+        while (heads[b] < end)
+        {
+            VSORT_WORD value = data[heads[b]];
+            unsigned int digit = VSORT_RFN(vsort_msd_digit)(value, shift, float_mask, sign_bit);
+            while (digit != b)
+            {
+                VSORT_WORD displaced = data[heads[digit]];
+                data[heads[digit]++] = value;
+                value = displaced;
+                digit = VSORT_RFN(vsort_msd_digit)(value, shift, float_mask, sign_bit);
+            }
+            data[heads[b]++] = value;
+        }
+    }
+}
+
+// Small buckets go to the signed introsort of this width, on the ordered
+// form of the words with the sign bit adjusted so their signed order is the
+// key order; NaNs and signed zeros keep the radix total order.
+static void VSORT_RFN(vsort_msd_small_bucket)(VSORT_WORD *data, size_t count, VSORT_WORD float_mask, VSORT_WORD sign_bit,
+                                              unsigned int flags)
+{
+    const VSORT_WORD adjust = sign_bit ^ ((VSORT_WORD)1 << (VSORT_WIDTH - 1));
+    if (float_mask || adjust)
+    {
+        for (size_t i = 0; i < count; ++i)
+            data[i] = VSORT_RFN(vsort_radix_ordered)(data[i], float_mask) ^ adjust;
+    }
+
+    VSORT_RFN(vsort_radix_signed_sort)(data, count, flags);
+
+    if (float_mask || adjust)
+    {
+        for (size_t i = 0; i < count; ++i)
+            data[i] = VSORT_RFN(vsort_radix_ordered)(data[i] ^ adjust, float_mask);
+    }
+}
+
+static void VSORT_CAT3(vsort_msd_radix, VSORT_WIDTH, _impl)(VSORT_WORD *data, size_t count, unsigned int shift,
+                                                            VSORT_WORD float_mask, VSORT_WORD sign_bit, unsigned int flags)
+{
+    if (count <= VSORT_MSD_CUTOFF)
+    {
+        VSORT_RFN(vsort_msd_small_bucket)(data, count, float_mask, sign_bit, flags);
+        return;
+    }
+
+    size_t starts[VSORT_RADIX_BINS + 1];
+    VSORT_RFN(vsort_msd_partition)(data, count, shift, float_mask, sign_bit, starts);
+    if (shift == 0)
+        return;
+
+    for (size_t b = 0; b < VSORT_RADIX_BINS; ++b)
+    {
+        size_t local = starts[b + 1] - starts[b];
+        if (local > 1)
+            VSORT_CAT3(vsort_msd_radix, VSORT_WIDTH, _impl)(data + starts[b], local, shift - VSORT_RADIX_BITS, float_mask,
+                                                            sign_bit, flags);
+    }
+}
+
+static void VSORT_RFN(vsort_msd_bucket)(void *context, size_t index)
+{
+    const VSORT_RTYPE(vsort_msd_job) *job = (const VSORT_RTYPE(vsort_msd_job) *)context;
+    size_t local = job->starts[index + 1] - job->starts[index];
+    if (local > 1)
+        VSORT_CAT3(vsort_msd_radix, VSORT_WIDTH, _impl)(job->data + job->starts[index], local, job->shift - VSORT_RADIX_BITS,
+                                                        job->float_mask, job->sign_bit, job->flags);
+}
+
+// In-place MSD radix sort: O(1) scratch besides the recursion stack. The
+// top-level buckets are independent and are sorted on the worker pool.
+static void VSORT_RFN(vsort_msd_radix)(VSORT_WORD *data, size_t count, int threads, VSORT_WORD float_mask, VSORT_WORD sign_bit,
+                                       unsigned int flags)
+{
+    if (count <= VSORT_MSD_CUTOFF || threads <= 1)
+    {
+        VSORT_CAT3(vsort_msd_radix, VSORT_WIDTH, _impl)(data, count, VSORT_WIDTH - VSORT_RADIX_BITS, float_mask, sign_bit, flags);
+        return;
+    }
+
+    VSORT_RTYPE(vsort_msd_job) job = {
+        .data = data,
+        .float_mask = float_mask,
+        .sign_bit = sign_bit,
+        .shift = VSORT_WIDTH - VSORT_RADIX_BITS,
+        .flags = flags};
+    VSORT_RFN(vsort_msd_partition)(data, count, job.shift, float_mask, sign_bit, job.starts);
+    vsort_pool_parallel_for(VSORT_RADIX_BINS, VSORT_RFN(vsort_msd_bucket), &job, threads, flags);
+}
+
+#undef VSORT_RFN
+#undef VSORT_RTYPE
+#undef VSORT_WORD
+#undef VSORT_SWORD
+#undef VSORT_WIDTH
@@ -0,0 +1,500 @@
+/**
+ * Implementation of VSort scratch cache
+ *
+ * Engine scratch is rounded up to one of four size classes per power of two
+ * (at most 25% slack). A released block goes to the releasing thread's cache
+ * of VSORT_CACHE_THREAD_BLOCKS recent blocks; the oldest block a full cache
+ * evicts, and everything a thread still holds when it exits, is handed to a
+ * shared depot of VSORT_CACHE_DEPOT_SLOTS atomic slots per class, where any
+ * thread can pick it up with a single exchange. Blocks are never zeroed, so
+ * their pages are first touched, and placed on a NUMA node, by whichever
+ * worker writes them first; a thread that keeps its blocks keeps them local.
+ *
+ * The bytes held by all caches are bounded by a high-water mark: a release
+ * that would exceed it frees the block instead. With an idle time set,
+ * blocks cached longer than that are freed lazily by the next scratch call
+ * of their thread (or of any thread, for the depot).
+ */
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vsort.h"
+#include "vsort_logger.h"
+#include "vsort_scratch.h"
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VSORT_THREAD_LOCAL __declspec(thread)
+#else
+#define VSORT_THREAD_LOCAL _Thread_local
+#endif
+
+#define VSORT_CACHE_ALIGN 64
+#define VSORT_CACHE_MIN_SHIFT 12  // Smallest class: 4 KiB
+#define VSORT_CACHE_MAX_SHIFT 47  // Larger requests bypass the cache
+#define VSORT_CACHE_CLASSES (1 + 4 * (VSORT_CACHE_MAX_SHIFT - VSORT_CACHE_MIN_SHIFT + 1))
+#define VSORT_CACHE_UNCACHED ((size_t)-1)
+#define VSORT_CACHE_THREAD_BLOCKS 4
+#define VSORT_CACHE_DEPOT_SLOTS 4
+#define VSORT_CACHE_DEFAULT_LIMIT ((size_t)64 << 20)
+
+typedef struct
+{
+    size_t size;       /**< Usable bytes (the class size) */
+    size_t index;      /**< Size class, VSORT_CACHE_UNCACHED for oversized blocks */
+    uint64_t released; /**< Milliseconds timestamp of the last release */
+} vsort_cache_block_t;
+
+#define VSORT_CACHE_HEADER VSORT_CACHE_ALIGN
+
+typedef struct
+{
+    vsort_cache_block_t *blocks[VSORT_CACHE_THREAD_BLOCKS]; /**< Oldest first */
+    size_t count;
+    uint64_t last_trim;
+    bool registered; /**< Thread-exit hook installed for this thread */
+} vsort_cache_thread_t;
+
+static VSORT_THREAD_LOCAL vsort_cache_thread_t t_cache;
+
+// -----------------------------------------------------------------------------
+// Platform helpers
+// -----------------------------------------------------------------------------
+
+#if defined(_WIN32) || defined(_MSC_VER)
+typedef PVOID volatile vsort_cache_slot_t;
+
+static vsort_cache_slot_t g_depot[VSORT_CACHE_CLASSES][VSORT_CACHE_DEPOT_SLOTS];
+static volatile LONG64 g_cached_bytes = 0;
+static volatile LONG64 g_cache_limit = (LONG64)VSORT_CACHE_DEFAULT_LIMIT;
+static volatile LONG g_cache_idle_ms = 0;
+static DWORD g_cache_fls = FLS_OUT_OF_INDEXES;
+
+static vsort_cache_block_t *vsort_slot_take(vsort_cache_slot_t *slot)
+{
+    return (vsort_cache_block_t *)InterlockedExchangePointer(slot, NULL);
+}
+
+static bool vsort_slot_put(vsort_cache_slot_t *slot, vsort_cache_block_t *block)
+{
+    return InterlockedCompareExchangePointer(slot, block, NULL) == NULL;
+}
+
+static bool vsort_slot_peek(vsort_cache_slot_t *slot)
+{
+    return *slot != NULL;
+}
+
+static size_t vsort_cached_bytes(void)
+{
+    return (size_t)InterlockedCompareExchange64(&g_cached_bytes, 0, 0);
+}
+
+static bool vsort_cached_add(size_t bytes, size_t limit)
+{
+    LONG64 current = InterlockedCompareExchange64(&g_cached_bytes, 0, 0);
+    while ((size_t)current + bytes <= limit)
+    {
+        LONG64 seen = InterlockedCompareExchange64(&g_cached_bytes, current + (LONG64)bytes, current);
+        if (seen == current)
+            return true;
+        current = seen;
+    }
+    return false;
+}
+
+static void vsort_cached_sub(size_t bytes)
+{
+    InterlockedExchangeAdd64(&g_cached_bytes, -(LONG64)bytes);
+}
+
+static size_t vsort_cache_limit(void)
+{
+    return (size_t)InterlockedCompareExchange64(&g_cache_limit, 0, 0);
+}
+
+static unsigned int vsort_cache_idle_ms(void)
+{
+    return (unsigned int)InterlockedCompareExchange(&g_cache_idle_ms, 0, 0);
+}
+
+static uint64_t vsort_cache_now_ms(void)
+{
+    return (uint64_t)GetTickCount64();
+}
+
+static void *vsort_cache_malloc(size_t bytes)
+{
+    return _aligned_malloc(bytes, VSORT_CACHE_ALIGN);
+}
+
+static void vsort_cache_free(void *ptr)
+{
+    _aligned_free(ptr);
+}
+#else
+typedef _Atomic(vsort_cache_block_t *) vsort_cache_slot_t;
+
+static vsort_cache_slot_t g_depot[VSORT_CACHE_CLASSES][VSORT_CACHE_DEPOT_SLOTS];
+static atomic_size_t g_cached_bytes = ATOMIC_VAR_INIT(0);
+static atomic_size_t g_cache_limit = ATOMIC_VAR_INIT(VSORT_CACHE_DEFAULT_LIMIT);
+static atomic_uint g_cache_idle_ms = ATOMIC_VAR_INIT(0);
+static pthread_key_t g_cache_key;
+static bool g_cache_key_ready = false;
+
+static vsort_cache_block_t *vsort_slot_take(vsort_cache_slot_t *slot)
+{
+    return atomic_exchange(slot, NULL);
+}
+
+static bool vsort_slot_put(vsort_cache_slot_t *slot, vsort_cache_block_t *block)
+{
+    vsort_cache_block_t *expected = NULL;
+    return atomic_compare_exchange_strong(slot, &expected, block);
+}
+
+static bool vsort_slot_peek(vsort_cache_slot_t *slot)
+{
+    return atomic_load_explicit(slot, memory_order_relaxed) != NULL;
+}
+
+static size_t vsort_cached_bytes(void)
+{
+    return atomic_load(&g_cached_bytes);
+}
+
+static bool vsort_cached_add(size_t bytes, size_t limit)
+{
+    size_t current = atomic_load(&g_cached_bytes);
+    while (current + bytes <= limit)
+    {
+        if (atomic_compare_exchange_weak(&g_cached_bytes, &current, current + bytes))
+            return true;
+    }
+    return false;
+}
+
+static void vsort_cached_sub(size_t bytes)
+{
+    atomic_fetch_sub(&g_cached_bytes, bytes);
+}
+
+static size_t vsort_cache_limit(void)
+{
+    return atomic_load_explicit(&g_cache_limit, memory_order_relaxed);
+}
+
+static unsigned int vsort_cache_idle_ms(void)
+{
+    return atomic_load_explicit(&g_cache_idle_ms, memory_order_relaxed);
+}
+
+static uint64_t vsort_cache_now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000u + (uint64_t)now.tv_nsec / 1000000u;
+}
+
+static void *vsort_cache_malloc(size_t bytes)
+{
+    void *ptr = NULL;
+    return posix_memalign(&ptr, VSORT_CACHE_ALIGN, bytes) == 0 ? ptr : NULL;
+}
+
+static void vsort_cache_free(void *ptr)
+{
+    free(ptr);
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Size classes
+// -----------------------------------------------------------------------------
+
+static unsigned int vsort_cache_log2(size_t value)
+{
+    unsigned int shift = 0;
+    while (value >>= 1)
+        shift++;
+    return shift;
+}
+
+// Class size for bytes (written to *size); VSORT_CACHE_UNCACHED when too large.
+static size_t vsort_cache_class(size_t bytes, size_t *size)
+{
+    if (bytes <= ((size_t)1 << VSORT_CACHE_MIN_SHIFT))
+    {
+        *size = (size_t)1 << VSORT_CACHE_MIN_SHIFT;
+        return 0;
+    }
+
+    size_t value = bytes - 1;
+    unsigned int shift = vsort_cache_log2(value);
+    if (shift > VSORT_CACHE_MAX_SHIFT)
+    {
+        *size = bytes;
+        return VSORT_CACHE_UNCACHED;
+    }
+
+    // value lies in [4, 8) steps of 2^(shift-2); the two bits below the top
+    // pick the quarter.
+    size_t step = (size_t)1 << (shift - 2);
+    size_t quarter = (value >> (shift - 2)) & 3u;
+    *size = (5 + quarter) * step;
+    return 1 + (size_t)(shift - VSORT_CACHE_MIN_SHIFT) * 4 + quarter;
+}
+
+// -----------------------------------------------------------------------------
+// Caches
+// -----------------------------------------------------------------------------
+
+static void vsort_cache_destroy(vsort_cache_block_t *block)
+{
+    vsort_cache_free(block);
+}
+
+// Hands a cached block (already counted) to the depot, or frees it.
+static void vsort_cache_to_depot(vsort_cache_block_t *block)
+{
+    for (size_t slot = 0; slot < VSORT_CACHE_DEPOT_SLOTS; ++slot)
+    {
+        if (vsort_slot_put(&g_depot[block->index][slot], block))
+            return;
+    }
+    vsort_cached_sub(block->size);
+    vsort_cache_destroy(block);
+}
+
+static void vsort_cache_thread_flush(vsort_cache_thread_t *cache, bool to_depot)
+{
+    for (size_t i = 0; i < cache->count; ++i)
+    {
+        if (to_depot)
+            vsort_cache_to_depot(cache->blocks[i]);
+        else
+        {
+            vsort_cached_sub(cache->blocks[i]->size);
+            vsort_cache_destroy(cache->blocks[i]);
+        }
+    }
+    cache->count = 0;
+}
+
+#if defined(_WIN32) || defined(_MSC_VER)
+static void WINAPI vsort_cache_thread_exit(PVOID value)
+{
+    if (value)
+        vsort_cache_thread_flush((vsort_cache_thread_t *)value, true);
+}
+
+static void vsort_cache_register_thread(vsort_cache_thread_t *cache)
+{
+    if (g_cache_fls != FLS_OUT_OF_INDEXES && FlsSetValue(g_cache_fls, cache))
+        cache->registered = true;
+}
+#else
+static void vsort_cache_thread_exit(void *value)
+{
+    if (value)
+        vsort_cache_thread_flush((vsort_cache_thread_t *)value, true);
+}
+
+static void vsort_cache_register_thread(vsort_cache_thread_t *cache)
+{
+    if (g_cache_key_ready && pthread_setspecific(g_cache_key, cache) == 0)
+        cache->registered = true;
+}
+#endif
+
+// Frees blocks idle for idle_ms or more, at most about twice per idle period.
+static void vsort_cache_trim_idle(vsort_cache_thread_t *cache)
+{
+    unsigned int idle_ms = vsort_cache_idle_ms();
+    if (idle_ms == 0)
+        return;
+
+    uint64_t now = vsort_cache_now_ms();
+    if (now - cache->last_trim < (uint64_t)(idle_ms / 2 + 1))
+        return;
+    cache->last_trim = now;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < cache->count; ++i)
+    {
+        vsort_cache_block_t *block = cache->blocks[i];
+        if (now - block->released >= idle_ms)
+        {
+            vsort_cached_sub(block->size);
+            vsort_cache_destroy(block);
+        }
+        else
+            cache->blocks[kept++] = block;
+    }
+    cache->count = kept;
+
+    for (size_t index = 0; index < VSORT_CACHE_CLASSES; ++index)
+    {
+        for (size_t slot = 0; slot < VSORT_CACHE_DEPOT_SLOTS; ++slot)
+        {
+            if (!vsort_slot_peek(&g_depot[index][slot]))
+                continue;
+            vsort_cache_block_t *block = vsort_slot_take(&g_depot[index][slot]);
+            if (!block)
+                continue;
+            if (now - block->released < idle_ms && vsort_slot_put(&g_depot[index][slot], block))
+                continue;
+            vsort_cached_sub(block->size);
+            vsort_cache_destroy(block);
+        }
+    }
+}
+
+void *vsort_scratch_cache_acquire(size_t bytes)
+{
+    if (bytes == 0 || bytes > SIZE_MAX - VSORT_CACHE_HEADER)
+        return NULL;
+
+    vsort_cache_thread_t *cache = &t_cache;
+    vsort_cache_trim_idle(cache);
+
+    size_t size;
+    size_t index = vsort_cache_class(bytes, &size);
+    vsort_cache_block_t *block = NULL;
+    if (index != VSORT_CACHE_UNCACHED)
+    {
+        // Most recent first: it is the likeliest to still be in cache.
+        for (size_t i = cache->count; i-- > 0;)
+        {
+            if (cache->blocks[i]->index == index)
+            {
+                block = cache->blocks[i];
+                memmove(&cache->blocks[i], &cache->blocks[i + 1], (cache->count - i - 1) * sizeof(block));
+                cache->count--;
+                break;
+            }
+        }
+        for (size_t slot = 0; !block && slot < VSORT_CACHE_DEPOT_SLOTS; ++slot)
+        {
+            if (vsort_slot_peek(&g_depot[index][slot]))
+                block = vsort_slot_take(&g_depot[index][slot]);
+        }
+        if (block)
+        {
+            vsort_cached_sub(block->size);
+            return (unsigned char *)block + VSORT_CACHE_HEADER;
+        }
+    }
+
+    block = (vsort_cache_block_t *)vsort_cache_malloc(VSORT_CACHE_HEADER + size);
+    if (!block)
+    {
+        vsort_log_error("Failed to allocate %zu bytes of scratch memory.", size);
+        return NULL;
+    }
+    block->size = size;
+    block->index = index;
+    block->released = 0;
+    return (unsigned char *)block + VSORT_CACHE_HEADER;
+}
+
+void vsort_scratch_cache_release(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    vsort_cache_block_t *block = (vsort_cache_block_t *)((unsigned char *)ptr - VSORT_CACHE_HEADER);
+    if (block->index == VSORT_CACHE_UNCACHED || !vsort_cached_add(block->size, vsort_cache_limit()))
+    {
+        vsort_cache_destroy(block);
+        return;
+    }
+
+    vsort_cache_thread_t *cache = &t_cache;
+    if (!cache->registered)
+        vsort_cache_register_thread(cache);
+    block->released = vsort_cache_idle_ms() ? vsort_cache_now_ms() : 0;
+
+    if (cache->count == VSORT_CACHE_THREAD_BLOCKS)
+    {
+        vsort_cache_to_depot(cache->blocks[0]);
+        memmove(&cache->blocks[0], &cache->blocks[1], (VSORT_CACHE_THREAD_BLOCKS - 1) * sizeof(block));
+        cache->count--;
+    }
+    cache->blocks[cache->count++] = block;
+    vsort_cache_trim_idle(cache);
+}
+
+void vsort_scratch_cache_init(void)
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    g_cache_fls = FlsAlloc(vsort_cache_thread_exit);
+#else
+    g_cache_key_ready = pthread_key_create(&g_cache_key, vsort_cache_thread_exit) == 0;
+#endif
+}
+
+void vsort_scratch_cache_shutdown(void)
+{
+    vsort_scratch_cache_trim();
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+VSORT_API void vsort_set_scratch_cache_limit(size_t bytes)
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    InterlockedExchange64(&g_cache_limit, bytes > (size_t)INT64_MAX ? INT64_MAX : (LONG64)bytes);
+#else
+    atomic_store(&g_cache_limit, bytes);
+#endif
+}
+
+VSORT_API void vsort_set_scratch_cache_idle_ms(unsigned int milliseconds)
+{
+#if defined(_WIN32) || defined(_MSC_VER)
+    InterlockedExchange(&g_cache_idle_ms, (LONG)milliseconds);
+#else
+    atomic_store(&g_cache_idle_ms, milliseconds);
+#endif
+}
+
+VSORT_API size_t vsort_scratch_cache_bytes(void)
+{
+    return vsort_cached_bytes();
+}
+
+VSORT_API void vsort_scratch_cache_trim(void)
+{
+    vsort_cache_thread_flush(&t_cache, false);
+    for (size_t index = 0; index < VSORT_CACHE_CLASSES; ++index)
+    {
+        for (size_t slot = 0; slot < VSORT_CACHE_DEPOT_SLOTS; ++slot)
+        {
+            vsort_cache_block_t *block = vsort_slot_take(&g_depot[index][slot]);
+            if (block)
+            {
+                vsort_cached_sub(block->size);
+                vsort_cache_destroy(block);
+            }
+        }
+    }
+}
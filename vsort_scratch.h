@@ -0,0 +1,40 @@
+/**
+ * Scratch cache for VSort library
+ *
+ * Size-classed cache of engine scratch blocks for sorts that run without a
+ * vsort_context_t: a few recently released blocks per thread, backed by a
+ * lock-free shared depot, bounded by a byte limit and an optional idle time.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#ifndef VSORT_SCRATCH_H
+#define VSORT_SCRATCH_H
+
+#include <stddef.h>
+#include "vsort.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block of at least bytes, aligned to 64 bytes; NULL for 0 bytes or when
+// out of memory. Contents are undefined (never pre-touched).
+void *vsort_scratch_cache_acquire(size_t bytes);
+
+// Return a block from vsort_scratch_cache_acquire (NULL is ignored). Any
+// thread may release any block.
+void vsort_scratch_cache_release(void *ptr);
+
+// Thread-exit hook registration (called once by vsort_init)
+void vsort_scratch_cache_init(void);
+
+// Free every cached block reachable from this thread (registered with atexit by vsort_init)
+void vsort_scratch_cache_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VSORT_SCRATCH_H */
@@ -0,0 +1,231 @@
+/**
+ * Implementation of VSort sort telemetry
+ *
+ * vsort_sort_with_stats binds a collector to the calling thread; the engine
+ * selection in vsort.c and the templates reports the engine, fallbacks,
+ * passes and scratch requests to it and times its phases. Pool tasks run on
+ * other threads and report nothing, so phases are timed around whole
+ * parallel passes. The process-wide counters are relaxed atomics that
+ * finished calls add to while they are enabled.
+ */
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include "vsort.h"
+#include "vsort_stats.h"
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <stdatomic.h>
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VSORT_THREAD_LOCAL __declspec(thread)
+#else
+#define VSORT_THREAD_LOCAL _Thread_local
+#endif
+
+// Counter slots, in the field order of vsort_counters_t.
+enum
+{
+    VSORT_COUNTER_CALLS = 0,
+    VSORT_COUNTER_ELEMENTS,
+    VSORT_COUNTER_ENGINES,
+    VSORT_COUNTER_FALLBACKS = VSORT_COUNTER_ENGINES + VSORT_ENGINE_COUNT,
+    VSORT_COUNTER_MERGE_PASSES = VSORT_COUNTER_FALLBACKS + VSORT_FALLBACK_COUNT,
+    VSORT_COUNTER_RADIX_PASSES,
+    VSORT_COUNTER_BYTES,
+    VSORT_COUNTER_TOTAL_NS,
+    VSORT_COUNTER_PHASES,
+    VSORT_COUNTER_SLOTS = VSORT_COUNTER_PHASES + VSORT_PHASE_COUNT
+};
+
+static VSORT_THREAD_LOCAL vsort_stats_collector_t *t_collector = NULL;
+
+#if defined(_WIN32) || defined(_MSC_VER)
+static volatile LONG64 g_counters[VSORT_COUNTER_SLOTS];
+static volatile LONG g_counters_enabled = 0;
+
+static void vsort_counter_add(size_t slot, uint64_t value)
+{
+    if (value)
+        InterlockedExchangeAdd64(&g_counters[slot], (LONG64)value);
+}
+
+static uint64_t vsort_counter_load(size_t slot)
+{
+    return (uint64_t)InterlockedCompareExchange64(&g_counters[slot], 0, 0);
+}
+
+static void vsort_counter_clear(size_t slot)
+{
+    InterlockedExchange64(&g_counters[slot], 0);
+}
+
+uint64_t vsort_stats_clock_ns(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    uint64_t ticks = (uint64_t)now.QuadPart;
+    uint64_t hz = (uint64_t)frequency.QuadPart;
+    return ticks / hz * 1000000000u + ticks % hz * 1000000000u / hz;
+}
+
+VSORT_API void vsort_set_counters_enabled(int enabled)
+{
+    InterlockedExchange(&g_counters_enabled, enabled ? 1 : 0);
+}
+
+VSORT_API int vsort_counters_enabled(void)
+{
+    return g_counters_enabled != 0;
+}
+#else
+static _Atomic uint64_t g_counters[VSORT_COUNTER_SLOTS];
+static atomic_int g_counters_enabled = ATOMIC_VAR_INIT(0);
+
+static void vsort_counter_add(size_t slot, uint64_t value)
+{
+    if (value)
+        atomic_fetch_add_explicit(&g_counters[slot], value, memory_order_relaxed);
+}
+
+static uint64_t vsort_counter_load(size_t slot)
+{
+    return atomic_load_explicit(&g_counters[slot], memory_order_relaxed);
+}
+
+static void vsort_counter_clear(size_t slot)
+{
+    atomic_store_explicit(&g_counters[slot], 0, memory_order_relaxed);
+}
+
+uint64_t vsort_stats_clock_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+VSORT_API void vsort_set_counters_enabled(int enabled)
+{
+    atomic_store_explicit(&g_counters_enabled, enabled ? 1 : 0, memory_order_relaxed);
+}
+
+VSORT_API int vsort_counters_enabled(void)
+{
+    return atomic_load_explicit(&g_counters_enabled, memory_order_relaxed);
+}
+#endif
+
+vsort_stats_collector_t *vsort_stats_bind(vsort_stats_collector_t *collector)
+{
+    vsort_stats_collector_t *previous = t_collector;
+    t_collector = collector;
+    return previous;
+}
+
+bool vsort_stats_active(void)
+{
+    return t_collector != NULL;
+}
+
+void vsort_stats_engine(vsort_engine_t engine, int threads)
+{
+    vsort_stats_collector_t *collector = t_collector;
+    if (!collector)
+        return;
+    collector->stats.engine = engine;
+    collector->stats.threads = threads;
+}
+
+void vsort_stats_fallback(unsigned int fallback)
+{
+    if (t_collector)
+        t_collector->stats.fallbacks |= fallback;
+}
+
+uint64_t vsort_stats_phase_begin(void)
+{
+    vsort_stats_collector_t *collector = t_collector;
+    if (!collector || collector->timing)
+        return 0;
+    collector->timing = true;
+    return vsort_stats_clock_ns() | 1u;
+}
+
+void vsort_stats_phase_end(vsort_phase_t phase, uint64_t token)
+{
+    vsort_stats_collector_t *collector = t_collector;
+    if (!collector || token == 0)
+        return;
+    collector->stats.phase_ns[phase] += vsort_stats_clock_ns() - (token & ~(uint64_t)1u);
+    collector->timing = false;
+}
+
+void vsort_stats_merge_pass(void)
+{
+    if (t_collector)
+        t_collector->stats.merge_passes++;
+}
+
+void vsort_stats_radix_pass(void)
+{
+    if (t_collector)
+        t_collector->stats.radix_passes++;
+}
+
+void vsort_stats_allocated(size_t bytes)
+{
+    if (t_collector)
+        t_collector->stats.bytes_allocated += bytes;
+}
+
+void vsort_counters_add(const vsort_stats_t *stats)
+{
+    vsort_counter_add(VSORT_COUNTER_CALLS, 1);
+    vsort_counter_add(VSORT_COUNTER_ELEMENTS, stats->length);
+    vsort_counter_add(VSORT_COUNTER_ENGINES + (size_t)stats->engine, 1);
+    for (size_t i = 0; i < VSORT_FALLBACK_COUNT; ++i)
+        vsort_counter_add(VSORT_COUNTER_FALLBACKS + i, (stats->fallbacks >> i) & 1u);
+    vsort_counter_add(VSORT_COUNTER_MERGE_PASSES, stats->merge_passes);
+    vsort_counter_add(VSORT_COUNTER_RADIX_PASSES, stats->radix_passes);
+    vsort_counter_add(VSORT_COUNTER_BYTES, stats->bytes_allocated);
+    vsort_counter_add(VSORT_COUNTER_TOTAL_NS, stats->total_ns);
+    for (size_t i = 0; i < VSORT_PHASE_COUNT; ++i)
+        vsort_counter_add(VSORT_COUNTER_PHASES + i, stats->phase_ns[i]);
+}
+
+VSORT_API void vsort_counters_read(vsort_counters_t *counters)
+{
+    if (!counters)
+        return;
+
+    counters->calls = vsort_counter_load(VSORT_COUNTER_CALLS);
+    counters->elements = vsort_counter_load(VSORT_COUNTER_ELEMENTS);
+    for (size_t i = 0; i < VSORT_ENGINE_COUNT; ++i)
+        counters->engine_calls[i] = vsort_counter_load(VSORT_COUNTER_ENGINES + i);
+    for (size_t i = 0; i < VSORT_FALLBACK_COUNT; ++i)
+        counters->fallbacks[i] = vsort_counter_load(VSORT_COUNTER_FALLBACKS + i);
+    counters->merge_passes = vsort_counter_load(VSORT_COUNTER_MERGE_PASSES);
+    counters->radix_passes = vsort_counter_load(VSORT_COUNTER_RADIX_PASSES);
+    counters->bytes_allocated = vsort_counter_load(VSORT_COUNTER_BYTES);
+    counters->total_ns = vsort_counter_load(VSORT_COUNTER_TOTAL_NS);
+    for (size_t i = 0; i < VSORT_PHASE_COUNT; ++i)
+        counters->phase_ns[i] = vsort_counter_load(VSORT_COUNTER_PHASES + i);
+}
+
+VSORT_API void vsort_counters_reset(void)
+{
+    for (size_t slot = 0; slot < VSORT_COUNTER_SLOTS; ++slot)
+        vsort_counter_clear(slot);
+}
@@ -0,0 +1,62 @@
+/**
+ * Sort telemetry for VSort library
+ *
+ * Per-call statistics of vsort_sort_with_stats and the process-wide
+ * counters. A collector is bound to the calling thread for the duration of
+ * one call; the engines report to it through the helpers below, which do
+ * nothing (one thread-local load) when no collector is bound.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#ifndef VSORT_STATS_H
+#define VSORT_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vsort.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    vsort_stats_t stats;
+    bool timing; /**< A phase is being timed; nested phases are not */
+} vsort_stats_collector_t;
+
+// Bind collector to the calling thread (NULL unbinds); returns the previous one.
+vsort_stats_collector_t *vsort_stats_bind(vsort_stats_collector_t *collector);
+
+// Whether a collector is bound to the calling thread.
+bool vsort_stats_active(void);
+
+// Monotonic clock in nanoseconds.
+uint64_t vsort_stats_clock_ns(void);
+
+// Engine that produced the result; a later call (a fallback) replaces it.
+void vsort_stats_engine(vsort_engine_t engine, int threads);
+
+// Record a VSORT_FALLBACK_* bit.
+void vsort_stats_fallback(unsigned int fallback);
+
+// Start timing a phase: a token for vsort_stats_phase_end, 0 when no
+// collector is bound or an enclosing phase is already being timed.
+uint64_t vsort_stats_phase_begin(void);
+void vsort_stats_phase_end(vsort_phase_t phase, uint64_t token);
+
+void vsort_stats_merge_pass(void);
+void vsort_stats_radix_pass(void);
+void vsort_stats_allocated(size_t bytes);
+
+// Add one finished call to the process-wide counters.
+void vsort_counters_add(const vsort_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VSORT_STATS_H */
@@ -0,0 +1,297 @@
+/**
+ * Implementation of VSort streaming sort
+ *
+ * Pushed batches are staged, sorted into runs as the stage fills, and the
+ * runs are merged log-structured: once VSORT_STREAM_FAN_IN runs of one level
+ * accumulate they become a single run of the next level. Finalizing merges
+ * whatever is left, a few runs per level, straight into the caller's buffer.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vsort.h"
+#include "vsort_logger.h"
+#include "vsort_merge.h"
+
+#define VSORT_STREAM_STAGE 65536 // Elements staged before they are sorted into a run
+#define VSORT_STREAM_FAN_IN 8    // Runs of one level merged into the next
+
+typedef struct
+{
+    unsigned char *data;
+    size_t length;
+    unsigned int level; /**< Merges this run's elements have been through */
+} vsort_stream_run_t;
+
+struct vsort_stream
+{
+    vsort_data_kind_t kind;
+    size_t element_size;
+    unsigned int flags;
+    unsigned char *stage; /**< Unsorted tail, VSORT_STREAM_STAGE elements */
+    size_t staged;
+    vsort_stream_run_t *runs; /**< Oldest first, levels non-increasing */
+    size_t run_count;
+    size_t run_capacity;
+    size_t length; /**< Elements pushed since the last finalize */
+};
+
+static void vsort_stream_release_runs(vsort_stream_t *stream)
+{
+    for (size_t i = 0; i < stream->run_count; ++i)
+        free(stream->runs[i].data);
+    stream->run_count = 0;
+}
+
+static vsort_result_t vsort_stream_sort(const vsort_stream_t *stream, void *data, size_t length)
+{
+    vsort_options_t options = {
+        .data = data,
+        .length = length,
+        .element_size = stream->element_size,
+        .kind = stream->kind,
+        .comparator = NULL,
+        .flags = stream->flags};
+    return vsort_sort(&options);
+}
+
+// Merges runs[first, run_count) into one run that replaces them.
+static vsort_result_t vsort_stream_merge_tail(vsort_stream_t *stream, size_t first, unsigned int level)
+{
+    size_t count = stream->run_count - first;
+    vsort_sorted_run_t sorted[VSORT_STREAM_FAN_IN];
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        sorted[i].data = stream->runs[first + i].data;
+        sorted[i].length = stream->runs[first + i].length;
+        length += sorted[i].length;
+    }
+
+    unsigned char *data = (unsigned char *)malloc(length * stream->element_size);
+    if (!data)
+        return VSORT_ERR_ALLOCATION_FAILED;
+
+    vsort_merge_options_t options = {
+        .runs = sorted,
+        .run_count = count,
+        .output = data,
+        .kind = stream->kind,
+        .flags = stream->flags};
+    vsort_result_t result = vsort_merge_runs(&options);
+    if (result != VSORT_OK)
+    {
+        free(data);
+        return result;
+    }
+
+    for (size_t i = first; i < stream->run_count; ++i)
+        free(stream->runs[i].data);
+    stream->runs[first].data = data;
+    stream->runs[first].length = length;
+    stream->runs[first].level = level;
+    stream->run_count = first + 1;
+    return VSORT_OK;
+}
+
+// Room for one more run, taken before a run is built so that appending it
+// cannot fail.
+static bool vsort_stream_reserve_run(vsort_stream_t *stream)
+{
+    if (stream->run_count < stream->run_capacity)
+        return true;
+
+    size_t capacity = stream->run_capacity ? stream->run_capacity * 2 : 16;
+    vsort_stream_run_t *runs = (vsort_stream_run_t *)realloc(stream->runs, capacity * sizeof(vsort_stream_run_t));
+    if (!runs)
+        return false;
+    stream->runs = runs;
+    stream->run_capacity = capacity;
+    return true;
+}
+
+// Appends a sorted run the stream now owns (space reserved), then cascades
+// full levels. A failed merge leaves the runs unmerged but intact.
+static vsort_result_t vsort_stream_add_run(vsort_stream_t *stream, unsigned char *data, size_t length)
+{
+    vsort_stream_run_t run = {.data = data, .length = length, .level = 0};
+    stream->runs[stream->run_count++] = run;
+
+    // Levels never increase towards the tail, so a full level is always the
+    // last VSORT_STREAM_FAN_IN runs.
+    while (stream->run_count >= VSORT_STREAM_FAN_IN)
+    {
+        size_t first = stream->run_count - VSORT_STREAM_FAN_IN;
+        unsigned int level = stream->runs[stream->run_count - 1].level;
+        if (stream->runs[first].level != level)
+            break;
+        vsort_result_t result = vsort_stream_merge_tail(stream, first, level + 1);
+        if (result != VSORT_OK)
+            return result;
+    }
+    return VSORT_OK;
+}
+
+// Sorts the staged elements into a run.
+static vsort_result_t vsort_stream_flush(vsort_stream_t *stream)
+{
+    if (stream->staged == 0)
+        return VSORT_OK;
+    if (!vsort_stream_reserve_run(stream))
+        return VSORT_ERR_ALLOCATION_FAILED;
+
+    unsigned char *data = stream->stage;
+    size_t length = stream->staged;
+    vsort_result_t result = vsort_stream_sort(stream, data, length);
+    if (result != VSORT_OK)
+        return result;
+
+    // The run keeps the stage buffer; a new one is allocated on demand.
+    stream->stage = NULL;
+    stream->staged = 0;
+    return vsort_stream_add_run(stream, data, length);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+VSORT_API vsort_result_t vsort_stream_create(vsort_stream_t **stream, vsort_data_kind_t kind, unsigned int flags)
+{
+    if (!stream)
+        return VSORT_ERR_INVALID_ARGUMENT;
+    *stream = NULL;
+
+    size_t element_size = vsort_merge_element_size(kind);
+    if (element_size == 0)
+        return VSORT_ERR_UNSUPPORTED_TYPE;
+
+    vsort_stream_t *created = (vsort_stream_t *)calloc(1, sizeof(vsort_stream_t));
+    if (!created)
+        return VSORT_ERR_ALLOCATION_FAILED;
+
+    vsort_init();
+    created->kind = kind;
+    created->element_size = element_size;
+    created->flags = flags;
+    *stream = created;
+    return VSORT_OK;
+}
+
+VSORT_API vsort_result_t vsort_stream_push(vsort_stream_t *stream, const void *data, size_t length)
+{
+    if (!stream || (!data && length > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+    if (length > SIZE_MAX / stream->element_size - stream->length)
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    const size_t element_size = stream->element_size;
+    const unsigned char *src = (const unsigned char *)data;
+
+    // Batches of at least a stage become runs of their own; the stage is
+    // flushed first so runs stay in push order.
+    if (length >= VSORT_STREAM_STAGE)
+    {
+        vsort_result_t result = vsort_stream_flush(stream);
+        if (result != VSORT_OK)
+            return result;
+        unsigned char *copy = vsort_stream_reserve_run(stream) ? (unsigned char *)malloc(length * element_size) : NULL;
+        if (!copy)
+            return VSORT_ERR_ALLOCATION_FAILED;
+
+        memcpy(copy, src, length * element_size);
+        result = vsort_stream_sort(stream, copy, length);
+        if (result != VSORT_OK)
+        {
+            free(copy);
+            return result;
+        }
+        stream->length += length;
+        return vsort_stream_add_run(stream, copy, length);
+    }
+
+    while (length > 0)
+    {
+        if (!stream->stage)
+        {
+            stream->stage = (unsigned char *)malloc(VSORT_STREAM_STAGE * element_size);
+            if (!stream->stage)
+                return VSORT_ERR_ALLOCATION_FAILED;
+        }
+
+        size_t take = VSORT_STREAM_STAGE - stream->staged;
+        if (take > length)
+            take = length;
+        memcpy(stream->stage + stream->staged * element_size, src, take * element_size);
+        stream->staged += take;
+        stream->length += take;
+        src += take * element_size;
+        length -= take;
+
+        if (stream->staged == VSORT_STREAM_STAGE)
+        {
+            vsort_result_t result = vsort_stream_flush(stream);
+            if (result != VSORT_OK)
+                return result;
+        }
+    }
+    return VSORT_OK;
+}
+
+VSORT_API size_t vsort_stream_length(const vsort_stream_t *stream)
+{
+    return stream ? stream->length : 0;
+}
+
+VSORT_API vsort_result_t vsort_stream_finalize(vsort_stream_t *stream, void *output)
+{
+    if (!stream || (!output && stream->length > 0))
+        return VSORT_ERR_INVALID_ARGUMENT;
+
+    vsort_result_t result = vsort_stream_flush(stream);
+    if (result != VSORT_OK)
+        return result;
+
+    if (stream->run_count > 0)
+    {
+        // At most FAN_IN - 1 runs per level remain, so this is one K-way
+        // merge with K logarithmic in the window length.
+        vsort_sorted_run_t *sorted = (vsort_sorted_run_t *)malloc(stream->run_count * sizeof(vsort_sorted_run_t));
+        if (!sorted)
+            return VSORT_ERR_ALLOCATION_FAILED;
+        for (size_t i = 0; i < stream->run_count; ++i)
+        {
+            sorted[i].data = stream->runs[i].data;
+            sorted[i].length = stream->runs[i].length;
+        }
+
+        vsort_log_debug("Stream finalize: merging %zu runs of %zu elements.", stream->run_count, stream->length);
+        vsort_merge_options_t options = {
+            .runs = sorted,
+            .run_count = stream->run_count,
+            .output = output,
+            .kind = stream->kind,
+            .flags = stream->flags};
+        result = vsort_merge_runs(&options);
+        free(sorted);
+        if (result != VSORT_OK)
+            return result;
+    }
+
+    vsort_stream_release_runs(stream);
+    stream->length = 0;
+    return VSORT_OK;
+}
+
+VSORT_API void vsort_stream_destroy(vsort_stream_t *stream)
+{
+    if (!stream)
+        return;
+    vsort_stream_release_runs(stream);
+    free(stream->runs);
+    free(stream->stage);
+    free(stream);
+}
@@ -0,0 +1,1375 @@
+/**
+ * Per-type sorting engines for VSort
+ *
+ * This file has no include guard: vsort.c includes it once per element type
+ * after defining
+ *
+ *   VSORT_T          element type (int, float, int64_t, uint64_t, double)
+ *   VSORT_DATA_KIND  matching vsort_data_kind_t (VSORT_KIND_INT32, ...)
+ *   VSORT_SUFFIX     name suffix (int32, float32, int64, uint64, float64)
+ *   VSORT_TYPE_NAME  element name used in log messages
+ *
+ * and the per-type hooks the engines call: vsort_partition_kernel_<suffix>,
+ * vsort_leaf_sort_<suffix>, vsort_radix_sort_<suffix> and
+ * vsort_msd_radix_<suffix>. Every function it defines is static and named
+ * vsort_<name>_<suffix>; the parameter macros are undefined at the end.
+ *
+ * @author Davide Santangelo <https://github.com/davidesantangelo>
+ * @license MIT
+ */
+
+#if !defined(VSORT_T) || !defined(VSORT_DATA_KIND) || !defined(VSORT_SUFFIX) || !defined(VSORT_TYPE_NAME)
+#error "vsort_template.h needs VSORT_T, VSORT_DATA_KIND, VSORT_SUFFIX and VSORT_TYPE_NAME"
+#endif
+
+#define VSORT_FN(name) VSORT_CAT(name##_, VSORT_SUFFIX)
+#define VSORT_FNX(name, tail) VSORT_CAT3(name##_, VSORT_SUFFIX, tail)
+
+// -----------------------------------------------------------------------------
+// Sorting primitives
+// -----------------------------------------------------------------------------
+
+static inline void VSORT_FN(vsort_swap)(VSORT_T *a, VSORT_T *b)
+{
+    VSORT_T tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void VSORT_FN(vsort_insertion_sort)(VSORT_T *data, size_t count)
+{
+    for (size_t i = 1; i < count; ++i)
+    {
+        VSORT_T value = data[i];
+        size_t j = i;
+        while (j > 0 && data[j - 1] > value)
+        {
+            data[j] = data[j - 1];
+            --j;
+        }
+        data[j] = value;
+    }
+}
+
+static void VSORT_FN(vsort_heapify_down)(VSORT_T *data, size_t count, size_t root)
+{
+    while (true)
+    {
+        size_t child = root * 2 + 1;
+        if (child >= count)
+            break;
+
+        if (child + 1 < count && data[child] < data[child + 1])
+            child++;
+
+        if (data[root] >= data[child])
+            break;
+
+        VSORT_FN(vsort_swap)(&data[root], &data[child]);
+        root = child;
+    }
+}
+
+static void VSORT_FN(vsort_heapsort)(VSORT_T *data, size_t count)
+{
+    if (count < 2)
+        return;
+
+    for (size_t i = count / 2; i-- > 0;)
+        VSORT_FN(vsort_heapify_down)(data, count, i);
+
+    for (size_t i = count - 1; i > 0; --i)
+    {
+        VSORT_FN(vsort_swap)(&data[0], &data[i]);
+        VSORT_FN(vsort_heapify_down)(data, i, 0);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Pattern-defeating quicksort helpers
+// -----------------------------------------------------------------------------
+//
+// Introsort follows pdqsort: ninther pivots on large ranges, a partition that
+// groups elements equal to the pivot once a range is known to start at a
+// repeated value, a bounded insertion sort for ranges that came out already
+// partitioned, and a few deterministic swaps that break up adversarial
+// patterns after an unbalanced split, before heapsort is the last resort.
+
+static inline void VSORT_FN(vsort_sort3)(VSORT_T *data, size_t a, size_t b, size_t c)
+{
+    if (data[b] < data[a])
+        VSORT_FN(vsort_swap)(&data[a], &data[b]);
+    if (data[c] < data[b])
+        VSORT_FN(vsort_swap)(&data[b], &data[c]);
+    if (data[b] < data[a])
+        VSORT_FN(vsort_swap)(&data[a], &data[b]);
+}
+
+// Moves the median of 3 (or the ninther on large ranges) to data[count - 1].
+static void VSORT_FN(vsort_choose_pivot)(VSORT_T *data, size_t count)
+{
+    size_t last = count - 1;
+    size_t mid = count / 2;
+
+    if (count > VSORT_NINTHER_THRESHOLD)
+    {
+        VSORT_FN(vsort_sort3)(data, 0, mid, last);
+        VSORT_FN(vsort_sort3)(data, 1, mid - 1, last - 1);
+        VSORT_FN(vsort_sort3)(data, 2, mid + 1, last - 2);
+        VSORT_FN(vsort_sort3)(data, mid - 1, mid, mid + 1);
+    }
+    else
+    {
+        VSORT_FN(vsort_sort3)(data, 0, mid, last);
+    }
+    VSORT_FN(vsort_swap)(&data[mid], &data[last]);
+}
+
+// Moves the elements of data[0, count) below pivot to the front and returns
+// how many there are.
+static size_t VSORT_FN(vsort_partition_less)(VSORT_T *data, size_t count, VSORT_T pivot, unsigned int flags)
+{
+    size_t split = VSORT_FN(vsort_partition_kernel)(data, count, pivot, true, flags);
+    if (split != SIZE_MAX)
+        return split;
+
+    // Branchless Lomuto: the swap always happens, only the cursor moves
+    // conditionally, so random data costs no mispredictions.
+    split = 0;
+    for (size_t j = 0; j < count; ++j)
+    {
+        VSORT_T value = data[j];
+        data[j] = data[split];
+        data[split] = value;
+        split += (size_t)(value < pivot);
+    }
+    return split;
+}
+
+// Partitions around the pivot at data[count - 1]: elements < pivot go left,
+// the pivot lands on the returned index. already_partitioned reports that
+// no element had to move.
+static size_t VSORT_FN(vsort_partition_right)(VSORT_T *data, size_t count, unsigned int flags, bool *already_partitioned)
+{
+    size_t last = count - 1;
+    VSORT_T pivot = data[last];
+
+    size_t first = 0;
+    while (first < last && data[first] < pivot)
+        first++;
+    size_t bound = last;
+    while (bound > first && !(data[bound - 1] < pivot))
+        bound--;
+    *already_partitioned = first == bound;
+
+    size_t split = first;
+    if (first < bound)
+        split += VSORT_FN(vsort_partition_less)(data + first, bound - first, pivot, flags);
+    VSORT_FN(vsort_swap)(&data[split], &data[last]);
+    return split;
+}
+
+// Partitions around the pivot at data[count - 1] with elements <= pivot on
+// the left. Used when the element before the range equals the pivot, so
+// everything up to the returned index is equal to it and already in place.
+static size_t VSORT_FN(vsort_partition_left)(VSORT_T *data, size_t count, unsigned int flags)
+{
+    size_t last = count - 1;
+    VSORT_T pivot = data[last];
+
+    size_t split = VSORT_FN(vsort_partition_kernel)(data, last, pivot, false, flags);
+    if (split == SIZE_MAX)
+    {
+        split = 0;
+        for (size_t j = 0; j < last; ++j)
+        {
+            VSORT_T value = data[j];
+            data[j] = data[split];
+            data[split] = value;
+            split += (size_t)(value <= pivot);
+        }
+    }
+    VSORT_FN(vsort_swap)(&data[split], &data[last]);
+    return split;
+}
+
+// Insertion sort that gives up after VSORT_PARTIAL_INSERTION_LIMIT moves.
+static bool VSORT_FN(vsort_partial_insertion_sort)(VSORT_T *data, size_t count)
+{
+    size_t moves = 0;
+    for (size_t i = 1; i < count; ++i)
+    {
+        VSORT_T value = data[i];
+        size_t j = i;
+        while (j > 0 && data[j - 1] > value)
+        {
+            data[j] = data[j - 1];
+            --j;
+        }
+        data[j] = value;
+        moves += i - j;
+        if (moves > VSORT_PARTIAL_INSERTION_LIMIT)
+            return false;
+    }
+    return true;
+}
+
+// Swaps a few elements from the quarter points towards the ends of a range
+// that came out of an unbalanced partition.
+static void VSORT_FN(vsort_break_patterns)(VSORT_T *data, size_t count)
+{
+    if (count < vsort_runtime()->thresholds.insertion_threshold)
+        return;
+
+    size_t quarter = count / 4;
+    VSORT_FN(vsort_swap)(&data[0], &data[quarter]);
+    VSORT_FN(vsort_swap)(&data[count - 1], &data[count - quarter]);
+    if (count > VSORT_NINTHER_THRESHOLD)
+    {
+        VSORT_FN(vsort_swap)(&data[1], &data[quarter + 1]);
+        VSORT_FN(vsort_swap)(&data[2], &data[quarter + 2]);
+        VSORT_FN(vsort_swap)(&data[count - 2], &data[count - quarter - 1]);
+        VSORT_FN(vsort_swap)(&data[count - 3], &data[count - quarter - 2]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Introsort and merge sort
+// -----------------------------------------------------------------------------
+
+static void VSORT_FNX(vsort_introsort, _impl)(VSORT_T *data, size_t count, size_t bad_allowed, bool leftmost, unsigned int flags)
+{
+    size_t threshold = vsort_runtime()->thresholds.insertion_threshold;
+
+    while (count > threshold)
+    {
+        VSORT_FN(vsort_choose_pivot)(data, count);
+
+        // The predecessor is a pivot of an enclosing partition, so when it is
+        // not smaller than this pivot every element equal to it goes left.
+        if (!leftmost && !(data[-1] < data[count - 1]))
+        {
+            size_t split = VSORT_FN(vsort_partition_left)(data, count, flags);
+            data += split + 1;
+            count -= split + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        size_t pivot_index = VSORT_FN(vsort_partition_right)(data, count, flags, &already_partitioned);
+        size_t left_count = pivot_index;
+        size_t right_count = count - pivot_index - 1;
+
+        if (left_count < count / 8 || right_count < count / 8)
+        {
+            if (--bad_allowed == 0)
+            {
+                VSORT_FN(vsort_heapsort)(data, count);
+                return;
+            }
+            VSORT_FN(vsort_break_patterns)(data, left_count);
+            VSORT_FN(vsort_break_patterns)(data + pivot_index + 1, right_count);
+        }
+        else if (already_partitioned && VSORT_FN(vsort_partial_insertion_sort)(data, left_count) &&
+                 VSORT_FN(vsort_partial_insertion_sort)(data + pivot_index + 1, right_count))
+        {
+            return;
+        }
+
+        if (left_count < right_count)
+        {
+            if (left_count > 0)
+                VSORT_FNX(vsort_introsort, _impl)(data, left_count, bad_allowed, leftmost, flags);
+            data += pivot_index + 1;
+            count = right_count;
+            leftmost = false;
+        }
+        else
+        {
+            if (right_count > 0)
+                VSORT_FNX(vsort_introsort, _impl)(data + pivot_index + 1, right_count, bad_allowed, false, flags);
+            count = left_count;
+        }
+    }
+
+    VSORT_FN(vsort_leaf_sort)(data, count);
+}
+
+static void VSORT_FN(vsort_introsort)(VSORT_T *data, size_t count, unsigned int flags)
+{
+    if (count <= 1)
+        return;
+
+    VSORT_FNX(vsort_introsort, _impl)(data, count, vsort_floor_log2(count) + 1, true, flags);
+}
+
+static void VSORT_FN(vsort_merge)(VSORT_T *data, VSORT_T *buffer, size_t left, size_t mid, size_t right)
+{
+    size_t left_count = mid - left;
+    if (left_count == 0)
+        return;
+
+    memcpy(buffer + left, data + left, left_count * sizeof(VSORT_T));
+
+    size_t i = 0;
+    size_t j = mid;
+    size_t dest = left;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    VSORT_UNUSED(left_count);
+#endif
+
+    while (i < left_count && j < right)
+    {
+        if (buffer[left + i] <= data[j])
+        {
+            data[dest++] = buffer[left + i];
+            ++i;
+        }
+        else
+        {
+            data[dest++] = data[j++];
+        }
+    }
+
+    while (i < left_count)
+        data[dest++] = buffer[left + i++];
+}
+
+static void VSORT_FNX(vsort_mergesort, _impl)(VSORT_T *data, VSORT_T *buffer, size_t left, size_t right)
+{
+    size_t count = right - left;
+    if (count <= vsort_runtime()->thresholds.insertion_threshold)
+    {
+        VSORT_FN(vsort_insertion_sort)(data + left, count);
+        return;
+    }
+
+    size_t mid = left + count / 2;
+    VSORT_FNX(vsort_mergesort, _impl)(data, buffer, left, mid);
+    VSORT_FNX(vsort_mergesort, _impl)(data, buffer, mid, right);
+
+    if (data[mid - 1] <= data[mid])
+        return;
+
+    VSORT_FN(vsort_merge)(data, buffer, left, mid, right);
+}
+
+static bool VSORT_FN(vsort_mergesort)(VSORT_T *data, size_t count)
+{
+    if (count <= 1)
+        return true;
+
+    VSORT_T *buffer = (VSORT_T *)vsort_scratch_alloc(count * sizeof(VSORT_T));
+    if (!buffer)
+        return false;
+
+    VSORT_FNX(vsort_mergesort, _impl)(data, buffer, 0, count);
+    vsort_scratch_free(buffer);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Adaptive run merging
+// -----------------------------------------------------------------------------
+//
+// Natural merge sort for presorted input: maximal ascending or strictly
+// descending runs are detected (descending ones are reversed), short runs
+// are extended to VSORT_MIN_RUN with insertion sort, and runs are merged in
+// the order given by the powersort policy, which keeps the merge tree close
+// to optimal for the run lengths. Merges skip the prefix and suffix that are
+// already in place and copy whole streaks once one side wins
+// VSORT_MIN_GALLOP times in a row. The sort is stable and costs
+// O(n + n log r) for r runs.
+
+static size_t VSORT_FN(vsort_gallop_upper)(const VSORT_T *data, size_t count, VSORT_T key)
+{
+    size_t hi = 1;
+    while (hi < count && !(key < data[hi - 1]))
+        hi <<= 1;
+
+    size_t lo = hi / 2;
+    hi = VSORT_MIN(hi, count);
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (key < data[mid])
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+static size_t VSORT_FN(vsort_gallop_lower)(const VSORT_T *data, size_t count, VSORT_T key)
+{
+    size_t hi = 1;
+    while (hi < count && data[hi - 1] < key)
+        hi <<= 1;
+
+    size_t lo = hi / 2;
+    hi = VSORT_MIN(hi, count);
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (data[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Stable merge of the sorted runs data[start, mid) and data[mid, end).
+static void VSORT_FN(vsort_merge_runs)(VSORT_T *data, VSORT_T *buffer, size_t start, size_t mid, size_t end)
+{
+    // Left elements not above the first right element and right elements
+    // not below the last left element are already in place.
+    start += VSORT_FN(vsort_gallop_upper)(data + start, mid - start, data[mid]);
+    if (start == mid)
+        return;
+    end = mid + VSORT_FN(vsort_gallop_lower)(data + mid, end - mid, data[mid - 1]);
+
+    size_t left_count = mid - start;
+    memcpy(buffer, data + start, left_count * sizeof(VSORT_T));
+
+    size_t i = 0;
+    size_t j = mid;
+    size_t dest = start;
+    while (i < left_count && j < end)
+    {
+        size_t left_wins = 0;
+        size_t right_wins = 0;
+        while (i < left_count && j < end && left_wins < VSORT_MIN_GALLOP && right_wins < VSORT_MIN_GALLOP)
+        {
+            if (data[j] < buffer[i])
+            {
+                data[dest++] = data[j++];
+                right_wins++;
+                left_wins = 0;
+            }
+            else
+            {
+                data[dest++] = buffer[i++];
+                left_wins++;
+                right_wins = 0;
+            }
+        }
+        if (i == left_count || j == end)
+            break;
+
+        // One side keeps winning: copy its whole streak in one block.
+        if (left_wins >= VSORT_MIN_GALLOP)
+        {
+            size_t streak = VSORT_FN(vsort_gallop_upper)(buffer + i, left_count - i, data[j]);
+            memcpy(data + dest, buffer + i, streak * sizeof(VSORT_T));
+            dest += streak;
+            i += streak;
+        }
+        else
+        {
+            size_t streak = VSORT_FN(vsort_gallop_lower)(data + j, end - j, buffer[i]);
+            memmove(data + dest, data + j, streak * sizeof(VSORT_T));
+            dest += streak;
+            j += streak;
+        }
+    }
+
+    memcpy(data + dest, buffer + i, (left_count - i) * sizeof(VSORT_T));
+}
+
+// Length of the run starting at data[0]; strictly descending runs are
+// reversed in place and runs shorter than VSORT_MIN_RUN are extended.
+static size_t VSORT_FN(vsort_next_run)(VSORT_T *data, size_t count)
+{
+    if (count < 2)
+        return count;
+
+    size_t length = 2;
+    if (data[1] < data[0])
+    {
+        while (length < count && data[length] < data[length - 1])
+            length++;
+        for (size_t lo = 0, hi = length - 1; lo < hi; ++lo, --hi)
+            VSORT_FN(vsort_swap)(&data[lo], &data[hi]);
+    }
+    else
+    {
+        while (length < count && !(data[length] < data[length - 1]))
+            length++;
+    }
+
+    size_t forced = VSORT_MIN((size_t)VSORT_MIN_RUN, count);
+    if (length < forced)
+    {
+        VSORT_FN(vsort_insertion_sort)(data, forced);
+        length = forced;
+    }
+    return length;
+}
+
+// True when the input splits into few enough natural runs (ascending or
+// strictly descending) that run merging beats a from-scratch sort. Bails
+// out as soon as the run budget is exhausted, so random input costs only a
+// short prefix scan.
+static bool VSORT_FN(vsort_has_long_runs)(const VSORT_T *data, size_t count, size_t average_run)
+{
+    if (average_run == 0 || count < average_run * 2)
+        return false;
+
+    size_t budget = count / average_run;
+    size_t runs = 0;
+    size_t i = 0;
+    while (i < count)
+    {
+        if (++runs > budget)
+            return false;
+
+        size_t end = i + 1;
+        if (end < count && data[end] < data[i])
+        {
+            while (end < count && data[end] < data[end - 1])
+                end++;
+        }
+        else
+        {
+            while (end < count && !(data[end] < data[end - 1]))
+                end++;
+        }
+        i = end;
+    }
+    return true;
+}
+
+static bool VSORT_FN(vsort_run_merge)(VSORT_T *data, size_t count)
+{
+    if (count <= 1)
+        return true;
+
+    VSORT_T *buffer = (VSORT_T *)vsort_scratch_alloc(count * sizeof(VSORT_T));
+    if (!buffer)
+        return false;
+
+    vsort_run_t stack[VSORT_RUN_STACK];
+    size_t top = 0;
+    size_t start = 0;
+    size_t length = VSORT_FN(vsort_next_run)(data, count);
+
+    while (start + length < count)
+    {
+        size_t next = start + length;
+        size_t next_length = VSORT_FN(vsort_next_run)(data + next, count - next);
+        unsigned int power = vsort_run_power(count, start, length, next_length);
+
+        while (top > 0 && (stack[top - 1].power > power || top == VSORT_RUN_STACK))
+        {
+            top--;
+            VSORT_FN(vsort_merge_runs)(data, buffer, stack[top].start, start, start + length);
+            length += start - stack[top].start;
+            start = stack[top].start;
+        }
+
+        stack[top].start = start;
+        stack[top].power = power;
+        top++;
+        start = next;
+        length = next_length;
+    }
+
+    while (top > 0)
+    {
+        top--;
+        VSORT_FN(vsort_merge_runs)(data, buffer, stack[top].start, start, start + length);
+        length += start - stack[top].start;
+        start = stack[top].start;
+    }
+
+    vsort_scratch_free(buffer);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Parallel sort
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    const VSORT_T *src;
+    VSORT_T *dst;
+    size_t count;
+    size_t width;
+    size_t part;
+    unsigned int flags;
+    vsort_cancel_t *cancel;
+} VSORT_FNX(vsort_parallel_job, _t);
+
+static void VSORT_FN(vsort_parallel_chunk)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_parallel_job, _t) *job = (const VSORT_FNX(vsort_parallel_job, _t) *)context;
+    size_t begin = index * job->width;
+    size_t end = VSORT_MIN(begin + job->width, job->count);
+    size_t local = end - begin;
+
+    if (local <= 1 || vsort_cancel_check(job->cancel))
+        return;
+
+    if (local <= vsort_runtime()->thresholds.insertion_threshold)
+    {
+        VSORT_FN(vsort_leaf_sort)(job->dst + begin, local);
+        return;
+    }
+
+    VSORT_FNX(vsort_introsort, _impl)(job->dst + begin, local, vsort_floor_log2(local) + 1, true, job->flags);
+}
+
+// Number of elements of a that precede position k of the stable merge of a and b.
+static size_t VSORT_FN(vsort_co_rank)(const VSORT_T *a, size_t a_count, const VSORT_T *b, size_t b_count, size_t k)
+{
+    size_t lo = k > b_count ? k - b_count : 0;
+    size_t hi = VSORT_MIN(k, a_count);
+    while (lo < hi)
+    {
+        size_t i = lo + (hi - lo) / 2;
+        if (a[i] <= b[k - i - 1])
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+static void VSORT_FN(vsort_merge_range)(const VSORT_T *a, size_t a_count, const VSORT_T *b, size_t b_count, VSORT_T *out)
+{
+    size_t i = 0;
+    size_t j = 0;
+    if (a_count > 0 && b_count > 0 && a[a_count - 1] > b[0])
+    {
+        while (i < a_count && j < b_count)
+        {
+            if (a[i] <= b[j])
+                *out++ = a[i++];
+            else
+                *out++ = b[j++];
+        }
+    }
+    if (i < a_count)
+    {
+        memcpy(out, a + i, (a_count - i) * sizeof(VSORT_T));
+        out += a_count - i;
+    }
+    if (j < b_count)
+        memcpy(out, b + j, (b_count - j) * sizeof(VSORT_T));
+}
+
+// Produces output slice [index * part, (index + 1) * part) of one merge pass.
+// The slice may span several run pairs; each piece is located with co-ranking.
+static void VSORT_FN(vsort_parallel_merge_part)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_parallel_job, _t) *job = (const VSORT_FNX(vsort_parallel_job, _t) *)context;
+    size_t pos = index * job->part;
+    size_t stop = VSORT_MIN(pos + job->part, job->count);
+
+    while (pos < stop)
+    {
+        size_t left = pos - pos % (job->width * 2);
+        size_t mid = VSORT_MIN(left + job->width, job->count);
+        size_t right = VSORT_MIN(left + job->width * 2, job->count);
+        size_t end = VSORT_MIN(stop, right);
+
+        const VSORT_T *a = job->src + left;
+        const VSORT_T *b = job->src + mid;
+        size_t a_count = mid - left;
+        size_t b_count = right - mid;
+        size_t k0 = pos - left;
+        size_t k1 = end - left;
+        size_t i0 = VSORT_FN(vsort_co_rank)(a, a_count, b, b_count, k0);
+        size_t i1 = VSORT_FN(vsort_co_rank)(a, a_count, b, b_count, k1);
+
+        VSORT_FN(vsort_merge_range)(a + i0, i1 - i0, b + (k0 - i0), (k1 - i1) - (k0 - i0), job->dst + pos);
+        pos = end;
+    }
+}
+
+static void VSORT_FN(vsort_parallel_copy_part)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_parallel_job, _t) *job = (const VSORT_FNX(vsort_parallel_job, _t) *)context;
+    size_t begin = index * job->part;
+    size_t end = VSORT_MIN(begin + job->part, job->count);
+    if (begin < end)
+        memcpy(job->dst + begin, job->src + begin, (end - begin) * sizeof(VSORT_T));
+}
+
+static bool VSORT_FN(vsort_parallel)(VSORT_T *data, size_t count, unsigned int flags)
+{
+    if (count < 2)
+        return true;
+
+    int threads = vsort_parallel_threads(flags);
+    if (threads < 2)
+        return false;
+
+    size_t chunk = vsort_parallel_chunk_size();
+    size_t chunk_count = (count + chunk - 1) / chunk;
+    if (chunk_count == 0)
+        return false;
+
+    VSORT_T *buffer = (VSORT_T *)vsort_scratch_alloc(count * sizeof(VSORT_T));
+    if (!buffer)
+    {
+        vsort_stats_fallback(VSORT_FALLBACK_MERGE_BUFFER);
+        return false;
+    }
+
+    size_t slices = vsort_parallel_slices(threads);
+    VSORT_FNX(vsort_parallel_job, _t) job = {
+        .src = data,
+        .dst = data,
+        .count = count,
+        .width = chunk,
+        .part = (count + slices - 1) / slices,
+        .flags = flags,
+        .cancel = vsort_cancel_current()};
+    uint64_t phase = vsort_stats_phase_begin();
+    vsort_pool_parallel_for(chunk_count, VSORT_FN(vsort_parallel_chunk), &job, threads, flags);
+    vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+
+    // Ping-pong between data and buffer; every pass splits its whole output
+    // into equal slices (one per thread unless cores differ in speed), so
+    // the final passes stay parallel.
+    phase = vsort_stats_phase_begin();
+    job.dst = buffer;
+    for (size_t width = chunk; width < count && !vsort_cancel_check(job.cancel); width *= 2)
+    {
+        job.width = width;
+        vsort_pool_parallel_for(slices, VSORT_FN(vsort_parallel_merge_part), &job, threads, flags);
+        vsort_stats_merge_pass();
+        VSORT_T *swap = (VSORT_T *)job.src;
+        job.src = job.dst;
+        job.dst = swap;
+    }
+
+    if (job.src != data)
+    {
+        job.dst = data;
+        vsort_pool_parallel_for(slices, VSORT_FN(vsort_parallel_copy_part), &job, threads, flags);
+    }
+    vsort_stats_phase_end(VSORT_PHASE_MERGE, phase);
+
+    vsort_scratch_free(buffer);
+    vsort_stats_engine(VSORT_ENGINE_PARALLEL_MERGE, threads);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Fork-join introsort
+// -----------------------------------------------------------------------------
+
+typedef struct
+{
+    VSORT_T *data;
+    size_t count;
+    size_t block;
+    VSORT_T pivot;
+    unsigned int flags;
+    size_t *splits; /**< Per block: elements below the pivot after the block pass */
+    size_t *left;   /**< (start, length) of elements >= pivot left of the split */
+    size_t *right;  /**< (start, length) of elements < pivot right of it */
+    size_t part;
+    size_t misplaced;
+} VSORT_FNX(vsort_partition_job, _t);
+
+static void VSORT_FN(vsort_partition_block)(void *context, size_t index)
+{
+    VSORT_FNX(vsort_partition_job, _t) *job = (VSORT_FNX(vsort_partition_job, _t) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    job->splits[index] = VSORT_FN(vsort_partition_less)(job->data + begin, end - begin, job->pivot, job->flags);
+}
+
+// Swaps misplaced pair [index * part, (index + 1) * part): the k-th element
+// of the left interval list trades places with the k-th of the right one.
+static void VSORT_FN(vsort_partition_swap)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_partition_job, _t) *job = (const VSORT_FNX(vsort_partition_job, _t) *)context;
+    size_t pos = index * job->part;
+    size_t stop = VSORT_MIN(pos + job->part, job->misplaced);
+    const size_t *left = job->left;
+    const size_t *right = job->right;
+
+    size_t left_offset = pos;
+    while (left_offset >= left[1])
+    {
+        left_offset -= left[1];
+        left += 2;
+    }
+    size_t right_offset = pos;
+    while (right_offset >= right[1])
+    {
+        right_offset -= right[1];
+        right += 2;
+    }
+
+    while (pos < stop)
+    {
+        size_t step = VSORT_MIN(stop - pos, VSORT_MIN(left[1] - left_offset, right[1] - right_offset));
+        VSORT_T *a = job->data + left[0] + left_offset;
+        VSORT_T *b = job->data + right[0] + right_offset;
+        for (size_t i = 0; i < step; ++i)
+            VSORT_FN(vsort_swap)(&a[i], &b[i]);
+
+        pos += step;
+        left_offset += step;
+        right_offset += step;
+        if (left_offset == left[1])
+        {
+            left += 2;
+            left_offset = 0;
+        }
+        if (right_offset == right[1])
+        {
+            right += 2;
+            right_offset = 0;
+        }
+    }
+}
+
+// Partitions around the pivot at data[count - 1] on the worker pool, with
+// the same result as vsort_partition_right: every block partitions itself,
+// then the elements that landed on the wrong side of the global split are
+// swapped across it in parallel. Returns SIZE_MAX when scratch is
+// unavailable.
+static size_t VSORT_FN(vsort_parallel_partition)(VSORT_T *data, size_t count, int threads, unsigned int flags)
+{
+    size_t slices = vsort_parallel_slices(threads);
+    size_t *scratch = (size_t *)vsort_scratch_alloc(slices * 5 * sizeof(size_t));
+    if (!scratch)
+        return SIZE_MAX;
+
+    size_t last = count - 1;
+    VSORT_FNX(vsort_partition_job, _t) job = {
+        .data = data,
+        .count = last,
+        .block = (last + slices - 1) / slices,
+        .pivot = data[last],
+        .flags = flags,
+        .splits = scratch,
+        .left = scratch + slices,
+        .right = scratch + slices * 3};
+    size_t blocks = (last + job.block - 1) / job.block;
+    vsort_pool_parallel_for(blocks, VSORT_FN(vsort_partition_block), &job, threads, flags);
+
+    size_t split = 0;
+    for (size_t b = 0; b < blocks; ++b)
+        split += job.splits[b];
+
+    size_t left_count = 0;
+    size_t right_count = 0;
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        size_t begin = b * job.block;
+        size_t end = VSORT_MIN(begin + job.block, last);
+        size_t mid = begin + job.splits[b];
+        size_t stop = VSORT_MIN(end, split);
+        size_t start = VSORT_MAX(begin, split);
+        if (mid < stop)
+        {
+            job.left[left_count++ * 2] = mid;
+            job.left[left_count * 2 - 1] = stop - mid;
+            job.misplaced += stop - mid;
+        }
+        if (start < mid)
+        {
+            job.right[right_count++ * 2] = start;
+            job.right[right_count * 2 - 1] = mid - start;
+        }
+    }
+
+    if (job.misplaced > 0)
+    {
+        job.part = (job.misplaced + slices - 1) / slices;
+        vsort_pool_parallel_for((job.misplaced + job.part - 1) / job.part, VSORT_FN(vsort_partition_swap), &job, threads, flags);
+    }
+    vsort_scratch_free(scratch);
+
+    VSORT_FN(vsort_swap)(&data[split], &data[last]);
+    return split;
+}
+
+typedef struct
+{
+    VSORT_T *data;
+    size_t cutoff;
+    unsigned int flags;
+    vsort_cancel_t *cancel;
+} VSORT_FNX(vsort_fork_job, _t);
+
+// Introsort over one range of a task group. Each partition queues its larger
+// side for an idle thread and keeps splitting the smaller one, until the
+// range fits a cache-sized chunk and the sequential introsort takes over.
+static void VSORT_FN(vsort_fork_task)(vsort_pool_group_t *group, void *context, const vsort_pool_range_t *range)
+{
+    const VSORT_FNX(vsort_fork_job, _t) *job = (const VSORT_FNX(vsort_fork_job, _t) *)context;
+    VSORT_T *data = job->data + range->begin;
+    size_t count = range->end - range->begin;
+    size_t bad_allowed = range->budget;
+    bool leftmost = range->begin == 0;
+
+    while (count > job->cutoff)
+    {
+        if (vsort_cancel_check(job->cancel))
+            return;
+
+        VSORT_FN(vsort_choose_pivot)(data, count);
+
+        if (!leftmost && !(data[-1] < data[count - 1]))
+        {
+            size_t split = VSORT_FN(vsort_partition_left)(data, count, job->flags);
+            data += split + 1;
+            count -= split + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        size_t pivot_index = VSORT_FN(vsort_partition_right)(data, count, job->flags, &already_partitioned);
+        size_t left_count = pivot_index;
+        size_t right_count = count - pivot_index - 1;
+
+        if (left_count < count / 8 || right_count < count / 8)
+        {
+            if (--bad_allowed == 0)
+            {
+                VSORT_FN(vsort_heapsort)(data, count);
+                return;
+            }
+            VSORT_FN(vsort_break_patterns)(data, left_count);
+            VSORT_FN(vsort_break_patterns)(data + pivot_index + 1, right_count);
+        }
+        else if (already_partitioned && VSORT_FN(vsort_partial_insertion_sort)(data, left_count) &&
+                 VSORT_FN(vsort_partial_insertion_sort)(data + pivot_index + 1, right_count))
+        {
+            return;
+        }
+
+        size_t base = (size_t)(data - job->data);
+        vsort_pool_range_t larger = {.budget = bad_allowed};
+        if (left_count < right_count)
+        {
+            larger.begin = base + pivot_index + 1;
+            larger.end = base + count;
+            count = left_count;
+        }
+        else
+        {
+            larger.begin = base;
+            larger.end = base + left_count;
+            data += pivot_index + 1;
+            count = right_count;
+            leftmost = false;
+        }
+        if (!vsort_pool_group_spawn(group, &larger))
+            VSORT_FNX(vsort_introsort, _impl)(job->data + larger.begin, larger.end - larger.begin, bad_allowed,
+                                               larger.begin == 0, job->flags);
+    }
+
+    if (count > 1 && !vsort_cancel_check(job->cancel))
+        VSORT_FNX(vsort_introsort, _impl)(data, count, bad_allowed, leftmost, job->flags);
+}
+
+// Parallel introsort without a merge buffer. The top levels split the
+// largest range with a parallel partition until there is about one range per
+// thread (a badly split range is left whole), then every range runs as a
+// task group seed whose partitions become tasks of their own.
+static void VSORT_FN(vsort_fork_join)(VSORT_T *data, size_t count, unsigned int flags)
+{
+    int threads = vsort_parallel_threads(flags);
+    size_t cutoff = vsort_parallel_chunk_size();
+    if (threads < 2 || count <= cutoff)
+    {
+        if (threads < 2)
+            vsort_stats_fallback(VSORT_FALLBACK_SEQUENTIAL);
+        uint64_t phase = vsort_stats_phase_begin();
+        VSORT_FN(vsort_introsort)(data, count, flags);
+        vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+        vsort_stats_engine(VSORT_ENGINE_INTROSORT, 1);
+        return;
+    }
+
+    uint64_t phase = vsort_stats_phase_begin();
+    size_t budget = vsort_floor_log2(count) + 1;
+    size_t wide = VSORT_MAX(vsort_runtime()->thresholds.parallel_threshold, cutoff * (size_t)threads);
+    vsort_pool_range_t seeds[VSORT_FORK_MAX_SEEDS] = {{.begin = 0, .end = count, .budget = budget}};
+    bool settled[VSORT_FORK_MAX_SEEDS] = {false};
+    size_t seed_count = 1;
+    vsort_cancel_t *cancel = vsort_cancel_current();
+
+    while (seed_count < (size_t)VSORT_MIN(threads, VSORT_FORK_MAX_SEEDS) && !vsort_cancel_requested(cancel))
+    {
+        size_t widest = SIZE_MAX;
+        size_t widest_count = wide - 1;
+        for (size_t i = 0; i < seed_count; ++i)
+        {
+            size_t length = seeds[i].end - seeds[i].begin;
+            if (!settled[i] && length > widest_count)
+            {
+                widest = i;
+                widest_count = length;
+            }
+        }
+        if (widest == SIZE_MAX)
+            break;
+
+        VSORT_T *range = data + seeds[widest].begin;
+        VSORT_FN(vsort_choose_pivot)(range, widest_count);
+        size_t split = VSORT_FN(vsort_parallel_partition)(range, widest_count, threads, flags);
+        if (split == SIZE_MAX)
+            break;
+        if (split < widest_count / 8 || widest_count - split - 1 < widest_count / 8)
+        {
+            settled[widest] = true;
+            continue;
+        }
+
+        seeds[seed_count].begin = seeds[widest].begin + split + 1;
+        seeds[seed_count].end = seeds[widest].end;
+        seeds[seed_count++].budget = budget;
+        seeds[widest].end = seeds[widest].begin + split;
+    }
+
+    VSORT_FNX(vsort_fork_job, _t) job = {.data = data, .cutoff = cutoff, .flags = flags, .cancel = cancel};
+    vsort_log_debug("Fork-join introsort of %zu " VSORT_TYPE_NAME " elements from %zu seed range(s).", count, seed_count);
+    vsort_pool_run_group(VSORT_FN(vsort_fork_task), &job, seeds, seed_count, threads, flags);
+    vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+    vsort_stats_engine(VSORT_ENGINE_FORK_JOIN, threads);
+}
+
+// -----------------------------------------------------------------------------
+// Engine selection
+// -----------------------------------------------------------------------------
+
+static void VSORT_FN(vsort_numa_stripe)(void *data, size_t count, unsigned int flags);
+
+// Stable merge sort when requested, run merging for presorted input, the
+// NUMA stripe sort on multi-node hosts, radix sort above the calibrated
+// threshold, the parallel chunk sort or fork-join introsort, then introsort.
+static void VSORT_FN(vsort_sort)(VSORT_T *data, size_t count, unsigned int flags)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    uint64_t phase;
+
+    if ((flags & VSORT_FLAG_FORCE_STABLE))
+    {
+        phase = vsort_stats_phase_begin();
+        if (VSORT_FN(vsort_mergesort)(data, count))
+            vsort_stats_engine(VSORT_ENGINE_MERGESORT, 1);
+        else
+        {
+            vsort_log_warning("Stable " VSORT_TYPE_NAME " sort allocation failed, falling back to introsort.");
+            vsort_stats_fallback(VSORT_FALLBACK_STABLE_BUFFER);
+            VSORT_FN(vsort_introsort)(data, count, flags);
+            vsort_stats_engine(VSORT_ENGINE_INTROSORT, 1);
+        }
+        vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+        return;
+    }
+
+    phase = vsort_stats_phase_begin();
+    bool presorted = VSORT_FN(vsort_has_long_runs)(data, count, rt->thresholds.adaptive_run_length);
+    vsort_stats_phase_end(VSORT_PHASE_PRESCAN, phase);
+    if (presorted)
+    {
+        phase = vsort_stats_phase_begin();
+        bool merged = VSORT_FN(vsort_run_merge)(data, count);
+        vsort_stats_phase_end(VSORT_PHASE_MERGE, phase);
+        if (merged)
+        {
+            vsort_stats_engine(VSORT_ENGINE_RUN_MERGE, 1);
+            return;
+        }
+        vsort_stats_fallback(VSORT_FALLBACK_RUN_BUFFER);
+    }
+
+    bool use_parallel = (flags & VSORT_FLAG_ALLOW_PARALLEL) && count >= rt->thresholds.parallel_threshold;
+    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
+        use_parallel = use_parallel && count >= (rt->thresholds.parallel_threshold * 2);
+
+    if (use_parallel && rt->hardware.numa_nodes > 1 && !vsort_radix_prefers_in_place(count, sizeof(VSORT_T), flags) &&
+        vsort_numa_sort(data, count, sizeof(VSORT_T), VSORT_DATA_KIND, VSORT_FN(vsort_numa_stripe), flags))
+        return;
+
+    if ((flags & VSORT_FLAG_ALLOW_RADIX) && count >= rt->thresholds.radix_threshold)
+    {
+        int threads = use_parallel ? vsort_parallel_threads(flags) : 1;
+        phase = vsort_stats_phase_begin();
+        if (!vsort_radix_prefers_in_place(count, sizeof(VSORT_T), flags))
+        {
+            if (VSORT_FN(vsort_radix_sort)(data, count, threads))
+            {
+                vsort_stats_phase_end(VSORT_PHASE_RADIX, phase);
+                vsort_stats_engine(VSORT_ENGINE_RADIX_LSD, threads);
+                return;
+            }
+            vsort_log_debug("Radix scratch unavailable, using in-place MSD radix for %zu " VSORT_TYPE_NAME " elements.", count);
+            vsort_stats_fallback(VSORT_FALLBACK_RADIX_BUFFER);
+        }
+        VSORT_FN(vsort_msd_radix)(data, count, threads, flags);
+        vsort_stats_phase_end(VSORT_PHASE_RADIX, phase);
+        vsort_stats_engine(VSORT_ENGINE_RADIX_MSD, threads);
+        return;
+    }
+
+    if (use_parallel)
+    {
+        if (!vsort_prefers_fork_join(count, sizeof(VSORT_T), flags) && VSORT_FN(vsort_parallel)(data, count, flags))
+            return;
+        VSORT_FN(vsort_fork_join)(data, count, flags);
+        return;
+    }
+
+    phase = vsort_stats_phase_begin();
+    VSORT_FN(vsort_introsort)(data, count, flags);
+    vsort_stats_phase_end(VSORT_PHASE_SORT, phase);
+    vsort_stats_engine(VSORT_ENGINE_INTROSORT, 1);
+}
+
+// Sorts one stripe of vsort_numa_sort on the calling thread.
+static void VSORT_FN(vsort_numa_stripe)(void *data, size_t count, unsigned int flags)
+{
+    VSORT_FN(vsort_sort)((VSORT_T *)data, count, flags);
+}
+
+// One array of a vsort_sort_batch call. Arrays up to the leaf size go
+// straight to the leaf sort (insertion sort when stable) and arrays below a
+// cache block straight to introsort, skipping the run detection and engine
+// selection of vsort_sort that only pay off on longer inputs.
+static void VSORT_FN(vsort_batch_sort)(VSORT_T *data, size_t count, unsigned int flags)
+{
+    const vsort_thresholds_t *thresholds = &vsort_runtime()->thresholds;
+    if (count <= 1)
+        return;
+
+    if (count <= thresholds->insertion_threshold)
+    {
+        if (flags & VSORT_FLAG_FORCE_STABLE)
+            VSORT_FN(vsort_insertion_sort)(data, count);
+        else
+            VSORT_FN(vsort_leaf_sort)(data, count);
+    }
+    else if (count < thresholds->cache_optimal_elements && !(flags & VSORT_FLAG_FORCE_STABLE))
+        VSORT_FN(vsort_introsort)(data, count, flags);
+    else
+        VSORT_FN(vsort_sort)(data, count, flags);
+}
+
+// -----------------------------------------------------------------------------
+// Selection
+// -----------------------------------------------------------------------------
+
+// Introselect on the pdqsort partitions: only the side that holds nth is
+// followed, so the expected cost is linear. A range that keeps partitioning
+// badly is heapsorted, which bounds the worst case at O(n log n).
+static void VSORT_FN(vsort_select)(VSORT_T *data, size_t count, size_t nth, unsigned int flags)
+{
+    size_t threshold = vsort_runtime()->thresholds.insertion_threshold;
+    size_t bad_allowed = vsort_floor_log2(count) + 1;
+    bool leftmost = true;
+
+    while (count > threshold)
+    {
+        VSORT_FN(vsort_choose_pivot)(data, count);
+
+        // Everything up to split equals the pivot, so nth may already be done.
+        if (!leftmost && !(data[-1] < data[count - 1]))
+        {
+            size_t split = VSORT_FN(vsort_partition_left)(data, count, flags);
+            if (nth <= split)
+                return;
+            data += split + 1;
+            count -= split + 1;
+            nth -= split + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        size_t pivot_index = VSORT_FN(vsort_partition_right)(data, count, flags, &already_partitioned);
+        if (nth == pivot_index)
+            return;
+
+        size_t left_count = pivot_index;
+        size_t right_count = count - pivot_index - 1;
+        if (left_count < count / 8 || right_count < count / 8)
+        {
+            if (--bad_allowed == 0)
+            {
+                VSORT_FN(vsort_heapsort)(data, count);
+                return;
+            }
+            VSORT_FN(vsort_break_patterns)(data, left_count);
+            VSORT_FN(vsort_break_patterns)(data + pivot_index + 1, right_count);
+        }
+
+        if (nth < pivot_index)
+        {
+            count = left_count;
+        }
+        else
+        {
+            data += pivot_index + 1;
+            count = right_count;
+            nth -= pivot_index + 1;
+            leftmost = false;
+        }
+    }
+
+    VSORT_FN(vsort_leaf_sort)(data, count);
+}
+
+typedef struct
+{
+    const VSORT_T *src;
+    VSORT_T *dst;
+    size_t count;
+    size_t block;
+    VSORT_T low;
+    VSORT_T high;
+    size_t *counts; /**< Per task: elements below, inside and above [low, high] */
+} VSORT_FNX(vsort_select_job, _t);
+
+static inline size_t VSORT_FN(vsort_select_class)(VSORT_T value, VSORT_T low, VSORT_T high)
+{
+    return value < low ? 0 : (high < value ? 2 : 1);
+}
+
+static void VSORT_FN(vsort_select_count)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_select_job, _t) *job = (const VSORT_FNX(vsort_select_job, _t) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t counts[3] = {0, 0, 0};
+
+    for (size_t i = begin; i < end; ++i)
+        counts[VSORT_FN(vsort_select_class)(job->src[i], job->low, job->high)]++;
+    memcpy(job->counts + index * 3, counts, sizeof(counts));
+}
+
+static void VSORT_FN(vsort_select_scatter)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_select_job, _t) *job = (const VSORT_FNX(vsort_select_job, _t) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    size_t cursor[3];
+    memcpy(cursor, job->counts + index * 3, sizeof(cursor));
+
+    for (size_t i = begin; i < end; ++i)
+        job->dst[cursor[VSORT_FN(vsort_select_class)(job->src[i], job->low, job->high)]++] = job->src[i];
+}
+
+static void VSORT_FN(vsort_select_copy)(void *context, size_t index)
+{
+    const VSORT_FNX(vsort_select_job, _t) *job = (const VSORT_FNX(vsort_select_job, _t) *)context;
+    size_t begin = index * job->block;
+    size_t end = VSORT_MIN(begin + job->block, job->count);
+    if (begin < end)
+        memcpy((VSORT_T *)job->src + begin, job->dst + begin, (end - begin) * sizeof(VSORT_T));
+}
+
+// Sample select: two splitters taken from a sorted sample bracket the rank
+// of nth, one parallel pass scatters the elements below, between and above
+// them through scratch, and introselect finishes inside the group holding
+// nth, which is the narrow middle band unless the sample was unlucky.
+static bool VSORT_FN(vsort_parallel_select)(VSORT_T *data, size_t count, size_t nth, unsigned int flags)
+{
+    int threads = vsort_parallel_threads(flags);
+    if (threads < 2 || count < VSORT_SELECT_SAMPLE * 4)
+        return false;
+
+    VSORT_T *sample = (VSORT_T *)vsort_scratch_alloc(VSORT_SELECT_SAMPLE * sizeof(VSORT_T));
+    size_t slices = vsort_parallel_slices(threads);
+    size_t *counts = (size_t *)vsort_scratch_alloc(slices * 3 * sizeof(size_t));
+    VSORT_T *buffer = (VSORT_T *)vsort_scratch_alloc(count * sizeof(VSORT_T));
+    if (!sample || !counts || !buffer)
+    {
+        vsort_scratch_free(sample);
+        vsort_scratch_free(counts);
+        vsort_scratch_free(buffer);
+        return false;
+    }
+
+    // One element per stride, at an offset that varies between strides so
+    // periodic inputs do not bias the sample.
+    size_t stride = count / VSORT_SELECT_SAMPLE;
+    for (size_t i = 0; i < VSORT_SELECT_SAMPLE; ++i)
+        sample[i] = data[i * stride + (i * 7919u) % stride];
+    VSORT_FN(vsort_introsort)(sample, VSORT_SELECT_SAMPLE, flags);
+
+    size_t rank = VSORT_MIN(nth / stride, (size_t)VSORT_SELECT_SAMPLE - 1);
+    VSORT_FNX(vsort_select_job, _t) job = {
+        .src = data,
+        .dst = buffer,
+        .count = count,
+        .block = (count + slices - 1) / slices,
+        .low = sample[rank > VSORT_SELECT_SLACK ? rank - VSORT_SELECT_SLACK : 0],
+        .high = sample[VSORT_MIN(rank + VSORT_SELECT_SLACK, (size_t)VSORT_SELECT_SAMPLE - 1)],
+        .counts = counts};
+    size_t tasks = (count + job.block - 1) / job.block;
+    vsort_scratch_free(sample);
+
+    vsort_pool_parallel_for(tasks, VSORT_FN(vsort_select_count), &job, threads, flags);
+
+    size_t bounds[3];
+    size_t total = 0;
+    for (size_t c = 0; c < 3; ++c)
+    {
+        for (size_t t = 0; t < tasks; ++t)
+        {
+            size_t tmp = counts[t * 3 + c];
+            counts[t * 3 + c] = total;
+            total += tmp;
+        }
+        bounds[c] = total;
+    }
+
+    vsort_pool_parallel_for(tasks, VSORT_FN(vsort_select_scatter), &job, threads, flags);
+    vsort_pool_parallel_for(tasks, VSORT_FN(vsort_select_copy), &job, threads, flags);
+    vsort_scratch_free(counts);
+    vsort_scratch_free(buffer);
+
+    size_t begin = nth < bounds[0] ? 0 : (nth < bounds[1] ? bounds[0] : bounds[1]);
+    size_t end = nth < bounds[0] ? bounds[0] : (nth < bounds[1] ? bounds[1] : count);
+    vsort_log_debug("Sample select narrowed %zu " VSORT_TYPE_NAME " elements to %zu.", count, end - begin);
+    VSORT_FN(vsort_select)(data + begin, end - begin, nth - begin, flags);
+    return true;
+}
+
+// Places the element of rank nth at data[nth] with no larger element before
+// it and no smaller one after it.
+static void VSORT_FN(vsort_nth_element)(VSORT_T *data, size_t count, size_t nth, unsigned int flags)
+{
+    vsort_runtime_t *rt = vsort_runtime();
+    bool use_parallel = (flags & VSORT_FLAG_ALLOW_PARALLEL) && count >= rt->thresholds.parallel_threshold;
+    if (flags & VSORT_FLAG_PREFER_EFFICIENCY)
+        use_parallel = use_parallel && count >= (rt->thresholds.parallel_threshold * 2);
+
+    if (use_parallel && VSORT_FN(vsort_parallel_select)(data, count, nth, flags))
+        return;
+    VSORT_FN(vsort_select)(data, count, nth, flags);
+}
+
+// Sorts the k smallest elements into data[0, k): select the k-th, then sort
+// what is in front of it with the regular engine selection.
+static void VSORT_FN(vsort_partial_sort)(VSORT_T *data, size_t count, size_t k, unsigned int flags)
+{
+    if (k < count)
+    {
+        VSORT_FN(vsort_nth_element)(data, count, k - 1, flags);
+        k--;
+    }
+    if (k > 1)
+        VSORT_FN(vsort_sort)(data, k, flags);
+}
+
+#undef VSORT_FN
+#undef VSORT_FNX
+#undef VSORT_T
+#undef VSORT_DATA_KIND
+#undef VSORT_SUFFIX
+#undef VSORT_TYPE_NAME